@@ -7,16 +7,28 @@ import java.io.File
 /**
  * Simple result for a single benchmark test run.
  * This captures timing for ONE side of the comparison (either control or treatment).
+ *
+ * Concurrent scenarios (see [ConcurrentBenchmarkRunner]) also report the thread count,
+ * tail latencies and throughput; [medianNs] is then the p50 of a single operation.
  */
 data class SingleBenchmarkResult(
     val name: String,
     val medianNs: Double,
     val stdDevNs: Double,
+    val threads: Int? = null,
+    val p90Ns: Double? = null,
+    val p99Ns: Double? = null,
+    val maxNs: Double? = null,
+    val throughputOpsPerSec: Double? = null,
+    val roundThroughputs: List<Double> = emptyList(),
 )
 
 /**
  * JUnit 5 extension that collects benchmark results and writes them to JSON.
  *
+ * When the JVMTI agent collects interception metrics (treatment project run with
+ * -PbenchmarkAgentMetrics), they are written alongside the results as `agentMetrics`.
+ *
  * Usage: Add @ExtendWith(BenchmarkResultsCollector::class) to test classes.
  */
 class BenchmarkResultsCollector : AfterAllCallback {
@@ -32,7 +44,7 @@ class BenchmarkResultsCollector : AfterAllCallback {
         outputDir.mkdirs()
 
         val outputFile = File(outputDir, "results.json")
-        val json = resultsToJson(results)
+        val json = resultsToJson(results, readAgentMetrics())
 
         outputFile.writeText(json)
         println("Benchmark results written to: ${outputFile.absolutePath}")
@@ -51,28 +63,61 @@ class BenchmarkResultsCollector : AfterAllCallback {
             }
         }
 
+        /**
+         * Read the agent's interception metrics as report entries, via reflection because
+         * benchmark-common does not depend on junit-airgap (the control project has no agent).
+         *
+         * @return Metrics entries, or null if junit-airgap is absent or metrics are off
+         */
+        private fun readAgentMetrics(): Map<*, *>? =
+            try {
+                val context = Class.forName("io.github.garryjeromson.junit.airgap.bytebuddy.NetworkBlockerContext")
+                val metrics = context.getMethod("getInterceptionMetrics").invoke(null) ?: return null
+                metrics.javaClass.getMethod("toReportEntries").invoke(metrics) as Map<*, *>
+            } catch (e: ReflectiveOperationException) {
+                null
+            } catch (e: LinkageError) {
+                null
+            }
+
         /**
          * Convert results to JSON format.
+         *
+         * Concurrent scenarios add their fields after stdDevNs, so readers of the plain
+         * name/medianNs/stdDevNs format keep working. Agent metrics go in a separate
+         * top-level object, which readers of `results` never see.
          */
-        private fun resultsToJson(results: List<SingleBenchmarkResult>): String {
+        private fun resultsToJson(
+            results: List<SingleBenchmarkResult>,
+            agentMetrics: Map<*, *>? = null,
+        ): String {
             val jsonResults =
-                results.joinToString(",\n    ") { result ->
-                    """
-                    {
-                        "name": "${result.name}",
-                        "medianNs": ${result.medianNs},
-                        "stdDevNs": ${result.stdDevNs}
+                results.joinToString(",\n") { result ->
+                    val fields =
+                        mutableListOf(
+                            "\"name\": \"${result.name}\"",
+                            "\"medianNs\": ${result.medianNs}",
+                            "\"stdDevNs\": ${result.stdDevNs}",
+                        )
+                    if (result.threads != null) {
+                        fields += "\"threads\": ${result.threads}"
+                        fields += "\"p90Ns\": ${result.p90Ns}"
+                        fields += "\"p99Ns\": ${result.p99Ns}"
+                        fields += "\"maxNs\": ${result.maxNs}"
+                        fields += "\"throughputOpsPerSec\": ${result.throughputOpsPerSec}"
+                        fields += "\"roundThroughputs\": [${result.roundThroughputs.joinToString(", ")}]"
                     }
-                    """.trimIndent()
+                    fields.joinToString(",\n", prefix = "    {\n", postfix = "\n    }") { "      $it" }
                 }
 
-            return """
-                {
-                    "results": [
-                        $jsonResults
-                    ]
-                }
-                """.trimIndent()
+            val metricsJson =
+                agentMetrics
+                    ?.entries
+                    ?.joinToString(",\n", prefix = ",\n  \"agentMetrics\": {\n", postfix = "\n  }") {
+                        "    \"${it.key}\": \"${it.value}\""
+                    } ?: ""
+
+            return "{\n  \"results\": [\n$jsonResults\n  ]$metricsJson\n}\n"
         }
     }
 }
@@ -0,0 +1,196 @@
+package io.github.garryjeromson.junit.airgap.benchmark
+
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.ExecutionException
+import java.util.concurrent.ExecutorService
+import java.util.concurrent.Executors
+import java.util.concurrent.Future
+import kotlin.math.ceil
+
+/**
+ * Timing statistics for one concurrent scenario at one thread count.
+ *
+ * @property name Scenario name including the thread count, e.g. "Loopback Connect Storm [32 threads]"
+ * @property threads Number of threads running the operation at once
+ * @property p50Ns Median latency of a single operation
+ * @property p90Ns 90th percentile latency
+ * @property p99Ns 99th percentile latency
+ * @property maxNs Slowest single operation
+ * @property stdDevNs Standard deviation of the operation latencies
+ * @property throughputOpsPerSec Median operations per second (all threads) across rounds
+ * @property roundThroughputs Operations per second of each measured round (used for the significance test)
+ */
+data class ConcurrentBenchmarkResult(
+    val name: String,
+    val threads: Int,
+    val p50Ns: Double,
+    val p90Ns: Double,
+    val p99Ns: Double,
+    val maxNs: Double,
+    val stdDevNs: Double,
+    val throughputOpsPerSec: Double,
+    val roundThroughputs: List<Double>,
+) {
+    fun toSingleResult(): SingleBenchmarkResult =
+        SingleBenchmarkResult(
+            name = name,
+            medianNs = p50Ns,
+            stdDevNs = stdDevNs,
+            threads = threads,
+            p90Ns = p90Ns,
+            p99Ns = p99Ns,
+            maxNs = maxNs,
+            throughputOpsPerSec = throughputOpsPerSec,
+            roundThroughputs = roundThroughputs,
+        )
+}
+
+/**
+ * Runner for concurrent workloads.
+ *
+ * Every thread starts each round at the same instant and times every single operation,
+ * so contention (agent mutexes, upcalls, shared caches) shows up in the tail latencies
+ * and in throughput instead of being averaged away in a per-iteration median.
+ */
+object ConcurrentBenchmarkRunner {
+    /**
+     * Rounds run (and discarded) before measuring, to let JIT and connection pools settle.
+     */
+    const val WARMUP_ROUNDS = 2
+
+    /**
+     * Measured rounds per thread count. Each round contributes one throughput sample.
+     */
+    const val MEASUREMENT_ROUNDS = 10
+
+    /**
+     * Default operations per thread in each round.
+     */
+    const val OPERATIONS_PER_THREAD = 200
+
+    /**
+     * Thread counts to run every scenario at.
+     * Override with -Djunit.airgap.benchmark.threads=1,8,64 (or -PbenchmarkThreads=... on Gradle).
+     */
+    val threadCounts: List<Int> =
+        System
+            .getProperty("junit.airgap.benchmark.threads", "1,4,16,32")
+            .split(",")
+            .map { it.trim().toInt() }
+            .onEach { require(it > 0) { "Thread counts must be positive: $it" } }
+
+    /**
+     * Run an operation on [threads] threads at once and record every operation's latency.
+     *
+     * @param name Scenario name (the thread count is appended)
+     * @param threads Number of concurrent threads
+     * @param operationsPerThread Operations each thread runs per round
+     * @param operation Operation to measure; receives the thread's iteration index within the round
+     * @return Latency percentiles and throughput
+     */
+    fun measureConcurrent(
+        name: String,
+        threads: Int,
+        operationsPerThread: Int = OPERATIONS_PER_THREAD,
+        operation: (iteration: Int) -> Unit,
+    ): ConcurrentBenchmarkResult {
+        val scenarioName = "$name [$threads threads]"
+        val executor = Executors.newFixedThreadPool(threads)
+        try {
+            println("Warming up $scenarioName...")
+            repeat(WARMUP_ROUNDS) {
+                runRound(executor, threads, operationsPerThread, operation, latencies = null, offset = 0)
+            }
+
+            println("Measuring $scenarioName...")
+            val latencies = LongArray(MEASUREMENT_ROUNDS * threads * operationsPerThread)
+            val roundThroughputs =
+                (0 until MEASUREMENT_ROUNDS).map { round ->
+                    val offset = round * threads * operationsPerThread
+                    runRound(executor, threads, operationsPerThread, operation, latencies, offset)
+                }
+
+            latencies.sort()
+            val values = latencies.map { it.toDouble() }
+            val result =
+                ConcurrentBenchmarkResult(
+                    name = scenarioName,
+                    threads = threads,
+                    p50Ns = percentile(latencies, 50.0),
+                    p90Ns = percentile(latencies, 90.0),
+                    p99Ns = percentile(latencies, 99.0),
+                    maxNs = latencies.last().toDouble(),
+                    stdDevNs = Statistics.stdDev(values),
+                    throughputOpsPerSec = Statistics.median(roundThroughputs),
+                    roundThroughputs = roundThroughputs,
+                )
+
+            println(
+                "  p50: ${result.p50Ns / 1_000.0}μs, p99: ${result.p99Ns / 1_000.0}μs, " +
+                    "max: ${result.maxNs / 1_000.0}μs, throughput: ${result.throughputOpsPerSec.toLong()} ops/s",
+            )
+            return result
+        } finally {
+            executor.shutdownNow()
+        }
+    }
+
+    /**
+     * Run one round: release all threads together, and time the round from release until
+     * the last thread finishes.
+     *
+     * @return Operations per second across all threads
+     */
+    private fun runRound(
+        executor: ExecutorService,
+        threads: Int,
+        operationsPerThread: Int,
+        operation: (iteration: Int) -> Unit,
+        latencies: LongArray?,
+        offset: Int,
+    ): Double {
+        val ready = CountDownLatch(threads)
+        val start = CountDownLatch(1)
+        val futures: List<Future<*>> =
+            (0 until threads).map { thread ->
+                executor.submit(
+                    Runnable {
+                        ready.countDown()
+                        start.await()
+                        val base = offset + thread * operationsPerThread
+                        for (iteration in 0 until operationsPerThread) {
+                            val begin = System.nanoTime()
+                            operation(iteration)
+                            val elapsed = System.nanoTime() - begin
+                            if (latencies != null) {
+                                latencies[base + iteration] = elapsed
+                            }
+                        }
+                    },
+                )
+            }
+
+        ready.await()
+        val begin = System.nanoTime()
+        start.countDown()
+        try {
+            futures.forEach { it.get() }
+        } catch (e: ExecutionException) {
+            throw e.cause ?: e
+        }
+        val elapsed = System.nanoTime() - begin
+
+        return threads * operationsPerThread * 1_000_000_000.0 / elapsed
+    }
+
+    /**
+     * Nearest-rank percentile of a sorted array.
+     */
+    private fun percentile(
+        sorted: LongArray,
+        percent: Double,
+    ): Double {
+        val rank = ceil(percent / 100.0 * sorted.size).toInt().coerceIn(1, sorted.size)
+        return sorted[rank - 1].toDouble()
+    }
+}
@@ -0,0 +1,114 @@
+package io.github.garryjeromson.junit.airgap.benchmark
+
+import com.sun.net.httpserver.HttpServer
+import java.net.HttpURLConnection
+import java.net.InetAddress
+import java.net.InetSocketAddress
+import java.net.ServerSocket
+import java.net.Socket
+import java.net.URI
+import java.net.URL
+import java.util.concurrent.ExecutorService
+import java.util.concurrent.Executors
+
+/**
+ * Loopback-only network workloads for the concurrent scenarios.
+ *
+ * Everything stays on 127.0.0.1/localhost, so control and treatment see the same
+ * kernel work and the difference between them is the interception cost.
+ */
+object ConcurrentWorkloads {
+    /**
+     * Make a pooled HTTP connection reconnect every this many requests (client churn).
+     */
+    const val HTTP_CHURN_INTERVAL = 10
+
+    /**
+     * TCP server on 127.0.0.1 that accepts and immediately closes every connection.
+     */
+    class LoopbackAcceptor : AutoCloseable {
+        private val server = ServerSocket(0, 1024, InetAddress.getLoopbackAddress())
+        private val acceptor =
+            Thread({ acceptUntilClosed() }, "benchmark-acceptor").apply {
+                isDaemon = true
+                start()
+            }
+
+        val address: InetSocketAddress = InetSocketAddress(InetAddress.getLoopbackAddress(), server.localPort)
+
+        private fun acceptUntilClosed() {
+            while (!server.isClosed) {
+                try {
+                    server.accept().close()
+                } catch (e: Exception) {
+                    return
+                }
+            }
+        }
+
+        override fun close() {
+            server.close()
+            acceptor.join()
+        }
+    }
+
+    /**
+     * HTTP server on 127.0.0.1 answering every request with a 2-byte body (keep-alive enabled).
+     */
+    class LoopbackHttpServer : AutoCloseable {
+        private val handlerPool: ExecutorService = Executors.newFixedThreadPool(8)
+        private val server =
+            HttpServer.create(InetSocketAddress(InetAddress.getLoopbackAddress(), 0), 1024).apply {
+                createContext("/") { exchange ->
+                    val body = "ok".toByteArray()
+                    exchange.sendResponseHeaders(200, body.size.toLong())
+                    exchange.responseBody.use { it.write(body) }
+                }
+                executor = handlerPool
+                start()
+            }
+
+        val url: URL = URI("http://127.0.0.1:${server.address.port}/").toURL()
+
+        override fun close() {
+            server.stop(0)
+            handlerPool.shutdownNow()
+        }
+    }
+
+    /**
+     * Open and close one TCP connection.
+     *
+     * The socket is reset on close (SO_LINGER 0) so thousands of connects per second
+     * don't exhaust ephemeral ports with TIME_WAIT entries.
+     */
+    fun connect(address: InetSocketAddress) {
+        Socket().use { socket ->
+            socket.setSoLinger(true, 0)
+            socket.connect(address, 1000)
+        }
+    }
+
+    /**
+     * Resolve localhost through the platform resolver.
+     * Run with -Dsun.net.inetaddr.ttl=0 so every call reaches the native lookup.
+     */
+    fun resolveLocalhost() {
+        InetAddress.getAllByName("localhost")
+    }
+
+    /**
+     * Send one GET through the JDK's keep-alive pool. Every [HTTP_CHURN_INTERVAL]th
+     * request drops its connection, so the next one has to connect again.
+     */
+    fun httpGet(
+        url: URL,
+        iteration: Int,
+    ) {
+        val connection = url.openConnection() as HttpURLConnection
+        connection.inputStream.use { it.readBytes() }
+        if (iteration % HTTP_CHURN_INTERVAL == HTTP_CHURN_INTERVAL - 1) {
+            connection.disconnect()
+        }
+    }
+}
@@ -80,6 +80,8 @@ android {
 junitAirgap {
     enabled = true
     debug = false
+    // Interception counts in results.json (-PbenchmarkAgentMetrics); the counters cost time, so off by default
+    collectInterceptionMetrics = providers.gradleProperty("benchmarkAgentMetrics").isPresent
 }
 
 // Configure JVM test task
@@ -92,6 +94,13 @@ tasks.named<Test>("jvmTest") {
 
     useJUnitPlatform()
 
+    // Concurrent scenarios: no InetAddress cache, so every DNS storm lookup reaches the
+    // resolver; thread counts can be overridden with -PbenchmarkThreads=1,8,64
+    systemProperty("sun.net.inetaddr.ttl", "0")
+    providers.gradleProperty("benchmarkThreads").orNull?.let {
+        systemProperty("junit.airgap.benchmark.threads", it)
+    }
+
     testLogging {
         events("passed", "skipped", "failed")
         showStandardStreams = true
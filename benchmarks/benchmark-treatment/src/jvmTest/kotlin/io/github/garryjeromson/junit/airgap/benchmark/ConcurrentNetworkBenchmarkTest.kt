@@ -0,0 +1,73 @@
+package io.github.garryjeromson.junit.airgap.benchmark
+
+import io.github.garryjeromson.junit.airgap.AllowRequestsToHosts
+import io.github.garryjeromson.junit.airgap.BlockNetworkRequests
+import org.junit.jupiter.api.AfterAll
+import org.junit.jupiter.api.BeforeAll
+import org.junit.jupiter.api.Test
+import org.junit.jupiter.api.TestInstance
+import org.junit.jupiter.api.extension.ExtendWith
+
+/**
+ * Concurrent network benchmarks for treatment group (with plugin and JVMTI agent).
+ * These tests measure loopback connect, DNS and pooled HTTP throughput and tail latency
+ * at several thread counts with network blocking enabled and loopback allowed, so every
+ * connect and lookup goes through policy evaluation.
+ */
+@ExtendWith(BenchmarkResultsCollector::class)
+@BlockNetworkRequests
+@AllowRequestsToHosts(hosts = ["localhost", "127.0.0.1"])
+@TestInstance(TestInstance.Lifecycle.PER_CLASS)
+class ConcurrentNetworkBenchmarkTest {
+    private lateinit var acceptor: ConcurrentWorkloads.LoopbackAcceptor
+    private lateinit var httpServer: ConcurrentWorkloads.LoopbackHttpServer
+
+    @BeforeAll
+    fun startServers() {
+        acceptor = ConcurrentWorkloads.LoopbackAcceptor()
+        httpServer = ConcurrentWorkloads.LoopbackHttpServer()
+    }
+
+    @AfterAll
+    fun stopServers() {
+        acceptor.close()
+        httpServer.close()
+    }
+
+    @Test
+    fun `benchmark loopback connect storm`() {
+        ConcurrentBenchmarkRunner.threadCounts.forEach { threads ->
+            val result =
+                ConcurrentBenchmarkRunner.measureConcurrent("Loopback Connect Storm", threads) {
+                    ConcurrentWorkloads.connect(acceptor.address)
+                }
+            BenchmarkResultsCollector.addResult(result.toSingleResult())
+        }
+    }
+
+    @Test
+    fun `benchmark DNS storm`() {
+        ConcurrentBenchmarkRunner.threadCounts.forEach { threads ->
+            val result =
+                ConcurrentBenchmarkRunner.measureConcurrent("DNS Storm", threads) {
+                    ConcurrentWorkloads.resolveLocalhost()
+                }
+            BenchmarkResultsCollector.addResult(result.toSingleResult())
+        }
+    }
+
+    @Test
+    fun `benchmark pooled HTTP client churn`() {
+        ConcurrentBenchmarkRunner.threadCounts.forEach { threads ->
+            val result =
+                ConcurrentBenchmarkRunner.measureConcurrent(
+                    name = "Pooled HTTP Client Churn",
+                    threads = threads,
+                    operationsPerThread = 100,
+                ) { iteration ->
+                    ConcurrentWorkloads.httpGet(httpServer.url, iteration)
+                }
+            BenchmarkResultsCollector.addResult(result.toSingleResult())
+        }
+    }
+}
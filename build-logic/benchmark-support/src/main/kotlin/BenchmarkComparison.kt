@@ -1,6 +1,8 @@
 import org.gradle.api.GradleException
 import java.io.File
 import kotlin.math.abs
+import kotlin.math.exp
+import kotlin.math.sqrt
 
 /**
  * Utility for comparing benchmark results from control and treatment projects.
@@ -10,14 +12,31 @@ object BenchmarkComparison {
         val name: String,
         val medianNs: Double,
         val stdDevNs: Double,
-    )
+        // Concurrent scenarios only (see ConcurrentBenchmarkRunner)
+        val threads: Int? = null,
+        val p90Ns: Double? = null,
+        val p99Ns: Double? = null,
+        val maxNs: Double? = null,
+        val throughputOpsPerSec: Double? = null,
+        val roundThroughputs: List<Double> = emptyList(),
+    ) {
+        val isConcurrent: Boolean
+            get() = threads != null
+    }
 
     /**
      * Compare benchmark results and generate a report.
      *
+     * Single-threaded results are judged by median overhead. Concurrent scenarios are
+     * reported with p50/p90/p99/max and throughput per thread count, and fail only when
+     * throughput drops by more than [maxOverheadPercent] AND a Mann-Whitney U test on the
+     * per-round throughputs says the drop is significant at [significanceLevel], so one
+     * noisy round under contention doesn't fail CI.
+     *
      * @param controlDir Build directory of the control project
      * @param treatmentDir Build directory of the treatment project
      * @param maxOverheadPercent Maximum acceptable per-test overhead percentage
+     * @param significanceLevel p-value below which a throughput drop counts as real
      * @return Comparison report as markdown
      * @throws GradleException if thresholds are exceeded
      */
@@ -25,10 +44,13 @@ object BenchmarkComparison {
         controlDir: File,
         treatmentDir: File,
         maxOverheadPercent: Double = 50.0,
+        significanceLevel: Double = 0.05,
     ): String {
         // Load per-test results
-        val controlResults = loadBenchmarkResults(File(controlDir, "benchmark-results/results.json"))
-        val treatmentResults = loadBenchmarkResults(File(treatmentDir, "benchmark-results/results.json"))
+        val allControlResults = loadBenchmarkResults(File(controlDir, "benchmark-results/results.json"))
+        val allTreatmentResults = loadBenchmarkResults(File(treatmentDir, "benchmark-results/results.json"))
+        val controlResults = allControlResults.filter { !it.isConcurrent }
+        val treatmentResults = allTreatmentResults.filter { !it.isConcurrent }
 
         // Match results by name
         val comparisons = mutableListOf<Triple<String, Double, String>>()
@@ -51,6 +73,14 @@ object BenchmarkComparison {
             }
         }
 
+        val concurrentComparisons = compareConcurrent(
+            allControlResults.filter { it.isConcurrent },
+            allTreatmentResults.filter { it.isConcurrent },
+            maxOverheadPercent,
+            significanceLevel
+        )
+        if (concurrentComparisons.any { !it.pass }) allPass = false
+
         // Build report
         val report = buildString {
             appendLine("# Benchmark Comparison Report")
@@ -77,8 +107,45 @@ object BenchmarkComparison {
                 }
             }
 
+            if (concurrentComparisons.isNotEmpty()) {
+                appendLine()
+                appendLine("## Concurrent Scenarios")
+                appendLine()
+                appendLine("Latencies are per operation (control → treatment); throughput is all threads together.")
+                appendLine()
+                appendLine(
+                    "| Scenario | Threads | p50 | p90 | p99 | max | " +
+                    "Throughput (ops/s) | Δ Throughput | p-value | Status |"
+                )
+                appendLine(
+                    "|----------|---------|-----|-----|-----|-----|" +
+                    "--------------------|--------------|---------|--------|"
+                )
+
+                concurrentComparisons.forEach { comparison ->
+                    val control = comparison.control
+                    val treatment = comparison.treatment
+                    appendLine(
+                        "| ${comparison.scenario} | ${control.threads} | " +
+                        "${formatChange(control.medianNs, treatment.medianNs)} | " +
+                        "${formatChange(control.p90Ns, treatment.p90Ns)} | " +
+                        "${formatChange(control.p99Ns, treatment.p99Ns)} | " +
+                        "${formatChange(control.maxNs, treatment.maxNs)} | " +
+                        "${String.format("%.0f", control.throughputOpsPerSec ?: 0.0)} → " +
+                        "${String.format("%.0f", treatment.throughputOpsPerSec ?: 0.0)} | " +
+                        "${String.format("%+.1f", -comparison.throughputDropPercent)}% | " +
+                        "${String.format("%.3f", comparison.pValue)} | " +
+                        "${if (comparison.pass) "✅" else "❌"} |"
+                    )
+                }
+            }
+
             appendLine()
             appendLine("**Maximum Overhead Threshold:** ${maxOverheadPercent}%")
+            if (concurrentComparisons.isNotEmpty()) {
+                appendLine()
+                appendLine("**Significance Level (concurrent throughput):** $significanceLevel")
+            }
             appendLine()
             appendLine("## Summary")
             appendLine()
@@ -90,28 +157,127 @@ object BenchmarkComparison {
             } else {
                 appendLine("❌ Some benchmarks exceeded the overhead threshold!")
                 appendLine()
-                val failures = comparisons.filter { it.third == "❌" }
                 appendLine("Failed tests:")
-                failures.forEach { (name, overhead, _) ->
-                    appendLine("- $name: ${String.format("%+.1f", overhead)}% (threshold: ${maxOverheadPercent}%)")
+                failureMessages(comparisons, concurrentComparisons, maxOverheadPercent).forEach {
+                    appendLine("- $it")
                 }
             }
         }
 
         // Throw if thresholds exceeded
         if (!allPass) {
-            val failures = comparisons.filter { it.third == "❌" }
             throw GradleException(
                 "Benchmark comparison failed:\n" +
-                failures.joinToString("\n") { (name, overhead, _) ->
-                    "  $name: ${String.format("%+.1f", overhead)}% overhead (threshold: ${maxOverheadPercent}%)"
-                }
+                failureMessages(comparisons, concurrentComparisons, maxOverheadPercent).joinToString("\n") { "  $it" }
             )
         }
 
         return report
     }
 
+    /**
+     * One concurrent scenario at one thread count, control vs treatment.
+     */
+    private data class ConcurrentComparison(
+        val control: BenchmarkResult,
+        val treatment: BenchmarkResult,
+        val throughputDropPercent: Double,
+        val pValue: Double,
+        val pass: Boolean,
+    ) {
+        val scenario: String
+            get() = control.name.substringBefore(" [")
+    }
+
+    private fun compareConcurrent(
+        controlResults: List<BenchmarkResult>,
+        treatmentResults: List<BenchmarkResult>,
+        maxOverheadPercent: Double,
+        significanceLevel: Double,
+    ): List<ConcurrentComparison> =
+        controlResults.mapNotNull { control ->
+            val treatment = treatmentResults.find { it.name == control.name } ?: return@mapNotNull null
+            val controlThroughput = control.throughputOpsPerSec ?: return@mapNotNull null
+            val treatmentThroughput = treatment.throughputOpsPerSec ?: return@mapNotNull null
+
+            val dropPercent = ((controlThroughput - treatmentThroughput) / controlThroughput) * 100.0
+            val pValue = mannWhitneyPValue(control.roundThroughputs, treatment.roundThroughputs)
+            ConcurrentComparison(
+                control = control,
+                treatment = treatment,
+                throughputDropPercent = dropPercent,
+                pValue = pValue,
+                pass = dropPercent <= maxOverheadPercent || pValue >= significanceLevel
+            )
+        }
+
+    private fun failureMessages(
+        comparisons: List<Triple<String, Double, String>>,
+        concurrentComparisons: List<ConcurrentComparison>,
+        maxOverheadPercent: Double,
+    ): List<String> =
+        comparisons.filter { it.third == "❌" }.map { (name, overhead, _) ->
+            "$name: ${String.format("%+.1f", overhead)}% overhead (threshold: ${maxOverheadPercent}%)"
+        } +
+        concurrentComparisons.filter { !it.pass }.map {
+            "${it.control.name}: throughput ${String.format("%+.1f", -it.throughputDropPercent)}% " +
+            "(threshold: -${maxOverheadPercent}%, p=${String.format("%.3f", it.pValue)})"
+        }
+
+    /**
+     * Two-sided p-value of the Mann-Whitney U test (normal approximation with tie and
+     * continuity correction).
+     *
+     * Rank-based, so a single outlier round doesn't dominate the way it would in a t-test,
+     * and no normality is assumed for throughput under contention.
+     *
+     * @return p-value, or 1.0 if either side has no samples
+     */
+    internal fun mannWhitneyPValue(a: List<Double>, b: List<Double>): Double {
+        if (a.isEmpty() || b.isEmpty()) {
+            return 1.0
+        }
+
+        val samples = (a.map { it to true } + b.map { it to false }).sortedBy { it.first }
+        val ranks = DoubleArray(samples.size)
+        var tieCorrection = 0.0
+        var start = 0
+        while (start < samples.size) {
+            var end = start
+            while (end + 1 < samples.size && samples[end + 1].first == samples[start].first) end++
+            val rank = (start + end) / 2.0 + 1.0
+            for (i in start..end) ranks[i] = rank
+            val ties = (end - start + 1).toDouble()
+            tieCorrection += ties * ties * ties - ties
+            start = end + 1
+        }
+
+        val n1 = a.size.toDouble()
+        val n2 = b.size.toDouble()
+        val n = n1 + n2
+        val rankSum = samples.indices.filter { samples[it].second }.sumOf { ranks[it] }
+        val u = rankSum - n1 * (n1 + 1) / 2.0
+        val variance = n1 * n2 / 12.0 * ((n + 1) - tieCorrection / (n * (n - 1)))
+        if (variance <= 0.0) {
+            return 1.0
+        }
+
+        val z = ((abs(u - n1 * n2 / 2.0) - 0.5) / sqrt(variance)).coerceAtLeast(0.0)
+        return (2.0 * (1.0 - normalCdf(z))).coerceIn(0.0, 1.0)
+    }
+
+    /**
+     * Standard normal CDF via the Abramowitz-Stegun 7.1.26 erf approximation (error < 1.5e-7).
+     */
+    private fun normalCdf(z: Double): Double {
+        val x = abs(z) / sqrt(2.0)
+        val t = 1.0 / (1.0 + 0.3275911 * x)
+        val polynomial =
+            t * (0.254829592 + t * (-0.284496736 + t * (1.421413741 + t * (-1.453152027 + t * 1.061405429))))
+        val erf = 1.0 - polynomial * exp(-x * x)
+        return if (z >= 0) 0.5 * (1.0 + erf) else 0.5 * (1.0 - erf)
+    }
+
     private fun loadBenchmarkResults(file: File): List<BenchmarkResult> {
         if (!file.exists()) {
             throw GradleException("Benchmark results file not found: ${file.absolutePath}")
@@ -120,17 +286,30 @@ object BenchmarkComparison {
         val content = file.readText()
         val results = mutableListOf<BenchmarkResult>()
 
-        // Parse JSON manually (simple approach for this structure)
-        val resultPattern = Regex(
-            """"name":\s*"([^"]+)",\s*"medianNs":\s*([0-9.]+),\s*"stdDevNs":\s*([0-9.]+)"""
-        )
+        // Parse JSON manually (simple approach for this structure): every result is a flat
+        // object; concurrent scenarios add their fields after stdDevNs
+        val objectPattern = Regex("""\{[^{}]*"name"[^{}]*\}""")
+        val namePattern = Regex(""""name":\s*"([^"]+)"""")
 
-        resultPattern.findAll(content).forEach { match ->
+        objectPattern.findAll(content).forEach { match ->
+            val entry = match.value
+            val name = namePattern.find(entry)?.groupValues?.get(1) ?: return@forEach
+            val medianNs = numberField(entry, "medianNs") ?: return@forEach
+            val stdDevNs = numberField(entry, "stdDevNs") ?: return@forEach
             results.add(
                 BenchmarkResult(
-                    name = match.groupValues[1],
-                    medianNs = match.groupValues[2].toDouble(),
-                    stdDevNs = match.groupValues[3].toDouble()
+                    name = name,
+                    medianNs = medianNs,
+                    stdDevNs = stdDevNs,
+                    threads = numberField(entry, "threads")?.toInt(),
+                    p90Ns = numberField(entry, "p90Ns"),
+                    p99Ns = numberField(entry, "p99Ns"),
+                    maxNs = numberField(entry, "maxNs"),
+                    throughputOpsPerSec = numberField(entry, "throughputOpsPerSec"),
+                    roundThroughputs = Regex(""""roundThroughputs":\s*\[([^\]]*)\]""")
+                        .find(entry)?.groupValues?.get(1)
+                        ?.split(",")?.mapNotNull { it.trim().toDoubleOrNull() }
+                        ?: emptyList()
                 )
             )
         }
@@ -142,6 +321,19 @@ object BenchmarkComparison {
         return results
     }
 
+    /**
+     * Read a numeric field (Kotlin's Double.toString switches to exponent notation above 1e7).
+     */
+    private fun numberField(entry: String, key: String): Double? =
+        Regex(""""$key":\s*(-?[0-9.]+(?:[eE][+-]?[0-9]+)?)""").find(entry)?.groupValues?.get(1)?.toDoubleOrNull()
+
+    private fun formatChange(control: Double?, treatment: Double?): String {
+        if (control == null || treatment == null) {
+            return "-"
+        }
+        return "${formatNanos(control)} → ${formatNanos(treatment)}"
+    }
+
     private fun formatNanos(nanos: Double): String {
         return when {
             nanos < 1_000 -> String.format("%.0f ns", nanos)
@@ -25,6 +25,7 @@ tasks.register("test") {
     dependsOn(
         ":junit-airgap:test",
         ":junit-airgap:integrationTest",
+        ":junit-airgap:nettyNativeIntegrationTest",
         ":gradle-plugin:test",
     )
 
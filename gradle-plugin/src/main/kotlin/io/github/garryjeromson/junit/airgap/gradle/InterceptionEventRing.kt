@@ -0,0 +1,195 @@
+package io.github.garryjeromson.junit.airgap.gradle
+
+import java.io.File
+import java.net.InetAddress
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Reads the ring file the JVMTI agents of a test task's forks append their interceptions to
+ * (events=<file> agent option), and aggregates it into a summary.
+ *
+ * The format is documented in native/include/shared_event_ring.h and must stay in sync with it.
+ * The file is read once every fork has exited, so no record is being written concurrently.
+ */
+object InterceptionEventRing {
+    private val MAGIC = "AIRGAPEV".toByteArray(Charsets.US_ASCII)
+    private const val VERSION = 1
+    internal const val HEADER_SIZE = 64
+    internal const val RECORD_SIZE = 128
+
+    /** Interception target names, in native InterceptTarget order. */
+    internal val TARGET_NAMES =
+        listOf(
+            "NetConnect0",
+            "SocketConnect0",
+            "SocketChannelConnect0",
+            "Inet6LookupAllHostAddr",
+            "Inet4LookupAllHostAddr",
+            "NettySocketConnect",
+        )
+
+    /** Decision path names, in native TracePath order. */
+    internal val PATH_NAMES =
+        listOf(
+            "vm-init-pending",
+            "unregistered",
+            "policy-image",
+            "disarmed",
+            "no-configuration",
+            "verdict-cache",
+            "dns-cache",
+            "host-override",
+            "policy",
+            "java",
+        )
+
+    /**
+     * One recorded interception.
+     *
+     * @property pid Process ID of the fork that made it
+     * @property contextId Test context in that fork (0 = none or JVM-wide shared)
+     * @property target Interception target, e.g. `NetConnect0`
+     * @property blocked Whether it was blocked
+     * @property path Decision path, e.g. `policy`
+     * @property hostname Hostname, if known (truncated by the agent)
+     * @property address Connect address, or null for DNS lookups
+     * @property port Connect port, 0 for DNS lookups
+     * @property timestampNanos Wall-clock time, nanoseconds since the epoch
+     */
+    data class Event(
+        val pid: Int,
+        val contextId: Long,
+        val target: String,
+        val blocked: Boolean,
+        val path: String,
+        val hostname: String?,
+        val address: String?,
+        val port: Int,
+        val timestampNanos: Long,
+    ) {
+        /** What was contacted: `host:port` for connects, `host` for DNS lookups. */
+        val destination: String
+            get() {
+                val host = hostname ?: address ?: "(unknown)"
+                return if (address == null) host else "$host:$port"
+            }
+    }
+
+    /**
+     * Records of a ring file, oldest first.
+     *
+     * @property events Complete records still in the ring
+     * @property overwritten Records lost because the ring wrapped (or left incomplete by a crashed fork)
+     */
+    data class Contents(
+        val events: List<Event>,
+        val overwritten: Long,
+    )
+
+    /**
+     * Read a ring file.
+     *
+     * @throws IllegalArgumentException if [file] is not a ring file of this version
+     */
+    fun read(file: File): Contents = decode(file.readBytes())
+
+    internal fun decode(bytes: ByteArray): Contents {
+        val buffer = ByteBuffer.wrap(bytes).order(ByteOrder.LITTLE_ENDIAN)
+        require(bytes.size >= HEADER_SIZE && bytes.copyOfRange(0, MAGIC.size).contentEquals(MAGIC)) {
+            "Not an interception event ring"
+        }
+        require(buffer.getInt(8) == VERSION && buffer.getInt(12) == RECORD_SIZE) {
+            "Unsupported event ring version ${buffer.getInt(8)}"
+        }
+        val capacity = buffer.getLong(16)
+        val isPowerOfTwo = capacity > 0 && (capacity and (capacity - 1)) == 0L
+        require(isPowerOfTwo && bytes.size == HEADER_SIZE + capacity * RECORD_SIZE) {
+            "Event ring size doesn't match its capacity $capacity"
+        }
+
+        val claimed = buffer.getLong(24)
+        val first = maxOf(0L, claimed - capacity)
+        val events = ArrayList<Event>((claimed - first).toInt())
+        for (index in first until claimed) {
+            val record = HEADER_SIZE + (index and (capacity - 1)).toInt() * RECORD_SIZE
+            if (buffer.getLong(record) == index + 1) {
+                events += decodeRecord(buffer, record)
+            }
+        }
+        return Contents(events, claimed - events.size)
+    }
+
+    private fun decodeRecord(
+        buffer: ByteBuffer,
+        record: Int,
+    ): Event {
+        val target = buffer.get(record + 30).toInt() and 0xff
+        val path = buffer.get(record + 32).toInt() and 0xff
+        val addressLength = buffer.get(record + 33).toInt() and 0xff
+        val hostnameLength = minOf(buffer.get(record + 34).toInt() and 0xff, RECORD_SIZE - 52)
+        val address =
+            if (addressLength == 4 || addressLength == 16) {
+                val bytes = buffer.array().copyOfRange(record + 36, record + 36 + addressLength)
+                InetAddress.getByAddress(bytes).hostAddress
+            } else {
+                null
+            }
+        val hostname =
+            if (hostnameLength > 0) String(buffer.array(), record + 52, hostnameLength, Charsets.UTF_8) else null
+        return Event(
+            pid = buffer.getInt(record + 24),
+            contextId = buffer.getLong(record + 16),
+            target = TARGET_NAMES.getOrNull(target) ?: "target-$target",
+            blocked = buffer.get(record + 31).toInt() != 0,
+            path = PATH_NAMES.getOrNull(path) ?: "path-$path",
+            hostname = hostname,
+            address = address,
+            port = buffer.getShort(record + 28).toInt() and 0xffff,
+            timestampNanos = buffer.getLong(record + 8),
+        )
+    }
+
+    /**
+     * Aggregate a ring's records into a plain-text summary: totals, then blocked and allowed
+     * destinations with the forks and tests that contacted them, most frequent first.
+     *
+     * @param taskName Test task the records belong to
+     */
+    fun summarize(
+        taskName: String,
+        contents: Contents,
+    ): String =
+        buildString {
+            val events = contents.events
+            val blocked = events.filter { it.blocked }
+            appendLine("junit-airgap interceptions for test task '$taskName'")
+            appendLine(
+                "  ${events.size} recorded from ${events.map { it.pid }.distinct().size} fork(s), " +
+                    "${blocked.size} blocked, ${contents.overwritten} overwritten",
+            )
+            appendDestinations("Blocked", blocked)
+            appendDestinations("Allowed", events.filterNot { it.blocked })
+        }
+
+    private fun StringBuilder.appendDestinations(
+        title: String,
+        events: List<Event>,
+    ) {
+        if (events.isEmpty()) {
+            return
+        }
+        appendLine()
+        appendLine("$title:")
+        events
+            .groupBy { it.destination }
+            .entries
+            .sortedWith(compareByDescending<Map.Entry<String, List<Event>>> { it.value.size }.thenBy { it.key })
+            .forEach { (destination, group) ->
+                val forks = group.map { it.pid }.distinct().size
+                val tests = group.map { it.pid to it.contextId }.distinct().size
+                val targets = group.map { it.target }.distinct().sorted().joinToString(", ")
+                appendLine("  $destination  ${group.size}x  forks=$forks tests=$tests  [$targets]")
+            }
+    }
+}
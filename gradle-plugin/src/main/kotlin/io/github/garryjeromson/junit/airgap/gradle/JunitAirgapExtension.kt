@@ -54,6 +54,70 @@ abstract class JunitAirgapExtension {
      */
     abstract val debug: Property<Boolean>
 
+    /**
+     * Enforce allowedHosts / blockedHosts from the first connection the test JVM makes, before the
+     * test framework has started (static initializers, test engine discovery, early agent code).
+     *
+     * The host lists are compiled once per test task into a policy image that every forked test JVM
+     * maps from disk. Until the junit-airgap library takes over, blocked connections fail with
+     * ConnectException and blocked lookups with UnknownHostException.
+     *
+     * Loopback is always allowed in this phase, because the Gradle test worker talks to the Gradle
+     * daemon over it; anything else must be in allowedHosts.
+     *
+     * Default: false
+     */
+    abstract val enforceFromJvmStart: Property<Boolean>
+
+    /**
+     * Also block connections and lookups made by JNI libraries with their own socket code, such as
+     * Netty's epoll transport, by intercepting connect(), sendto(), sendmsg(), getaddrinfo() and
+     * gethostbyname() at the libc level.
+     *
+     * Decided by the native host policy alone: blocked calls fail with the library's own I/O error
+     * (EACCES, or an unknown-host error for lookups) rather than NetworkRequestAttemptedException.
+     *
+     * Linux only; ignored with a warning elsewhere.
+     *
+     * Default: false
+     */
+    abstract val interceptNativeLibraries: Property<Boolean>
+
+    /**
+     * Attach the JVMTI native agent when the first test sets a network configuration, instead of
+     * loading it with -agentpath when the test JVM starts.
+     *
+     * Test JVMs that never block anything then run without the agent. The agent rebinds the JDK
+     * natives that were already bound; Netty natives registered before the attach are only covered
+     * with interceptNativeLibraries. Ignored when enforceFromJvmStart is set.
+     *
+     * Default: false
+     */
+    abstract val attachNativeAgentOnDemand: Property<Boolean>
+
+    /**
+     * Have the JVMTI native agent count every interception per target and decision path, with
+     * histograms of its JNI upcall and original call times.
+     *
+     * Each test then publishes the interceptions made while it ran as `airgap.*` JUnit report
+     * entries. Wrappers skip their disarmed fast path while this is on, so leave it off for
+     * timing-sensitive suites.
+     *
+     * Default: false
+     */
+    abstract val collectInterceptionMetrics: Property<Boolean>
+
+    /**
+     * Summarize the network interceptions of all forks after each test task.
+     *
+     * The JVMTI native agents of a test task's forks append every connect and DNS lookup they
+     * enforce (fork, test, target, host, port, verdict, time) to one shared memory-mapped file, and
+     * a `<testTask>AirgapSummary` task aggregates it into build/reports/junit-airgap/<testTask>/interceptions.txt.
+     *
+     * Default: false
+     */
+    abstract val interceptionSummary: Property<Boolean>
+
     /**
      * Enable automatic @Rule injection for JUnit 4 test classes via bytecode enhancement.
      * When true, the plugin will automatically inject a AirgapRule field into JUnit 4 test classes,
@@ -78,6 +142,11 @@ abstract class JunitAirgapExtension {
         applyToAllTests.convention(false)
         libraryVersion.convention("0.1.0-beta.1") // Matches the actual library version
         debug.convention(false)
+        enforceFromJvmStart.convention(false)
+        interceptNativeLibraries.convention(false)
+        attachNativeAgentOnDemand.convention(false)
+        collectInterceptionMetrics.convention(false)
+        interceptionSummary.convention(false)
         // injectJUnit4Rule has no convention - null means auto-detect
     }
 }
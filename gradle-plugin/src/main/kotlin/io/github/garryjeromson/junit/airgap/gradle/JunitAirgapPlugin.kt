@@ -66,6 +66,11 @@ class JunitAirgapPlugin : Plugin<Project> {
             configureJUnit4RuleInjection(project, extension)
         }
 
+        // 3. Summarize each test task's interceptions across its forks
+        if (extension.interceptionSummary.get()) {
+            configureInterceptionSummary(project)
+        }
+
         // 4. Handle Kotlin Multiplatform projects
         if (project.plugins.hasPlugin("org.jetbrains.kotlin.multiplatform")) {
             configureKmpProject(project, extension)
@@ -322,16 +327,87 @@ class JunitAirgapPlugin : Plugin<Project> {
                     )
 
                 if (nativeAgentPath != null) {
-                    // Add debug option if debug mode is enabled
-                    val agentArg =
-                        if (extension.debug.get()) {
-                            "-agentpath:$nativeAgentPath=debug"
+                    // Agent options: debug mode, libc-level interception, interception metrics, Netty native
+                    // transport binds, the precompiled policy image for early enforcement, and the shared
+                    // interception event ring
+                    val agentOptions = mutableListOf<String>()
+                    if (extension.debug.get()) {
+                        agentOptions += "debug"
+                    }
+                    if (extension.interceptNativeLibraries.get()) {
+                        agentOptions += "libc"
+                    }
+                    if (extension.collectInterceptionMetrics.get()) {
+                        agentOptions += "metrics"
+                    }
+                    if (NettyTransportDetector.hasNativeTransport(classpath)) {
+                        agentOptions += NettyTransportDetector.AGENT_OPTION
+                    }
+                    if (extension.enforceFromJvmStart.get()) {
+                        val policyImage =
+                            PolicyImageWriter.write(
+                                File(buildDirectory, "junit-airgap/policy/$testTaskName.policy"),
+                                extension.allowedHosts.get() + LOOPBACK_HOSTS,
+                                extension.blockedHosts.get(),
+                            )
+                        if (policyImage.absolutePath.contains(',')) {
+                            logger.warn(
+                                "Policy image path contains ',' and can't be passed to the JVMTI agent: " +
+                                    "${policyImage.absolutePath}. enforceFromJvmStart is ignored.",
+                            )
                         } else {
-                            "-agentpath:$nativeAgentPath"
+                            agentOptions += "policy=${policyImage.absolutePath}"
+                        }
+                    }
+                    if (extension.interceptionSummary.get()) {
+                        // One ring per run: the first fork's agent creates it, the rest append to it
+                        val eventsFile = interceptionEventsFile(buildDirectory, testTaskName)
+                        eventsFile.parentFile.mkdirs()
+                        eventsFile.delete()
+                        if (eventsFile.absolutePath.contains(',')) {
+                            logger.warn(
+                                "Interception events path contains ',' and can't be passed to the JVMTI agent: " +
+                                    "${eventsFile.absolutePath}. interceptionSummary is ignored.",
+                            )
+                        } else {
+                            agentOptions += "events=${eventsFile.absolutePath}"
+                        }
+                    }
+
+                    val attachOnDemand = extension.attachNativeAgentOnDemand.get()
+                    if (attachOnDemand && extension.enforceFromJvmStart.get()) {
+                        logger.warn(
+                            "attachNativeAgentOnDemand is ignored for test task '$testTaskName': " +
+                                "enforceFromJvmStart needs the JVMTI agent from JVM start.",
+                        )
+                    }
+
+                    if (attachOnDemand && !extension.enforceFromJvmStart.get()) {
+                        // NetworkBlockerContext attaches the agent through the Attach API on the first
+                        // setConfiguration(); the JVM only allows that with allowAttachSelf
+                        systemProperty("junit.airgap.nativeAgentPath", nativeAgentPath)
+                        systemProperty("junit.airgap.nativeAgentOptions", agentOptions.joinToString(","))
+                        jvmArgs("-Djdk.attach.allowAttachSelf=true")
+                        if (javaLauncher.get().metadata.languageVersion.asInt() >= 21) {
+                            // Silences the JDK 21+ warning about dynamically loaded agents
+                            jvmArgs("-XX:+EnableDynamicAgentLoading")
+                        }
+                        if (extension.debug.get()) {
+                            logger.debug(
+                                "[junit-airgap:plugin] Attaching JVMTI native agent on demand: $nativeAgentPath",
+                            )
+                        }
+                    } else {
+                        val agentArg =
+                            if (agentOptions.isNotEmpty()) {
+                                "-agentpath:$nativeAgentPath=${agentOptions.joinToString(",")}"
+                            } else {
+                                "-agentpath:$nativeAgentPath"
+                            }
+                        jvmArgs(agentArg)
+                        if (extension.debug.get()) {
+                            logger.debug("[junit-airgap:plugin] Loading JVMTI native agent from: $nativeAgentPath")
                         }
-                    jvmArgs(agentArg)
-                    if (extension.debug.get()) {
-                        logger.debug("[junit-airgap:plugin] Loading JVMTI native agent from: $nativeAgentPath")
                     }
                 } else {
                     logger.warn(
@@ -680,6 +756,27 @@ class JunitAirgapPlugin : Plugin<Project> {
         )
     }
 
+    /**
+     * Register a `<testTask>AirgapSummary` task per test task, run as its finalizer.
+     */
+    private fun configureInterceptionSummary(project: Project) {
+        val buildDirectory =
+            project.layout.buildDirectory
+                .get()
+                .asFile
+        project.tasks.withType<Test>().names.toList().forEach { testTaskName ->
+            val summaryTaskName = "${testTaskName}AirgapSummary"
+            project.tasks.register(summaryTaskName, SummarizeInterceptionsTask::class.java) {
+                eventsFile.set(interceptionEventsFile(buildDirectory, testTaskName))
+                this.testTaskName.set(testTaskName)
+                summaryFile.set(
+                    project.layout.buildDirectory.file("reports/junit-airgap/$testTaskName/interceptions.txt"),
+                )
+            }
+            configureTaskWiring(project, testTaskName, finalizedByTask = summaryTaskName)
+        }
+    }
+
     private fun configureTaskWiring(
         project: Project,
         taskName: String,
@@ -696,4 +793,20 @@ class JunitAirgapPlugin : Plugin<Project> {
             project.logger.debug("[junit-airgap:plugin] Task $taskName not found, skipping wiring: ${e.message}")
         }
     }
+
+    private companion object {
+        /**
+         * Shared ring file the forks of a test task append their interceptions to.
+         */
+        fun interceptionEventsFile(
+            buildDirectory: File,
+            testTaskName: String,
+        ): File = File(buildDirectory, "junit-airgap/events/$testTaskName.events")
+
+        /**
+         * Always allowed by the policy image: the test worker's connection to the Gradle daemon.
+         * IPv6 is in the agent's uncompressed form (as InetAddress.getHostAddress() formats it).
+         */
+        val LOOPBACK_HOSTS = listOf("localhost", "127.0.0.1", "0:0:0:0:0:0:0:1")
+    }
 }
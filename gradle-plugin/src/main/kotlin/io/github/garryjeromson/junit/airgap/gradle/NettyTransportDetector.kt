@@ -0,0 +1,35 @@
+package io.github.garryjeromson.junit.airgap.gradle
+
+import java.io.File
+
+/**
+ * Detects Netty's native transports on a test classpath.
+ *
+ * Their JNI libraries register natives when the transport is first used, usually after the JVMTI
+ * agent has switched off native method bind events. When a transport is present the plugin asks
+ * the agent to keep bind events on until Netty's connect native is bound
+ * (requiredBinds=connect+dns+netty), so connects through epoll/kqueue are intercepted too.
+ */
+object NettyTransportDetector {
+    /**
+     * JAR name prefixes of artifacts that ship a Netty native transport (unshaded or shaded).
+     */
+    private val TRANSPORT_ARTIFACTS =
+        listOf(
+            "netty-transport-native-epoll",
+            "netty-transport-native-kqueue",
+            "netty-transport-classes-epoll",
+            "netty-transport-classes-kqueue",
+            "grpc-netty-shaded",
+        )
+
+    /**
+     * Agent option that keeps bind events on until the Netty natives are bound.
+     */
+    const val AGENT_OPTION = "requiredBinds=connect+dns+netty"
+
+    fun hasNativeTransport(classpath: Iterable<File>): Boolean =
+        classpath.any { file ->
+            TRANSPORT_ARTIFACTS.any { artifact -> file.name.startsWith("$artifact-") }
+        }
+}
@@ -0,0 +1,208 @@
+package io.github.garryjeromson.junit.airgap.gradle
+
+import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.nio.file.Files
+import java.nio.file.StandardCopyOption
+
+/**
+ * Compiles host lists into the JVMTI agent's binary policy image.
+ *
+ * The agent maps the image read-only (policy=<file> agent option), so every forked test JVM
+ * shares the same page-cache pages and enforces the policy from its first connection, without
+ * parsing or compiling anything. The format is documented in native/include/policy_image.h and
+ * must stay in sync with it.
+ */
+object PolicyImageWriter {
+    private val MAGIC = "AIRGAPPI".toByteArray(Charsets.US_ASCII)
+    private const val VERSION = 2
+    private const val HEADER_SIZE = 56
+    private const val MATCH_ALL = 1
+    private const val MAX_PATTERN_LENGTH = 0xFFFF
+
+    /**
+     * One host list, split by shape exactly like the agent's HostPatternSet::Add().
+     * CIDR candidates ('/' and no '*') go to the range list, which the agent compiles at load.
+     */
+    private class PatternSet(
+        patterns: List<String>,
+    ) {
+        var matchAll = false
+        val exact = linkedSetOf<String>()
+        val suffixes = linkedSetOf<String>()
+        val globs = linkedSetOf<String>()
+        val ranges = linkedSetOf<String>()
+
+        init {
+            for (pattern in normalize(patterns)) {
+                val firstStar = pattern.indexOf('*')
+                when {
+                    pattern == "*" -> matchAll = true
+                    firstStar < 0 && '/' in pattern -> ranges += pattern
+                    firstStar < 0 -> exact += pattern
+                    firstStar == 0 && pattern.indexOf('*', 1) < 0 -> suffixes += pattern.substring(1)
+                    else -> globs += pattern
+                }
+            }
+        }
+
+        val bucketCount: Int
+            get() = if (exact.isEmpty()) 0 else Integer.highestOneBit(exact.size * 2 - 1) shl 1
+
+        val tablesSize: Int
+            get() = 4 + bucketCount * 8 + 4 + suffixes.size * 4 + 4 + globs.size * 4 + 4 + ranges.size * 4
+
+        val strings: Sequence<String>
+            get() = exact.asSequence() + suffixes.asSequence() + globs.asSequence() + ranges.asSequence()
+    }
+
+    /**
+     * Encode an image for the given host lists.
+     *
+     * Patterns are trimmed, comma-separated entries are split, and an ASCII lowercase is
+     * applied, matching how the library parses junit.airgap.allowedHosts / blockedHosts and
+     * how the agent normalizes hosts.
+     */
+    fun encode(
+        allowedHosts: List<String>,
+        blockedHosts: List<String>,
+    ): ByteArray {
+        val sets = listOf(PatternSet(allowedHosts), PatternSet(blockedHosts))
+
+        // Layout: header, then each set's tables, then the string pool
+        var offset = HEADER_SIZE
+        val tableOffsets =
+            sets.map { set ->
+                offset.also { offset += set.tablesSize }
+            }
+
+        val stringOffsets = LinkedHashMap<String, Int>()
+        for (string in sets.asSequence().flatMap { it.strings }) {
+            if (string !in stringOffsets) {
+                stringOffsets[string] = offset
+                offset += 2 + string.toByteArray(Charsets.UTF_8).size
+            }
+        }
+
+        val buffer = ByteBuffer.allocate(offset).order(ByteOrder.LITTLE_ENDIAN)
+        buffer.put(MAGIC)
+        buffer.putInt(VERSION)
+        buffer.putInt(offset)
+
+        sets.forEachIndexed { index, set ->
+            val exactTable = tableOffsets[index]
+            val suffixList = exactTable + 4 + set.bucketCount * 8
+            val globList = suffixList + 4 + set.suffixes.size * 4
+            val rangeList = globList + 4 + set.globs.size * 4
+            buffer.putInt(if (set.matchAll) MATCH_ALL else 0)
+            buffer.putInt(exactTable)
+            buffer.putInt(suffixList)
+            buffer.putInt(globList)
+            buffer.putInt(rangeList)
+        }
+
+        for (set in sets) {
+            writeExactTable(buffer, set, stringOffsets)
+            writeStringList(buffer, set.suffixes, stringOffsets)
+            writeStringList(buffer, set.globs, stringOffsets)
+            writeStringList(buffer, set.ranges, stringOffsets)
+        }
+
+        for (string in stringOffsets.keys) {
+            val bytes = string.toByteArray(Charsets.UTF_8)
+            buffer.putShort(bytes.size.toShort())
+            buffer.put(bytes)
+        }
+
+        return buffer.array()
+    }
+
+    /**
+     * Write the image for the given host lists to a file.
+     *
+     * The file is only replaced (atomically) when its content changes, so test JVMs that are
+     * already running keep a consistent mapping, and unchanged builds keep the same pages.
+     *
+     * @return The image file
+     */
+    fun write(
+        file: File,
+        allowedHosts: List<String>,
+        blockedHosts: List<String>,
+    ): File {
+        val image = encode(allowedHosts, blockedHosts)
+        if (file.isFile && file.readBytes().contentEquals(image)) {
+            return file
+        }
+
+        file.parentFile.mkdirs()
+        val temp = File.createTempFile(file.name, ".tmp", file.parentFile)
+        try {
+            temp.writeBytes(image)
+            Files.move(temp.toPath(), file.toPath(), StandardCopyOption.ATOMIC_MOVE)
+        } finally {
+            temp.delete()
+        }
+        return file
+    }
+
+    /**
+     * 32-bit FNV-1a, the hash the agent uses for the exact table.
+     */
+    internal fun hash(bytes: ByteArray): Int {
+        var hash = 0x811c9dc5.toInt()
+        for (byte in bytes) {
+            hash = (hash xor (byte.toInt() and 0xff)) * 0x01000193
+        }
+        return hash
+    }
+
+    private fun normalize(patterns: List<String>): List<String> =
+        patterns
+            .flatMap { it.split(",") }
+            .map { it.trim() }
+            .filter { it.isNotEmpty() }
+            .map { pattern -> buildString { pattern.forEach { append(if (it in 'A'..'Z') it + 32 else it) } } }
+            .onEach {
+                require(it.toByteArray(Charsets.UTF_8).size <= MAX_PATTERN_LENGTH) { "Host pattern too long: $it" }
+            }
+
+    private fun writeExactTable(
+        buffer: ByteBuffer,
+        set: PatternSet,
+        stringOffsets: Map<String, Int>,
+    ) {
+        val bucketCount = set.bucketCount
+        val hashes = IntArray(bucketCount)
+        val offsets = IntArray(bucketCount)
+
+        // Linear probing; at least half the buckets stay empty, so every probe terminates
+        for (pattern in set.exact) {
+            val hash = hash(pattern.toByteArray(Charsets.UTF_8))
+            var bucket = hash and (bucketCount - 1)
+            while (offsets[bucket] != 0) {
+                bucket = (bucket + 1) and (bucketCount - 1)
+            }
+            hashes[bucket] = hash
+            offsets[bucket] = stringOffsets.getValue(pattern)
+        }
+
+        buffer.putInt(bucketCount)
+        for (bucket in 0 until bucketCount) {
+            buffer.putInt(hashes[bucket])
+            buffer.putInt(offsets[bucket])
+        }
+    }
+
+    private fun writeStringList(
+        buffer: ByteBuffer,
+        strings: Set<String>,
+        stringOffsets: Map<String, Int>,
+    ) {
+        buffer.putInt(strings.size)
+        for (string in strings) {
+            buffer.putInt(stringOffsets.getValue(string))
+        }
+    }
+}
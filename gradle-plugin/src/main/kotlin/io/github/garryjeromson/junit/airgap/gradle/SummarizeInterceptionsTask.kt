@@ -0,0 +1,80 @@
+package io.github.garryjeromson.junit.airgap.gradle
+
+import org.gradle.api.DefaultTask
+import org.gradle.api.file.RegularFileProperty
+import org.gradle.api.provider.Property
+import org.gradle.api.tasks.Input
+import org.gradle.api.tasks.InputFiles
+import org.gradle.api.tasks.OutputFile
+import org.gradle.api.tasks.PathSensitive
+import org.gradle.api.tasks.PathSensitivity
+import org.gradle.api.tasks.TaskAction
+
+/**
+ * Gradle task that aggregates the interceptions recorded by every fork of a test task into one summary.
+ *
+ * Runs as the test task's finalizer. The forks' JVMTI agents append to a shared ring file
+ * ([InterceptionEventRing]); this task reads it once, logs the totals and writes the full summary
+ * to [summaryFile].
+ *
+ * Configuration cache compatible: All inputs use Property APIs.
+ */
+abstract class SummarizeInterceptionsTask : DefaultTask() {
+    /**
+     * Ring file the test task's forks wrote (missing if no fork recorded anything)
+     */
+    @get:InputFiles
+    @get:PathSensitive(PathSensitivity.NONE)
+    abstract val eventsFile: RegularFileProperty
+
+    /**
+     * Name of the test task the events belong to
+     */
+    @get:Input
+    abstract val testTaskName: Property<String>
+
+    /**
+     * Output location for the summary
+     */
+    @get:OutputFile
+    abstract val summaryFile: RegularFileProperty
+
+    init {
+        group = "verification"
+        description = "Summarize the network interceptions recorded by all test forks"
+    }
+
+    @TaskAction
+    fun summarize() {
+        val events = eventsFile.get().asFile
+        val output = summaryFile.get().asFile
+        output.parentFile.mkdirs()
+
+        if (!events.isFile) {
+            output.writeText("No interceptions recorded for test task '${testTaskName.get()}'\n")
+            logger.info("[junit-airgap:plugin] No interception events file at ${events.absolutePath}")
+            return
+        }
+
+        val contents =
+            try {
+                InterceptionEventRing.read(events)
+            } catch (e: IllegalArgumentException) {
+                logger.warn("Can't read interception events file ${events.absolutePath}: ${e.message}")
+                return
+            }
+
+        val summary = InterceptionEventRing.summarize(testTaskName.get(), contents)
+        output.writeText(summary)
+
+        val blocked = contents.events.count { it.blocked }
+        val message =
+            "junit-airgap: ${contents.events.size} interceptions in test task '${testTaskName.get()}', " +
+                "$blocked blocked. Summary: ${output.absolutePath}"
+        if (blocked > 0) {
+            logger.lifecycle(message)
+        } else {
+            logger.info(message)
+        }
+    }
+}
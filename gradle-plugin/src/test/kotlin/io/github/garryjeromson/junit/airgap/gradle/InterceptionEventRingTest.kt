@@ -0,0 +1,154 @@
+package io.github.garryjeromson.junit.airgap.gradle
+
+import org.junit.jupiter.api.Test
+import org.junit.jupiter.api.assertThrows
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+/**
+ * Unit tests for reading the ring file written by the JVMTI agents (native/include/shared_event_ring.h).
+ */
+class InterceptionEventRingTest {
+    /**
+     * Writes records like the agent's RecordSharedEvent().
+     */
+    private class RingWriter(
+        private val capacity: Int,
+    ) {
+        val buffer: ByteBuffer =
+            ByteBuffer
+                .allocate(InterceptionEventRing.HEADER_SIZE + capacity * InterceptionEventRing.RECORD_SIZE)
+                .order(ByteOrder.LITTLE_ENDIAN)
+        private var next = 0L
+
+        init {
+            buffer.put("AIRGAPEV".toByteArray(Charsets.US_ASCII))
+            buffer.putInt(8, 1)
+            buffer.putInt(12, InterceptionEventRing.RECORD_SIZE)
+            buffer.putLong(16, capacity.toLong())
+        }
+
+        fun record(
+            pid: Int,
+            contextId: Long,
+            target: Int,
+            blocked: Boolean,
+            hostname: String?,
+            address: ByteArray?,
+            port: Int,
+        ) {
+            val index = next++
+            val slot = (index % capacity).toInt()
+            val record = InterceptionEventRing.HEADER_SIZE + slot * InterceptionEventRing.RECORD_SIZE
+            val host = hostname?.toByteArray(Charsets.UTF_8) ?: ByteArray(0)
+            buffer.putLong(record, index + 1)
+            buffer.putLong(record + 8, 1_700_000_000_000_000_000L + index)
+            buffer.putLong(record + 16, contextId)
+            buffer.putInt(record + 24, pid)
+            buffer.putShort(record + 28, port.toShort())
+            buffer.put(record + 30, target.toByte())
+            buffer.put(record + 31, (if (blocked) 1 else 0).toByte())
+            buffer.put(record + 32, InterceptionEventRing.PATH_NAMES.indexOf("policy").toByte())
+            buffer.put(record + 33, (address?.size ?: 0).toByte())
+            buffer.put(record + 34, host.size.toByte())
+            address?.forEachIndexed { i, byte -> buffer.put(record + 36 + i, byte) }
+            host.forEachIndexed { i, byte -> buffer.put(record + 52 + i, byte) }
+            buffer.putLong(24, next)
+        }
+
+        fun bytes(): ByteArray = buffer.array()
+    }
+
+    private val loopback = byteArrayOf(127, 0, 0, 1)
+
+    @Test
+    fun `decodes connect and DNS records`() {
+        val ring = RingWriter(capacity = 4)
+        val address = byteArrayOf(93, 184.toByte(), 216.toByte(), 34)
+        ring.record(pid = 100, contextId = 3, target = 0, blocked = true, "example.com", address, 443)
+        ring.record(pid = 101, contextId = 1, target = 4, blocked = false, "localhost", address = null, port = 0)
+
+        val contents = InterceptionEventRing.decode(ring.bytes())
+
+        assertEquals(0L, contents.overwritten)
+        assertEquals(2, contents.events.size)
+        val connect = contents.events[0]
+        assertEquals(100, connect.pid)
+        assertEquals(3L, connect.contextId)
+        assertEquals("NetConnect0", connect.target)
+        assertTrue(connect.blocked)
+        assertEquals("policy", connect.path)
+        assertEquals("93.184.216.34", connect.address)
+        assertEquals("example.com:443", connect.destination)
+        val lookup = contents.events[1]
+        assertEquals("Inet4LookupAllHostAddr", lookup.target)
+        assertNull(lookup.address)
+        assertEquals("localhost", lookup.destination)
+    }
+
+    @Test
+    fun `a wrapped ring keeps the newest records and counts the overwritten ones`() {
+        val ring = RingWriter(capacity = 2)
+        repeat(5) { ring.record(pid = 100, contextId = it.toLong(), target = 0, false, null, loopback, 8080 + it) }
+
+        val contents = InterceptionEventRing.decode(ring.bytes())
+
+        assertEquals(3L, contents.overwritten)
+        assertEquals(listOf(8083, 8084), contents.events.map { it.port })
+        assertEquals("127.0.0.1:8084", contents.events[1].destination)
+    }
+
+    @Test
+    fun `incomplete records are skipped`() {
+        val ring = RingWriter(capacity = 4)
+        ring.record(pid = 100, contextId = 1, target = 0, blocked = true, "example.com", loopback, 80)
+        ring.record(pid = 100, contextId = 1, target = 0, blocked = true, "example.org", loopback, 80)
+        ring.buffer.putLong(InterceptionEventRing.HEADER_SIZE + InterceptionEventRing.RECORD_SIZE, 0L)
+
+        val contents = InterceptionEventRing.decode(ring.bytes())
+
+        assertEquals(listOf("example.com:80"), contents.events.map { it.destination })
+        assertEquals(1L, contents.overwritten)
+    }
+
+    @Test
+    fun `rejects files that are not event rings`() {
+        val ring = RingWriter(capacity = 4).bytes()
+
+        assertThrows<IllegalArgumentException> { InterceptionEventRing.decode(ByteArray(16)) }
+        assertThrows<IllegalArgumentException> { InterceptionEventRing.decode(ring.copyOf(ring.size - 1)) }
+        assertThrows<IllegalArgumentException> {
+            InterceptionEventRing.decode(ring.copyOf().also { it[8] = 2 })
+        }
+    }
+
+    @Test
+    fun `summary groups destinations by verdict across forks and tests`() {
+        val ring = RingWriter(capacity = 8)
+        ring.record(pid = 100, contextId = 1, target = 0, blocked = true, "example.com", loopback, 443)
+        ring.record(pid = 101, contextId = 1, target = 0, blocked = true, "example.com", loopback, 443)
+        ring.record(pid = 101, contextId = 2, target = 3, blocked = true, "example.com", address = null, port = 0)
+        ring.record(pid = 100, contextId = 1, target = 0, blocked = false, "localhost", loopback, 8080)
+
+        val summary = InterceptionEventRing.summarize("test", InterceptionEventRing.decode(ring.bytes()))
+
+        assertEquals(
+            """
+            junit-airgap interceptions for test task 'test'
+              4 recorded from 2 fork(s), 3 blocked, 0 overwritten
+
+            Blocked:
+              example.com:443  2x  forks=2 tests=2  [NetConnect0]
+              example.com  1x  forks=1 tests=1  [Inet6LookupAllHostAddr]
+
+            Allowed:
+              localhost:8080  1x  forks=1 tests=1  [NetConnect0]
+
+            """.trimIndent(),
+            summary,
+        )
+    }
+}
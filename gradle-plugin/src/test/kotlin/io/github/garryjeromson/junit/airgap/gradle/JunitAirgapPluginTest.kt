@@ -288,6 +288,87 @@ class JunitAirgapPluginTest {
         )
     }
 
+    @Test
+    fun `plugin accepts on-demand native agent attach configuration`() {
+        buildFile.writeText(
+            """
+            plugins {
+                kotlin("jvm") version "2.1.0"
+                id("io.github.garry-jeromson.junit-airgap")
+            }
+
+            repositories {
+                mavenLocal()
+                mavenCentral()
+            }
+
+            junitAirgap {
+                attachNativeAgentOnDemand = true
+            }
+
+            tasks.register("printAttachSetting") {
+                doLast {
+                    println("attachNativeAgentOnDemand = ${'$'}{junitAirgap.attachNativeAgentOnDemand.get()}")
+                }
+            }
+            """.trimIndent(),
+        )
+
+        val result =
+            GradleRunner
+                .create()
+                .withProjectDir(testProjectDir)
+                .withArguments("printAttachSetting", "--stacktrace")
+                .withPluginClasspath()
+                .build()
+
+        assertTrue(
+            result.output.contains("attachNativeAgentOnDemand = true"),
+            "Should expose the attachNativeAgentOnDemand setting",
+        )
+    }
+
+    @Test
+    fun `plugin registers an interception summary task per test task`() {
+        buildFile.writeText(
+            """
+            plugins {
+                kotlin("jvm") version "2.1.0"
+                id("io.github.garry-jeromson.junit-airgap")
+            }
+
+            repositories {
+                mavenLocal()
+                mavenCentral()
+            }
+
+            junitAirgap {
+                interceptionSummary = true
+            }
+
+            tasks.register("printSummaryWiring") {
+                doLast {
+                    val finalizers = tasks.named("test").get().finalizedBy.getDependencies(null).map { it.name }
+                    println("test finalized by = ${'$'}finalizers")
+                }
+            }
+            """.trimIndent(),
+        )
+
+        val result =
+            GradleRunner
+                .create()
+                .withProjectDir(testProjectDir)
+                .withArguments("printSummaryWiring", "--stacktrace")
+                .withPluginClasspath()
+                .build()
+
+        assertTrue(
+            result.output.contains("test finalized by = [testAirgapSummary]"),
+            "Should finalize the test task with its interception summary task",
+        )
+    }
+
     @Test
     fun `plugin works with custom library version`() {
         buildFile.writeText(
@@ -0,0 +1,31 @@
+package io.github.garryjeromson.junit.airgap.gradle
+
+import org.junit.jupiter.api.Test
+import java.io.File
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+class NettyTransportDetectorTest {
+    @Test
+    fun `detects native transports and shaded grpc-netty`() {
+        assertTrue(
+            NettyTransportDetector.hasNativeTransport(
+                listOf(File("/cache/netty-transport-native-epoll-4.1.112.Final-linux-x86_64.jar")),
+            ),
+        )
+        assertTrue(NettyTransportDetector.hasNativeTransport(listOf(File("/cache/grpc-netty-shaded-1.66.0.jar"))))
+    }
+
+    @Test
+    fun `ignores the NIO-only Netty artifacts`() {
+        assertFalse(
+            NettyTransportDetector.hasNativeTransport(
+                listOf(
+                    File("/cache/netty-transport-4.1.112.Final.jar"),
+                    File("/cache/netty-transport-native-unix-common-4.1.112.Final.jar"),
+                    File("/cache/grpc-netty-1.66.0.jar"),
+                ),
+            ),
+        )
+    }
+}
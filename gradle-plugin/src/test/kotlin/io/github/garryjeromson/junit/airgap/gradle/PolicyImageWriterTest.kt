@@ -0,0 +1,126 @@
+package io.github.garryjeromson.junit.airgap.gradle
+
+import org.junit.jupiter.api.Test
+import org.junit.jupiter.api.io.TempDir
+import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+/**
+ * Unit tests for the policy image encoding read by the JVMTI agent (native/include/policy_image.h).
+ */
+class PolicyImageWriterTest {
+    @TempDir
+    lateinit var tempDir: File
+
+    /**
+     * Minimal reader for one pattern set, following the agent's lookup logic.
+     */
+    private class ImageReader(
+        bytes: ByteArray,
+    ) {
+        val buffer: ByteBuffer = ByteBuffer.wrap(bytes).order(ByteOrder.LITTLE_ENDIAN)
+
+        fun string(offset: Int): String {
+            val length = buffer.getShort(offset).toInt() and 0xffff
+            return String(buffer.array(), offset + 2, length, Charsets.UTF_8)
+        }
+
+        fun flags(setOffset: Int): Int = buffer.getInt(setOffset)
+
+        fun exactContains(
+            setOffset: Int,
+            host: String,
+        ): Boolean {
+            val table = buffer.getInt(setOffset + 4)
+            val bucketCount = buffer.getInt(table)
+            if (bucketCount == 0) {
+                return false
+            }
+            val hash = PolicyImageWriter.hash(host.toByteArray(Charsets.UTF_8))
+            var bucket = hash and (bucketCount - 1)
+            while (true) {
+                val stringOffset = buffer.getInt(table + 4 + bucket * 8 + 4)
+                if (stringOffset == 0) {
+                    return false
+                }
+                if (buffer.getInt(table + 4 + bucket * 8) == hash && string(stringOffset) == host) {
+                    return true
+                }
+                bucket = (bucket + 1) and (bucketCount - 1)
+            }
+        }
+
+        fun list(
+            setOffset: Int,
+            index: Int,
+        ): List<String> {
+            val list = buffer.getInt(setOffset + 8 + index * 4)
+            return (0 until buffer.getInt(list)).map { string(buffer.getInt(list + 4 + it * 4)) }
+        }
+    }
+
+    @Test
+    fun `header carries magic, version and file size`() {
+        val image = PolicyImageWriter.encode(listOf("localhost"), emptyList())
+        val buffer = ByteBuffer.wrap(image).order(ByteOrder.LITTLE_ENDIAN)
+
+        assertEquals("AIRGAPPI", String(image, 0, 8, Charsets.US_ASCII))
+        assertEquals(2, buffer.getInt(8))
+        assertEquals(image.size, buffer.getInt(12))
+    }
+
+    @Test
+    fun `patterns are classified like the native HostPatternSet`() {
+        val reader =
+            ImageReader(
+                PolicyImageWriter.encode(
+                    listOf("localhost", "127.0.0.1", "*.example.com", "api-*.svc.local", "10.0.0.0/8", "FD00::/8"),
+                    listOf("*"),
+                ),
+            )
+
+        assertTrue(reader.exactContains(16, "localhost"))
+        assertTrue(reader.exactContains(16, "127.0.0.1"))
+        assertFalse(reader.exactContains(16, "10.0.0.0/8"))
+        assertEquals(listOf(".example.com"), reader.list(16, 0))
+        assertEquals(listOf("api-*.svc.local"), reader.list(16, 1))
+        assertEquals(listOf("10.0.0.0/8", "fd00::/8"), reader.list(16, 2))
+        assertEquals(0, reader.flags(16))
+        assertEquals(1, reader.flags(36))
+    }
+
+    @Test
+    fun `patterns are trimmed, split on commas and lowercased`() {
+        val reader = ImageReader(PolicyImageWriter.encode(listOf(" LocalHost , Example.COM", ""), emptyList()))
+
+        assertTrue(reader.exactContains(16, "localhost"))
+        assertTrue(reader.exactContains(16, "example.com"))
+    }
+
+    @Test
+    fun `exact table keeps an empty bucket for every probe sequence`() {
+        val hosts = (1..100).map { "host-$it.internal" }
+        val image = PolicyImageWriter.encode(hosts, emptyList())
+        val reader = ImageReader(image)
+
+        hosts.forEach { assertTrue(reader.exactContains(16, it), "Should find $it") }
+        assertFalse(reader.exactContains(16, "missing.internal"))
+    }
+
+    @Test
+    fun `write leaves an unchanged image untouched`() {
+        val file = File(tempDir, "policy/test.policy")
+        PolicyImageWriter.write(file, listOf("localhost"), listOf("evil.com"))
+        file.setLastModified(0)
+
+        PolicyImageWriter.write(file, listOf("localhost"), listOf("evil.com"))
+
+        assertEquals(0L, file.lastModified())
+        assertContentEquals(PolicyImageWriter.encode(listOf("localhost"), listOf("evil.com")), file.readBytes())
+    }
+}
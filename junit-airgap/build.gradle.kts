@@ -203,6 +203,8 @@ kotlin.jvm().compilations.create("integrationTest") {
             implementation(libs.retrofit.converter.scalars)
             implementation(libs.reactor.netty.http)
             implementation("io.netty:netty-resolver-dns-native-macos:${libs.versions.netty.get()}:osx-aarch_64")
+            implementation("io.netty:netty-transport-native-epoll:${libs.versions.netty.get()}:linux-x86_64")
+            implementation("io.netty:netty-transport-native-epoll:${libs.versions.netty.get()}:linux-aarch_64")
             implementation(libs.spring.webflux)
             implementation(libs.spring.context)
             implementation(libs.openfeign.core)
@@ -329,7 +331,10 @@ tasks.register<Test>("integrationTest") {
     classpath = integrationCompilation.output.classesDirs + integrationCompilation.runtimeDependencyFiles
 
     shouldRunAfter(tasks.named("jvmTest"))
-    useJUnitPlatform()
+    useJUnitPlatform {
+        // Needs Netty's native transports enabled; run by nettyNativeIntegrationTest
+        excludeTags("netty-native")
+    }
 
     // Exclude Kotlin companion objects from test discovery
     exclude("**/*\$Companion.class")
@@ -367,6 +372,61 @@ tasks.register<Test>("integrationTest") {
     // This forces Reactor Netty and Spring WebClient to use the standard NIO transport.
     systemProperty("io.netty.transport.noNative", "true")
 
+    // Disable the JDK's address cache (as many test JVMs do) so every lookup reaches the
+    // agent's DNS wrappers - DnsResultCacheIntegrationTest relies on it
+    systemProperty("sun.net.inetaddr.ttl", "0")
+
+    testLogging {
+        events("failed")
+        showStandardStreams = false
+    }
+}
+
+// Create Netty native transport integration test task (JVM)
+// Runs the tests tagged netty-native with Netty's native transports enabled and the agent
+// waiting for Netty's natives, as the Gradle plugin configures it when a transport is present
+tasks.register<Test>("nettyNativeIntegrationTest") {
+    description = "Runs JVM integration tests through Netty's native transports"
+    group = "verification"
+
+    val integrationCompilation = kotlin.jvm().compilations.getByName("integrationTest")
+    testClassesDirs = integrationCompilation.output.classesDirs
+    classpath = integrationCompilation.output.classesDirs + integrationCompilation.runtimeDependencyFiles
+
+    shouldRunAfter(tasks.named("integrationTest"))
+    useJUnitPlatform {
+        includeTags("netty-native")
+    }
+
+    // Exclude Kotlin companion objects from test discovery
+    exclude("**/*\$Companion.class")
+
+    // Use Java 21 toolchain (native agent built with Java 21)
+    javaLauncher.set(
+        javaToolchains.launcherFor {
+            languageVersion.set(JavaLanguageVersion.of(21))
+        },
+    )
+
+    // Capture file references at configuration time for configuration cache compatibility
+    val agentFile = project.file("../native/build/${getNativeAgentLibraryName()}")
+    val agentPath = agentFile.absolutePath
+
+    doFirst {
+        if (!agentFile.exists()) {
+            logger.warn("JVMTI agent not found at: $agentPath")
+            logger.warn("Run 'make build-native' to build the native agent.")
+            logger.warn("Integration tests will fail without the agent.")
+        }
+    }
+
+    // Same option as NettyTransportDetector.AGENT_OPTION in the Gradle plugin
+    jvmArgs("-agentpath:$agentPath=requiredBinds=connect+dns+netty")
+
+    val debugProperty = System.getProperty("junit.airgap.debug") ?: "false"
+    systemProperty("junit.airgap.debug", debugProperty)
+    systemProperty("sun.net.inetaddr.ttl", "0")
+
     testLogging {
         events("failed")
         showStandardStreams = false
@@ -410,9 +470,37 @@ tasks.register<Exec>("cmakeConfigureNativeAgent") {
     inputs.files(
         "../native/CMakeLists.txt",
         "../native/include/agent.h",
+        "../native/include/agent_options.h",
+        "../native/include/host_policy.h",
+        "../native/include/verdict_cache.h",
+        "../native/include/inet_address.h",
+        "../native/include/dns_binding_table.h",
+        "../native/include/dns_result_cache.h",
+        "../native/include/host_overrides.h",
+        "../native/include/trace_buffer.h",
+        "../native/include/log_sink.h",
+        "../native/include/policy_image.h",
+        "../native/include/libc_interceptor.h",
+        "../native/include/intercept_targets.h",
+        "../native/include/interception_metrics.h",
+        "../native/include/shared_event_ring.h",
+        "../native/include/interceptor.h",
         "../native/src/agent.cpp",
+        "../native/src/agent_options.cpp",
         "../native/src/socket_interceptor.cpp",
         "../native/src/dns_interceptor.cpp",
+        "../native/src/host_policy.cpp",
+        "../native/src/verdict_cache.cpp",
+        "../native/src/inet_address.cpp",
+        "../native/src/dns_binding_table.cpp",
+        "../native/src/dns_result_cache.cpp",
+        "../native/src/host_overrides.cpp",
+        "../native/src/trace_buffer.cpp",
+        "../native/src/log_sink.cpp",
+        "../native/src/policy_image.cpp",
+        "../native/src/libc_interceptor.cpp",
+        "../native/src/interception_metrics.cpp",
+        "../native/src/shared_event_ring.cpp",
     )
     outputs.dir("../native/build")
 }
@@ -430,8 +518,37 @@ tasks.register<Exec>("buildNativeAgent") {
     // Input: all source files
     inputs.files(
         "../native/include/agent.h",
+        "../native/include/agent_options.h",
+        "../native/include/host_policy.h",
+        "../native/include/verdict_cache.h",
+        "../native/include/inet_address.h",
+        "../native/include/dns_binding_table.h",
+        "../native/include/dns_result_cache.h",
+        "../native/include/host_overrides.h",
+        "../native/include/trace_buffer.h",
+        "../native/include/log_sink.h",
+        "../native/include/policy_image.h",
+        "../native/include/libc_interceptor.h",
+        "../native/include/intercept_targets.h",
+        "../native/include/interception_metrics.h",
+        "../native/include/shared_event_ring.h",
+        "../native/include/interceptor.h",
         "../native/src/agent.cpp",
+        "../native/src/agent_options.cpp",
         "../native/src/socket_interceptor.cpp",
+        "../native/src/dns_interceptor.cpp",
+        "../native/src/host_policy.cpp",
+        "../native/src/verdict_cache.cpp",
+        "../native/src/inet_address.cpp",
+        "../native/src/dns_binding_table.cpp",
+        "../native/src/dns_result_cache.cpp",
+        "../native/src/host_overrides.cpp",
+        "../native/src/trace_buffer.cpp",
+        "../native/src/log_sink.cpp",
+        "../native/src/policy_image.cpp",
+        "../native/src/libc_interceptor.cpp",
+        "../native/src/interception_metrics.cpp",
+        "../native/src/shared_event_ring.cpp",
     )
 
     // Output: the built native library (platform-specific)
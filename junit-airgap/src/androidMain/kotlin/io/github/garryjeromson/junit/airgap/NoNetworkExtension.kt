@@ -186,18 +186,12 @@ class AirgapExtension(
             annotations.addAll(clazz.annotations)
         }
 
-        // Build configuration from annotations
-        val annotationConfig = NetworkConfiguration.fromAnnotations(annotations)
-
-        // Read global configuration from system properties
-        val globalConfig =
-            NetworkConfiguration(
-                allowedHosts = ExtensionConfiguration.getAllowedHosts(),
-                blockedHosts = ExtensionConfiguration.getBlockedHosts(),
-            )
-
-        // Merge configurations - annotation-level takes precedence for blocked hosts,
-        // but allowed hosts are combined
-        return globalConfig.merge(annotationConfig)
+        // Merge with the global configuration from system properties - blocked and allowed hosts
+        // are combined. Resolved once per distinct annotations, so the tests of a class share one.
+        return NetworkConfiguration.resolve(
+            annotations,
+            globalAllowedHosts = ExtensionConfiguration.getAllowedHosts(),
+            globalBlockedHosts = ExtensionConfiguration.getBlockedHosts(),
+        )
     }
 }
@@ -63,6 +63,43 @@ annotation class BlockRequestsToHosts(
 @Retention(AnnotationRetention.RUNTIME)
 annotation class AllowNetworkRequests
 
+/**
+ * Annotation to let the JVMTI agent cache DNS results of allowed hosts during a test.
+ *
+ * Test JVMs often disable the JDK's own address cache, so every `InetAddress.getByName("localhost")`
+ * goes to the platform resolver. With this annotation, repeated lookups of hosts allowed by
+ * [AllowRequestsToHosts] return the addresses resolved first, without calling the resolver again.
+ * Cached results never outlive the test that resolved them. Blocked lookups are never cached.
+ *
+ * Has no effect without the JVMTI agent.
+ *
+ * @param ttlMillis How long a resolved result is reused, in milliseconds
+ */
+@Target(AnnotationTarget.FUNCTION, AnnotationTarget.CLASS)
+@Retention(AnnotationRetention.RUNTIME)
+annotation class CacheDnsResults(
+    val ttlMillis: Long = 60_000,
+)
+
+/**
+ * Annotation to resolve hostnames to fixed addresses during a test, without DNS.
+ *
+ * Useful for hosts the test points at a local fake, e.g. `api.internal` served by a WireMock instance on
+ * 127.0.0.1. The JVMTI agent answers lookups of a mapped hostname with the given address; the system
+ * resolver is never called and no `/etc/hosts` entry is needed. Mapped hostnames are allowed (unless also
+ * listed in [BlockRequestsToHosts]).
+ *
+ * Requires the JVMTI agent.
+ *
+ * @param mappings "hostname=address" pairs, where address is an IPv4 or IPv6 literal
+ * (e.g., "api.internal=127.0.0.1", "ipv6.internal=::1").
+ */
+@Target(AnnotationTarget.FUNCTION, AnnotationTarget.CLASS)
+@Retention(AnnotationRetention.RUNTIME)
+annotation class OverrideHosts(
+    val mappings: Array<String>,
+)
+
 // ============================================================================
 // Deprecated: Type aliases for backward compatibility
 // ============================================================================
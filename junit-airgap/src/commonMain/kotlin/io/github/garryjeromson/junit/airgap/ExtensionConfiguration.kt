@@ -24,6 +24,40 @@ internal const val ALLOWED_HOSTS_PROPERTY: String = "junit.airgap.allowedHosts"
  */
 internal const val BLOCKED_HOSTS_PROPERTY: String = "junit.airgap.blockedHosts"
 
+/**
+ * System property key for throwing blocked-request exceptions without a stack trace.
+ * Set to "true" to enable: -Djunit.airgap.stacklessExceptions=true
+ *
+ * Speeds up suites that assert blocking in a loop; the exception message still names the host,
+ * port and caller. Leave it off to see where a blocked request came from.
+ */
+internal const val STACKLESS_EXCEPTIONS_PROPERTY: String = "junit.airgap.stacklessExceptions"
+
+/**
+ * System property key for applying the active configuration to every thread in the JVM.
+ * Set to "true" to enable: -Djunit.airgap.sharedConfiguration=true
+ *
+ * The configuration becomes one JVM-wide test context instead of inheritable thread-local state,
+ * so virtual threads carry no copy of it and the JVMTI agent needs no per-thread check. Only use
+ * it when tests don't run in parallel within one JVM.
+ */
+internal const val SHARED_CONFIGURATION_PROPERTY: String = "junit.airgap.sharedConfiguration"
+
+/**
+ * System property key for attaching the JVMTI agent on demand instead of at JVM start.
+ * Path to the agent library: -Djunit.airgap.nativeAgentPath=/path/to/libjunit-airgap-agent.so
+ *
+ * The agent is attached through the Attach API when the first test configuration is set, so a
+ * test JVM that never blocks anything doesn't load it. Needs -Djdk.attach.allowAttachSelf=true.
+ */
+internal const val NATIVE_AGENT_PATH_PROPERTY: String = "junit.airgap.nativeAgentPath"
+
+/**
+ * System property key for the options passed to an on-demand attached JVMTI agent.
+ * Same syntax as after -agentpath:<path>= : -Djunit.airgap.nativeAgentOptions=debug,libc
+ */
+internal const val NATIVE_AGENT_OPTIONS_PROPERTY: String = "junit.airgap.nativeAgentOptions"
+
 /**
  * Configuration helper for the NoNetwork extension.
  * This object centralizes configuration logic for determining whether network blocking
@@ -37,6 +71,36 @@ internal object ExtensionConfiguration {
      */
     fun isApplyToAllTestsEnabled(): Boolean = (System.getProperty(APPLY_TO_ALL_TESTS_PROPERTY) ?: "false").toBoolean()
 
+    /**
+     * Checks if blocked requests should throw stackless exceptions based on system property.
+     *
+     * @return true if the system property is set to "true", false otherwise
+     */
+    fun isStacklessExceptionsEnabled(): Boolean =
+        (System.getProperty(STACKLESS_EXCEPTIONS_PROPERTY) ?: "false").toBoolean()
+
+    /**
+     * Checks if the active configuration should apply to every thread based on system property.
+     *
+     * @return true if the system property is set to "true", false otherwise
+     */
+    fun isSharedConfigurationEnabled(): Boolean =
+        (System.getProperty(SHARED_CONFIGURATION_PROPERTY) ?: "false").toBoolean()
+
+    /**
+     * Retrieves the path of the JVMTI agent to attach on demand from system property.
+     *
+     * @return Agent library path, or null if the agent is not attached on demand
+     */
+    fun getNativeAgentPath(): String? = System.getProperty(NATIVE_AGENT_PATH_PROPERTY)?.takeIf { it.isNotBlank() }
+
+    /**
+     * Retrieves the options for an on-demand attached JVMTI agent from system property.
+     *
+     * @return Agent options string, empty if not configured
+     */
+    fun getNativeAgentOptions(): String = System.getProperty(NATIVE_AGENT_OPTIONS_PROPERTY) ?: ""
+
     /**
      * Retrieves the list of globally allowed hosts from system property.
      *
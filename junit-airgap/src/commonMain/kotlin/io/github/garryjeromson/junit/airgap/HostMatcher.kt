@@ -0,0 +1,307 @@
+package io.github.garryjeromson.junit.airgap
+
+/**
+ * Compiled form of a host pattern list ([NetworkConfiguration.allowedHosts] or
+ * [NetworkConfiguration.blockedHosts]).
+ *
+ * Patterns are compiled once per distinct pattern set ([of]), and split by shape so a
+ * check costs O(label count) for the common cases instead of a regex per pattern:
+ * - "*" → matches every host
+ * - Exact names ("localhost", "127.0.0.1") → hash set
+ * - "*.example.com" → suffix trie of reversed labels (com → example)
+ * - CIDR ranges ("10.0.0.0/8", "fd00::/8") → binary radix tree per address family,
+ *   matched against hosts that are IP literals
+ * - Any other pattern with '*' → glob, where '*' matches any run of characters
+ *
+ * The JVMTI agent compiles the same [patterns] with the same rules (HostPatternSet in
+ * native/include/host_policy.h), so both enforcement paths agree on every host.
+ *
+ * @param rawPatterns Host patterns; compared case-insensitively, empty ones are ignored
+ */
+internal class HostMatcher(
+    rawPatterns: Collection<String>,
+) {
+    /**
+     * Normalized (lowercase, deduplicated) patterns, as pushed to the JVMTI agent.
+     */
+    val patterns: List<String> = rawPatterns.map { it.lowercase() }.filter { it.isNotEmpty() }.distinct()
+
+    private var matchAll = false
+    private val exact = HashSet<String>()
+    private val suffixes = LabelNode()
+    private val globs = ArrayList<String>()
+    private val ipv4Ranges = RangeNode()
+    private val ipv6Ranges = RangeNode()
+    private var hasSuffixes = false
+    private var hasRanges = false
+
+    /**
+     * One label of the suffix trie; [wildcard] marks the end of a "*.labels" pattern.
+     */
+    private class LabelNode {
+        val children = HashMap<String, LabelNode>()
+        var wildcard = false
+    }
+
+    /**
+     * One bit of the radix tree; [terminal] marks the end of a range's prefix.
+     */
+    private class RangeNode {
+        val children = arrayOfNulls<RangeNode>(2)
+        var terminal = false
+    }
+
+    init {
+        for (pattern in patterns) {
+            val firstStar = pattern.indexOf('*')
+            val range = if (firstStar < 0) parseCidr(pattern) else null
+            when {
+                pattern == "*" -> matchAll = true
+                range != null -> addRange(range.first, range.second)
+                firstStar < 0 -> exact += pattern
+                pattern.startsWith("*.") && pattern.indexOf('*', 1) < 0 -> addSuffix(pattern.substring(2))
+                else -> globs += pattern
+            }
+        }
+    }
+
+    /**
+     * Check if a host matches any pattern.
+     *
+     * @param host Lowercase hostname or IP address
+     */
+    fun matches(host: String): Boolean {
+        if (matchAll || host in exact) {
+            return true
+        }
+        if (hasSuffixes && matchesSuffix(host)) {
+            return true
+        }
+        if (hasRanges && matchesRange(host)) {
+            return true
+        }
+        return globs.any { globMatches(it, host) }
+    }
+
+    private fun addSuffix(labels: String) {
+        var node = suffixes
+        for (label in labels.split('.').asReversed()) {
+            node = node.children.getOrPut(label) { LabelNode() }
+        }
+        node.wildcard = true
+        hasSuffixes = true
+    }
+
+    /**
+     * Walk the host's labels from the right; a wildcard node matches if at least one label is left.
+     */
+    private fun matchesSuffix(host: String): Boolean {
+        var node = suffixes
+        var end = host.length
+        while (true) {
+            val dot = host.lastIndexOf('.', end - 1)
+            if (dot < 0) {
+                return false
+            }
+            node = node.children[host.substring(dot + 1, end)] ?: return false
+            if (node.wildcard) {
+                return true
+            }
+            end = dot
+        }
+    }
+
+    private fun addRange(
+        address: ByteArray,
+        prefixBits: Int,
+    ) {
+        var node = if (address.size == 4) ipv4Ranges else ipv6Ranges
+        for (bit in 0 until prefixBits) {
+            if (node.terminal) {
+                // Already covered by a shorter range
+                return
+            }
+            val branch = addressBit(address, bit)
+            node = node.children[branch] ?: RangeNode().also { node.children[branch] = it }
+        }
+        node.terminal = true
+        hasRanges = true
+    }
+
+    private fun matchesRange(host: String): Boolean {
+        val address = parseIpAddress(host) ?: return false
+        var node: RangeNode? = if (address.size == 4) ipv4Ranges else ipv6Ranges
+        var bit = 0
+        while (node != null) {
+            if (node.terminal) {
+                return true
+            }
+            if (bit == address.size * 8) {
+                return false
+            }
+            node = node.children[addressBit(address, bit++)]
+        }
+        return false
+    }
+
+    companion object {
+        private val EMPTY = HostMatcher(emptyList())
+
+        /**
+         * Matchers compiled so far, keyed by their raw patterns. Every test of a class (and of
+         * classes with the same annotations) builds equal pattern sets, so they share one matcher.
+         */
+        private val compiled = InternCache<Set<String>, HostMatcher>(capacity = 256)
+
+        /**
+         * Get the matcher for [rawPatterns], compiling it only the first time these patterns are seen.
+         * Matchers are immutable once built, so one instance can serve any number of configurations.
+         */
+        fun of(rawPatterns: Set<String>): HostMatcher {
+            if (rawPatterns.isEmpty()) {
+                return EMPTY
+            }
+            compiled.get(rawPatterns)?.let { return it }
+            return HostMatcher(rawPatterns).also { compiled.put(rawPatterns.toSet(), it) }
+        }
+
+        private fun addressBit(
+            address: ByteArray,
+            bit: Int,
+        ): Int = (address[bit / 8].toInt() shr (7 - bit % 8)) and 1
+
+        /**
+         * Parse "address/prefix" with a decimal prefix of at most the address width.
+         *
+         * @return Address bytes and prefix length, or null if [pattern] is not a CIDR range
+         */
+        internal fun parseCidr(pattern: String): Pair<ByteArray, Int>? {
+            val slash = pattern.lastIndexOf('/')
+            val prefix = pattern.substring(slash + 1)
+            if (slash < 0 || prefix.isEmpty() || prefix.length > 3 || !prefix.all { it in '0'..'9' }) {
+                return null
+            }
+            val address = parseIpAddress(pattern.substring(0, slash)) ?: return null
+            val prefixBits = prefix.toInt()
+            return if (prefixBits <= address.size * 8) address to prefixBits else null
+        }
+
+        /**
+         * Parse an IP literal host ("10.1.2.3", "::1", "[::1]", "fe80::1%eth0") like the agent's
+         * inet_pton()-based ParseIpLiteral(): brackets and an IPv6 zone are stripped, IPv4 parts
+         * must be decimal without leading zeros.
+         *
+         * @return 4 or 16 address bytes in network order, or null if [host] is not an IP literal
+         */
+        internal fun parseIpAddress(host: String): ByteArray? {
+            val bracketed = host.length > 2 && host.startsWith('[') && host.endsWith(']')
+            val literal = if (bracketed) host.substring(1, host.length - 1) else host
+            return parseIpv4(literal) ?: parseIpv6(literal.substringBefore('%'))
+        }
+
+        private fun parseIpv4(text: String): ByteArray? {
+            val parts = text.split('.')
+            if (parts.size != 4) {
+                return null
+            }
+            val bytes = ByteArray(4)
+            parts.forEachIndexed { i, part ->
+                val decimal = part.isNotEmpty() && part.length <= 3 && part.all { it in '0'..'9' }
+                if (!decimal || (part.length > 1 && part[0] == '0')) {
+                    return null
+                }
+                val value = part.toInt()
+                if (value > 255) {
+                    return null
+                }
+                bytes[i] = value.toByte()
+            }
+            return bytes
+        }
+
+        private fun parseIpv6(text: String): ByteArray? {
+            if (':' !in text) {
+                return null
+            }
+            val compression = text.indexOf("::")
+            if (compression >= 0 && text.indexOf("::", compression + 1) >= 0) {
+                return null
+            }
+            val head = if (compression >= 0) text.substring(0, compression) else text
+            val tail = if (compression >= 0) text.substring(compression + 2) else ""
+            val headGroups = parseGroups(head, allowIpv4 = compression < 0) ?: return null
+            val tailGroups = parseGroups(tail, allowIpv4 = true) ?: return null
+
+            val groupCount = headGroups.size + tailGroups.size
+            if ((compression < 0 && groupCount != 8) || (compression >= 0 && groupCount > 7)) {
+                return null
+            }
+
+            val groups = headGroups + List(8 - groupCount) { 0 } + tailGroups
+            return ByteArray(16) { i -> (groups[i / 2] shr (if (i % 2 == 0) 8 else 0)).toByte() }
+        }
+
+        /**
+         * Parse colon-separated 16-bit hex groups; a trailing IPv4 literal counts as two groups.
+         */
+        private fun parseGroups(
+            text: String,
+            allowIpv4: Boolean,
+        ): List<Int>? {
+            if (text.isEmpty()) {
+                return emptyList()
+            }
+            val parts = text.split(':')
+            val groups = ArrayList<Int>(8)
+            parts.forEachIndexed { i, part ->
+                if (allowIpv4 && i == parts.lastIndex && '.' in part) {
+                    val ipv4 = parseIpv4(part) ?: return null
+                    groups += ((ipv4[0].toInt() and 0xff) shl 8) or (ipv4[1].toInt() and 0xff)
+                    groups += ((ipv4[2].toInt() and 0xff) shl 8) or (ipv4[3].toInt() and 0xff)
+                    return groups
+                }
+                if (part.isEmpty() || part.length > 4 || !part.all { it.isHexDigit() }) {
+                    return null
+                }
+                groups += part.toInt(16)
+            }
+            return groups
+        }
+
+        private fun Char.isHexDigit(): Boolean = this in '0'..'9' || this in 'a'..'f' || this in 'A'..'F'
+
+        /**
+         * Glob match where '*' matches any run of characters (including empty), like the agent's
+         * GlobMatches(): iterative with a single backtrack point.
+         */
+        internal fun globMatches(
+            pattern: String,
+            host: String,
+        ): Boolean {
+            var p = 0
+            var h = 0
+            var star = -1
+            var starHost = 0
+
+            while (h < host.length) {
+                if (p < pattern.length && pattern[p] == '*') {
+                    star = p++
+                    starHost = h
+                } else if (p < pattern.length && pattern[p] == host[h]) {
+                    p++
+                    h++
+                } else if (star >= 0) {
+                    p = star + 1
+                    h = ++starHost
+                } else {
+                    return false
+                }
+            }
+
+            while (p < pattern.length && pattern[p] == '*') {
+                p++
+            }
+            return p == pattern.length
+        }
+    }
+}
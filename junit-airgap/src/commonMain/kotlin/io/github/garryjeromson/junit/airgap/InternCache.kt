@@ -0,0 +1,37 @@
+package io.github.garryjeromson.junit.airgap
+
+import kotlin.concurrent.Volatile
+
+/**
+ * Small concurrent cache for values that are expensive to build from an immutable key, such as
+ * compiled host patterns ([HostMatcher.of]) or resolved test configurations ([NetworkConfiguration.resolve]).
+ *
+ * A lookup is one volatile read and a hash lookup, without locking. [put] copies the map, so this
+ * is meant for few distinct keys looked up once per test. Concurrent puts may drop an entry, which
+ * only means it is built again later. Once [capacity] keys are cached, the next put starts over
+ * instead of evicting.
+ *
+ * @param capacity Maximum number of cached keys
+ */
+internal class InternCache<K : Any, V : Any>(
+    private val capacity: Int,
+) {
+    @Volatile
+    private var entries: Map<K, V> = emptyMap()
+
+    /**
+     * Get the value cached for [key], or null.
+     */
+    fun get(key: K): V? = entries[key]
+
+    /**
+     * Cache [value] for [key], which must not change afterwards.
+     */
+    fun put(
+        key: K,
+        value: V,
+    ) {
+        val current = entries
+        entries = if (current.size >= capacity) mapOf(key to value) else current + (key to value)
+    }
+}
@@ -4,17 +4,29 @@ package io.github.garryjeromson.junit.airgap
  * Configuration for network request blocking behavior.
  *
  * @param allowedHosts Set of host names or patterns that are allowed. Use "*" to allow all hosts.
- *                     Patterns support wildcards (e.g., "*.example.com").
+ *                     Patterns support wildcards (e.g., "*.example.com") and CIDR ranges of
+ *                     IP addresses (e.g., "10.0.0.0/8", "fd00::/8").
  * @param blockedHosts Set of host names or patterns that are blocked. Blocked hosts take precedence
  *                     over allowed hosts.
+ * @param dnsCacheTtlMillis If positive, the JVMTI agent caches the addresses of allowed hostnames it
+ *                          resolves for this many milliseconds (never beyond the end of the test).
+ *                          0 disables the cache. See [CacheDnsResults].
+ * @param hostOverrides Hostnames the JVMTI agent resolves to a fixed IP address without DNS
+ *                      (e.g., "api.internal" to "127.0.0.1"). Overridden hosts are allowed unless
+ *                      blocked. See [OverrideHosts].
  */
 data class NetworkConfiguration(
     val allowedHosts: Set<String> = emptySet(),
     val blockedHosts: Set<String> = emptySet(),
+    val dnsCacheTtlMillis: Long = 0,
+    val hostOverrides: Map<String, String> = emptyMap(),
 ) {
     /**
-     * Generation counter to invalidate stale configurations in inherited threads.
-     * Used internally to handle InheritableThreadLocal persistence across test methods.
+     * ID of the test context this configuration was installed as by setConfiguration(). A new one
+     * per test, except that a test whose configuration equals the one of the test that just ended
+     * takes over its context, cached native decisions included. Used internally to invalidate
+     * stale configurations in inherited threads once their test ends, and by the JVMTI agent to
+     * pick the host policy of the calling thread's test.
      *
      * This is not part of the primary constructor to exclude it from equals(), hashCode(),
      * copy(), and other data class generated methods.
@@ -22,6 +34,15 @@ data class NetworkConfiguration(
     var generation: Long = 0
         internal set
 
+    /**
+     * [allowedHosts] and [blockedHosts] compiled once per distinct pattern set and shared by every
+     * configuration with the same patterns (see [HostMatcher.of]), so copy() doesn't recompile them.
+     * Like [generation], not part of the primary constructor, so they don't take part in equals().
+     */
+    internal val allowedMatcher = HostMatcher.of(allowedHosts)
+    internal val blockedMatcher = HostMatcher.of(blockedHosts)
+    private val overriddenHosts = hostOverrides.keys.mapTo(HashSet()) { it.lowercase() }
+
     /**
      * Checks if a given host is allowed based on the configuration.
      *
@@ -32,22 +53,36 @@ data class NetworkConfiguration(
         val normalizedHost = host.lowercase()
 
         // Check if host is explicitly blocked (blocked hosts take precedence)
-        if (matchesAnyPattern(normalizedHost, blockedHosts)) {
+        if (blockedMatcher.matches(normalizedHost)) {
             return false
         }
 
+        // Overridden hosts resolve to the test's own address, so they are allowed
+        if (normalizedHost in overriddenHosts) {
+            return true
+        }
+
         // Check if host is in allowed list
         if (allowedHosts.isEmpty()) {
             // No allowed hosts means block everything
             return false
         }
 
-        return matchesAnyPattern(normalizedHost, allowedHosts)
+        return allowedMatcher.matches(normalizedHost)
     }
 
+    /**
+     * Checks if a given host matches a pattern in [blockedHosts].
+     *
+     * @param host The host name or IP address to check
+     */
+    internal fun isExplicitlyBlocked(host: String): Boolean = blockedMatcher.matches(host.lowercase())
+
     /**
      * Merges this configuration with another configuration.
-     * The resulting configuration will have combined allowed and blocked hosts.
+     * The resulting configuration will have combined allowed and blocked hosts, the
+     * longer of the two DNS cache TTLs, and combined hosts overrides (the other
+     * configuration's mapping wins for a hostname in both).
      *
      * @param other The other configuration to merge with
      * @return A new NetworkConfiguration with combined settings
@@ -56,36 +91,53 @@ data class NetworkConfiguration(
         NetworkConfiguration(
             allowedHosts = this.allowedHosts + other.allowedHosts,
             blockedHosts = this.blockedHosts + other.blockedHosts,
+            dnsCacheTtlMillis = maxOf(this.dnsCacheTtlMillis, other.dnsCacheTtlMillis),
+            hostOverrides = this.hostOverrides + other.hostOverrides,
         )
 
-    private fun matchesAnyPattern(
-        host: String,
-        patterns: Set<String>,
-    ): Boolean =
-        patterns.any { pattern ->
-            matchesPattern(host, pattern.lowercase())
-        }
+    companion object {
+        /**
+         * Configurations built by [resolve], keyed by their annotations and global hosts.
+         */
+        private val resolved = InternCache<Triple<List<Annotation>, Set<String>, Set<String>>, NetworkConfiguration>(
+            capacity = 256,
+        )
 
-    private fun matchesPattern(
-        host: String,
-        pattern: String,
-    ): Boolean {
-        // Handle wildcard for "allow all"
-        if (pattern == "*") {
-            return true
+        /**
+         * Resolves the configuration of one test: the global allowed/blocked hosts merged with
+         * [fromAnnotations] of the test's method and class annotations.
+         *
+         * Every test of a class (and of classes with the same annotations) resolves the same
+         * configuration, so it is built once per distinct combination. Each call returns its own
+         * copy, which setConfiguration() can install as a separate test context; the copies share
+         * their compiled host patterns.
+         *
+         * @param annotations Annotations of the test method and class; unrelated ones are ignored
+         * @param globalAllowedHosts Allowed hosts configured for every test
+         * @param globalBlockedHosts Blocked hosts configured for every test
+         * @throws IllegalArgumentException if an [OverrideHosts] mapping is malformed
+         */
+        internal fun resolve(
+            annotations: Collection<Annotation>,
+            globalAllowedHosts: Set<String>,
+            globalBlockedHosts: Set<String>,
+        ): NetworkConfiguration {
+            val relevant =
+                annotations.filter {
+                    it is AllowRequestsToHosts ||
+                        it is BlockRequestsToHosts ||
+                        it is CacheDnsResults ||
+                        it is OverrideHosts
+                }
+            val key = Triple(relevant, globalAllowedHosts, globalBlockedHosts)
+            val configuration =
+                resolved.get(key)
+                    ?: NetworkConfiguration(allowedHosts = globalAllowedHosts, blockedHosts = globalBlockedHosts)
+                        .merge(fromAnnotations(relevant))
+                        .also { resolved.put(key, it) }
+            return configuration.copy()
         }
 
-        // Convert wildcard pattern to regex
-        // Escape special regex characters except *
-        val regexPattern =
-            pattern
-                .replace(".", "\\.")
-                .replace("*", ".*")
-
-        return host.matches(Regex("^$regexPattern$"))
-    }
-
-    companion object {
         /**
          * Creates a configuration from annotations on a test method or class.
          *
@@ -105,10 +157,39 @@ data class NetworkConfiguration(
                     .flatMap { it.hosts.toList() }
                     .toSet()
 
+            // Method and class annotations combine like merge(): the longer TTL wins
+            val dnsCacheTtlMillis =
+                annotations
+                    .filterIsInstance<CacheDnsResults>()
+                    .maxOfOrNull { it.ttlMillis } ?: 0
+
+            val hostOverrides =
+                annotations
+                    .filterIsInstance<OverrideHosts>()
+                    .flatMap { it.mappings.toList() }
+                    .associate { parseHostOverride(it) }
+
             return NetworkConfiguration(
                 allowedHosts = allowedHosts,
                 blockedHosts = blockedHosts,
+                dnsCacheTtlMillis = dnsCacheTtlMillis,
+                hostOverrides = hostOverrides,
             )
         }
+
+        /**
+         * Parses a "hostname=address" mapping as used by [OverrideHosts].
+         *
+         * @throws IllegalArgumentException if the mapping has no '=' or an empty side
+         */
+        fun parseHostOverride(mapping: String): Pair<String, String> {
+            val separator = mapping.indexOf('=')
+            val hostname = mapping.substring(0, maxOf(separator, 0)).trim()
+            val address = mapping.substring(separator + 1).trim()
+            require(separator > 0 && hostname.isNotEmpty() && address.isNotEmpty()) {
+                "Invalid host override \"$mapping\": expected \"hostname=address\", e.g. \"api.internal=127.0.0.1\""
+            }
+            return hostname to address
+        }
     }
 }
@@ -3,11 +3,13 @@ package io.github.garryjeromson.junit.airgap
 /**
  * Exception thrown when a test attempts to make a network request while the NoNetwork extension is active.
  *
+ * Open so that the JVM blocker can throw a stackless variant (see [STACKLESS_EXCEPTIONS_PROPERTY]).
+ *
  * @param message Description of the attempted network request
  * @param requestDetails Additional details about the request (host, port, protocol, etc.)
  * @param cause The original exception that triggered this, if any
  */
-class NetworkRequestAttemptedException(
+open class NetworkRequestAttemptedException(
     message: String,
     val requestDetails: NetworkRequestDetails? = null,
     cause: Throwable? = null,
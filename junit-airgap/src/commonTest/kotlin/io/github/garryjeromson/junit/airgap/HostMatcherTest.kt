@@ -0,0 +1,117 @@
+package io.github.garryjeromson.junit.airgap
+
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNotSame
+import kotlin.test.assertNull
+import kotlin.test.assertSame
+import kotlin.test.assertTrue
+
+class HostMatcherTest {
+    @Test
+    fun `exact patterns match only the same host`() {
+        val matcher = HostMatcher(setOf("localhost", "127.0.0.1"))
+
+        assertTrue(matcher.matches("localhost"))
+        assertTrue(matcher.matches("127.0.0.1"))
+        assertFalse(matcher.matches("localhost.localdomain"))
+    }
+
+    @Test
+    fun `leading wildcard needs at least one more label`() {
+        val matcher = HostMatcher(setOf("*.example.com", "*.svc.cluster.local"))
+
+        assertTrue(matcher.matches("api.example.com"))
+        assertTrue(matcher.matches("a.b.example.com"))
+        assertTrue(matcher.matches("db.default.svc.cluster.local"))
+        assertFalse(matcher.matches("example.com"))
+        assertFalse(matcher.matches("notexample.com"))
+        assertFalse(matcher.matches("cluster.local"))
+    }
+
+    @Test
+    fun `other wildcards match any run of characters`() {
+        val matcher = HostMatcher(setOf("api-*.internal", "*example.com", "*.*.example.org"))
+
+        assertTrue(matcher.matches("api-v1.internal"))
+        assertTrue(matcher.matches("api-.internal"))
+        assertTrue(matcher.matches("example.com"))
+        assertTrue(matcher.matches("myexample.com"))
+        assertTrue(matcher.matches("a.b.example.org"))
+        assertFalse(matcher.matches("a.example.org"))
+        assertFalse(matcher.matches("web-v1.internal"))
+    }
+
+    @Test
+    fun `IPv4 CIDR ranges match addresses inside the prefix`() {
+        val matcher = HostMatcher(setOf("10.0.0.0/8", "192.168.1.128/25"))
+
+        assertTrue(matcher.matches("10.0.0.1"))
+        assertTrue(matcher.matches("10.255.255.255"))
+        assertTrue(matcher.matches("192.168.1.200"))
+        assertFalse(matcher.matches("192.168.1.127"))
+        assertFalse(matcher.matches("11.0.0.1"))
+        assertFalse(matcher.matches("10.example.com"))
+    }
+
+    @Test
+    fun `IPv6 CIDR ranges match addresses in any notation`() {
+        val matcher = HostMatcher(setOf("fd00::/8", "2001:db8::/32"))
+
+        assertTrue(matcher.matches("fd12:3456::1"))
+        assertTrue(matcher.matches("[fd00::1]"))
+        assertTrue(matcher.matches("2001:db8:0:0:0:0:0:1"))
+        assertTrue(matcher.matches("fd00::1%eth0"))
+        assertFalse(matcher.matches("fe80::1"))
+        assertFalse(matcher.matches("10.0.0.1"))
+    }
+
+    @Test
+    fun `host bits of a range and zero-length prefixes are accepted`() {
+        assertTrue(HostMatcher(setOf("10.1.2.3/8")).matches("10.200.0.1"))
+        assertTrue(HostMatcher(setOf("0.0.0.0/0")).matches("203.0.113.7"))
+        assertFalse(HostMatcher(setOf("0.0.0.0/0")).matches("::1"))
+    }
+
+    @Test
+    fun `invalid ranges are exact names`() {
+        val matcher = HostMatcher(setOf("10.0.0.0/33", "example.com/8"))
+
+        assertTrue(matcher.matches("10.0.0.0/33"))
+        assertFalse(matcher.matches("10.0.0.1"))
+    }
+
+    @Test
+    fun `patterns are lowercased and deduplicated for the agent`() {
+        val matcher = HostMatcher(listOf("Example.COM", "example.com", "", "FD00::/8"))
+
+        assertEquals(listOf("example.com", "fd00::/8"), matcher.patterns)
+    }
+
+    @Test
+    fun `IP literals are parsed like inet_pton`() {
+        assertContentEquals(byteArrayOf(10, 0, 0, 1), HostMatcher.parseIpAddress("10.0.0.1"))
+        assertContentEquals(ByteArray(15) + byteArrayOf(1), HostMatcher.parseIpAddress("::1"))
+        assertContentEquals(
+            ByteArray(10) + byteArrayOf(-1, -1, 1, 2, 3, 4),
+            HostMatcher.parseIpAddress("::ffff:1.2.3.4"),
+        )
+        assertNull(HostMatcher.parseIpAddress("010.0.0.1"))
+        assertNull(HostMatcher.parseIpAddress("1.2.3"))
+        assertNull(HostMatcher.parseIpAddress("1:2:3:4:5:6:7:8:9"))
+        assertNull(HostMatcher.parseIpAddress("1::2::3"))
+        assertNull(HostMatcher.parseIpAddress("localhost"))
+    }
+
+    @Test
+    fun `equal pattern sets share one compiled matcher`() {
+        val matcher = HostMatcher.of(setOf("*.example.com", "10.0.0.0/8"))
+
+        assertSame(matcher, HostMatcher.of(setOf("10.0.0.0/8", "*.example.com")))
+        assertNotSame(matcher, HostMatcher.of(setOf("*.example.com")))
+        assertTrue(matcher.matches("api.example.com"))
+        assertTrue(matcher.matches("10.1.2.3"))
+    }
+}
@@ -1,7 +1,11 @@
 package io.github.garryjeromson.junit.airgap
 
 import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
 import kotlin.test.assertFalse
+import kotlin.test.assertNotSame
+import kotlin.test.assertSame
 import kotlin.test.assertTrue
 
 class NetworkConfigurationTest {
@@ -99,6 +103,60 @@ class NetworkConfigurationTest {
         assertFalse(merged.isAllowed("bad.com"))
     }
 
+    @Test
+    fun `merge should keep the longer DNS cache TTL`() {
+        val config1 = NetworkConfiguration(allowedHosts = setOf("localhost"), dnsCacheTtlMillis = 5_000)
+        val config2 = NetworkConfiguration(allowedHosts = setOf("127.0.0.1"))
+
+        assertEquals(5_000, config1.merge(config2).dnsCacheTtlMillis)
+        assertEquals(5_000, config2.merge(config1).dnsCacheTtlMillis)
+    }
+
+    @Test
+    fun `DNS cache should be disabled by default`() {
+        assertEquals(0, NetworkConfiguration().dnsCacheTtlMillis)
+    }
+
+    @Test
+    fun `overridden hosts should be allowed unless blocked`() {
+        val config =
+            NetworkConfiguration(
+                blockedHosts = setOf("blocked.internal"),
+                hostOverrides = mapOf("API.internal" to "127.0.0.1", "blocked.internal" to "127.0.0.1"),
+            )
+
+        assertTrue(config.isAllowed("api.internal"))
+        assertFalse(config.isAllowed("blocked.internal"))
+        assertFalse(config.isAllowed("127.0.0.1"), "Override addresses are not allowed by themselves")
+    }
+
+    @Test
+    fun `merge should combine hosts overrides with the other configuration winning`() {
+        val config1 = NetworkConfiguration(hostOverrides = mapOf("a.internal" to "127.0.0.1", "b.internal" to "::1"))
+        val config2 = NetworkConfiguration(hostOverrides = mapOf("b.internal" to "127.0.0.2"))
+
+        assertEquals(
+            mapOf("a.internal" to "127.0.0.1", "b.internal" to "127.0.0.2"),
+            config1.merge(config2).hostOverrides,
+        )
+    }
+
+    @Test
+    fun `parseHostOverride should split hostname and address`() {
+        assertEquals(
+            "api.internal" to "127.0.0.1",
+            NetworkConfiguration.parseHostOverride(" api.internal = 127.0.0.1 "),
+        )
+        assertEquals("v6.internal" to "::1", NetworkConfiguration.parseHostOverride("v6.internal=::1"))
+    }
+
+    @Test
+    fun `parseHostOverride should reject malformed mappings`() {
+        assertFailsWith<IllegalArgumentException> { NetworkConfiguration.parseHostOverride("api.internal") }
+        assertFailsWith<IllegalArgumentException> { NetworkConfiguration.parseHostOverride("=127.0.0.1") }
+        assertFailsWith<IllegalArgumentException> { NetworkConfiguration.parseHostOverride("api.internal=") }
+    }
+
     @Test
     fun `pattern matching should support wildcards`() {
         val config = NetworkConfiguration(allowedHosts = setOf("*.example.com"))
@@ -119,4 +177,41 @@ class NetworkConfigurationTest {
         assertFalse(config.isAllowed("api.example.com"))
         assertFalse(config.isAllowed("example.com"))
     }
+
+    @Test
+    fun `CIDR ranges should allow and block IP addresses`() {
+        val config =
+            NetworkConfiguration(
+                allowedHosts = setOf("10.0.0.0/8", "fd00::/8"),
+                blockedHosts = setOf("10.96.0.0/12"),
+            )
+
+        assertTrue(config.isAllowed("10.1.2.3"))
+        assertTrue(config.isAllowed("fd00::1"))
+        assertFalse(config.isAllowed("10.96.0.10"))
+        assertFalse(config.isAllowed("192.168.0.1"))
+    }
+
+    @Test
+    fun `resolve merges annotations with global hosts into a copy per call`() {
+        val annotations =
+            listOf(
+                BlockNetworkRequests(),
+                AllowRequestsToHosts(hosts = arrayOf("api.example.com")),
+                BlockRequestsToHosts(hosts = arrayOf("evil.com")),
+            )
+
+        val first = NetworkConfiguration.resolve(annotations, setOf("localhost"), emptySet())
+        val second = NetworkConfiguration.resolve(annotations.toList(), setOf("localhost"), emptySet())
+
+        assertEquals(setOf("localhost", "api.example.com"), first.allowedHosts)
+        assertEquals(setOf("evil.com"), first.blockedHosts)
+        assertEquals(first, second)
+        assertNotSame(first, second, "Each test needs its own instance to install")
+        assertSame(first.allowedMatcher, second.allowedMatcher)
+        assertEquals(
+            setOf("api.example.com"),
+            NetworkConfiguration.resolve(annotations, emptySet(), emptySet()).allowedHosts,
+        )
+    }
 }
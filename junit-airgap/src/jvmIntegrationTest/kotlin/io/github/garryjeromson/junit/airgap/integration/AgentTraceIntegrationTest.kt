@@ -0,0 +1,50 @@
+package io.github.garryjeromson.junit.airgap.integration
+
+import org.junit.jupiter.api.Test
+import org.junit.jupiter.api.condition.EnabledOnOs
+import org.junit.jupiter.api.condition.OS
+import org.junit.jupiter.api.io.TempDir
+import java.io.File
+import java.util.concurrent.TimeUnit
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+/**
+ * Integration tests for the JVMTI agent's interception trace (agent option `trace=<file>`).
+ *
+ * Runs a subprocess because agent options can only be given at JVM startup.
+ */
+class AgentTraceIntegrationTest {
+    private val javaHome = System.getProperty("java.home")
+    private val agentPath = File("../native/build/libjunit-airgap-agent.dylib").absolutePath
+    private val testClasspath = System.getProperty("java.class.path")
+
+    @Test
+    @EnabledOnOs(OS.MAC)
+    fun `blocked interceptions are written to the trace file as NDJSON`(
+        @TempDir tempDir: File,
+    ) {
+        val traceFile = File(tempDir, "trace.ndjson")
+
+        val process =
+            ProcessBuilder(
+                "$javaHome/bin/java",
+                "-agentpath:$agentPath=trace=${traceFile.absolutePath}",
+                "-cp",
+                testClasspath,
+                "io.github.garryjeromson.junit.airgap.integration.fixtures.AgentTraceMainKt",
+            ).redirectErrorStream(true).start()
+        val output = process.inputStream.bufferedReader().readText()
+        assertTrue(process.waitFor(30, TimeUnit.SECONDS), "Process timed out. Output:\n$output")
+        assertEquals(0, process.exitValue(), "Output:\n$output")
+
+        // The on-demand dump wrote at least one record; unload may append more
+        val dumped = Regex("TRACE_RECORDS=(\\d+)").find(output)?.groupValues?.get(1)?.toLong()
+        val records = traceFile.readLines().filter { it.startsWith("{\"ts\":") }
+        assertTrue(dumped != null && dumped > 0 && records.size >= dumped, "Output:\n$output")
+        assertTrue(
+            records.any { it.contains("\"verdict\":\"blocked\"") },
+            "Expected a blocked record in:\n${records.joinToString("\n")}",
+        )
+    }
+}
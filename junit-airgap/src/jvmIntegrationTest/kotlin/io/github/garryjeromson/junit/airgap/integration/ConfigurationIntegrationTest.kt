@@ -123,6 +123,15 @@ class ConfigurationIntegrationTest {
         }
     }
 
+    @Test
+    @BlockRequestsToHosts(hosts = ["127.0.0.1"]) // Block the IP even though the class allows its hostname
+    fun `blocks explicitly blocked IP even when hostname is allowed`() {
+        // Reverse lookup of 127.0.0.1 yields "localhost" (allowed), but the IP itself is blocked
+        assertNetworkBlocked("Explicitly blocked IP should win over allowed hostname") {
+            Socket("127.0.0.1", mockServer.listeningPort)
+        }
+    }
+
     @Test
     @AllowRequestsToHosts(hosts = ["192.168.*.*", "10.*.*.*"])
     fun `supports IP address wildcard patterns`() {
@@ -0,0 +1,93 @@
+package io.github.garryjeromson.junit.airgap.integration
+
+import io.github.garryjeromson.junit.airgap.AirgapExtension
+import io.github.garryjeromson.junit.airgap.AllowRequestsToHosts
+import io.github.garryjeromson.junit.airgap.BlockNetworkRequests
+import io.github.garryjeromson.junit.airgap.NetworkConfiguration
+import io.github.garryjeromson.junit.airgap.bytebuddy.NetworkBlockerContext
+import io.github.garryjeromson.junit.airgap.integration.fixtures.assertNetworkBlocked
+import org.junit.jupiter.api.AfterAll
+import org.junit.jupiter.api.Assumptions.assumeTrue
+import org.junit.jupiter.api.BeforeAll
+import org.junit.jupiter.api.BeforeEach
+import org.junit.jupiter.api.Test
+import org.junit.jupiter.api.extension.ExtendWith
+import java.net.Inet4Address
+import java.net.InetAddress
+import java.net.InetSocketAddress
+import java.net.ServerSocket
+import java.net.Socket
+
+/**
+ * Integration tests for the JVMTI agent's forward-DNS binding table: a connect to a literal
+ * address is matched against the hostname an earlier lookup in the same test resolved to it
+ * (never a reverse DNS lookup).
+ *
+ * The integration test JVM runs with -Dsun.net.inetaddr.ttl=0, so every lookup reaches the agent.
+ */
+@ExtendWith(AirgapExtension::class)
+@BlockNetworkRequests
+@AllowRequestsToHosts(hosts = ["localhost"])
+class DnsBindingIntegrationTest {
+    companion object {
+        private lateinit var server: ServerSocket
+
+        @JvmStatic
+        @BeforeAll
+        fun startServer() {
+            server = ServerSocket(0, 50, InetAddress.getByName("127.0.0.1"))
+        }
+
+        @JvmStatic
+        @AfterAll
+        fun stopServer() {
+            server.close()
+        }
+    }
+
+    @BeforeEach
+    fun requireAgent() {
+        assumeTrue(NetworkBlockerContext.getVerdictCacheStats() != null, "JVMTI agent not loaded")
+    }
+
+    /**
+     * Resolve "localhost" and rebuild its IPv4 address from raw bytes, so the connect target
+     * carries no hostname of its own (like an address from a resolver or connection pool).
+     */
+    private fun resolvedLiteralAddress(): InetSocketAddress {
+        val resolved = InetAddress.getAllByName("localhost").first { it is Inet4Address }
+        return InetSocketAddress(InetAddress.getByAddress(resolved.address), server.localPort)
+    }
+
+    @Test
+    fun `a literal address connect is allowed by the hostname it was resolved from`() {
+        val target = resolvedLiteralAddress()
+
+        Socket().use { it.connect(target, 1000) }
+    }
+
+    @Test
+    fun `a literal address that was never resolved is matched on its IP alone`() {
+        val target = InetSocketAddress(InetAddress.getByAddress(byteArrayOf(127, 0, 0, 1)), server.localPort)
+
+        assertNetworkBlocked("127.0.0.1 is not allowed and no lookup named it") {
+            Socket().use { it.connect(target, 1000) }
+        }
+    }
+
+    @Test
+    fun `bindings are ignored once the generation moves on`() {
+        val target = resolvedLiteralAddress()
+        Socket().use { it.connect(target, 1000) }
+
+        // A different configuration drops the parked context and increments the generation
+        NetworkBlockerContext.clearConfiguration()
+        NetworkBlockerContext.setConfiguration(
+            NetworkConfiguration(allowedHosts = setOf("localhost"), blockedHosts = setOf("blocked.invalid")),
+        )
+
+        assertNetworkBlocked("The binding was recorded under the previous generation") {
+            Socket().use { it.connect(target, 1000) }
+        }
+    }
+}
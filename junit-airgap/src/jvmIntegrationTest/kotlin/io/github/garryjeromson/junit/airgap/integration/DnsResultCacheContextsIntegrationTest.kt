@@ -0,0 +1,81 @@
+package io.github.garryjeromson.junit.airgap.integration
+
+import io.github.garryjeromson.junit.airgap.NetworkConfiguration
+import io.github.garryjeromson.junit.airgap.bytebuddy.NetworkBlockerContext
+import org.junit.jupiter.api.Assumptions.assumeTrue
+import org.junit.jupiter.api.Test
+import java.net.InetAddress
+import java.util.concurrent.Callable
+import java.util.concurrent.ExecutorService
+import java.util.concurrent.Executors
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+/**
+ * Edge cases of the agent's DNS result cache under in-JVM parallel execution: each test
+ * context has its own TTL, so two tests running at once never share or switch off each
+ * other's cache.
+ *
+ * Drives NetworkBlockerContext directly, one single-thread executor per test, like
+ * NetworkBlockerContextEdgeCasesTest. The integration test JVM runs with
+ * -Dsun.net.inetaddr.ttl=0, so every lookup reaches the agent.
+ */
+class DnsResultCacheContextsIntegrationTest {
+    @Test
+    fun `parallel test contexts keep their own DNS cache TTL`() {
+        assumeTrue(NetworkBlockerContext.getDnsCacheStats() != null, "JVMTI agent not loaded")
+        val cachingTest = Executors.newSingleThreadExecutor()
+        val plainTest = Executors.newSingleThreadExecutor()
+        try {
+            // Given: A test with caching on, which has resolved localhost once
+            cachingTest.onThread {
+                NetworkBlockerContext.setConfiguration(
+                    NetworkConfiguration(allowedHosts = setOf("localhost"), dnsCacheTtlMillis = 60_000),
+                )
+                InetAddress.getAllByName("localhost")
+            }
+
+            // When: A test without caching starts while it runs
+            plainTest.onThread {
+                NetworkBlockerContext.setConfiguration(NetworkConfiguration(allowedHosts = setOf("localhost")))
+            }
+
+            // Then: The second test's lookups never reach the cache
+            val beforePlain = NetworkBlockerContext.getDnsCacheStats()!!
+            repeat(3) { plainTest.onThread { InetAddress.getAllByName("localhost") } }
+            assertEquals(
+                beforePlain,
+                NetworkBlockerContext.getDnsCacheStats(),
+                "A test without caching should not use another test's DNS result cache",
+            )
+
+            // And: The first test's cache is still on, with its entry still live
+            repeat(3) { cachingTest.onThread { InetAddress.getAllByName("localhost") } }
+            val afterCaching = NetworkBlockerContext.getDnsCacheStats()!!
+            assertTrue(
+                afterCaching.hits - beforePlain.hits >= 3,
+                "Another test starting should not flush or disable the cache, got $beforePlain -> $afterCaching",
+            )
+
+            // And: The second test ending doesn't turn it off either
+            plainTest.onThread { NetworkBlockerContext.clearConfiguration() }
+            cachingTest.onThread { InetAddress.getAllByName("localhost") }
+            val afterPlainEnded = NetworkBlockerContext.getDnsCacheStats()!!
+            assertEquals(
+                afterCaching.hits + 1,
+                afterPlainEnded.hits,
+                "Another test ending should not flush or disable the cache",
+            )
+        } finally {
+            plainTest.onThread { NetworkBlockerContext.clearConfiguration() }
+            cachingTest.onThread { NetworkBlockerContext.clearConfiguration() }
+            cachingTest.shutdown()
+            plainTest.shutdown()
+        }
+    }
+
+    /**
+     * Run [block] on this executor's thread and wait for the result.
+     */
+    private fun <T> ExecutorService.onThread(block: () -> T): T = submit(Callable { block() }).get()
+}
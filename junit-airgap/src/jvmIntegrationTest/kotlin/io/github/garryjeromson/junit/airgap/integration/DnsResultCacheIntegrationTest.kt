@@ -0,0 +1,69 @@
+package io.github.garryjeromson.junit.airgap.integration
+
+import io.github.garryjeromson.junit.airgap.AirgapExtension
+import io.github.garryjeromson.junit.airgap.AllowRequestsToHosts
+import io.github.garryjeromson.junit.airgap.BlockNetworkRequests
+import io.github.garryjeromson.junit.airgap.CacheDnsResults
+import io.github.garryjeromson.junit.airgap.bytebuddy.NetworkBlockerContext
+import io.github.garryjeromson.junit.airgap.integration.fixtures.assertNetworkBlocked
+import org.junit.jupiter.api.Assumptions.assumeTrue
+import org.junit.jupiter.api.Test
+import org.junit.jupiter.api.extension.ExtendWith
+import java.net.InetAddress
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+/**
+ * Integration tests for the JVMTI agent's opt-in DNS result cache.
+ *
+ * The integration test JVM runs with -Dsun.net.inetaddr.ttl=0, so every lookup reaches the agent.
+ */
+@ExtendWith(AirgapExtension::class)
+@BlockNetworkRequests
+@AllowRequestsToHosts(hosts = ["localhost"])
+class DnsResultCacheIntegrationTest {
+    @Test
+    @CacheDnsResults
+    fun `repeated lookups of an allowed host are served from the cache`() {
+        val before = NetworkBlockerContext.getDnsCacheStats()
+        assumeTrue(before != null, "JVMTI agent not loaded")
+
+        val first = InetAddress.getAllByName("localhost")
+        repeat(4) {
+            assertContentEquals(first, InetAddress.getAllByName("localhost"))
+        }
+
+        val after = NetworkBlockerContext.getDnsCacheStats()!!
+        assertTrue(
+            after.hits - before!!.hits >= 4,
+            "Expected cache hits after the first lookup, got $before -> $after",
+        )
+    }
+
+    @Test
+    @CacheDnsResults
+    fun `blocked hosts are still blocked with the cache enabled`() {
+        InetAddress.getAllByName("localhost")
+
+        assertNetworkBlocked("Non-allowed hosts should still be blocked") {
+            InetAddress.getAllByName("example.com")
+        }
+    }
+
+    @Test
+    fun `lookups bypass the cache unless the test enables it`() {
+        val before = NetworkBlockerContext.getDnsCacheStats()
+        assumeTrue(before != null, "JVMTI agent not loaded")
+
+        repeat(3) {
+            InetAddress.getAllByName("localhost")
+        }
+
+        assertEquals(
+            before,
+            NetworkBlockerContext.getDnsCacheStats(),
+            "Lookups should not reach the DNS result cache without @CacheDnsResults",
+        )
+    }
+}
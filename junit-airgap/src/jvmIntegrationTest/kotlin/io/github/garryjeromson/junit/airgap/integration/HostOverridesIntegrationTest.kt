@@ -0,0 +1,78 @@
+package io.github.garryjeromson.junit.airgap.integration
+
+import io.github.garryjeromson.junit.airgap.AirgapExtension
+import io.github.garryjeromson.junit.airgap.BlockNetworkRequests
+import io.github.garryjeromson.junit.airgap.BlockRequestsToHosts
+import io.github.garryjeromson.junit.airgap.OverrideHosts
+import io.github.garryjeromson.junit.airgap.integration.fixtures.MockHttpServer
+import io.github.garryjeromson.junit.airgap.integration.fixtures.assertNetworkBlocked
+import org.junit.jupiter.api.AfterAll
+import org.junit.jupiter.api.BeforeAll
+import org.junit.jupiter.api.Test
+import org.junit.jupiter.api.extension.ExtendWith
+import java.net.HttpURLConnection
+import java.net.InetAddress
+import java.net.URI
+import kotlin.test.assertEquals
+
+/**
+ * Integration tests for hosts overrides: mapped hostnames resolve to fixed addresses
+ * inside the JVMTI agent, without DNS.
+ *
+ * The hostnames use the reserved .invalid TLD, so they could never resolve for real.
+ */
+@ExtendWith(AirgapExtension::class)
+@BlockNetworkRequests
+@OverrideHosts(["api.airgap.invalid=127.0.0.1", "blocked.airgap.invalid=127.0.0.1"])
+class HostOverridesIntegrationTest {
+    companion object {
+        private lateinit var mockServer: MockHttpServer
+
+        @JvmStatic
+        @BeforeAll
+        fun startMockServer() {
+            mockServer = MockHttpServer()
+            mockServer.start()
+            Thread.sleep(100)
+        }
+
+        @JvmStatic
+        @AfterAll
+        fun stopMockServer() {
+            mockServer.stop()
+        }
+    }
+
+    @Test
+    fun `overridden hostname resolves to the mapped address`() {
+        val addresses = InetAddress.getAllByName("api.airgap.invalid")
+
+        assertEquals(1, addresses.size)
+        assertEquals("127.0.0.1", addresses[0].hostAddress)
+        assertEquals("api.airgap.invalid", addresses[0].hostName)
+    }
+
+    @Test
+    fun `requests to an overridden hostname reach the local server`() {
+        val url = URI("http://api.airgap.invalid:${mockServer.listeningPort}/api/test").toURL()
+        val connection = url.openConnection() as HttpURLConnection
+
+        assertEquals(200, connection.responseCode)
+        connection.disconnect()
+    }
+
+    @Test
+    @BlockRequestsToHosts(["blocked.airgap.invalid"])
+    fun `blocked hosts take precedence over overrides`() {
+        assertNetworkBlocked("Blocked hosts should stay blocked when overridden") {
+            InetAddress.getAllByName("blocked.airgap.invalid")
+        }
+    }
+
+    @Test
+    fun `hosts that are not overridden are still blocked`() {
+        assertNetworkBlocked("Non-overridden hosts should be blocked") {
+            InetAddress.getAllByName("example.com")
+        }
+    }
+}
@@ -0,0 +1,98 @@
+package io.github.garryjeromson.junit.airgap.integration
+
+import io.github.garryjeromson.junit.airgap.AirgapExtension
+import io.github.garryjeromson.junit.airgap.AllowRequestsToHosts
+import io.github.garryjeromson.junit.airgap.BlockNetworkRequests
+import io.github.garryjeromson.junit.airgap.bytebuddy.NetworkBlockerContext
+import io.github.garryjeromson.junit.airgap.integration.fixtures.assertNetworkBlocked
+import io.netty.bootstrap.Bootstrap
+import io.netty.channel.ChannelInboundHandlerAdapter
+import io.netty.channel.ChannelOption
+import io.netty.channel.EventLoopGroup
+import io.netty.channel.epoll.Epoll
+import io.netty.channel.epoll.EpollEventLoopGroup
+import io.netty.channel.epoll.EpollSocketChannel
+import org.junit.jupiter.api.AfterAll
+import org.junit.jupiter.api.Assumptions.assumeTrue
+import org.junit.jupiter.api.BeforeAll
+import org.junit.jupiter.api.BeforeEach
+import org.junit.jupiter.api.Tag
+import org.junit.jupiter.api.Test
+import org.junit.jupiter.api.extension.ExtendWith
+import java.net.Inet4Address
+import java.net.InetAddress
+import java.net.InetSocketAddress
+import java.net.ServerSocket
+import io.netty.channel.unix.Socket as UnixSocket
+
+/**
+ * Integration tests for the JVMTI agent's Netty wrapper: connects through the epoll
+ * transport reach io.netty.channel.unix.Socket.connect(), not sun.nio.ch.Net.connect0.
+ *
+ * Run by the nettyNativeIntegrationTest task, which enables Netty's native transports and
+ * loads the agent with requiredBinds=connect+dns+netty. Linux only.
+ */
+@Tag("netty-native")
+@ExtendWith(AirgapExtension::class)
+@BlockNetworkRequests
+@AllowRequestsToHosts(hosts = ["localhost"])
+class NettyEpollIntegrationTest {
+    companion object {
+        private lateinit var server: ServerSocket
+        private var group: EventLoopGroup? = null
+
+        @JvmStatic
+        @BeforeAll
+        fun startServer() {
+            server = ServerSocket(0, 50, InetAddress.getByName("127.0.0.1"))
+            if (Epoll.isAvailable()) {
+                group = EpollEventLoopGroup(1)
+            }
+        }
+
+        @JvmStatic
+        @AfterAll
+        fun stopServer() {
+            group?.shutdownGracefully()?.syncUninterruptibly()
+            server.close()
+        }
+    }
+
+    @BeforeEach
+    fun requireEpollAndAgent() {
+        assumeTrue(Epoll.isAvailable(), "Netty epoll transport not available")
+        assumeTrue(NetworkBlockerContext.getVerdictCacheStats() != null, "JVMTI agent not loaded")
+    }
+
+    private fun connect(target: InetSocketAddress) {
+        Bootstrap()
+            .group(group)
+            .channel(EpollSocketChannel::class.java)
+            .option(ChannelOption.CONNECT_TIMEOUT_MILLIS, 1000)
+            .handler(ChannelInboundHandlerAdapter())
+            .connect(target)
+            .sync()
+            .channel()
+            .close()
+            .sync()
+    }
+
+    @Test
+    fun `an epoll connect to a blocked address throws`() {
+        val target = InetSocketAddress(InetAddress.getByAddress(byteArrayOf(127, 0, 0, 1)), server.localPort)
+
+        assertNetworkBlocked("127.0.0.1 is not allowed and no lookup named it") {
+            connect(target)
+        }
+    }
+
+    @Test
+    fun `an epoll connect on a dual-stack socket is matched as IPv4`() {
+        // A dual-stack socket passes the IPv4 target as ::ffff:127.0.0.1, which the wrapper
+        // must decode to 127.0.0.1 to find the binding that allows it
+        assumeTrue(UnixSocket.isIPv6Preferred(), "Netty sockets are IPv4-only on this host")
+        val resolved = InetAddress.getAllByName("localhost").first { it is Inet4Address }
+
+        connect(InetSocketAddress(InetAddress.getByAddress(resolved.address), server.localPort))
+    }
+}
@@ -0,0 +1,84 @@
+package io.github.garryjeromson.junit.airgap.integration
+
+import io.github.garryjeromson.junit.airgap.AirgapExtension
+import io.github.garryjeromson.junit.airgap.AllowRequestsToHosts
+import io.github.garryjeromson.junit.airgap.BlockNetworkRequests
+import io.github.garryjeromson.junit.airgap.bytebuddy.NetworkBlockerContext
+import io.github.garryjeromson.junit.airgap.integration.fixtures.MockHttpServer
+import io.github.garryjeromson.junit.airgap.integration.fixtures.assertNetworkBlocked
+import org.junit.jupiter.api.AfterAll
+import org.junit.jupiter.api.Assumptions.assumeTrue
+import org.junit.jupiter.api.BeforeAll
+import org.junit.jupiter.api.Test
+import org.junit.jupiter.api.extension.ExtendWith
+import java.net.Socket
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+/**
+ * Integration tests for the JVMTI agent's per-thread connect verdict cache.
+ */
+@ExtendWith(AirgapExtension::class)
+@BlockNetworkRequests
+@AllowRequestsToHosts(hosts = ["localhost", "127.0.0.1"])
+class VerdictCacheIntegrationTest {
+    companion object {
+        private lateinit var mockServer: MockHttpServer
+
+        @JvmStatic
+        @BeforeAll
+        fun startMockServer() {
+            mockServer = MockHttpServer()
+            mockServer.start()
+            Thread.sleep(100)
+        }
+
+        @JvmStatic
+        @AfterAll
+        fun stopMockServer() {
+            mockServer.stop()
+        }
+    }
+
+    @Test
+    fun `repeated allowed connections are served from the verdict cache`() {
+        val before = NetworkBlockerContext.getVerdictCacheStats()
+        assumeTrue(before != null, "JVMTI agent not loaded")
+
+        repeat(5) {
+            Socket("127.0.0.1", mockServer.listeningPort).use { }
+        }
+
+        val after = NetworkBlockerContext.getVerdictCacheStats()!!
+        assertTrue(
+            after.hits - before!!.hits >= 4,
+            "Expected cache hits after the first connect, got $before -> $after",
+        )
+    }
+
+    @Test
+    fun `cached verdicts do not allow other hosts`() {
+        Socket("127.0.0.1", mockServer.listeningPort).use { }
+
+        assertNetworkBlocked("Non-allowed hosts should still be blocked") {
+            Socket("example.com", 80)
+        }
+    }
+
+    @Test
+    fun `connections bypass the agent while no configuration is set`() {
+        // Disarms the agent; the extension clears again after the test
+        NetworkBlockerContext.clearConfiguration()
+
+        val before = NetworkBlockerContext.getVerdictCacheStats()
+        assumeTrue(before != null, "JVMTI agent not loaded")
+
+        Socket("127.0.0.1", mockServer.listeningPort).use { }
+
+        assertEquals(
+            before,
+            NetworkBlockerContext.getVerdictCacheStats(),
+            "Disarmed agent should not reach the verdict cache",
+        )
+    }
+}
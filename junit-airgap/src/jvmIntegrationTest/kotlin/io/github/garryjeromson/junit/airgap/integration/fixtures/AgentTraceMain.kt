@@ -0,0 +1,30 @@
+package io.github.garryjeromson.junit.airgap.integration.fixtures
+
+import io.github.garryjeromson.junit.airgap.NetworkBlocker
+import io.github.garryjeromson.junit.airgap.NetworkConfiguration
+import io.github.garryjeromson.junit.airgap.NetworkRequestAttemptedException
+import io.github.garryjeromson.junit.airgap.bytebuddy.NetworkBlockerContext
+import java.net.Socket
+import kotlin.system.exitProcess
+
+/**
+ * Test fixture for the JVMTI agent's interception trace (agent option `trace=<file>`).
+ *
+ * Makes one blocked connection attempt, then drains the trace buffers and prints the
+ * number of records written as `TRACE_RECORDS=<n>`.
+ */
+fun main() {
+    val blocker = NetworkBlocker(NetworkConfiguration(allowedHosts = emptySet()))
+    blocker.install()
+    try {
+        Socket("example.com", 80).use { }
+        System.err.println("ERROR: Network request should have been blocked!")
+        exitProcess(1)
+    } catch (e: NetworkRequestAttemptedException) {
+        // Expected
+    } finally {
+        blocker.uninstall()
+    }
+
+    println("TRACE_RECORDS=${NetworkBlockerContext.dumpTrace()}")
+}
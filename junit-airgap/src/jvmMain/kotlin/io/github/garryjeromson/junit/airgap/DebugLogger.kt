@@ -41,6 +41,13 @@ internal interface DebugLogger {
      */
     fun debug(message: () -> String)
 
+    /**
+     * Whether debug mode is enabled. Lets hot callers skip a group of [debug] calls whose
+     * capturing message lambdas would otherwise be allocated on every call.
+     */
+    val isEnabled: Boolean
+        get() = true
+
     companion object {
         /**
          * Get the current logger instance (either test or default).
@@ -82,6 +89,9 @@ private class SystemPropertyDebugLogger : DebugLogger {
      */
     private val debugEnabled: Boolean = System.getProperty("junit.airgap.debug") == "true"
 
+    override val isEnabled: Boolean
+        get() = debugEnabled
+
     override fun debug(message: () -> String) {
         if (debugEnabled) {
             System.err.println("[junit-airgap] ${message()}")
@@ -38,14 +38,14 @@ import io.github.garryjeromson.junit.airgap.bytebuddy.NetworkBlockerContext
  * Replace with wrapper: wrapped_Net_connect0() [ONE TIME]
  *   ↓
  * Test execution: install() sets NetworkBlockerContext [PER TEST]
- *   ↓
+ *   ↓                  (host lists pushed to the agent's native policy)
  * Network call: ANY socket connection
  *   ↓
  * wrapped_Net_connect0(): Extract host/port via JNI
  *   ↓
- * NetworkBlockerContext.checkConnection(): Check ThreadLocal config
- *   ↓
- * Throw NetworkRequestAttemptedException if blocked
+ * Native host policy: allow/block decided in C++ (no upcall)
+ *   ↓ (if blocked)
+ * NetworkBlockerContext.checkConnection(): Throw NetworkRequestAttemptedException
  * ```
  *
  * ## Why This is the Ultimate Solution
@@ -1,5 +1,7 @@
 package io.github.garryjeromson.junit.airgap
 
+import io.github.garryjeromson.junit.airgap.bytebuddy.AgentInterceptionMetrics
+import io.github.garryjeromson.junit.airgap.bytebuddy.NetworkBlockerContext
 import org.junit.jupiter.api.extension.AfterEachCallback
 import org.junit.jupiter.api.extension.BeforeEachCallback
 import org.junit.jupiter.api.extension.ExtensionContext
@@ -57,6 +59,9 @@ import org.junit.jupiter.api.extension.ExtensionContext
  *
  * The extension respects @AllowRequestsToHosts and @BlockRequestsToHosts annotations for fine-grained control.
  *
+ * When the JVMTI agent collects interception metrics (agent option `metrics`), each test
+ * publishes the interceptions made while it ran as `airgap.*` report entries.
+ *
  * @param applyToAllTests If true, network blocking is applied to all tests by default.
  *                       When null, the value is determined by system property or class-level @BlockNetworkRequests annotation.
  */
@@ -66,6 +71,7 @@ class AirgapExtension(
     AfterEachCallback {
     companion object {
         private const val BLOCKER_KEY = "junit-airgap-blocker"
+        private const val METRICS_KEY = "junit-airgap-metrics"
 
         init {
             // Force NetworkBlockerContext to initialize early.
@@ -75,7 +81,7 @@ class AirgapExtension(
             try {
                 // Access the object to trigger its init block (accessing just ::class doesn't work)
                 // getConfiguration() is a simple getter that won't cause side effects
-                io.github.garryjeromson.junit.airgap.bytebuddy.NetworkBlockerContext
+                NetworkBlockerContext
                     .getConfiguration()
             } catch (e: Throwable) {
                 // Ignore errors - NetworkBlockerContext will initialize when first used
@@ -84,6 +90,13 @@ class AirgapExtension(
     }
 
     override fun beforeEach(context: ExtensionContext) {
+        // Snapshot the agent's metrics for every test, blocked or not (null when metrics are off)
+        NetworkBlockerContext.getInterceptionMetrics()?.let { metrics ->
+            context
+                .getStore(ExtensionContext.Namespace.create(AirgapExtension::class.java))
+                .put(METRICS_KEY, metrics)
+        }
+
         // Priority order for determining whether to block network:
         // 1. @AllowNetworkRequests (opt-out - highest priority)
         // 2. Constructor parameter (applyToAllTests)
@@ -174,6 +187,24 @@ class AirgapExtension(
                 .get(BLOCKER_KEY, NetworkBlocker::class.java)
 
         blocker?.uninstall()
+
+        publishInterceptionMetrics(context)
+    }
+
+    /**
+     * Publish the interceptions made since [beforeEach] took its snapshot as report entries.
+     * Metrics are JVM-wide, so with parallel tests they include the other tests' interceptions.
+     */
+    private fun publishInterceptionMetrics(context: ExtensionContext) {
+        val before =
+            context
+                .getStore(ExtensionContext.Namespace.create(AirgapExtension::class.java))
+                .get(METRICS_KEY, AgentInterceptionMetrics::class.java)
+                ?: return
+        val delta = (NetworkBlockerContext.getInterceptionMetrics() ?: return) - before
+        if (delta.calls > 0) {
+            context.publishReportEntry(delta.toReportEntries())
+        }
     }
 
     private fun buildConfiguration(context: ExtensionContext): NetworkConfiguration {
@@ -190,9 +221,6 @@ class AirgapExtension(
             annotations.addAll(clazz.annotations)
         }
 
-        // Build configuration from annotations
-        val annotationConfig = NetworkConfiguration.fromAnnotations(annotations)
-
         // Read global configuration from JUnit Platform configuration parameters (preferred)
         // or fall back to system properties. This matches how applyToAllTests is handled.
         val allowedHostsStr =
@@ -205,15 +233,13 @@ class AirgapExtension(
                 .getConfigurationParameter(BLOCKED_HOSTS_PROPERTY)
                 .orElse(System.getProperty(BLOCKED_HOSTS_PROPERTY, ""))
 
-        val globalConfig =
-            NetworkConfiguration(
-                allowedHosts = parseHostList(allowedHostsStr),
-                blockedHosts = parseHostList(blockedHostsStr),
-            )
-
-        // Merge configurations - annotation-level takes precedence for blocked hosts,
-        // but allowed hosts are combined
-        return globalConfig.merge(annotationConfig)
+        // Merge with the annotation configuration - blocked and allowed hosts are combined.
+        // Resolved once per distinct annotations, so the tests of a class share one configuration.
+        return NetworkConfiguration.resolve(
+            annotations,
+            globalAllowedHosts = parseHostList(allowedHostsStr),
+            globalBlockedHosts = parseHostList(blockedHostsStr),
+        )
     }
 
     /**
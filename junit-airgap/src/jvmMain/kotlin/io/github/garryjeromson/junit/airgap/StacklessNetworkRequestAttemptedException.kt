@@ -0,0 +1,16 @@
+package io.github.garryjeromson.junit.airgap
+
+/**
+ * [NetworkRequestAttemptedException] that skips capturing a stack trace.
+ *
+ * Filling in the stack is most of the cost of a blocked request when the caller is deep
+ * inside an HTTP client or coroutine machinery. Thrown instead of the regular exception
+ * when [STACKLESS_EXCEPTIONS_PROPERTY] is enabled; the message still carries host, port
+ * and caller, and `catch (e: NetworkRequestAttemptedException)` still matches.
+ */
+internal class StacklessNetworkRequestAttemptedException(
+    message: String,
+    requestDetails: NetworkRequestDetails? = null,
+) : NetworkRequestAttemptedException(message, requestDetails) {
+    override fun fillInStackTrace(): Throwable = this
+}
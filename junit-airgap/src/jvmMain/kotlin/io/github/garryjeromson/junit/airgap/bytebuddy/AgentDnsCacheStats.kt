@@ -0,0 +1,14 @@
+package io.github.garryjeromson.junit.airgap.bytebuddy
+
+/**
+ * Counters of the JVMTI agent's DNS result cache.
+ *
+ * Counts are JVM-wide and cumulative; take a delta around the code of interest.
+ *
+ * @property hits Lookups of allowed hosts answered from the cache
+ * @property misses Lookups of allowed hosts that went to the resolver while the cache was enabled
+ */
+data class AgentDnsCacheStats(
+    val hits: Long,
+    val misses: Long,
+)
@@ -0,0 +1,189 @@
+package io.github.garryjeromson.junit.airgap.bytebuddy
+
+/**
+ * Interception metrics of the JVMTI agent (agent option `metrics`).
+ *
+ * Counts are JVM-wide and cumulative; take a delta with [minus] around the code of interest.
+ * Histogram bucket `i` counts durations in `[2^i, 2^(i+1))` nanoseconds; the last bucket is open-ended.
+ *
+ * @property targets Counters per interception target (`NetConnect0`, `Inet4LookupAllHostAddr`, ...)
+ * @property paths Decisions per path (`disarmed`, `verdict-cache`, `policy`, `java`, ...)
+ * @property upcallHistogram Time spent in JNI upcalls into [NetworkBlockerContext], per interception that made one
+ * @property originalHistogram Time spent after the verdict (the original native call), per allowed interception
+ * @property upcallTotalNanos Sum of all upcall times
+ * @property originalTotalNanos Sum of all original call times
+ */
+data class AgentInterceptionMetrics(
+    val targets: Map<String, Target>,
+    val paths: Map<String, Long>,
+    val upcallHistogram: List<Long>,
+    val originalHistogram: List<Long>,
+    val upcallTotalNanos: Long,
+    val originalTotalNanos: Long,
+) {
+    /**
+     * Counters of one interception target.
+     *
+     * @property calls Interceptions
+     * @property allowed Interceptions that went on to the original implementation
+     * @property blocked Interceptions that were blocked
+     */
+    data class Target(
+        val calls: Long,
+        val allowed: Long,
+        val blocked: Long,
+    ) {
+        operator fun minus(other: Target): Target =
+            Target(
+                calls = calls - other.calls,
+                allowed = allowed - other.allowed,
+                blocked = blocked - other.blocked,
+            )
+    }
+
+    /** Interceptions over all targets. */
+    val calls: Long get() = targets.values.sumOf { it.calls }
+
+    /** Blocked interceptions over all targets. */
+    val blocked: Long get() = targets.values.sumOf { it.blocked }
+
+    /**
+     * Counters accumulated since [earlier], a previous reading of the same agent.
+     */
+    operator fun minus(earlier: AgentInterceptionMetrics): AgentInterceptionMetrics =
+        AgentInterceptionMetrics(
+            targets = targets.mapValues { (name, target) -> earlier.targets[name]?.let { target - it } ?: target },
+            paths = paths.mapValues { (name, count) -> count - (earlier.paths[name] ?: 0L) },
+            upcallHistogram = upcallHistogram.minusEach(earlier.upcallHistogram),
+            originalHistogram = originalHistogram.minusEach(earlier.originalHistogram),
+            upcallTotalNanos = upcallTotalNanos - earlier.upcallTotalNanos,
+            originalTotalNanos = originalTotalNanos - earlier.originalTotalNanos,
+        )
+
+    /**
+     * Upper bound of the bucket holding the given percentile of [histogram], in nanoseconds.
+     *
+     * @param fraction Percentile as a fraction, e.g. 0.99
+     * @return Upper bound, or 0 if the histogram is empty
+     */
+    fun percentileNanos(
+        histogram: List<Long>,
+        fraction: Double,
+    ): Long {
+        val total = histogram.sum()
+        if (total == 0L) {
+            return 0L
+        }
+        val rank = kotlin.math.ceil(total * fraction).toLong().coerceAtLeast(1L)
+        var seen = 0L
+        histogram.forEachIndexed { bucket, count ->
+            seen += count
+            if (seen >= rank) {
+                return if (bucket >= Long.SIZE_BITS - 2) Long.MAX_VALUE else 1L shl (bucket + 1)
+            }
+        }
+        return Long.MAX_VALUE
+    }
+
+    /**
+     * Flatten into JUnit report entries (`airgap.*` keys), leaving out targets and paths with no calls.
+     */
+    fun toReportEntries(): Map<String, String> {
+        val entries = linkedMapOf<String, String>()
+        entries["airgap.interceptions"] = calls.toString()
+        entries["airgap.blocked"] = blocked.toString()
+        targets.filterValues { it.calls > 0 }.forEach { (name, target) ->
+            entries["airgap.target.$name"] =
+                "calls=${target.calls} allowed=${target.allowed} blocked=${target.blocked}"
+        }
+        paths.filterValues { it > 0 }.forEach { (name, count) ->
+            entries["airgap.path.$name"] = count.toString()
+        }
+        entries["airgap.upcallNanos"] = histogramSummary(upcallHistogram, upcallTotalNanos)
+        entries["airgap.originalNanos"] = histogramSummary(originalHistogram, originalTotalNanos)
+        return entries
+    }
+
+    private fun histogramSummary(
+        histogram: List<Long>,
+        totalNanos: Long,
+    ): String =
+        "total=$totalNanos p50<=${percentileNanos(histogram, 0.5)} p99<=${percentileNanos(histogram, 0.99)}"
+
+    companion object {
+        /** Layout version of the native array this class understands. */
+        private const val LAYOUT_VERSION = 1L
+
+        /** Interception target names, in native InterceptTarget order. */
+        internal val TARGET_NAMES =
+            listOf(
+                "NetConnect0",
+                "SocketConnect0",
+                "SocketChannelConnect0",
+                "Inet6LookupAllHostAddr",
+                "Inet4LookupAllHostAddr",
+                "NettySocketConnect",
+            )
+
+        /** Decision path names, in native TracePath order (same names as the trace file). */
+        internal val PATH_NAMES =
+            listOf(
+                "vm-init-pending",
+                "unregistered",
+                "policy-image",
+                "disarmed",
+                "no-configuration",
+                "verdict-cache",
+                "dns-cache",
+                "host-override",
+                "policy",
+                "java",
+            )
+
+        /**
+         * Parse the array returned by the agent's getAgentMetrics().
+         *
+         * The agent reports its own target, path and bucket counts, so an agent with more
+         * targets than this class knows still parses (unknown ones are named by index).
+         *
+         * @return Metrics, or null if [values] has a different layout version or is truncated
+         */
+        fun fromArray(values: LongArray): AgentInterceptionMetrics? {
+            if (values.size < 4 || values[0] != LAYOUT_VERSION) {
+                return null
+            }
+            val targetCount = values[1].toInt()
+            val pathCount = values[2].toInt()
+            val bucketCount = values[3].toInt()
+            if (values.size != 4 + 3 * targetCount + pathCount + 2 * bucketCount + 2) {
+                return null
+            }
+
+            var offset = 4
+
+            fun next(count: Int): List<Long> = values.slice(offset until offset + count).also { offset += count }
+
+            val calls = next(targetCount)
+            val allowed = next(targetCount)
+            val blocked = next(targetCount)
+            val paths = next(pathCount)
+            val upcallHistogram = next(bucketCount)
+            val originalHistogram = next(bucketCount)
+
+            return AgentInterceptionMetrics(
+                targets =
+                    (0 until targetCount).associate { i ->
+                        (TARGET_NAMES.getOrNull(i) ?: "target-$i") to Target(calls[i], allowed[i], blocked[i])
+                    },
+                paths = (0 until pathCount).associate { i -> (PATH_NAMES.getOrNull(i) ?: "path-$i") to paths[i] },
+                upcallHistogram = upcallHistogram,
+                originalHistogram = originalHistogram,
+                upcallTotalNanos = values[offset],
+                originalTotalNanos = values[offset + 1],
+            )
+        }
+
+        private fun List<Long>.minusEach(earlier: List<Long>): List<Long> =
+            mapIndexed { i, count -> count - (earlier.getOrNull(i) ?: 0L) }
+    }
+}
@@ -0,0 +1,14 @@
+package io.github.garryjeromson.junit.airgap.bytebuddy
+
+/**
+ * Counters of the JVMTI agent's per-thread connect verdict cache.
+ *
+ * Counts are JVM-wide and cumulative; take a delta around the code of interest.
+ *
+ * @property hits Connections allowed from the cache without policy evaluation
+ * @property misses Connections that went through full policy evaluation
+ */
+data class AgentVerdictCacheStats(
+    val hits: Long,
+    val misses: Long,
+)
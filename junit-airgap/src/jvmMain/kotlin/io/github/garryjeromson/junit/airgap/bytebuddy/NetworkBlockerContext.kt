@@ -1,9 +1,14 @@
 package io.github.garryjeromson.junit.airgap.bytebuddy
 
 import io.github.garryjeromson.junit.airgap.DebugLogger
+import io.github.garryjeromson.junit.airgap.ExtensionConfiguration
 import io.github.garryjeromson.junit.airgap.NetworkConfiguration
 import io.github.garryjeromson.junit.airgap.NetworkRequestAttemptedException
 import io.github.garryjeromson.junit.airgap.NetworkRequestDetails
+import io.github.garryjeromson.junit.airgap.StacklessNetworkRequestAttemptedException
+import java.lang.reflect.InvocationTargetException
+import java.lang.reflect.Proxy
+import java.util.concurrent.ConcurrentHashMap
 
 /**
  * Thread-local context for network blocking configuration.
@@ -30,8 +35,38 @@ import io.github.garryjeromson.junit.airgap.NetworkRequestDetails
  * This class also serves as the configuration source for the JVMTI native agent.
  * The static initializer registers this class with the agent (if loaded) to cache
  * class and method references, avoiding FindClass issues from native contexts.
+ *
+ * [setConfiguration] also pushes the allowed/blocked host lists down to the agent once,
+ * where they are compiled into a native matcher. The agent then decides allow/block
+ * without calling back into Kotlin, and only calls [checkConnection] to throw on a block.
+ *
+ * ## Checkpoint/Restore
+ * On a CRaC JVM this class registers a checkpoint resource with the agent (see
+ * [registerCheckpointHooks]). A fork restored from a checkpoint then keeps its bound
+ * interceptors and only has the agent revalidate its state, instead of starting the JVM and
+ * binding every target again.
  */
 object NetworkBlockerContext {
+    /**
+     * Whether the JVMTI agent is loaded and accepted our registration.
+     * Declared before the init block so the initializer doesn't overwrite the result.
+     */
+    @Volatile
+    private var agentRegistered = false
+
+    /**
+     * Whether an on-demand attach of the JVMTI agent was already tried (see [attachAgentOnDemand]).
+     */
+    @Volatile
+    private var agentAttachAttempted = false
+
+    /**
+     * CRaC resource registered by [registerCheckpointHooks]. CRaC only holds resources weakly,
+     * so this keeps it reachable. Declared before the init block, like [agentRegistered].
+     */
+    @Volatile
+    private var checkpointResource: Any? = null
+
     init {
         // Register with JVMTI agent (if loaded) to cache class/method references.
         // This avoids FindClass issues when the native agent tries to look us up
@@ -39,22 +74,246 @@ object NetworkBlockerContext {
         //
         // If the JVMTI agent is not loaded, this will throw UnsatisfiedLinkError,
         // which we catch and ignore (graceful degradation).
+        registerAgent()
+    }
+
+    /**
+     * Register with the JVMTI agent if it is loaded.
+     * Runs from the static initializer, so it must not use fields declared below it.
+     *
+     * @return true if the agent accepted the registration
+     */
+    private fun registerAgent(): Boolean =
         try {
             registerWithAgent()
+            agentRegistered = true
+
+            // Nothing is configured yet: let the agent skip hasActiveConfiguration() upcalls
+            // until the first setConfiguration()
+            setAgentArmState(false, 0L)
+            registerCheckpointHooks()
+            true
         } catch (e: UnsatisfiedLinkError) {
             // Agent not loaded - this is fine, JVMTI agent may not be available
             // The library will continue to function without native interception
+            false
+        }
+
+    /**
+     * Register a checkpoint resource with CRaC, if this JVM supports it: `jdk.crac` on a CRaC
+     * JDK, or else the `org.crac` facade if it is on the classpath (it delegates to `jdk.crac`
+     * when present). Neither is a compile-time dependency, so the resource is a proxy.
+     * Runs from the static initializer (through [registerAgent]), so it must not use fields
+     * declared below it; the resource's callbacks only run at a checkpoint.
+     */
+    private fun registerCheckpointHooks() {
+        if (checkpointResource != null) {
+            return
+        }
+        for (api in listOf("jdk.crac", "org.crac")) {
+            try {
+                val resourceInterface = Class.forName("$api.Resource")
+                val resource =
+                    Proxy.newProxyInstance(
+                        NetworkBlockerContext::class.java.classLoader,
+                        arrayOf(resourceInterface),
+                    ) { proxy, method, args ->
+                        when (method.name) {
+                            "beforeCheckpoint" -> beforeCheckpoint()
+                            "afterRestore" -> afterRestore()
+                            "hashCode" -> System.identityHashCode(proxy)
+                            "equals" -> proxy === args?.get(0)
+                            "toString" -> "NetworkBlockerContext checkpoint resource"
+                            else -> null
+                        }
+                    }
+                val context = Class.forName("$api.Core").getMethod("getGlobalContext").invoke(null)
+                Class.forName("$api.Context").getMethod("register", resourceInterface).invoke(context, resource)
+                checkpointResource = resource
+                return
+            } catch (e: Exception) {
+                // Not a CRaC JVM, or this API isn't available: try the next one
+            }
+        }
+    }
+
+    /**
+     * Prepare the agent for a checkpoint. Nothing the agent cached before it may be used after
+     * the restore, where DNS answers and the network differ: the generation is advanced (a
+     * parked context is then revived with empty caches) and the agent is left disarmed unless
+     * a test is running. Then the agent flushes its DNS result cache, writes out its trace and
+     * unmaps its event ring.
+     */
+    private fun beforeCheckpoint() {
+        synchronized(lifecycleLock) {
+            logger.debug { "NetworkBlockerContext: Checkpoint, incrementing generation: $currentGeneration" }
+            currentGeneration++
+            withAgent { setAgentArmState(globalConfiguration != null, currentGeneration) }
+            withAgent { quiesceAgentForCheckpoint() }
+        }
+    }
+
+    /**
+     * Revalidate the agent after a restore and republish the running test's configuration,
+     * if any. The interceptors are still bound, and the agent's registration of this class
+     * survives the checkpoint, so this costs no bind events.
+     */
+    private fun afterRestore() {
+        synchronized(lifecycleLock) {
+            val complete = withAgent { restoreAgentAfterCheckpoint() } ?: return
+            logger.debug { "NetworkBlockerContext: Restored from checkpoint (agent state complete: $complete)" }
+            val configuration = globalConfiguration
+            if (configuration != null) {
+                withAgent { setAgentSharedContext(sharedConfiguration) }
+                publishJvmWideContext(configuration)
+            } else {
+                withAgent { setAgentArmState(false, currentGeneration) }
+            }
         }
     }
 
     /**
      * Native method to register this class with the JVMTI agent.
-     * Called from static initializer to cache class/method references.
-     * Only works if JVMTI agent is loaded via -agentpath at JVM startup.
+     * Called from static initializer to cache class/method references, and again after
+     * the agent is attached on demand.
      */
     @JvmStatic
     private external fun registerWithAgent()
 
+    /**
+     * Native method to compile and publish the host policy in the JVMTI agent.
+     * Drops the DNS results cached under the previous one.
+     *
+     * @param allowedHosts Allowed host patterns (same syntax as [NetworkConfiguration.allowedHosts])
+     * @param blockedHosts Blocked host patterns (same syntax as [NetworkConfiguration.blockedHosts])
+     * @param dnsCacheTtlMillis [NetworkConfiguration.dnsCacheTtlMillis] (0 disables the DNS result cache)
+     */
+    @JvmStatic
+    private external fun setAgentHostPolicy(
+        allowedHosts: Array<String>,
+        blockedHosts: Array<String>,
+        dnsCacheTtlMillis: Long,
+    )
+
+    /**
+     * Native method to clear the host policy published in the JVMTI agent.
+     */
+    @JvmStatic
+    private external fun clearAgentHostPolicy()
+
+    /**
+     * Native method to compile and publish the host policy of one test context in the JVMTI agent.
+     * Threads whose [activeContextId] is [contextId] are evaluated against it, and their lookups
+     * use the context's own DNS result cache.
+     *
+     * @param contextId Test context ([NetworkConfiguration.generation])
+     * @param allowedHosts Allowed host patterns (same syntax as [NetworkConfiguration.allowedHosts])
+     * @param blockedHosts Blocked host patterns (same syntax as [NetworkConfiguration.blockedHosts])
+     * @param dnsCacheTtlMillis [NetworkConfiguration.dnsCacheTtlMillis] (0 disables the DNS result cache)
+     */
+    @JvmStatic
+    private external fun setAgentContextPolicy(
+        contextId: Long,
+        allowedHosts: Array<String>,
+        blockedHosts: Array<String>,
+        dnsCacheTtlMillis: Long,
+    )
+
+    /**
+     * Native method to drop the host policy and cached DNS results of a finished test context.
+     *
+     * @param contextId Test context ([NetworkConfiguration.generation])
+     */
+    @JvmStatic
+    private external fun clearAgentContextPolicy(contextId: Long)
+
+    /**
+     * Native method to mirror the configuration state into the JVMTI agent.
+     *
+     * While disarmed the agent allows every connection and DNS lookup without calling
+     * [hasActiveConfiguration]. A new [generation] invalidates every cached connect verdict.
+     *
+     * @param armed Whether a configuration is set (see [globalConfiguration])
+     * @param generation Current value of [currentGeneration]
+     */
+    @JvmStatic
+    private external fun setAgentArmState(
+        armed: Boolean,
+        generation: Long,
+    )
+
+    /**
+     * Native method to mirror the configuration scope into the JVMTI agent.
+     *
+     * While a shared configuration is armed the agent skips the per-thread
+     * [hasActiveConfiguration] upcall; [evaluate] still decides every blocked request.
+     *
+     * @param shared Whether the configuration applies to every thread (see [sharedConfiguration])
+     */
+    @JvmStatic
+    private external fun setAgentSharedContext(shared: Boolean)
+
+    /**
+     * Native method to read the agent's connect verdict cache counters.
+     *
+     * @return `[hits, misses]`
+     */
+    @JvmStatic
+    private external fun getAgentVerdictCacheStats(): LongArray
+
+    /**
+     * Native method to install a test context's hosts overrides, replacing its previous ones.
+     *
+     * @param contextId Test context ([NetworkConfiguration.generation])
+     * @param hostnames Overridden hostnames (keys of [NetworkConfiguration.hostOverrides])
+     * @param addresses IP literal for each hostname, at the same index
+     */
+    @JvmStatic
+    private external fun setAgentHostOverrides(
+        contextId: Long,
+        hostnames: Array<String>,
+        addresses: Array<String>,
+    )
+
+    /**
+     * Native method to read the agent's DNS result cache counters.
+     *
+     * @return `[hits, misses]`
+     */
+    @JvmStatic
+    private external fun getAgentDnsCacheStats(): LongArray
+
+    /**
+     * Native method to write the agent's interception trace buffers to its trace file.
+     *
+     * @return Number of records written, or -1 if tracing is disabled
+     */
+    @JvmStatic
+    private external fun dumpAgentTrace(): Long
+
+    /**
+     * Native method to read the agent's interception metrics, summed over its shards.
+     *
+     * @return Metrics array (see [AgentInterceptionMetrics.fromArray]), or null if metrics are disabled
+     */
+    @JvmStatic
+    private external fun getAgentMetrics(): LongArray?
+
+    /**
+     * Native method to quiesce the JVMTI agent before a CRaC checkpoint.
+     * Disarm it and advance [currentGeneration] first (see [beforeCheckpoint]).
+     */
+    @JvmStatic
+    private external fun quiesceAgentForCheckpoint()
+
+    /**
+     * Native method to revalidate the JVMTI agent's state after a CRaC restore.
+     *
+     * @return false if an intercepted native's original implementation can't be called any more
+     */
+    @JvmStatic
+    private external fun restoreAgentAfterCheckpoint(): Boolean
+
     /**
      * Thread-local storage for network configuration.
      * Uses InheritableThreadLocal so that configuration is inherited by child threads
@@ -63,95 +322,405 @@ object NetworkBlockerContext {
     private val configurationThreadLocal = InheritableThreadLocal<NetworkConfiguration?>()
 
     /**
-     * Global generation counter to invalidate stale configurations in inherited threads.
-     * Incremented each time clearConfiguration() is called.
+     * Global generation counter, mirrored into the JVMTI agent to invalidate its caches.
+     * Incremented each time the last active configuration is cleared, unless its context is
+     * parked ([parkedConfiguration]), and when a parked context is dropped.
      */
     @Volatile
     private var currentGeneration = 0L
 
     /**
-     * Global reference to the currently active configuration.
+     * Configurations of the tests currently running, keyed by context ID ([NetworkConfiguration.generation]).
+     * Several are active at once under in-JVM parallel execution. A thread-local configuration
+     * stays valid exactly as long as its context is registered here, so one test ending never
+     * invalidates the threads of another.
+     */
+    private val activeContexts = ConcurrentHashMap<Long, NetworkConfiguration>()
+
+    /**
+     * Source of context IDs. Never reused by another configuration: only a revived context (see
+     * [parkedConfiguration]) keeps its ID. A stale inherited configuration still can't match it,
+     * because [activeContexts] then holds the new test's configuration instance.
+     */
+    private var nextContextId = 1L
+
+    /**
+     * Last test's configuration, whose context is left in the agent after the test ended: its host
+     * policy, hosts overrides and the verdicts and DNS bindings cached under the current generation.
+     * Only the agent is disarmed. If the next test's configuration is equal, [setConfiguration]
+     * revives the context by arming the agent again; the tests of a class then install no new policy
+     * and keep every cached decision. Any other configuration drops it first.
+     *
+     * Configurations with a DNS cache TTL are never parked, since their cached results must not
+     * outlive the test. Guarded by [lifecycleLock].
+     */
+    private var parkedConfiguration: NetworkConfiguration? = null
+
+    /**
+     * Serializes [setConfiguration] and [clearConfiguration] (once per test each), so the JVM-wide
+     * state pushed to the agent always describes the most recently started running test.
+     */
+    private val lifecycleLock = Any()
+
+    /**
+     * Global reference to the most recently started active configuration.
      * Used to provide fresh configuration to worker threads.
      */
     @Volatile
     private var globalConfiguration: NetworkConfiguration? = null
 
+    /**
+     * Whether [globalConfiguration] applies to every thread ([ExtensionConfiguration.isSharedConfigurationEnabled]).
+     * Then no thread-local state is written or read: the configuration is one JVM-wide test context,
+     * which keeps millions of short-lived virtual threads from each carrying a copy.
+     */
+    @Volatile
+    private var sharedConfiguration = false
+
     /**
      * Debug logger for troubleshooting network blocking issues.
      */
     private val logger = DebugLogger.instance
 
+    /**
+     * Frames listed under "Called from" in a blocked request's details.
+     */
+    private const val CALLER_FRAME_COUNT = 10L
+
+    /**
+     * [evaluate] results. The JVMTI agent mirrors these values (kVerdict* in agent.h).
+     */
+    const val VERDICT_ALLOW = 0
+    const val VERDICT_BLOCK_HOSTNAME = 1
+    const val VERDICT_BLOCK_ADDRESS = 2
+
     /**
      * Set the configuration for the current thread.
      *
+     * Starts a new test context: the configuration gets a fresh context ID, its own host policy and
+     * hosts overrides in the agent, and becomes the [globalConfiguration]. Tests running in parallel
+     * in the same JVM keep their own contexts. A context this thread had already started is replaced.
+     *
+     * If no test is running and [configuration] equals the last test's, that test's parked context
+     * is revived instead (see [parkedConfiguration]): nothing is recompiled and the agent's caches
+     * stay valid, which keeps the per-test cost constant for the tests of a class.
+     *
      * @param configuration Network configuration for this test
      */
     @JvmStatic
     fun setConfiguration(configuration: NetworkConfiguration) {
-        // Set the generation on the configuration
-        configuration.generation = currentGeneration
+        synchronized(lifecycleLock) {
+            attachAgentOnDemand()
+            currentContext()?.let { retireContext(it) }
+
+            val shared = ExtensionConfiguration.isSharedConfigurationEnabled()
+            val parked = parkedConfiguration
+            if (parked != null) {
+                parkedConfiguration = null
+                if (activeContexts.isEmpty() && shared == sharedConfiguration && parked == configuration) {
+                    reviveContext(parked.generation, configuration)
+                    return
+                }
+                dropParkedContext(parked)
+            }
 
-        logger.debug { "NetworkBlockerContext: Setting configuration for thread ${Thread.currentThread().name}" }
-        logger.debug { "  allowedHosts: ${configuration.allowedHosts}" }
-        logger.debug { "  blockedHosts: ${configuration.blockedHosts}" }
-        logger.debug { "  generation: ${configuration.generation}" }
+            // The context ID doubles as the configuration's generation
+            val contextId = nextContextId++
+            configuration.generation = contextId
+
+            // One check instead of a lambda allocation per line on every test
+            if (logger.isEnabled) {
+                logger.debug { "NetworkBlockerContext: Setting configuration for ${Thread.currentThread().name}" }
+                logger.debug { "  allowedHosts: ${configuration.allowedHosts}" }
+                logger.debug { "  blockedHosts: ${configuration.blockedHosts}" }
+                logger.debug { "  dnsCacheTtlMillis: ${configuration.dnsCacheTtlMillis}" }
+                logger.debug { "  hostOverrides: ${configuration.hostOverrides}" }
+                logger.debug { "  context: $contextId (${activeContexts.size} other active)" }
+            }
 
-        globalConfiguration = configuration
-        configurationThreadLocal.set(configuration)
+            sharedConfiguration = shared
+            activeContexts[contextId] = configuration
+            globalConfiguration = configuration
+            if (shared) {
+                configurationThreadLocal.remove()
+            } else {
+                configurationThreadLocal.set(configuration)
+            }
+
+            // Before arming, so the agent never skips activeContextId() for a per-thread configuration
+            withAgent { setAgentSharedContext(shared) }
+            withAgent {
+                // Overridden hosts are allowed, like in NetworkConfiguration.isAllowed()
+                setAgentContextPolicy(
+                    contextId,
+                    (configuration.allowedMatcher.patterns + configuration.hostOverrides.keys).toTypedArray(),
+                    configuration.blockedMatcher.patterns.toTypedArray(),
+                    configuration.dnsCacheTtlMillis,
+                )
+            }
+            withAgent {
+                val overrides = configuration.hostOverrides.toList()
+                setAgentHostOverrides(
+                    contextId,
+                    overrides.map { it.first }.toTypedArray(),
+                    overrides.map { it.second }.toTypedArray(),
+                )
+            }
+            publishJvmWideContext(configuration)
+        }
     }
 
     /**
      * Clear the configuration for the current thread.
-     * Also increments the generation counter to invalidate any stale configurations
-     * in child threads (worker threads, coroutine threads, etc.).
+     *
+     * Ends the test context this thread started (or, from any other thread, the [globalConfiguration]'s).
+     * Other running tests keep theirs. Once no context is left, also disarms the agent, and either
+     * parks the context for an equal next configuration ([parkedConfiguration]) or increments the
+     * generation counter to invalidate the agent's caches.
      */
     @JvmStatic
     fun clearConfiguration() {
-        logger.debug { "NetworkBlockerContext: Clearing configuration for thread ${Thread.currentThread().name}" }
-        logger.debug { "  Incrementing generation: $currentGeneration -> ${currentGeneration + 1}" }
+        synchronized(lifecycleLock) {
+            logger.debug { "NetworkBlockerContext: Clearing configuration for thread ${Thread.currentThread().name}" }
 
-        globalConfiguration = null
-        configurationThreadLocal.remove()
-        currentGeneration++ // Invalidate all inherited configurations
+            val configuration = currentContext() ?: globalConfiguration
+            configurationThreadLocal.remove()
+            configuration?.let { retireContext(it) }
+        }
+    }
+
+    /**
+     * Attach the JVMTI agent through the Attach API if it isn't loaded yet and the plugin deferred
+     * loading it to the first test that needs it ([ExtensionConfiguration.getNativeAgentPath]).
+     * Tried once per JVM; on failure the ByteBuddy and Java-level interception still apply.
+     * Caller holds [lifecycleLock].
+     */
+    private fun attachAgentOnDemand() {
+        if (agentRegistered || agentAttachAttempted) {
+            return
+        }
+        agentAttachAttempted = true
+        val agentPath = ExtensionConfiguration.getNativeAgentPath() ?: return
+
+        logger.debug { "NetworkBlockerContext: Attaching JVMTI agent from $agentPath" }
+        try {
+            // jdk.attach is in every JDK image, but not a compile-time dependency of this module
+            val virtualMachine = Class.forName("com.sun.tools.attach.VirtualMachine")
+            val vm =
+                virtualMachine
+                    .getMethod("attach", String::class.java)
+                    .invoke(null, ProcessHandle.current().pid().toString())
+            try {
+                virtualMachine
+                    .getMethod("loadAgentPath", String::class.java, String::class.java)
+                    .invoke(vm, agentPath, ExtensionConfiguration.getNativeAgentOptions().ifEmpty { null })
+            } finally {
+                virtualMachine.getMethod("detach").invoke(vm)
+            }
+        } catch (e: Exception) {
+            val cause = (e as? InvocationTargetException)?.targetException ?: e
+            System.err.println(
+                "[junit-airgap] WARNING: Failed to attach the JVMTI agent: ${cause.javaClass.name}: ${cause.message}",
+            )
+            return
+        }
+
+        if (!registerAgent()) {
+            System.err.println("[junit-airgap] WARNING: JVMTI agent attached but NetworkBlockerContext can't reach it")
+        }
+    }
+
+    /**
+     * This thread's own active test context, if it has one.
+     */
+    private fun currentContext(): NetworkConfiguration? {
+        val configuration = if (sharedConfiguration) globalConfiguration else configurationThreadLocal.get()
+        return configuration?.takeIf { activeContexts[it.generation] === it }
+    }
+
+    /**
+     * End a test context and republish the most recently started remaining one JVM-wide.
+     * The last one is parked if its configuration allows (see [parkedConfiguration]).
+     * Caller holds [lifecycleLock].
+     */
+    private fun retireContext(configuration: NetworkConfiguration) {
+        val contextId = configuration.generation
+        activeContexts.remove(contextId, configuration)
+
+        val latest = activeContexts.values.maxByOrNull { it.generation }
+        globalConfiguration = latest
+        if (latest == null && configuration.dnsCacheTtlMillis == 0L) {
+            // Its policy stays published JVM-wide and in its slot, unused while disarmed
+            logger.debug { "  Last context ended, parking context $contextId" }
+            parkedConfiguration = configuration
+            withAgent { setAgentArmState(false, currentGeneration) }
+            return
+        }
+
+        withAgent { clearAgentContextPolicy(contextId) }
+        withAgent { setAgentHostOverrides(contextId, emptyArray(), emptyArray()) }
+        if (latest != null) {
+            logger.debug { "  Context $contextId ended, ${activeContexts.size} still active" }
+            publishJvmWideContext(latest)
+            return
+        }
+
+        logger.debug { "  Last context ended, incrementing generation: $currentGeneration -> ${currentGeneration + 1}" }
+        currentGeneration++ // Invalidate the agent's caches
+        withAgent {
+            clearAgentHostPolicy()
+            setAgentArmState(false, currentGeneration)
+        }
+    }
+
+    /**
+     * Make [configuration] the running test's configuration in the parked context [contextId].
+     * The agent still holds the equal policy and overrides, so only arming it is left. The new
+     * instance replaces the parked one in [activeContexts], so threads the previous test left
+     * behind don't take part in this test's context. Caller holds [lifecycleLock].
+     */
+    private fun reviveContext(
+        contextId: Long,
+        configuration: NetworkConfiguration,
+    ) {
+        logger.debug { "NetworkBlockerContext: Reviving context $contextId for ${Thread.currentThread().name}" }
+        configuration.generation = contextId
+        activeContexts[contextId] = configuration
+        globalConfiguration = configuration
+        if (sharedConfiguration) {
+            configurationThreadLocal.remove()
+        } else {
+            configurationThreadLocal.set(configuration)
+        }
+        withAgent { setAgentArmState(true, currentGeneration) }
+    }
+
+    /**
+     * Remove a parked context from the agent before another configuration is installed, and
+     * invalidate what the agent cached for it. The agent is disarmed, and the caller publishes
+     * the next configuration's JVM-wide policy. Caller holds [lifecycleLock].
+     */
+    private fun dropParkedContext(configuration: NetworkConfiguration) {
+        val contextId = configuration.generation
+        logger.debug { "  Dropping parked context $contextId, incrementing generation: $currentGeneration" }
+        withAgent { clearAgentContextPolicy(contextId) }
+        withAgent { setAgentHostOverrides(contextId, emptyArray(), emptyArray()) }
+        currentGeneration++
+    }
+
+    /**
+     * Push [configuration] to the agent as the JVM-wide context: the host policy used without a
+     * per-thread context (shared configuration, libc interception), with its DNS cache TTL for
+     * lookups in that context. Caller holds [lifecycleLock].
+     */
+    private fun publishJvmWideContext(configuration: NetworkConfiguration) {
+        withAgent {
+            setAgentHostPolicy(
+                (configuration.allowedMatcher.patterns + configuration.hostOverrides.keys).toTypedArray(),
+                configuration.blockedMatcher.patterns.toTypedArray(),
+                configuration.dnsCacheTtlMillis,
+            )
+            setAgentArmState(true, currentGeneration)
+        }
+    }
+
+    /**
+     * Get the JVMTI agent's connect verdict cache statistics.
+     *
+     * @return Cache statistics, or null if the agent is not loaded
+     */
+    @JvmStatic
+    fun getVerdictCacheStats(): AgentVerdictCacheStats? =
+        withAgent {
+            val stats = getAgentVerdictCacheStats()
+            AgentVerdictCacheStats(hits = stats[0], misses = stats[1])
+        }
+
+    /**
+     * Get the JVMTI agent's DNS result cache statistics (see [NetworkConfiguration.dnsCacheTtlMillis]).
+     *
+     * @return Cache statistics, or null if the agent is not loaded
+     */
+    @JvmStatic
+    fun getDnsCacheStats(): AgentDnsCacheStats? =
+        withAgent {
+            val stats = getAgentDnsCacheStats()
+            AgentDnsCacheStats(hits = stats[0], misses = stats[1])
+        }
+
+    /**
+     * Write the JVMTI agent's interception trace (agent option `trace=<file>`) recorded
+     * since the last dump to the trace file. The agent also does this when the JVM exits.
+     *
+     * @return Number of records written, or null if the agent is not loaded or tracing is off
+     */
+    @JvmStatic
+    fun dumpTrace(): Long? = withAgent { dumpAgentTrace() }?.takeIf { it >= 0 }
+
+    /**
+     * Get the JVMTI agent's interception metrics (agent option `metrics`).
+     *
+     * @return Cumulative metrics, or null if the agent is not loaded or metrics are off
+     */
+    @JvmStatic
+    fun getInterceptionMetrics(): AgentInterceptionMetrics? =
+        withAgent { getAgentMetrics() }?.let { AgentInterceptionMetrics.fromArray(it) }
+
+    /**
+     * Run [block] against the JVMTI agent if it is loaded.
+     *
+     * An older agent may lack newer entry points; the resulting UnsatisfiedLinkError is
+     * swallowed so the agent falls back to calling [checkConnection] for every decision.
+     *
+     * @return Result of [block], or null if the agent is not loaded or lacks the entry point
+     */
+    private inline fun <T> withAgent(block: () -> T): T? {
+        if (!agentRegistered) {
+            return null
+        }
+        return try {
+            block()
+        } catch (e: UnsatisfiedLinkError) {
+            logger.debug { "  JVMTI agent does not support ${e.message}" }
+            null
+        }
     }
 
     /**
      * Get the current thread's configuration.
      * If the thread-local config is stale, returns the global config instead.
      *
+     * Called on every intercepted request, so the common paths neither allocate (no capturing
+     * debug lambdas) nor touch the thread-local when nothing is configured or the configuration
+     * is shared. Virtual threads skip the Gradle worker name check.
+     *
      * @return Current configuration, or null if not set
      */
     @JvmStatic
     fun getConfiguration(): NetworkConfiguration? {
-        val config = configurationThreadLocal.get()
-        val threadName = Thread.currentThread().name
-
-        logger.debug { "NetworkBlockerContext.getConfiguration() on thread $threadName" }
-        logger.debug { "  ThreadLocal config: $config" }
-        logger.debug { "  Current generation: $currentGeneration" }
-        logger.debug { "  Global config: $globalConfiguration" }
-
-        // If we have a config and it matches current generation, use it
-        if (config != null && config.generation == currentGeneration) {
-            logger.debug { "  Using thread-local config (generation matches)" }
-            return config
+        // Nothing configured anywhere: a thread-local config can only be stale.
+        // Checked first so virtual threads that never had a configuration don't get a
+        // ThreadLocalMap allocated by configurationThreadLocal.get().
+        val global = globalConfiguration ?: return null
+
+        if (!sharedConfiguration) {
+            // If we have a config and its test is still running, use it
+            val config = configurationThreadLocal.get()
+            if (config != null && activeContexts[config.generation] === config) {
+                return config
+            }
         }
 
         // Don't use global configuration for Gradle worker threads
         // This prevents the JVMTI agent from blocking Gradle's Maven artifact fetching
         // See: docs/investigation/macos-ci-failures.md
-        if (isGradleWorkerThread(threadName)) {
+        val thread = Thread.currentThread()
+        if (!thread.isVirtual && isGradleWorkerThread(thread.name)) {
             logger.debug { "  Detected Gradle worker thread, not applying global configuration" }
             return null
         }
 
         // Otherwise, use the global configuration (for HTTP client worker threads)
-        val global = globalConfiguration
-        if (global != null) {
-            logger.debug { "  Using global configuration (thread-local was stale or missing)" }
-        } else {
-            logger.debug { "  No configuration available!" }
-        }
         return global
     }
 
@@ -191,14 +760,16 @@ object NetworkBlockerContext {
      * @return true if a configuration is set for the current thread, false otherwise
      */
     @JvmStatic
-    fun hasActiveConfiguration(): Boolean {
-        val config = getConfiguration()
-        val hasConfig = config != null
-        logger.debug {
-            "NetworkBlockerContext.hasActiveConfiguration() = $hasConfig (thread=${Thread.currentThread().name})"
-        }
-        return hasConfig
-    }
+    fun hasActiveConfiguration(): Boolean = getConfiguration() != null
+
+    /**
+     * Get the test context of the current thread.
+     * Called by the JVMTI agent before evaluating a request, to pick that context's host policy.
+     *
+     * @return Context ID ([NetworkConfiguration.generation]), or 0 if no configuration is set for this thread
+     */
+    @JvmStatic
+    fun activeContextId(): Long = getConfiguration()?.generation ?: 0L
 
     /**
      * Check if a connection to the given host:port should be allowed.
@@ -227,41 +798,127 @@ object NetworkBlockerContext {
             return
         }
 
+        // Check if allowed
+        val allowed = configuration.isAllowed(host)
+        logger.debug { "  isAllowed($host) = $allowed" }
+
+        if (allowed) {
+            return
+        }
+
         // Check if this is Robolectric's MavenArtifactFetcher downloading android-all JARs
         // Robolectric lazily downloads Android framework JARs at test runtime from Maven Central
-        // These downloads are infrastructure, not test code, so we should allow them
+        // These downloads are infrastructure, not test code, so we should allow them.
+        // Only checked for blocked connections, since it has to walk the stack.
         if (isRobolectricArtifactDownload()) {
             logger.debug { "  Detected Robolectric artifact download, allowing connection to $host:$port" }
             return
         }
 
-        // Check if allowed
-        val allowed = configuration.isAllowed(host)
-        logger.debug { "  isAllowed($host) = $allowed" }
+        throw blockedRequestException(host, port, caller)
+    }
 
-        if (!allowed) {
-            val details =
-                NetworkRequestDetails(
-                    host = host,
-                    port = port,
-                    url = "$host:$port",
-                    stackTrace =
-                        Thread
-                            .currentThread()
-                            .stackTrace
-                            .drop(2) // Skip checkConnection and caller
-                            .take(10)
-                            .joinToString("\n") { "  at $it" },
-                )
+    /**
+     * Final verdict for a request the JVMTI agent's native host policy blocked.
+     *
+     * Applies the native engine's rules in the same order against the current thread's
+     * configuration, then the exemptions only NetworkBlockerContext knows about (no
+     * configuration between tests, Robolectric artifact downloads). Returns a code instead
+     * of throwing so the agent needs a single upcall to tell a fallback allow from a block;
+     * only a block makes a second call, to [blockedRequestException], and throws its result.
+     *
+     * Called from the JVMTI agent only.
+     *
+     * @param hostname Hostname of the request, or null if unknown
+     * @param address IP address of the request, or null for a DNS lookup
+     * @param port Port number (-1 for DNS)
+     * @return [VERDICT_ALLOW], [VERDICT_BLOCK_HOSTNAME] or [VERDICT_BLOCK_ADDRESS]
+     */
+    @JvmStatic
+    fun evaluate(
+        hostname: String?,
+        address: String?,
+        port: Int,
+    ): Int {
+        val configuration = getConfiguration()
+
+        logger.debug { "NetworkBlockerContext.evaluate: hostname=$hostname, address=$address, port=$port" }
+
+        if (configuration == null) {
+            logger.debug { "  No configuration set, allowing request" }
+            return VERDICT_ALLOW
+        }
+
+        // Same order as the native engine: explicit blocks, then allows, then block by default
+        val verdict =
+            when {
+                hostname != null && configuration.isExplicitlyBlocked(hostname) -> VERDICT_BLOCK_HOSTNAME
+                address != null && configuration.isExplicitlyBlocked(address) -> VERDICT_BLOCK_ADDRESS
+                address != null && configuration.isAllowed(address) -> VERDICT_ALLOW
+                hostname != null && configuration.isAllowed(hostname) -> VERDICT_ALLOW
+                address != null -> VERDICT_BLOCK_ADDRESS
+                hostname != null -> VERDICT_BLOCK_HOSTNAME
+                else -> VERDICT_ALLOW
+            }
 
-            throw NetworkRequestAttemptedException(
-                "Network request blocked by @BlockNetworkRequests: " +
-                    "Attempted to connect to $host:$port via $caller",
-                requestDetails = details,
+        if (verdict != VERDICT_ALLOW && isRobolectricArtifactDownload()) {
+            logger.debug { "  Detected Robolectric artifact download, allowing request" }
+            return VERDICT_ALLOW
+        }
+
+        logger.debug { "  evaluate = $verdict" }
+        return verdict
+    }
+
+    /**
+     * Build the exception for a blocked request.
+     *
+     * The "Called from" frames come from a short [StackWalker] walk rather than a full
+     * `Thread.getStackTrace()`, so the exception's own stack trace is the only full capture -
+     * and with [ExtensionConfiguration.isStacklessExceptionsEnabled] there is none at all.
+     *
+     * Also called by the JVMTI agent after [evaluate] reported a block; the agent throws it.
+     */
+    @JvmStatic
+    fun blockedRequestException(
+        host: String,
+        port: Int,
+        caller: String,
+    ): NetworkRequestAttemptedException {
+        val message =
+            "Network request blocked by @BlockNetworkRequests: " +
+                "Attempted to connect to $host:$port via $caller"
+
+        if (ExtensionConfiguration.isStacklessExceptionsEnabled()) {
+            return StacklessNetworkRequestAttemptedException(
+                message,
+                requestDetails = NetworkRequestDetails(host = host, port = port, url = "$host:$port"),
             )
         }
+
+        val details =
+            NetworkRequestDetails(
+                host = host,
+                port = port,
+                url = "$host:$port",
+                stackTrace = callerFrames(),
+            )
+        return NetworkRequestAttemptedException(message, requestDetails = details)
     }
 
+    /**
+     * The first frames outside NetworkBlockerContext (walks only as deep as needed).
+     */
+    private fun callerFrames(): String =
+        StackWalker.getInstance().walk { frames ->
+            frames
+                .dropWhile { it.className == NetworkBlockerContext::class.java.name }
+                .limit(CALLER_FRAME_COUNT)
+                .map { "  at ${it.toStackTraceElement()}" }
+                .toList()
+                .joinToString("\n")
+        }
+
     /**
      * Check if the current call stack indicates a Robolectric artifact download.
      * Robolectric's MavenArtifactFetcher downloads android-all JARs at test runtime.
@@ -270,34 +927,37 @@ object NetworkBlockerContext {
      */
     @JvmStatic // Make accessible for testing
     internal fun isRobolectricArtifactDownload(): Boolean {
-        val stackTrace = Thread.currentThread().stackTrace
-
-        // DEBUG: Print full stack trace to investigate CI failures
-        logger.debug { "=== FULL STACK TRACE FOR ROBOLECTRIC DETECTION ===" }
-        stackTrace.forEachIndexed { index, element ->
-            val frame = "${element.className}.${element.methodName}"
-            val location = "(${element.fileName}:${element.lineNumber})"
-            logger.debug { "  [$index] $frame$location" }
-        }
-        logger.debug { "=== END STACK TRACE ===" }
-
-        return stackTrace.any { element ->
-            val className = element.className
-            val matches =
-                className.contains("org.robolectric.internal.dependency.MavenArtifactFetcher") ||
-                    className.contains("org.robolectric.internal.dependency.MavenDependencyResolver")
-            if (matches) {
-                logger.debug { "Detected Robolectric class in stack: $className" }
+        logger.debug {
+            // DEBUG: Print full stack trace to investigate CI failures
+            val frames =
+                Thread.currentThread().stackTrace.mapIndexed { index, element ->
+                    "  [$index] ${element.className}.${element.methodName}(${element.fileName}:${element.lineNumber})"
+                }
+            (
+                listOf("=== FULL STACK TRACE FOR ROBOLECTRIC DETECTION ===") + frames +
+                    "=== END STACK TRACE ==="
+            ).joinToString("\n")
+        }
+
+        return StackWalker.getInstance().walk { frames ->
+            frames.anyMatch { frame ->
+                val className = frame.className
+                val matches =
+                    className.contains("org.robolectric.internal.dependency.MavenArtifactFetcher") ||
+                        className.contains("org.robolectric.internal.dependency.MavenDependencyResolver")
+                if (matches) {
+                    logger.debug { "Detected Robolectric class in stack: $className" }
+                }
+                matches
             }
-            matches
         }
     }
 
     /**
      * Check if a host is explicitly in the blockedHosts list.
      *
-     * This is used by the JVMTI agent to determine if a hostname/IP should be blocked
-     * regardless of whether an alternative identifier (hostname vs IP) is allowed.
+     * The JVMTI agent evaluates the same rule natively from the pushed host policy;
+     * this remains the reference implementation for ByteBuddy advice and tests.
      *
      * @param host Hostname or IP address to check
      * @return true if host is explicitly blocked, false otherwise
@@ -315,46 +975,10 @@ object NetworkBlockerContext {
             return false
         }
 
-        // Check if host matches any pattern in blockedHosts
-        val normalizedHost = host.lowercase()
-        val blocked =
-            configuration.blockedHosts.any { pattern ->
-                val matches = matchesPattern(normalizedHost, pattern.lowercase())
-                if (matches) {
-                    logger.debug { "  Host $host matches blocked pattern: $pattern" }
-                }
-                matches
-            }
+        val blocked = configuration.isExplicitlyBlocked(host)
 
         logger.debug { "  isExplicitlyBlocked($host) = $blocked" }
 
         return blocked
     }
-
-    /**
-     * Check if a host matches a wildcard pattern.
-     * This mirrors the logic in NetworkConfiguration.matchesPattern().
-     *
-     * @param host Normalized (lowercase) hostname
-     * @param pattern Normalized (lowercase) pattern with wildcards
-     * @return true if host matches pattern
-     */
-    private fun matchesPattern(
-        host: String,
-        pattern: String,
-    ): Boolean {
-        // Handle wildcard for "allow all"
-        if (pattern == "*") {
-            return true
-        }
-
-        // Convert wildcard pattern to regex
-        // Escape special regex characters except *
-        val regexPattern =
-            pattern
-                .replace(".", "\\.")
-                .replace("*", ".*")
-
-        return host.matches(Regex("^$regexPattern$"))
-    }
 }
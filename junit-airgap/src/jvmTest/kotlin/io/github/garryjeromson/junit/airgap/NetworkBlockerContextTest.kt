@@ -2,6 +2,8 @@ package io.github.garryjeromson.junit.airgap
 
 import io.github.garryjeromson.junit.airgap.bytebuddy.NetworkBlockerContext
 import org.junit.jupiter.api.AfterEach
+import org.junit.jupiter.api.Assertions.assertEquals
+import org.junit.jupiter.api.Assertions.assertFalse
 import org.junit.jupiter.api.Assertions.assertTrue
 import org.junit.jupiter.api.Test
 import org.junit.jupiter.api.assertThrows
@@ -126,6 +128,102 @@ class NetworkBlockerContextTest {
         }
     }
 
+    @Test
+    fun `checkConnection lists the caller's frames in the request details`() {
+        NetworkBlockerContext.setConfiguration(NetworkConfiguration())
+
+        val exception =
+            assertThrows<NetworkRequestAttemptedException> {
+                NetworkBlockerContext.checkConnection("example.com", 443, "test-caller")
+            }
+
+        val calledFrom = exception.requestDetails!!.stackTrace!!
+        assertFalse(calledFrom.lines().first().contains("NetworkBlockerContext")) {
+            "Called-from frames should start outside NetworkBlockerContext, but were:\n$calledFrom"
+        }
+        assertTrue(exception.stackTrace.isNotEmpty(), "Exceptions carry a stack trace by default")
+    }
+
+    @Test
+    fun `checkConnection throws a stackless exception when enabled`() {
+        NetworkBlockerContext.setConfiguration(NetworkConfiguration())
+        System.setProperty(STACKLESS_EXCEPTIONS_PROPERTY, "true")
+        try {
+            val exception =
+                assertThrows<NetworkRequestAttemptedException> {
+                    NetworkBlockerContext.checkConnection("example.com", 443, "test-caller")
+                }
+
+            assertEquals(0, exception.stackTrace.size)
+            assertEquals("example.com", exception.requestDetails?.host)
+            assertEquals(443, exception.requestDetails?.port)
+            assertTrue(exception.message!!.contains("example.com:443 via test-caller")) {
+                "Stackless exception should still name host, port and caller, but was: ${exception.message}"
+            }
+        } finally {
+            System.clearProperty(STACKLESS_EXCEPTIONS_PROPERTY)
+        }
+    }
+
+    @Test
+    fun `evaluate returns allow without a configuration`() {
+        assertEquals(
+            NetworkBlockerContext.VERDICT_ALLOW,
+            NetworkBlockerContext.evaluate("example.com", "93.184.216.34", 443),
+        )
+    }
+
+    @Test
+    fun `evaluate names the rejected identifier like the native policy`() {
+        NetworkBlockerContext.setConfiguration(
+            NetworkConfiguration(
+                allowedHosts = setOf("*.example.com", "10.0.0.1"),
+                blockedHosts = setOf("evil.example.com", "10.0.0.2"),
+            ),
+        )
+
+        // Explicit blocks win, hostname first
+        assertEquals(
+            NetworkBlockerContext.VERDICT_BLOCK_HOSTNAME,
+            NetworkBlockerContext.evaluate("evil.example.com", "10.0.0.1", 443),
+        )
+        assertEquals(
+            NetworkBlockerContext.VERDICT_BLOCK_ADDRESS,
+            NetworkBlockerContext.evaluate("api.example.com", "10.0.0.2", 443),
+        )
+        // Either identifier allowed is enough
+        assertEquals(
+            NetworkBlockerContext.VERDICT_ALLOW,
+            NetworkBlockerContext.evaluate("api.other.com", "10.0.0.1", 443),
+        )
+        assertEquals(
+            NetworkBlockerContext.VERDICT_ALLOW,
+            NetworkBlockerContext.evaluate("api.example.com", "10.0.0.3", 443),
+        )
+        // Neither allowed: the address is reported, or the hostname for DNS lookups
+        assertEquals(
+            NetworkBlockerContext.VERDICT_BLOCK_ADDRESS,
+            NetworkBlockerContext.evaluate("api.other.com", "10.0.0.3", 443),
+        )
+        assertEquals(
+            NetworkBlockerContext.VERDICT_BLOCK_HOSTNAME,
+            NetworkBlockerContext.evaluate("api.other.com", null, -1),
+        )
+    }
+
+    @Test
+    fun `blockedRequestException describes the request without throwing`() {
+        NetworkBlockerContext.setConfiguration(NetworkConfiguration())
+
+        val exception = NetworkBlockerContext.blockedRequestException("example.com", 443, "Native-Agent")
+
+        assertEquals("example.com", exception.requestDetails?.host)
+        assertEquals(443, exception.requestDetails?.port)
+        assertTrue(exception.message!!.contains("example.com:443 via Native-Agent")) {
+            "Exception message should name host, port and caller, but was: ${exception.message}"
+        }
+    }
+
     @Test
     fun `isExplicitlyBlocked matches wildcard pattern`() {
         // Set up configuration with wildcard blocked hosts
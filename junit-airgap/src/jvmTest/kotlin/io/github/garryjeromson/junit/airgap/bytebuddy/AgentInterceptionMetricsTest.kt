@@ -0,0 +1,91 @@
+package io.github.garryjeromson.junit.airgap.bytebuddy
+
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNull
+
+/**
+ * Tests for parsing the JVMTI agent's metrics array and the per-test deltas built from it.
+ */
+class AgentInterceptionMetricsTest {
+    private val targetCount = AgentInterceptionMetrics.TARGET_NAMES.size
+    private val pathCount = AgentInterceptionMetrics.PATH_NAMES.size
+    private val bucketCount = 32
+
+    /**
+     * Build an array in the agent's layout with one target and one path set.
+     */
+    private fun metricsArray(
+        netConnectCalls: Long,
+        netConnectBlocked: Long,
+        policyDecisions: Long,
+        upcallBucket: Int = 10,
+        upcallTotalNanos: Long = 0L,
+    ): LongArray {
+        val calls = LongArray(targetCount).also { it[0] = netConnectCalls }
+        val allowed = LongArray(targetCount).also { it[0] = netConnectCalls - netConnectBlocked }
+        val blocked = LongArray(targetCount).also { it[0] = netConnectBlocked }
+        val policyPath = AgentInterceptionMetrics.PATH_NAMES.indexOf("policy")
+        val paths = LongArray(pathCount).also { it[policyPath] = policyDecisions }
+        val upcalls = LongArray(bucketCount).also { it[upcallBucket] = netConnectBlocked }
+        val originals = LongArray(bucketCount)
+        return longArrayOf(1L, targetCount.toLong(), pathCount.toLong(), bucketCount.toLong()) +
+            calls + allowed + blocked + paths + upcalls + originals + longArrayOf(upcallTotalNanos, 0L)
+    }
+
+    @Test
+    fun `fromArray parses counters per target and path`() {
+        val metrics = AgentInterceptionMetrics.fromArray(metricsArray(5, 2, 5, upcallTotalNanos = 3000))!!
+
+        assertEquals(
+            AgentInterceptionMetrics.Target(calls = 5, allowed = 3, blocked = 2),
+            metrics.targets["NetConnect0"],
+        )
+        assertEquals(5L, metrics.paths["policy"])
+        assertEquals(5L, metrics.calls)
+        assertEquals(2L, metrics.blocked)
+        assertEquals(3000L, metrics.upcallTotalNanos)
+        assertEquals(2L, metrics.upcallHistogram[10])
+    }
+
+    @Test
+    fun `fromArray rejects unknown layout versions and truncated arrays`() {
+        val values = metricsArray(1, 0, 1)
+
+        assertNull(AgentInterceptionMetrics.fromArray(values.copyOf().also { it[0] = 2L }))
+        assertNull(AgentInterceptionMetrics.fromArray(values.copyOf(values.size - 1)))
+        assertNull(AgentInterceptionMetrics.fromArray(LongArray(0)))
+    }
+
+    @Test
+    fun `minus gives the interceptions made since an earlier reading`() {
+        val before = AgentInterceptionMetrics.fromArray(metricsArray(5, 2, 5, upcallTotalNanos = 3000))!!
+        val after = AgentInterceptionMetrics.fromArray(metricsArray(8, 3, 8, upcallTotalNanos = 4000))!!
+
+        val delta = after - before
+
+        assertEquals(
+            AgentInterceptionMetrics.Target(calls = 3, allowed = 2, blocked = 1),
+            delta.targets["NetConnect0"],
+        )
+        assertEquals(3L, delta.paths["policy"])
+        assertEquals(1L, delta.upcallHistogram[10])
+        assertEquals(1000L, delta.upcallTotalNanos)
+    }
+
+    @Test
+    fun `report entries leave out targets and paths without calls`() {
+        val metrics = AgentInterceptionMetrics.fromArray(metricsArray(4, 1, 4, upcallTotalNanos = 1500))!!
+
+        val entries = metrics.toReportEntries()
+
+        assertEquals("4", entries["airgap.interceptions"])
+        assertEquals("1", entries["airgap.blocked"])
+        assertEquals("calls=4 allowed=3 blocked=1", entries["airgap.target.NetConnect0"])
+        assertEquals("4", entries["airgap.path.policy"])
+        assertEquals("total=1500 p50<=2048 p99<=2048", entries["airgap.upcallNanos"])
+        assertFalse(entries.containsKey("airgap.target.SocketConnect0"))
+        assertFalse(entries.containsKey("airgap.path.disarmed"))
+    }
+}
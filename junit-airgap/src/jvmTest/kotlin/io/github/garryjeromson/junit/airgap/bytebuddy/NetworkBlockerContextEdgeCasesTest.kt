@@ -1,10 +1,16 @@
 package io.github.garryjeromson.junit.airgap.bytebuddy
 
 import io.github.garryjeromson.junit.airgap.NetworkConfiguration
+import io.github.garryjeromson.junit.airgap.SHARED_CONFIGURATION_PROPERTY
+import java.util.concurrent.Callable
+import java.util.concurrent.ExecutorService
+import java.util.concurrent.Executors
 import kotlin.test.AfterTest
 import kotlin.test.Test
 import kotlin.test.assertEquals
 import kotlin.test.assertFalse
+import kotlin.test.assertNotEquals
+import kotlin.test.assertSame
 
 /**
  * Tests for NetworkBlockerContext edge cases and uncovered branches.
@@ -17,6 +23,7 @@ class NetworkBlockerContextEdgeCasesTest {
     fun cleanup() {
         // Clear configuration after each test to avoid interference
         NetworkBlockerContext.clearConfiguration()
+        System.clearProperty(SHARED_CONFIGURATION_PROPERTY)
     }
 
     @Test
@@ -130,4 +137,177 @@ class NetworkBlockerContextEdgeCasesTest {
         val currentConfig = NetworkBlockerContext.getConfiguration()
         assertEquals(null, currentConfig, "Configuration should be null after clear")
     }
+
+    @Test
+    fun `configuration is visible to virtual threads`() {
+        // Given: Configuration is set in main thread
+        val config =
+            NetworkConfiguration(
+                allowedHosts = setOf("localhost"),
+                blockedHosts = emptySet(),
+            )
+        NetworkBlockerContext.setConfiguration(config)
+
+        // When: Checking configuration in a virtual thread
+        var virtualThreadConfig: NetworkConfiguration? = null
+        Thread.ofVirtual().start { virtualThreadConfig = NetworkBlockerContext.getConfiguration() }.join()
+
+        // Then: The virtual thread sees the test's configuration
+        assertEquals(config, virtualThreadConfig, "Virtual thread should see the configuration")
+    }
+
+    @Test
+    fun `shared configuration applies to every thread until cleared`() {
+        // Given: A shared configuration
+        System.setProperty(SHARED_CONFIGURATION_PROPERTY, "true")
+        val config =
+            NetworkConfiguration(
+                allowedHosts = setOf("localhost"),
+                blockedHosts = emptySet(),
+            )
+        NetworkBlockerContext.setConfiguration(config)
+
+        // When: Checking configuration on this thread and in a virtual thread
+        var virtualThreadConfig: NetworkConfiguration? = null
+        Thread.ofVirtual().start { virtualThreadConfig = NetworkBlockerContext.getConfiguration() }.join()
+
+        // Then: Both see it, and neither does after clearing
+        assertEquals(config, NetworkBlockerContext.getConfiguration(), "Test thread should see the configuration")
+        assertEquals(config, virtualThreadConfig, "Virtual thread should see the configuration")
+
+        NetworkBlockerContext.clearConfiguration()
+        Thread.ofVirtual().start { virtualThreadConfig = NetworkBlockerContext.getConfiguration() }.join()
+        assertEquals(null, NetworkBlockerContext.getConfiguration(), "Configuration should be null after clear")
+        assertEquals(null, virtualThreadConfig, "Virtual thread configuration should be null after clear")
+    }
+
+    @Test
+    fun `shared configuration is not applied to Gradle worker threads`() {
+        // Given: A shared configuration
+        System.setProperty(SHARED_CONFIGURATION_PROPERTY, "true")
+        NetworkBlockerContext.setConfiguration(
+            NetworkConfiguration(
+                allowedHosts = emptySet(),
+                blockedHosts = emptySet(),
+            ),
+        )
+
+        // When: Checking configuration in a Gradle execution worker thread
+        var workerHasConfig = true
+        val thread = Thread({ workerHasConfig = NetworkBlockerContext.hasActiveConfiguration() }, "Execution worker 1")
+        thread.start()
+        thread.join()
+
+        // Then: Gradle infrastructure stays unblocked
+        assertFalse(workerHasConfig, "Gradle worker thread should not see the shared configuration")
+    }
+
+    @Test
+    fun `clearing one test's configuration keeps a parallel test's configuration`() {
+        // Given: Two tests running in parallel, each on its own thread
+        val testA = Executors.newSingleThreadExecutor()
+        val testB = Executors.newSingleThreadExecutor()
+        val configA = NetworkConfiguration(allowedHosts = setOf("a.example.com"))
+        val configB = NetworkConfiguration(allowedHosts = setOf("b.example.com"))
+        try {
+            testA.onThread { NetworkBlockerContext.setConfiguration(configA) }
+            testB.onThread { NetworkBlockerContext.setConfiguration(configB) }
+
+            // Then: Each thread sees its own test's configuration and context
+            assertEquals(configA, testA.onThread { NetworkBlockerContext.getConfiguration() })
+            assertEquals(configB, testB.onThread { NetworkBlockerContext.getConfiguration() })
+            val contextA = testA.onThread { NetworkBlockerContext.activeContextId() }
+            val contextB = testB.onThread { NetworkBlockerContext.activeContextId() }
+            assertFalse(contextA == contextB, "Parallel tests should have distinct context IDs")
+
+            // When: Test A ends
+            testA.onThread { NetworkBlockerContext.clearConfiguration() }
+
+            // Then: Test B and the threads it starts keep its configuration
+            assertEquals(null, testA.onThread { NetworkBlockerContext.getConfiguration() })
+            assertEquals(configB, testB.onThread { NetworkBlockerContext.getConfiguration() })
+            val childConfig =
+                testB.onThread {
+                    var config: NetworkConfiguration? = null
+                    Thread { config = NetworkBlockerContext.getConfiguration() }.apply { start() }.join()
+                    config
+                }
+            assertEquals(configB, childConfig, "Child thread of test B should inherit its configuration")
+        } finally {
+            testB.onThread { NetworkBlockerContext.clearConfiguration() }
+            testA.shutdown()
+            testB.shutdown()
+        }
+    }
+
+    @Test
+    fun `threads without a configuration fall back to the most recently started running test`() {
+        // Given: Two tests running in parallel
+        val testA = Executors.newSingleThreadExecutor()
+        val testB = Executors.newSingleThreadExecutor()
+        val configA = NetworkConfiguration(allowedHosts = setOf("a.example.com"))
+        val configB = NetworkConfiguration(allowedHosts = setOf("b.example.com"))
+        try {
+            testA.onThread { NetworkBlockerContext.setConfiguration(configA) }
+            testB.onThread { NetworkBlockerContext.setConfiguration(configB) }
+
+            // Then: An unrelated thread sees the test started last, then the remaining one
+            assertEquals(configB, NetworkBlockerContext.getConfiguration())
+            testB.onThread { NetworkBlockerContext.clearConfiguration() }
+            assertEquals(configA, NetworkBlockerContext.getConfiguration())
+            testA.onThread { NetworkBlockerContext.clearConfiguration() }
+            assertEquals(null, NetworkBlockerContext.getConfiguration())
+        } finally {
+            testA.shutdown()
+            testB.shutdown()
+        }
+    }
+
+    @Test
+    fun `a test with the previous test's configuration takes over its context`() {
+        // Given: A test that ended
+        NetworkBlockerContext.setConfiguration(NetworkConfiguration(allowedHosts = setOf("localhost")))
+        val firstContext = NetworkBlockerContext.activeContextId()
+        NetworkBlockerContext.clearConfiguration()
+        assertEquals(null, NetworkBlockerContext.getConfiguration(), "Configuration should be null after clear")
+
+        // When: The next test installs an equal configuration
+        val next = NetworkConfiguration(allowedHosts = setOf("localhost"))
+        NetworkBlockerContext.setConfiguration(next)
+
+        // Then: It revives the parked context, as its own configuration
+        assertEquals(firstContext, NetworkBlockerContext.activeContextId())
+        assertSame(next, NetworkBlockerContext.getConfiguration())
+        NetworkBlockerContext.clearConfiguration()
+
+        // And: A different configuration gets a new context
+        NetworkBlockerContext.setConfiguration(NetworkConfiguration(allowedHosts = setOf("example.com")))
+        assertNotEquals(firstContext, NetworkBlockerContext.activeContextId())
+    }
+
+    @Test
+    fun `a thread left by the previous test doesn't join a revived context`() {
+        // Given: A test that started a pool thread
+        val pool = Executors.newSingleThreadExecutor()
+        val first = NetworkConfiguration(allowedHosts = setOf("localhost"))
+        try {
+            NetworkBlockerContext.setConfiguration(first)
+            pool.onThread { }
+            NetworkBlockerContext.clearConfiguration()
+
+            // When: The next test revives its context
+            val next = NetworkConfiguration(allowedHosts = setOf("localhost"))
+            NetworkBlockerContext.setConfiguration(next)
+
+            // Then: The pool thread's inherited configuration stays stale; it falls back to the running test
+            assertSame(next, pool.onThread { NetworkBlockerContext.getConfiguration() })
+        } finally {
+            pool.shutdown()
+        }
+    }
+
+    /**
+     * Run [block] on this executor's thread and wait for the result.
+     */
+    private fun <T> ExecutorService.onThread(block: () -> T): T = submit(Callable { block() }).get()
 }
@@ -0,0 +1,499 @@
+/**
+ * Interceptor Microbenchmark for junit-airgap JVMTI Agent
+ *
+ * Measures the cost of each interceptor fast path in isolation, which the
+ * whole-test wall time of the benchmarks/ control and treatment projects cannot
+ * attribute. The harness links the agent sources directly, embeds a JVM through the
+ * Invocation API and drives the wrappers with real JNI objects:
+ *
+ *   connect/...  Net.connect0 wrapper (vm-init-pending, unregistered, disarmed,
+ *                no-configuration, allow, block)
+ *   dns/...      Inet4AddressImpl.lookupAllHostAddr wrapper (same paths)
+ *   bind/...     NativeMethodBindCallback (rejected, intercepted)
+ *
+ * The "original" natives behind the wrappers are no-op fakes, so no socket or
+ * resolver is touched and every number is pure agent overhead; connect/baseline and
+ * dns/baseline call the fakes directly for reference. Agent state is advanced the
+ * way the JVM and NetworkBlockerContext advance it (VM_INIT, registerWithAgent(),
+ * setAgentArmState(), setAgentHostPolicy()), using the stub NetworkBlockerContext
+ * from native/test on the classpath.
+ *
+ * Each path runs at every requested thread count. Results go to
+ * <output>/benchmark-results/results.json in the format BenchmarkComparison reads,
+ * so a run against a baseline build and a run against a candidate build can be
+ * compared like the control and treatment projects.
+ *
+ * Usage:
+ *   interceptor-benchmark --classpath <dir> [--output <dir>] [--threads 1,2,4,8]
+ *                         [--samples 15] [--iterations 20000] [--warmup 3]
+ */
+
+#include "agent.h"
+#include "agent_options.h"
+#include "host_policy.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+static const char* kContextClassName = "io/github/garryjeromson/junit/airgap/bytebuddy/NetworkBlockerContext";
+static const char* kAllowedHost = "allowed.example.com";
+static const char* kBlockedHost = "blocked.example.com";
+
+struct BenchmarkConfig {
+    std::string classpath;
+    std::string output = "build/microbench";
+    std::vector<int> thread_counts = {1, 2, 4, 8};
+    int samples = 15;
+    int iterations = 20000;
+    int warmup = 3;
+};
+
+struct BenchmarkResult {
+    std::string name;
+    double median_ns;
+    double std_dev_ns;
+    double ops_per_second;
+};
+
+/**
+ * JNI objects and entry points shared by every benchmark thread (global refs).
+ */
+struct BenchmarkFixture {
+    jvmtiEnv* jvmti;
+    jclass context_class;
+    jfieldID active_configuration_field;
+    jobject allowed_address;      // InetAddress "allowed.example.com"/10.0.0.1
+    jobject blocked_address;      // InetAddress "blocked.example.com"/10.0.0.2
+    jstring allowed_host;
+    jstring blocked_host;
+    jobjectArray lookup_result;   // What the fake resolver returns: { allowed_address }
+    jmethodID rejected_bind_method;     // java.lang.Object.hashCode()
+    jmethodID intercepted_bind_method;  // sun.nio.ch.Net.connect0()
+
+    jint (JNICALL* connect)(JNIEnv*, jclass, jboolean, jobject, jobject, jint);
+    jobjectArray (JNICALL* lookup)(JNIEnv*, jobject, jstring);
+};
+
+static BenchmarkFixture g_fixture;
+
+typedef void (*BenchmarkOperation)(JNIEnv* env);
+
+// ============================================================================
+// Fake originals
+// ============================================================================
+
+static jint JNICALL FakeNetConnect0(JNIEnv* env, jclass cls, jboolean preferIPv6, jobject fd, jobject remote, jint remotePort) {
+    return 0;
+}
+
+static jobjectArray JNICALL FakeInet4LookupAllHostAddr(JNIEnv* env, jobject obj, jstring hostname) {
+    return (jobjectArray)env->NewLocalRef(g_fixture.lookup_result);
+}
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+static void ConnectBaseline(JNIEnv* env) {
+    FakeNetConnect0(env, g_fixture.context_class, JNI_FALSE, nullptr, g_fixture.allowed_address, 443);
+}
+
+static void ConnectAllowed(JNIEnv* env) {
+    g_fixture.connect(env, g_fixture.context_class, JNI_FALSE, nullptr, g_fixture.allowed_address, 443);
+}
+
+static void ConnectBlocked(JNIEnv* env) {
+    g_fixture.connect(env, g_fixture.context_class, JNI_FALSE, nullptr, g_fixture.blocked_address, 443);
+    env->ExceptionClear();
+}
+
+static void LookupBaseline(JNIEnv* env) {
+    jobjectArray addresses = FakeInet4LookupAllHostAddr(env, nullptr, g_fixture.allowed_host);
+    env->DeleteLocalRef(addresses);
+}
+
+static void LookupAllowed(JNIEnv* env) {
+    jobjectArray addresses = g_fixture.lookup(env, nullptr, g_fixture.allowed_host);
+    env->DeleteLocalRef(addresses);
+}
+
+static void LookupBlocked(JNIEnv* env) {
+    jobjectArray addresses = g_fixture.lookup(env, nullptr, g_fixture.blocked_host);
+    env->DeleteLocalRef(addresses);
+    env->ExceptionClear();
+}
+
+static void BindRejected(JNIEnv* env) {
+    void* new_address = nullptr;
+    NativeMethodBindCallback(g_fixture.jvmti, env, nullptr, g_fixture.rejected_bind_method,
+                             (void*)FakeNetConnect0, &new_address);
+}
+
+static void BindIntercepted(JNIEnv* env) {
+    // Rebinding the fake keeps the connect wrapper's original pointed at the fake
+    void* new_address = nullptr;
+    NativeMethodBindCallback(g_fixture.jvmti, env, nullptr, g_fixture.intercepted_bind_method,
+                             (void*)FakeNetConnect0, &new_address);
+}
+
+// ============================================================================
+// Measurement
+// ============================================================================
+
+/**
+ * Reusable barrier for the coordinator and its worker threads (no std::barrier in C++17).
+ */
+class SampleBarrier {
+public:
+    explicit SampleBarrier(int parties) : parties_(parties) {}
+
+    void Arrive() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        uint64_t phase = phase_;
+        if (++waiting_ == parties_) {
+            waiting_ = 0;
+            phase_++;
+            cv_.notify_all();
+            return;
+        }
+        cv_.wait(lock, [&] { return phase_ != phase; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    const int parties_;
+    int waiting_ = 0;
+    uint64_t phase_ = 0;
+};
+
+/**
+ * Run one operation on `threads` attached threads and report nanoseconds per operation
+ * (per thread, so a contended path shows up as a rising median).
+ */
+static BenchmarkResult Measure(JavaVM* vm, const char* path, BenchmarkOperation operation, int threads,
+                               const BenchmarkConfig& config) {
+    int rounds = config.warmup + config.samples;
+    SampleBarrier barrier(threads + 1);
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&] {
+            JNIEnv* env = nullptr;
+            if (vm->AttachCurrentThreadAsDaemon((void**)&env, nullptr) != JNI_OK) {
+                fprintf(stderr, "[junit-airgap:native] ERROR: Failed to attach benchmark thread\n");
+                abort();
+            }
+            for (int round = 0; round < rounds; round++) {
+                barrier.Arrive();
+                // Local refs from the wrappers (e.g. declaring classes in the bind
+                // callback) are released with the frame, as on return to Java
+                env->PushLocalFrame(16);
+                for (int i = 0; i < config.iterations; i++) {
+                    operation(env);
+                }
+                env->PopLocalFrame(nullptr);
+                barrier.Arrive();
+            }
+            vm->DetachCurrentThread();
+        });
+    }
+
+    std::vector<double> samples;
+    for (int round = 0; round < rounds; round++) {
+        barrier.Arrive();
+        auto start = std::chrono::steady_clock::now();
+        barrier.Arrive();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (round >= config.warmup) {
+            samples.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() /
+                              config.iterations);
+        }
+    }
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    std::sort(samples.begin(), samples.end());
+    size_t middle = samples.size() / 2;
+    double median = samples.size() % 2 == 0 ? (samples[middle - 1] + samples[middle]) / 2 : samples[middle];
+
+    double mean = 0;
+    for (double sample : samples) {
+        mean += sample;
+    }
+    mean /= samples.size();
+    double variance = 0;
+    for (double sample : samples) {
+        variance += (sample - mean) * (sample - mean);
+    }
+
+    BenchmarkResult result;
+    result.name = std::string(path) + "/threads=" + std::to_string(threads);
+    result.median_ns = median;
+    result.std_dev_ns = std::sqrt(variance / samples.size());
+    result.ops_per_second = median > 0 ? threads * 1e9 / median : 0;
+    return result;
+}
+
+static void MeasureAll(JavaVM* vm, const char* path, BenchmarkOperation operation, const BenchmarkConfig& config,
+                       std::vector<BenchmarkResult>* results) {
+    for (int threads : config.thread_counts) {
+        BenchmarkResult result = Measure(vm, path, operation, threads, config);
+        printf("%-40s %12.1f %12.1f %15.0f\n", result.name.c_str(), result.median_ns, result.std_dev_ns,
+               result.ops_per_second);
+        fflush(stdout);
+        results->push_back(result);
+    }
+}
+
+// ============================================================================
+// Setup and output
+// ============================================================================
+
+static jobject NewGlobal(JNIEnv* env, jobject local) {
+    if (local == nullptr) {
+        env->ExceptionDescribe();
+        fprintf(stderr, "[junit-airgap:native] ERROR: Benchmark fixture setup failed\n");
+        exit(1);
+    }
+    jobject global = env->NewGlobalRef(local);
+    env->DeleteLocalRef(local);
+    return global;
+}
+
+static jobject NewInetAddress(JNIEnv* env, const char* host, jbyte last_octet) {
+    jclass inet_address_class = env->FindClass("java/net/InetAddress");
+    jmethodID get_by_address = env->GetStaticMethodID(inet_address_class, "getByAddress",
+                                                      "(Ljava/lang/String;[B)Ljava/net/InetAddress;");
+    jbyteArray bytes = env->NewByteArray(4);
+    jbyte octets[4] = {10, 0, 0, last_octet};
+    env->SetByteArrayRegion(bytes, 0, 4, octets);
+
+    jstring host_string = env->NewStringUTF(host);
+    jobject address = env->CallStaticObjectMethod(inet_address_class, get_by_address, host_string, bytes);
+    env->DeleteLocalRef(host_string);
+    env->DeleteLocalRef(bytes);
+    env->DeleteLocalRef(inet_address_class);
+    return NewGlobal(env, address);
+}
+
+static jobjectArray NewStringArray(JNIEnv* env, const std::vector<const char*>& values) {
+    jobjectArray array = env->NewObjectArray((jsize)values.size(), env->FindClass("java/lang/String"), nullptr);
+    for (size_t i = 0; i < values.size(); i++) {
+        jstring value = env->NewStringUTF(values[i]);
+        env->SetObjectArrayElement(array, (jsize)i, value);
+        env->DeleteLocalRef(value);
+    }
+    return array;
+}
+
+static void SetUpFixture(JNIEnv* env, jvmtiEnv* jvmti) {
+    g_fixture.jvmti = jvmti;
+
+    // Class initialization tries registerWithAgent(), which isn't linked into the
+    // embedded JVM (the stub catches the UnsatisfiedLinkError); the harness then
+    // calls the entry points directly at each stage
+    g_fixture.context_class = (jclass)NewGlobal(env, env->FindClass(kContextClassName));
+    g_fixture.active_configuration_field =
+        env->GetStaticFieldID(g_fixture.context_class, "activeConfiguration", "Z");
+    if (g_fixture.active_configuration_field == nullptr) {
+        env->ExceptionDescribe();
+        fprintf(stderr, "[junit-airgap:native] ERROR: Stub NetworkBlockerContext has no activeConfiguration field\n");
+        exit(1);
+    }
+
+    g_fixture.allowed_address = NewInetAddress(env, kAllowedHost, 1);
+    g_fixture.blocked_address = NewInetAddress(env, kBlockedHost, 2);
+    g_fixture.allowed_host = (jstring)NewGlobal(env, env->NewStringUTF(kAllowedHost));
+    g_fixture.blocked_host = (jstring)NewGlobal(env, env->NewStringUTF(kBlockedHost));
+
+    jobjectArray lookup_result = env->NewObjectArray(1, env->FindClass("java/net/InetAddress"), g_fixture.allowed_address);
+    g_fixture.lookup_result = (jobjectArray)NewGlobal(env, lookup_result);
+
+    jclass object_class = env->FindClass("java/lang/Object");
+    g_fixture.rejected_bind_method = env->GetMethodID(object_class, "hashCode", "()I");
+    jclass net_class = env->FindClass("sun/nio/ch/Net");
+    g_fixture.intercepted_bind_method = net_class != nullptr
+        ? env->GetStaticMethodID(net_class, "connect0", "(ZLjava/io/FileDescriptor;Ljava/net/InetAddress;I)I")
+        : nullptr;
+    if (g_fixture.rejected_bind_method == nullptr || g_fixture.intercepted_bind_method == nullptr) {
+        env->ExceptionDescribe();
+        fprintf(stderr, "[junit-airgap:native] ERROR: Failed to find native methods for the bind benchmark\n");
+        exit(1);
+    }
+
+    // Wrappers in front of the fakes, as NativeMethodBindCallback would install them
+    g_fixture.connect = (jint (JNICALL*)(JNIEnv*, jclass, jboolean, jobject, jobject, jint))
+        InstallNetConnect0Wrapper((void*)FakeNetConnect0);
+    g_fixture.lookup = (jobjectArray (JNICALL*)(JNIEnv*, jobject, jstring))
+        InstallInet4LookupWrapper((void*)FakeInet4LookupAllHostAddr);
+
+    // Keep bind events "enabled": the harness has no JVMTI capabilities to disable them
+    g_agent_options.bind_events = BindEventMode::Keep;
+}
+
+static bool ParseThreadCounts(const char* value, std::vector<int>* thread_counts) {
+    thread_counts->clear();
+    for (const char* p = value; *p != '\0';) {
+        char* end = nullptr;
+        long count = strtol(p, &end, 10);
+        if (end == p || count < 1 || count > 1024) {
+            return false;
+        }
+        if (*end != ',' && *end != '\0') {
+            return false;
+        }
+        thread_counts->push_back((int)count);
+        p = *end == ',' ? end + 1 : end;
+    }
+    return !thread_counts->empty();
+}
+
+static bool ParseArguments(int argc, char** argv, BenchmarkConfig* config) {
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value == nullptr) {
+            return false;
+        }
+        if (strcmp(argv[i], "--classpath") == 0) {
+            config->classpath = value;
+        } else if (strcmp(argv[i], "--output") == 0) {
+            config->output = value;
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            if (!ParseThreadCounts(value, &config->thread_counts)) {
+                return false;
+            }
+        } else if (strcmp(argv[i], "--samples") == 0) {
+            config->samples = atoi(value);
+        } else if (strcmp(argv[i], "--iterations") == 0) {
+            config->iterations = atoi(value);
+        } else if (strcmp(argv[i], "--warmup") == 0) {
+            config->warmup = atoi(value);
+        } else {
+            return false;
+        }
+        i++;
+    }
+    return !config->classpath.empty() && config->samples > 0 && config->iterations > 0 && config->warmup >= 0;
+}
+
+/**
+ * Write results as <output>/benchmark-results/results.json (BenchmarkResultsCollector format).
+ */
+static bool WriteResults(const std::string& output, const std::vector<BenchmarkResult>& results) {
+    std::string directory = output + "/benchmark-results";
+    for (size_t slash = directory.find('/', 1); slash != std::string::npos; slash = directory.find('/', slash + 1)) {
+        mkdir(directory.substr(0, slash).c_str(), 0755);
+    }
+    mkdir(directory.c_str(), 0755);
+
+    std::string path = directory + "/results.json";
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        fprintf(stderr, "[junit-airgap:native] ERROR: Cannot write %s\n", path.c_str());
+        return false;
+    }
+
+    fprintf(file, "{\n  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        fprintf(file, "    {\n      \"name\": \"%s\",\n      \"medianNs\": %.1f,\n      \"stdDevNs\": %.1f\n    }%s\n",
+                results[i].name.c_str(), results[i].median_ns, results[i].std_dev_ns,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+
+    printf("\nBenchmark results written to: %s\n", path.c_str());
+    return true;
+}
+
+int main(int argc, char** argv) {
+    BenchmarkConfig config;
+    if (!ParseArguments(argc, argv, &config)) {
+        fprintf(stderr, "Usage: %s --classpath <dir> [--output <dir>] [--threads 1,2,4,8] "
+                        "[--samples 15] [--iterations 20000] [--warmup 3]\n", argv[0]);
+        return 2;
+    }
+
+    std::string classpath_option = "-Djava.class.path=" + config.classpath;
+    JavaVMOption vm_options[1];
+    vm_options[0].optionString = (char*)classpath_option.c_str();
+    JavaVMInitArgs vm_args;
+    vm_args.version = JNI_VERSION_1_8;
+    vm_args.nOptions = 1;
+    vm_args.options = vm_options;
+    vm_args.ignoreUnrecognized = JNI_FALSE;
+
+    JavaVM* vm = nullptr;
+    JNIEnv* env = nullptr;
+    if (JNI_CreateJavaVM(&vm, (void**)&env, &vm_args) != JNI_OK) {
+        fprintf(stderr, "[junit-airgap:native] ERROR: Failed to create the benchmark JVM\n");
+        return 1;
+    }
+    g_jvm = vm;
+
+    jvmtiEnv* jvmti = nullptr;
+    if (vm->GetEnv((void**)&jvmti, JVMTI_VERSION_1_2) != JNI_OK) {
+        fprintf(stderr, "[junit-airgap:native] ERROR: Failed to get JVMTI environment\n");
+        return 1;
+    }
+
+    SetUpFixture(env, jvmti);
+    jclass context_class = g_fixture.context_class;
+    std::vector<BenchmarkResult> results;
+
+    printf("BENCHMARK: interceptor fast paths (%d samples x %d iterations per thread)\n",
+           config.samples, config.iterations);
+    printf("%-40s %12s %12s %15s\n", "path", "median ns", "stddev ns", "ops/sec");
+
+    MeasureAll(vm, "connect/baseline", ConnectBaseline, config, &results);
+    MeasureAll(vm, "dns/baseline", LookupBaseline, config, &results);
+
+    // Before VM_INIT
+    MeasureAll(vm, "connect/vm-init-pending", ConnectAllowed, config, &results);
+    MeasureAll(vm, "dns/vm-init-pending", LookupAllowed, config, &results);
+
+    // After VM_INIT, before NetworkBlockerContext registers
+    VMInitCallback(jvmti, env, nullptr);
+    MeasureAll(vm, "connect/unregistered", ConnectAllowed, config, &results);
+    MeasureAll(vm, "dns/unregistered", LookupAllowed, config, &results);
+
+    // Registered, no configuration anywhere in the JVM
+    Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_registerWithAgent(env, context_class);
+    Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_setAgentArmState(env, context_class, JNI_FALSE, 1);
+    MeasureAll(vm, "connect/disarmed", ConnectAllowed, config, &results);
+    MeasureAll(vm, "dns/disarmed", LookupAllowed, config, &results);
+
+    // Armed (another test has a configuration), none on this thread
+    env->SetStaticBooleanField(context_class, g_fixture.active_configuration_field, JNI_FALSE);
+    Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_setAgentArmState(env, context_class, JNI_TRUE, 2);
+    MeasureAll(vm, "connect/no-configuration", ConnectAllowed, config, &results);
+    MeasureAll(vm, "dns/no-configuration", LookupAllowed, config, &results);
+
+    // Active configuration allowing only kAllowedHost
+    env->SetStaticBooleanField(context_class, g_fixture.active_configuration_field, JNI_TRUE);
+    jobjectArray allowed_hosts = NewStringArray(env, {kAllowedHost});
+    jobjectArray blocked_hosts = NewStringArray(env, {});
+    Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_setAgentHostPolicy(
+        env, context_class, allowed_hosts, blocked_hosts, 0);
+    MeasureAll(vm, "connect/allow", ConnectAllowed, config, &results);
+    MeasureAll(vm, "dns/allow", LookupAllowed, config, &results);
+    MeasureAll(vm, "connect/block", ConnectBlocked, config, &results);
+    MeasureAll(vm, "dns/block", LookupBlocked, config, &results);
+
+    MeasureAll(vm, "bind/rejected", BindRejected, config, &results);
+    MeasureAll(vm, "bind/intercepted", BindIntercepted, config, &results);
+
+    return WriteResults(config.output, results) ? 0 : 1;
+}
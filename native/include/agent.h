@@ -3,18 +3,22 @@
 
 #include <jvmti.h>
 #include <jni.h>
+#include "inet_address.h"
+#include "intercept_targets.h"
+#include "log_sink.h"
 #include <string>
-#include <map>
+#include <atomic>
 #include <mutex>
 
-// Debug logging
-extern bool g_debug_mode;
-#define DEBUG_LOG(msg) if (g_debug_mode) fprintf(stderr, "[junit-airgap:native] %s\n", msg)
-#define DEBUG_LOGF(fmt, ...) if (g_debug_mode) fprintf(stderr, "[junit-airgap:native] " fmt "\n", __VA_ARGS__)
+// Debug logging through the async log sink (see log_sink.h), in the category the
+// including file declares as kLogCategory
+#define DEBUG_LOG(msg) AGENT_LOG(LogLevel::Debug, kLogCategory, "%s", msg)
+#define DEBUG_LOGF(fmt, ...) AGENT_LOG(LogLevel::Debug, kLogCategory, fmt, __VA_ARGS__)
 
-// Agent entry point
+// Agent entry points (load at JVM start, attach to a running JVM)
 extern "C" {
     JNIEXPORT jint JNICALL Agent_OnLoad(JavaVM *vm, char *options, void *reserved);
+    JNIEXPORT jint JNICALL Agent_OnAttach(JavaVM *vm, char *options, void *reserved);
     JNIEXPORT void JNICALL Agent_OnUnload(JavaVM *vm);
 }
 
@@ -44,58 +48,236 @@ bool InitializeJVMTI(jvmtiEnv *jvmti);
 // Get JNI environment for current thread
 JNIEnv* GetJNIEnv();
 
-// Original function storage
-extern std::map<std::string, void*> g_original_functions;
-extern std::mutex g_functions_mutex;
+// Original function storage (fixed array indexed by InterceptTarget, lock-free)
+void* GetOriginalFunction(InterceptTarget target);
+void StoreOriginalFunction(InterceptTarget target, void* address);
 
-void* GetOriginalFunction(const std::string& key);
-void StoreOriginalFunction(const std::string& key, void* address);
+// Display name of an interception target, e.g. "sun.nio.ch.Net.connect0"
+const char* GetInterceptTargetName(InterceptTarget target);
 
 // Socket interception functions
 void* InstallNetConnect0Wrapper(void* original_address);
 
+// Netty native transport interception (socket_interceptor.cpp)
+void* InstallNettySocketConnectWrapper(void* original_address);
+
 // DNS interception functions
 void* InstallInet6LookupWrapper(void* original_address);
 void* InstallInet4LookupWrapper(void* original_address);
 
-// Cached NetworkBlockerContext class and method references
-// These are set by registerWithAgent() called from Java
-extern jclass g_network_blocker_context_class;
-extern jmethodID g_check_connection_method;
-extern jmethodID g_is_explicitly_blocked_method;
-extern jmethodID g_has_active_configuration_method;
-extern std::mutex g_context_mutex;
+/**
+ * Cached NetworkBlockerContext class and method references plus string constants.
+ *
+ * Immutable once published. registerWithAgent() (class and methods) and VM_INIT
+ * (string constants) each publish a new snapshot through an atomic pointer, so
+ * interceptors read everything they need with a single acquire load instead of
+ * taking a mutex per field.
+ *
+ * Fields are nullptr until the corresponding publisher has run.
+ */
+struct AgentContext {
+    // Set by registerWithAgent() called from Java
+    jclass network_blocker_context_class;
+    jmethodID check_connection_method;
+    jmethodID is_explicitly_blocked_method;
+    jmethodID has_active_configuration_method;
+    // Test context of the calling thread (see ResolveThreadContext()); nullptr if the
+    // registered class predates per-test contexts, in which case hasActiveConfiguration() decides
+    jmethodID active_context_id_method;
+    // Single-upcall verdict protocol (see ConfirmBlockedRequest()); nullptr if the
+    // registered class predates it, in which case checkConnection() decides
+    jmethodID evaluate_method;
+    jmethodID blocked_request_exception_method;
+
+    // java.net.InetAddress field/method IDs for allocation-free decoding
+    // (looked up alongside the class and methods above)
+    InetAddressFields inet_address;
+
+    // Initialized during VM_INIT to avoid "platform encoding not initialized" errors
+    jstring caller_agent_string;  // "Native-Agent"
+    jstring caller_dns_string;    // "Native-DNS"
+
+    // java.lang.InternalError (global ref, cached during VM_INIT).
+    // Thrown by the JVM while platform encoding is not initialized.
+    jclass internal_error_class;
+
+    // Exceptions thrown natively (global refs). ConnectException only with a policy image
+    // (see policy_image.h), cached during VM_INIT for blocks before NetworkBlockerContext
+    // registers; UnknownHostException then too, and at registration for hosts overrides.
+    jclass connect_exception_class;        // java.net.ConnectException
+    jclass unknown_host_exception_class;   // java.net.UnknownHostException
+};
 
-// Cached string constants (initialized during VM_INIT to avoid "platform encoding not initialized" errors)
-// See: https://github.com/garry-jeromson/junit-airgap/issues/XXX
-extern jstring g_caller_agent_string;  // "Native-Agent"
-extern jstring g_caller_dns_string;    // "Native-DNS"
-extern std::mutex g_strings_mutex;
+/**
+ * Get the current agent context snapshot (lock-free).
+ *
+ * @return Current snapshot, never nullptr (all fields nullptr before the first publish)
+ */
+const AgentContext* GetAgentContext();
+
+// NetworkBlockerContext.evaluate() results (mirror NetworkBlockerContext.VERDICT_*)
+static constexpr jint kVerdictAllow = 0;
+static constexpr jint kVerdictBlockHostname = 1;
+static constexpr jint kVerdictBlockAddress = 2;
+
+/**
+ * Let NetworkBlockerContext decide a request the native host policy blocked, and
+ * throw its exception if it stays blocked.
+ *
+ * One evaluate() upcall returns the verdict, so a request NetworkBlockerContext still
+ * allows (no configuration between tests, Robolectric artifact downloads) costs a
+ * single call and no exception. Only a block calls blockedRequestException() and
+ * throws the result. Without evaluate() (older class) this falls back to
+ * checkConnection() with the culprit, which throws by itself.
+ *
+ * @param env JNI environment
+ * @param agentContext Registered agent context
+ * @param hostname Hostname of the request, or nullptr
+ * @param address IP address of the request, or nullptr (DNS)
+ * @param port Port number (-1 for DNS)
+ * @param caller Caller string for the exception message
+ * @param hostnameIsCulprit Whether the native policy rejected the hostname (fallback only)
+ * @return true if the request is blocked (exception pending)
+ */
+bool ConfirmBlockedRequest(
+    JNIEnv* env,
+    const AgentContext* agentContext,
+    jstring hostname,
+    jstring address,
+    jint port,
+    jstring caller,
+    bool hostnameIsCulprit
+);
+
+/**
+ * Find the test context of the calling thread.
+ *
+ * Under in-JVM parallel execution several configurations are active at once, each
+ * published as its own context policy (see host_policy.h). With a shared configuration
+ * the answer is the JVM-wide context without an upcall; otherwise it takes one
+ * activeContextId() upcall (hasActiveConfiguration() for an older class, which only
+ * tells whether the JVM-wide context applies).
+ *
+ * @param env JNI environment
+ * @param agentContext Registered agent context
+ * @param contextId Output: context id for the policy, verdict cache and hosts override
+ *                  lookups (0: the JVM-wide context)
+ * @return false if the calling thread has no configuration
+ */
+bool ResolveThreadContext(JNIEnv* env, const AgentContext* agentContext, int64_t* contextId);
 
 // VM initialization state (true after VM_INIT callback completes)
 // Used to guard JNI string operations that require platform encoding to be initialized
 extern bool g_vm_init_complete;
 
-// Get cached context class and method (thread-safe)
-jclass GetNetworkBlockerContextClass();
-jmethodID GetCheckConnectionMethod();
-jmethodID GetIsExplicitlyBlockedMethod();
-jmethodID GetHasActiveConfigurationMethod();
+// Mirror of NetworkBlockerContext.currentGeneration (set via setAgentArmState()).
+// Native caches stamp entries with it; a bump invalidates them all.
+extern std::atomic<int64_t> g_configuration_generation;
+
+/**
+ * Whether a NetworkConfiguration is set anywhere in the JVM, mirrored from
+ * NetworkBlockerContext via setAgentArmState().
+ *
+ * Unknown until NetworkBlockerContext first reports (e.g. an older or stub
+ * context class); interceptors then keep asking hasActiveConfiguration().
+ */
+enum class AgentArmState : uint8_t {
+    Unknown,
+    Disarmed,
+    Armed
+};
+
+extern std::atomic<AgentArmState> g_agent_arm_state;
+
+/**
+ * Check if no configuration is set anywhere in the JVM.
+ *
+ * When true every connect and lookup is allowed without the hasActiveConfiguration()
+ * upcall. A single relaxed load: NetworkBlockerContext reports the state on the thread
+ * that sets/clears the configuration, before any of that test's own connections.
+ */
+inline bool IsAgentDisarmed() {
+    return g_agent_arm_state.load(std::memory_order_relaxed) == AgentArmState::Disarmed;
+}
+
+// Whether interceptors may call the original without any check: disarmed and not
+// tracing (set together with the arm state in setAgentArmState())
+extern std::atomic<bool> g_interception_bypassed;
+
+/**
+ * Gate in front of every generated wrapper (see interceptor.h).
+ *
+ * One relaxed load. False until NetworkBlockerContext first disarms the agent, so the
+ * policy image and VM_INIT checks still run before it registers.
+ */
+inline bool IsInterceptionBypassed() {
+    return g_interception_bypassed.load(std::memory_order_relaxed);
+}
+
+// Whether the armed configuration applies to every thread in the JVM, mirrored from
+// NetworkBlockerContext via setAgentSharedContext() (junit.airgap.sharedConfiguration)
+extern std::atomic<bool> g_agent_shared_context;
+
+/**
+ * Check if the armed configuration is one JVM-wide test context.
+ *
+ * Then every thread - virtual threads included - has the configuration, so armed
+ * interceptors skip the per-thread hasActiveConfiguration() upcall and go straight to
+ * policy evaluation. This never allows anything the upcall would have blocked:
+ * NetworkBlockerContext.evaluate() still decides every blocked request.
+ */
+inline bool IsAgentContextShared() {
+    return g_agent_shared_context.load(std::memory_order_relaxed);
+}
+
+// Per-thread platform encoding readiness (set once this thread has seen a
+// successful string conversion; never cleared)
+extern thread_local bool t_platform_encoding_ready;
 
-// Get cached string constants (thread-safe)
-jstring GetCallerAgentString();
-jstring GetCallerDnsString();
+// Slow path of EnsurePlatformEncodingReady(): probe, and wait for readiness if needed
+bool WaitForPlatformEncodingReady(JNIEnv* env);
 
 // Ensure platform encoding is ready for the current thread
-// Returns true if ready, false if failed after retries
-bool EnsurePlatformEncodingReady(JNIEnv* env);
+// Returns true if ready, false if still not ready after the wait deadline
+// Once a thread has seen it ready, this is a single thread-local branch
+inline bool EnsurePlatformEncodingReady(JNIEnv* env) {
+    return t_platform_encoding_ready || WaitForPlatformEncodingReady(env);
+}
 
-// Registration function called from Java to cache class/method references
+// JNI entry points called from NetworkBlockerContext
 extern "C" {
     JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_registerWithAgent(
         JNIEnv* env,
         jclass clazz
     );
+
+    JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_setAgentArmState(
+        JNIEnv* env,
+        jclass clazz,
+        jboolean armed,
+        jlong generation
+    );
+
+    JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_setAgentSharedContext(
+        JNIEnv* env,
+        jclass clazz,
+        jboolean shared
+    );
+
+    JNIEXPORT jlong JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_getAgentNativeBindEventCount(
+        JNIEnv* env,
+        jclass clazz
+    );
+
+    JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_quiesceAgentForCheckpoint(
+        JNIEnv* env,
+        jclass clazz
+    );
+
+    JNIEXPORT jboolean JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_restoreAgentAfterCheckpoint(
+        JNIEnv* env,
+        jclass clazz
+    );
 }
 
 #endif // JUNIT_NO_NETWORK_AGENT_H
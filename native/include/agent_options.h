@@ -0,0 +1,98 @@
+#ifndef JUNIT_AIRGAP_AGENT_OPTIONS_H
+#define JUNIT_AIRGAP_AGENT_OPTIONS_H
+
+#include "log_sink.h"
+#include <cstdint>
+#include <string>
+
+/**
+ * Agent Options
+ *
+ * Parsed from the -agentpath options string: comma-separated flags and key=value
+ * pairs, list values separated by '+'.
+ *
+ *   -agentpath:libjunit-airgap-agent.so=debug,bindEvents=keep
+ *   -agentpath:libjunit-airgap-agent.so=log=info+socket:debug+bind:trace
+ *
+ * | Option                | Values                    | Default        |
+ * |-----------------------|---------------------------|----------------|
+ * | debug                 | (flag, same as log=trace) | off            |
+ * | log                   | see below                 | off            |
+ * | logRate               | per site per second       | 50 (0 = off)   |
+ * | bindEvents            | auto, keep                | auto           |
+ * | requiredBinds         | connect, dns, netty ('+') | connect+dns    |
+ * | trace                 | file path ("%p" = pid)    | off            |
+ * | traceBufferSize       | records per thread        | 4096           |
+ * | policy                | policy image file path    | off            |
+ * | libc                  | (flag)                    | off            |
+ * | metrics               | (flag)                    | off            |
+ * | events                | ring file path            | off            |
+ * | eventsCapacity        | records                   | 65536          |
+ *
+ * bindEvents=auto switches NativeMethodBind events off once every requiredBinds group
+ * has a bound target. Use requiredBinds=connect on JDKs where the DNS natives never
+ * bind natively (DNS is then left to the ByteBuddy fallback), or bindEvents=keep to
+ * never disarm. Netty's native transports register their natives when the transport
+ * is first used, usually after the JDK natives are bound; requiredBinds=connect+dns+netty
+ * keeps bind events on until then (the Gradle plugin adds it when a native transport is
+ * on the test classpath).
+ *
+ * log takes '+'-joined entries: <level> sets every category, <category>:<level> one
+ * category; later entries win. Levels: off, info, debug, trace. Categories: agent,
+ * bind, socket, dns, policy, registration, encoding (see log_sink.h).
+ *
+ * trace=<file> records every interception into per-thread ring buffers and writes
+ * them to <file> as NDJSON at unload (see trace_buffer.h).
+ *
+ * policy=<file> maps a precompiled policy image written by the Gradle plugin and
+ * enforces it until NetworkBlockerContext registers (see policy_image.h). The path
+ * can't contain ','.
+ *
+ * libc also intercepts connect()/getaddrinfo() and friends called by JNI libraries
+ * with their own socket code, such as Netty's epoll transport (see libc_interceptor.h).
+ *
+ * metrics counts every interception per target and path, with histograms of upcall
+ * and original-call time, readable via NetworkBlockerContext (see interception_metrics.h).
+ *
+ * events=<file> appends every enforced interception to a ring file shared by all forks
+ * given the same path; eventsCapacity sizes the file if this agent is the one creating
+ * it (see shared_event_ring.h). The path can't contain ','.
+ */
+
+// Interception target groups that must be bound before bind events can be disarmed
+constexpr uint32_t kBindGroupNone = 0;
+constexpr uint32_t kBindGroupConnect = 1u << 0;   // sun.nio.ch.Net.connect0
+constexpr uint32_t kBindGroupDns = 1u << 1;       // Inet6AddressImpl or Inet4AddressImpl lookupAllHostAddr
+constexpr uint32_t kBindGroupNetty = 1u << 2;     // io.netty.channel.unix.Socket.connect (epoll/kqueue)
+
+enum class BindEventMode {
+    Auto,   // Disarm once all required groups are bound
+    Keep    // Never disarm
+};
+
+struct AgentOptions {
+    LogLevel log_levels[kLogCategoryCount] = {};   // All Off
+    uint32_t log_rate = 50;
+    BindEventMode bind_events = BindEventMode::Auto;
+    uint32_t required_bind_groups = kBindGroupConnect | kBindGroupDns;
+    std::string trace_path;                    // Empty = tracing off
+    uint32_t trace_records_per_thread = 4096;
+    std::string policy_path;                   // Empty = no policy image
+    bool libc_interception = false;
+    bool metrics = false;
+    std::string events_path;                   // Empty = no shared event ring
+    uint32_t events_capacity = 65536;
+};
+
+extern AgentOptions g_agent_options;
+
+/**
+ * Parse an agent options string. Unknown options and values are reported on stderr
+ * and otherwise ignored, so a typo never prevents the agent from loading.
+ *
+ * @param options Options string (may be null)
+ * @param out Parsed options (defaults for anything not specified)
+ */
+void ParseAgentOptions(const char* options, AgentOptions* out);
+
+#endif // JUNIT_AIRGAP_AGENT_OPTIONS_H
@@ -0,0 +1,56 @@
+#ifndef JUNIT_AIRGAP_DNS_BINDING_TABLE_H
+#define JUNIT_AIRGAP_DNS_BINDING_TABLE_H
+
+#include "inet_address.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Forward-DNS Binding Table
+ *
+ * Remembers which hostname produced which addresses, as observed by the
+ * lookupAllHostAddr() wrappers in dns_interceptor.cpp. When the connect target carries
+ * no hostname of its own (an InetAddress rebuilt from raw bytes, as some resolvers and
+ * connection pools do), the Net.connect0 wrapper looks it up here to match hostname
+ * allow/block lists instead of calling InetAddress.getHostName() - which, for such an
+ * address, starts a blocking reverse-DNS lookup inside the connect path.
+ *
+ * ## Bounds
+ *
+ * A fixed, direct-mapped array of kDnsBindingTableSlots slots allocated statically
+ * (~300 KB). A colliding record overwrites the older binding; a lost binding only
+ * means the connect is matched on its IP address alone.
+ *
+ * ## Concurrency
+ *
+ * Each slot is a seqlock: writers claim it with a CAS (and give up if another writer
+ * holds it), readers never block and treat a concurrent write as a miss.
+ *
+ * ## Scope
+ *
+ * Bindings are stamped with g_configuration_generation and ignored once it moves on,
+ * so addresses resolved during one test never name hosts in the next.
+ */
+
+// Number of slots (power of two)
+constexpr uint32_t kDnsBindingTableSlots = 1024;
+
+// Longest hostname stored (RFC 1035 maximum is 253 characters)
+constexpr size_t kDnsBindingMaxHostnameLength = 255;
+
+/**
+ * Record that hostname resolved to address (under the current generation).
+ * Hostnames longer than kDnsBindingMaxHostnameLength are not recorded.
+ */
+void RecordDnsBinding(const InetAddressBytes& address, const char* hostname);
+
+/**
+ * Look up the hostname that address was resolved from under the current generation.
+ *
+ * @param address Raw address bytes
+ * @param hostname Output buffer of kDnsBindingMaxHostnameLength + 1 bytes
+ * @return true if a binding was found
+ */
+bool LookupDnsBinding(const InetAddressBytes& address, char* hostname);
+
+#endif // JUNIT_AIRGAP_DNS_BINDING_TABLE_H
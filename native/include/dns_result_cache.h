@@ -0,0 +1,106 @@
+#ifndef JUNIT_AIRGAP_DNS_RESULT_CACHE_H
+#define JUNIT_AIRGAP_DNS_RESULT_CACHE_H
+
+#include <jni.h>
+#include "intercept_targets.h"
+#include <atomic>
+#include <cstdint>
+
+/**
+ * DNS Result Cache
+ *
+ * Test JVMs often run with the JDK's own address cache disabled
+ * (-Dsun.net.inetaddr.ttl=0) for determinism, so a suite that resolves "localhost" or
+ * an allowlisted staging host thousands of times pays the platform resolver - and its
+ * occasional timeouts - on every call. When a test opts in through
+ * NetworkConfiguration.dnsCacheTtlMillis, the lookupAllHostAddr() wrappers serve
+ * repeated lookups of allowed hostnames from here instead of calling the original.
+ *
+ * ## What is cached
+ *
+ * Only successful lookups the native host policy allowed, keyed by (test context,
+ * hostname, InetAddressImpl). The InetAddress[] is held as a global ref; each hit
+ * returns a fresh copy of the array, so callers can't disturb the cached one.
+ *
+ * ## Scope and bounds
+ *
+ * The TTL is part of each test context's compiled policy (setAgentContextPolicy(), or
+ * setAgentHostPolicy() for the JVM-wide context), so parallel tests each get their own:
+ * one test enabling the cache never serves another test's lookups from it, and one
+ * test starting or ending never turns off another's. Entries are stamped with the
+ * configuration generation and their context's policy id and expire after the TTL, so
+ * a result never outlives the test that resolved it. Publishing or clearing a context's
+ * policy flushes its entries (releasing the global refs). At most
+ * kDnsResultCacheMaxEntries entries are kept across all contexts.
+ */
+
+// Most entries kept at once
+constexpr size_t kDnsResultCacheMaxEntries = 256;
+
+/**
+ * Cache InetAddress for copying results, once a policy with a TTL is compiled.
+ * Called from the policy JNI entry points.
+ *
+ * @return false (with a warning) if the cache can't be used; the policy then gets no TTL
+ */
+bool PrepareDnsResultCache(JNIEnv* env);
+
+/**
+ * Whether the DNS result cache is enabled for a test context. A single relaxed load
+ * until any policy has enabled it; checked before any cache work.
+ *
+ * @param context_id Test context of the calling thread (0: the JVM-wide policy)
+ */
+bool IsDnsResultCacheEnabled(int64_t context_id);
+
+/**
+ * Look up a context's cached result for hostname.
+ *
+ * Updates the hit/miss counters.
+ *
+ * @param env JNI environment
+ * @param context_id Test context of the calling thread
+ * @param target Lookup wrapper (Inet4 and Inet6 results are cached separately)
+ * @param hostname Hostname being resolved
+ * @return New local ref to a copy of the cached InetAddress[], or nullptr on a miss
+ */
+jobjectArray LookupDnsResult(JNIEnv* env, int64_t context_id, InterceptTarget target, const char* hostname);
+
+/**
+ * Cache the result of an allowed lookup under the current generation and the context's
+ * policy and TTL. Does nothing if the cache is full of live entries.
+ *
+ * @param env JNI environment
+ * @param context_id Test context of the calling thread
+ * @param target Lookup wrapper
+ * @param hostname Hostname that was resolved
+ * @param addresses InetAddress[] returned by the original lookupAllHostAddr()
+ */
+void StoreDnsResult(JNIEnv* env, int64_t context_id, InterceptTarget target, const char* hostname,
+                    jobjectArray addresses);
+
+/**
+ * Drop a test context's entries and release their global refs.
+ */
+void FlushDnsResults(JNIEnv* env, int64_t context_id);
+
+/**
+ * Drop every entry (before a checkpoint).
+ */
+void FlushAllDnsResults(JNIEnv* env);
+
+/**
+ * Cache statistics (relaxed counters, approximate under concurrency).
+ */
+uint64_t GetDnsResultCacheHits();
+uint64_t GetDnsResultCacheMisses();
+
+// JNI entry points called from NetworkBlockerContext
+extern "C" {
+    JNIEXPORT jlongArray JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_getAgentDnsCacheStats(
+        JNIEnv* env,
+        jclass clazz
+    );
+}
+
+#endif // JUNIT_AIRGAP_DNS_RESULT_CACHE_H
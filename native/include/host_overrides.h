@@ -0,0 +1,61 @@
+#ifndef JUNIT_AIRGAP_HOST_OVERRIDES_H
+#define JUNIT_AIRGAP_HOST_OVERRIDES_H
+
+#include <jni.h>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Native Hosts Override Table
+ *
+ * Compiled form of NetworkConfiguration.hostOverrides ("api.internal" -> "127.0.0.1").
+ *
+ * NetworkBlockerContext.setConfiguration() pushes the mappings down once via
+ * setAgentHostOverrides(). Each address literal is parsed natively and turned into an
+ * InetAddress carrying the mapped hostname (InetAddress.getByAddress(host, bytes), which
+ * never resolves), held as a global ref. The lookupAllHostAddr() wrappers then answer a
+ * lookup of a mapped hostname with a fresh array of those addresses; the original
+ * resolver is never called, so a test pointing "api.internal" at a local WireMock needs
+ * neither real DNS nor /etc/hosts entries.
+ *
+ * Overridden hostnames are also added to the published host policy's allowed hosts, so
+ * both the lookup and the connect to the synthetic address (which carries the hostname)
+ * are allowed. Blocked hosts still take precedence.
+ *
+ * Matching is exact and case-insensitive. Mappings belong to one test context (see
+ * host_policy.h): they are replaced by its setConfiguration() and dropped by its
+ * clearConfiguration(), and only lookups from that context see them. Lookups in the
+ * JVM-wide context (0) use the most recently installed context's mappings.
+ */
+
+/**
+ * Whether any override is installed (single relaxed load).
+ */
+bool HasHostOverrides();
+
+/**
+ * Look up the synthetic addresses of an overridden hostname.
+ *
+ * @param env JNI environment
+ * @param context_id Test context of the calling thread (see ResolveThreadContext())
+ * @param hostname Hostname being resolved
+ * @param ipv4_only Only return IPv4 addresses (Inet4AddressImpl)
+ * @param addresses Output: new local InetAddress[], or nullptr if the hostname is
+ *                  overridden but has no address of the requested family (or on OOM,
+ *                  with the exception pending)
+ * @return true if the hostname is overridden
+ */
+bool LookupHostOverride(JNIEnv* env, int64_t context_id, const char* hostname, bool ipv4_only, jobjectArray* addresses);
+
+// JNI entry points called from NetworkBlockerContext
+extern "C" {
+    JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_setAgentHostOverrides(
+        JNIEnv* env,
+        jclass clazz,
+        jlong contextId,
+        jobjectArray hostnames,
+        jobjectArray addresses
+    );
+}
+
+#endif // JUNIT_AIRGAP_HOST_OVERRIDES_H
@@ -0,0 +1,303 @@
+#ifndef JUNIT_AIRGAP_HOST_POLICY_H
+#define JUNIT_AIRGAP_HOST_POLICY_H
+
+#include <jni.h>
+#include "policy_image.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * Native Host Policy Engine
+ *
+ * Compiled form of NetworkConfiguration.allowedHosts / blockedHosts.
+ *
+ * NetworkBlockerContext.setConfiguration() pushes the host lists down once via
+ * setAgentHostPolicy(). They are compiled into a HostPolicy and published as an
+ * immutable snapshot, so the interceptors can decide allow/block without calling
+ * back into Kotlin. Only a block goes up to Java (to build the exception).
+ *
+ * Matching mirrors HostMatcher in Kotlin, which compiles the same patterns:
+ * - Hosts and patterns are compared case-insensitively
+ * - "*" matches every host
+ * - "*" inside a pattern matches any run of characters ("*.example.com")
+ * - "address/prefix" matches IP literals in that range ("10.0.0.0/8", "fd00::/8")
+ *
+ * ## Test Contexts
+ *
+ * Under in-JVM parallel execution every running test has its own configuration.
+ * setAgentContextPolicy() publishes each one into a fixed table of context slots
+ * (indexed by context id, one atomic load per lookup, no locks), and interceptors
+ * evaluate against the slot of the calling thread's context (see
+ * ResolveThreadContext()). Context 0 is the JVM-wide policy from setAgentHostPolicy()
+ * (the most recently started test's), used with a shared configuration. Two running
+ * contexts mapping to one slot leave the older one without a native policy, so its
+ * requests are decided by NetworkBlockerContext - slower, never wrong.
+ */
+
+/**
+ * CIDR ranges as a binary radix tree per address family: one bit per level, a range
+ * ends at a terminal node, so a lookup walks at most 32 (IPv4) or 128 (IPv6) nodes.
+ */
+struct CidrTree {
+    struct Node {
+        int32_t children[2] = {-1, -1};
+        bool terminal = false;
+    };
+
+    std::vector<Node> ipv4;
+    std::vector<Node> ipv6;
+
+    /**
+     * Add the range of the first prefix_bits bits of an address.
+     *
+     * @param bytes Address in network order
+     * @param length 4 (IPv4) or 16 (IPv6)
+     * @param prefix_bits Prefix length, at most length * 8
+     */
+    void Insert(const uint8_t* bytes, int length, int prefix_bits);
+
+    /**
+     * Check if an address lies in any range of its family.
+     */
+    bool Contains(const uint8_t* bytes, int length) const;
+
+    bool Empty() const;
+};
+
+/**
+ * Parse an IP literal host ("10.1.2.3", "::1", "[::1]", "fe80::1%eth0").
+ * Brackets and an IPv6 zone are stripped, as in HostMatcher.parseIpAddress().
+ *
+ * @param host Hostname or IP address
+ * @param bytes Output buffer of 16 bytes
+ * @return Number of address bytes (4 or 16), or 0 if host is not an IP literal
+ */
+int ParseIpLiteral(const std::string& host, uint8_t bytes[16]);
+
+/**
+ * A set of compiled host patterns.
+ *
+ * Patterns are split by shape so the common cases avoid the generic glob matcher:
+ * - Exact names ("localhost", "127.0.0.1") → hash set lookup
+ * - Leading wildcard ("*.example.com") → suffix comparison
+ * - CIDR ranges ("10.0.0.0/8") → radix tree, for hosts that are IP literals
+ * - Anything else containing '*' → glob match
+ *
+ * A set can also (or instead) be backed by a mapped policy image (see policy_image.h).
+ */
+struct HostPatternSet {
+    bool match_all = false;
+    std::unordered_set<std::string> exact;
+    std::vector<std::string> suffixes;
+    std::vector<std::string> globs;
+    CidrTree ranges;
+    PolicyImagePatternSet mapped;
+
+    /**
+     * Compile and add a pattern. Empty patterns are ignored.
+     */
+    void Add(const std::string& pattern);
+
+    /**
+     * Check if a host matches any pattern in the set.
+     *
+     * @param host Lowercase hostname or IP address
+     */
+    bool Matches(const std::string& host) const;
+
+    bool Empty() const;
+};
+
+/**
+ * Glob match where '*' matches any run of characters (including empty).
+ *
+ * @param pattern Lowercase pattern (not NUL-terminated)
+ * @param pattern_length Pattern length in bytes
+ * @param host Lowercase hostname or IP address
+ */
+bool GlobMatches(const char* pattern, size_t pattern_length, const std::string& host);
+
+/**
+ * Lowercase a host string (ASCII only, matching String.lowercase() for hostnames).
+ */
+std::string NormalizeHost(const char* host);
+
+/**
+ * Compiled allow/block policy for one NetworkConfiguration.
+ */
+struct HostPolicy {
+    HostPatternSet allowed;
+    HostPatternSet blocked;
+
+    // Unique, non-zero id of this snapshot (used to stamp cached verdicts)
+    uint64_t id = 0;
+
+    // Test context this snapshot belongs to (0: the JVM-wide policy)
+    int64_t context_id = 0;
+
+    // DNS result cache TTL of this context, in nanoseconds (0: disabled, see dns_result_cache.h)
+    int64_t dns_cache_ttl_ns = 0;
+
+    /**
+     * Mirrors NetworkConfiguration.isAllowed(): blocked hosts take precedence,
+     * an empty allow list blocks everything.
+     */
+    bool IsAllowed(const std::string& host) const;
+
+    /**
+     * Mirrors NetworkBlockerContext.isExplicitlyBlocked().
+     */
+    bool IsExplicitlyBlocked(const std::string& host) const;
+};
+
+/**
+ * Which identifier of a connection caused a block verdict.
+ * Used to pick the host string passed to checkConnection() so the
+ * exception names the identifier that was actually rejected.
+ */
+enum class PolicyCulprit {
+    None,
+    Hostname,
+    Address
+};
+
+/**
+ * Result of evaluating a connection against the published policy.
+ */
+struct PolicyVerdict {
+    bool blocked;
+    PolicyCulprit culprit;
+
+    // True if this allow verdict depends only on the address (not the hostname),
+    // so it can be cached by (address, port)
+    bool cacheable;
+
+    // Id of the policy snapshot the verdict was computed against (0 if none)
+    uint64_t policy_id;
+};
+
+/**
+ * Evaluate a socket connection against the published policy.
+ *
+ * Logic (same order as the former Kotlin upcall sequence):
+ * 1. Hostname or IP explicitly in blockedHosts → block
+ * 2. IP allowed → allow
+ * 3. Hostname allowed → allow
+ * 4. Otherwise → block
+ *
+ * If no policy is published, the verdict is "blocked" with the address (or
+ * hostname) as culprit, so Java remains the authority and fails closed.
+ *
+ * @param hostname Hostname (may be null)
+ * @param address IP address string (may be null)
+ * @param context_id Test context of the calling thread (0: the JVM-wide policy)
+ */
+PolicyVerdict EvaluateConnectPolicy(const char* hostname, const char* address, int64_t context_id = 0);
+
+/**
+ * Evaluate a socket connection against a specific policy (e.g. the policy image).
+ */
+PolicyVerdict EvaluateConnectPolicy(const HostPolicy& policy, const char* hostname, const char* address);
+
+/**
+ * Evaluate a DNS lookup against the published policy.
+ *
+ * @param hostname Hostname being resolved
+ * @param context_id Test context of the calling thread (0: the JVM-wide policy)
+ * @return true if the lookup is allowed
+ */
+bool EvaluateDnsPolicy(const char* hostname, int64_t context_id = 0);
+
+/**
+ * Evaluate a DNS lookup against a specific policy (e.g. the policy image).
+ */
+bool EvaluateDnsPolicy(const HostPolicy& policy, const char* hostname);
+
+/**
+ * Publish a new policy snapshot (nullptr clears it).
+ * Readers holding the previous snapshot keep it alive until they are done.
+ */
+void PublishHostPolicy(std::shared_ptr<const HostPolicy> policy);
+
+/**
+ * Allocate a new policy snapshot id.
+ */
+uint64_t NextHostPolicyId();
+
+/**
+ * Get the id of the currently published policy snapshot.
+ * Cheaper than GetHostPolicy() (single atomic load, no refcount).
+ *
+ * @return Current policy id, or 0 if none is published
+ */
+uint64_t GetHostPolicyId();
+
+/**
+ * Get the currently published policy snapshot.
+ *
+ * @return Current policy, or nullptr if none is published
+ */
+std::shared_ptr<const HostPolicy> GetHostPolicy();
+
+/**
+ * Publish the policy of one test context (policy->context_id, non-zero) into its slot.
+ */
+void PublishContextPolicy(std::shared_ptr<const HostPolicy> policy);
+
+/**
+ * Drop the policy of a finished test context, if its slot still holds it.
+ */
+void RetireContextPolicy(int64_t context_id);
+
+/**
+ * Get the policy of a test context.
+ *
+ * @param context_id Test context (0: the JVM-wide policy, like GetHostPolicy())
+ * @return The context's policy, or nullptr if none is published for it
+ */
+std::shared_ptr<const HostPolicy> GetContextPolicy(int64_t context_id);
+
+/**
+ * Get the id of the policy snapshot in a test context's slot (single atomic load).
+ * May belong to another context sharing the slot; callers holding a snapshot id
+ * computed for context_id compare against it.
+ *
+ * @return Policy id, or 0 if none is published
+ */
+uint64_t GetContextPolicyId(int64_t context_id);
+
+// JNI entry points called from NetworkBlockerContext
+extern "C" {
+    JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_setAgentHostPolicy(
+        JNIEnv* env,
+        jclass clazz,
+        jobjectArray allowedHosts,
+        jobjectArray blockedHosts,
+        jlong dnsCacheTtlMillis
+    );
+
+    JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_clearAgentHostPolicy(
+        JNIEnv* env,
+        jclass clazz
+    );
+
+    JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_setAgentContextPolicy(
+        JNIEnv* env,
+        jclass clazz,
+        jlong contextId,
+        jobjectArray allowedHosts,
+        jobjectArray blockedHosts,
+        jlong dnsCacheTtlMillis
+    );
+
+    JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_clearAgentContextPolicy(
+        JNIEnv* env,
+        jclass clazz,
+        jlong contextId
+    );
+}
+
+#endif // JUNIT_AIRGAP_HOST_POLICY_H
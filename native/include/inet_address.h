@@ -0,0 +1,111 @@
+#ifndef JUNIT_AIRGAP_INET_ADDRESS_H
+#define JUNIT_AIRGAP_INET_ADDRESS_H
+
+#include <jni.h>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Allocation-free java.net.InetAddress decoding
+ *
+ * Reads the raw address straight out of the JDK's holder objects with cached field IDs,
+ * instead of calling getHostAddress() (a new Java String per call) and copying it with
+ * GetStringUTFChars. Text is then formatted natively into a stack buffer.
+ *
+ * OpenJDK layout (JDK 8+):
+ * - InetAddress.holder                     → InetAddress$InetAddressHolder
+ * - InetAddressHolder.address / .family    → IPv4 address as int, IPv4 = 1 / IPv6 = 2
+ * - InetAddressHolder.hostName             → hostname the address was created with (or null)
+ * - Inet6Address.holder6                   → Inet6Address$Inet6AddressHolder
+ * - Inet6AddressHolder.ipaddress           → byte[16]
+ *
+ * JNI field access ignores Java access control and module encapsulation. If the layout
+ * differs (non-OpenJDK class library), decoding falls back to InetAddress.getAddress().
+ */
+
+// Maximum raw address length (IPv6)
+constexpr int kInetAddressMaxLength = 16;
+
+// Buffer size for textual form: "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff" + NUL
+constexpr size_t kInetAddressTextMaxLength = 40;
+
+/**
+ * Raw address bytes in network order (4 for IPv4, 16 for IPv6).
+ */
+struct InetAddressBytes {
+    uint8_t bytes[kInetAddressMaxLength];
+    uint8_t length;
+};
+
+/**
+ * Field and method IDs used for decoding, looked up once at registration.
+ *
+ * Field/method IDs of bootstrap classes stay valid for the lifetime of the JVM.
+ */
+struct InetAddressFields {
+    // Direct field access (nullptr if the JDK layout is not recognized)
+    jfieldID holder;              // InetAddress.holder
+    jfieldID holder_address;      // InetAddressHolder.address (int)
+    jfieldID holder_family;       // InetAddressHolder.family (int)
+    jfieldID holder_host_name;    // InetAddressHolder.hostName (String)
+    jfieldID holder6;             // Inet6Address.holder6
+    jfieldID holder6_ipaddress;   // Inet6AddressHolder.ipaddress (byte[])
+
+    // Fallbacks and hostname
+    jmethodID get_address;        // InetAddress.getAddress() → byte[]
+    jmethodID get_host_name;      // InetAddress.getHostName() → String (may do reverse DNS)
+};
+
+/**
+ * Look up the InetAddress field and method IDs.
+ *
+ * Never leaves a JNI exception pending. Missing holder fields only disable the fast
+ * path; the method IDs are required.
+ *
+ * @param env JNI environment
+ * @param fields Output IDs
+ * @return true if at least the method IDs were found
+ */
+bool LookupInetAddressFields(JNIEnv* env, InetAddressFields* fields);
+
+/**
+ * Read the raw address bytes of an InetAddress.
+ *
+ * No Java objects are allocated when the holder fields are available.
+ *
+ * @param env JNI environment
+ * @param fields IDs from LookupInetAddressFields()
+ * @param address java.net.InetAddress (may be null)
+ * @param out Output bytes
+ * @return true if an address was read
+ */
+bool DecodeInetAddress(JNIEnv* env, const InetAddressFields& fields, jobject address, InetAddressBytes* out);
+
+/**
+ * Get the hostname an InetAddress already carries, without any resolution.
+ *
+ * Reads InetAddressHolder.hostName, which is set when the address came from a
+ * forward lookup (InetAddress.getByName("example.com")) and null for addresses
+ * created from a literal IP. Unlike getHostName(), this never starts a reverse
+ * DNS lookup. Only if the holder layout is not recognized does it fall back to
+ * getHostName().
+ *
+ * Never leaves a JNI exception pending.
+ *
+ * @return Local reference to the hostname, or nullptr if unknown
+ */
+jstring GetInetAddressHostName(JNIEnv* env, const InetAddressFields& fields, jobject address);
+
+/**
+ * Format raw address bytes the way InetAddress.getHostAddress() does:
+ * - IPv4: dotted decimal ("127.0.0.1")
+ * - IPv6: eight lowercase hex groups without zero compression ("0:0:0:0:0:0:0:1")
+ *
+ * The IPv6 scope suffix ("%eth0") is not included.
+ *
+ * @param address Raw bytes
+ * @param out Buffer of at least kInetAddressTextMaxLength bytes
+ */
+void FormatInetAddress(const InetAddressBytes& address, char* out);
+
+#endif // JUNIT_AIRGAP_INET_ADDRESS_H
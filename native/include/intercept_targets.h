@@ -0,0 +1,76 @@
+#ifndef JUNIT_AIRGAP_INTERCEPT_TARGETS_H
+#define JUNIT_AIRGAP_INTERCEPT_TARGETS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Native Method Interception Targets
+ *
+ * Every native method the agent cares about, as an enum. The enum indexes the
+ * original-function array and the declarative target table in agent.cpp, which the
+ * NativeMethodBind callback dispatches on.
+ *
+ * To add a target: add an enumerator here and a row to kInterceptTargets (in the same
+ * order - a static_assert checks it), and generate its wrapper from a traits type with
+ * Interceptor<Traits>::Install (interceptor.h) as the row's install_wrapper.
+ */
+enum class InterceptTarget : uint8_t {
+    NetConnect0,              // sun.nio.ch.Net.connect0()
+    SocketConnect0,           // java.net.Socket.socketConnect0() (legacy, pre-Java 7)
+    SocketChannelConnect0,    // sun.nio.ch.SocketChannelImpl.connect0()
+    Inet6LookupAllHostAddr,   // java.net.Inet6AddressImpl.lookupAllHostAddr()
+    Inet4LookupAllHostAddr,   // java.net.Inet4AddressImpl.lookupAllHostAddr()
+    NettySocketConnect,       // io.netty.channel.unix.Socket.connect() (epoll/kqueue, also shaded)
+    Count
+};
+
+constexpr size_t kInterceptTargetCount = (size_t)InterceptTarget::Count;
+
+/**
+ * 32-bit FNV-1a hash of a NUL-terminated name, usable at compile time.
+ *
+ * Used to reject binds by method name (and then class signature) with one integer
+ * comparison per target before falling back to strcmp.
+ */
+constexpr uint32_t HashName(const char* name) {
+    uint32_t hash = 2166136261u;
+    for (const char* p = name; *p != '\0'; p++) {
+        hash = (hash ^ (uint8_t)*p) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * One row of the interception table.
+ */
+struct InterceptTargetSpec {
+    InterceptTarget target;
+    const char* class_signature;    // JVM type signature, e.g. "Lsun/nio/ch/Net;"
+    const char* method_name;
+    uint32_t class_hash;
+    uint32_t method_hash;
+    const char* display_name;       // For logging, e.g. "sun.nio.ch.Net.connect0"
+
+    // Match any class whose signature ends in "<package>/" + class_signature (given without
+    // the leading 'L'), for libraries that are commonly shaded into another package
+    bool match_class_suffix;
+
+    // JNI method signature the wrapper was written against; nullptr = not checked
+    // (JDK natives). A bind with any other signature is left alone.
+    const char* method_signature;
+
+    // kBindGroup* this target satisfies once bound (see agent_options.h);
+    // kBindGroupNone for targets that never block disarming bind events
+    uint32_t bind_group;
+
+    // Stores the original and returns the wrapper address; nullptr = only record
+    // the original, keep the JDK implementation bound
+    void* (*install_wrapper)(void* original_address);
+
+    // JDK library exporting the JNI symbol ("nio" for libnio), used to rebind the target
+    // when the agent is attached to a running JVM; nullptr = not rebound on attach
+    const char* jdk_library;
+};
+
+#endif // JUNIT_AIRGAP_INTERCEPT_TARGETS_H
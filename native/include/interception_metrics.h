@@ -0,0 +1,74 @@
+#ifndef JUNIT_AIRGAP_INTERCEPTION_METRICS_H
+#define JUNIT_AIRGAP_INTERCEPTION_METRICS_H
+
+#include <jni.h>
+#include "intercept_targets.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Interception Metrics
+ *
+ * Aggregated counters for every intercepted connect and DNS lookup, enabled with the
+ * agent option metrics (off by default). Where the trace buffer keeps one record per
+ * interception, these keep totals: cheap enough to leave on for a whole suite and
+ * read between tests.
+ *
+ * ## Counted
+ *
+ * - Calls, allowed and blocked, per interception target
+ * - Decisions per path (TracePath: disarmed, no configuration, verdict cache, ...)
+ * - Log2-bucketed histograms of the time spent in JNI upcalls into
+ *   NetworkBlockerContext, and of the time after the verdict (the original native
+ *   call) for allowed interceptions, plus the total of each
+ *
+ * ## Sharding
+ *
+ * Counters live in kMetricsShards cache-line-aligned shards; each thread is assigned
+ * one round-robin on first use and only does relaxed fetch_adds on it, so threads on
+ * different shards never share a cache line. Reading sums the shards and is not an
+ * atomic snapshot (a concurrent interception may be half counted).
+ *
+ * With metrics on, the wrappers' disarmed gate is turned off like for tracing, so
+ * disarmed interceptions are counted too.
+ */
+
+// Defined in trace_buffer.h
+enum class TracePath : uint8_t;
+enum class TraceVerdict : uint8_t;
+
+constexpr size_t kMetricsShards = 16;
+
+// Histogram bucket i counts durations in [2^i, 2^(i+1)) ns; the last bucket is open-ended
+constexpr size_t kMetricsHistogramBuckets = 32;
+
+// Whether metrics are enabled (set once in Agent_OnLoad, never changed)
+extern bool g_metrics_enabled;
+
+/**
+ * Count one finished interception.
+ *
+ * @param target Interception target
+ * @param path Path that decided the verdict
+ * @param verdict Verdict
+ * @param upcall_ns Time inside JNI upcalls (0 if none)
+ * @param original_ns Time after the verdict, spent mostly in the original native
+ *                    (counted for allowed interceptions only)
+ */
+void RecordInterceptionMetrics(
+    InterceptTarget target,
+    TracePath path,
+    TraceVerdict verdict,
+    uint64_t upcall_ns,
+    uint64_t original_ns
+);
+
+// JNI entry points called from NetworkBlockerContext
+extern "C" {
+    JNIEXPORT jlongArray JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_getAgentMetrics(
+        JNIEnv* env,
+        jclass clazz
+    );
+}
+
+#endif // JUNIT_AIRGAP_INTERCEPTION_METRICS_H
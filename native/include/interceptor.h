@@ -0,0 +1,92 @@
+#ifndef JUNIT_AIRGAP_INTERCEPTOR_H
+#define JUNIT_AIRGAP_INTERCEPTOR_H
+
+#include "agent.h"
+#include "trace_buffer.h"
+#include <atomic>
+
+/**
+ * Interceptor Framework
+ *
+ * Generates the JNI wrapper for an interception target from a traits type, so every
+ * wrapper shares one gate in front of its own decision logic:
+ *
+ * ```
+ * struct NetConnect0Traits {
+ *     static constexpr InterceptTarget kTarget = InterceptTarget::NetConnect0;
+ *     using Signature = jint(JNIEnv*, jclass, jboolean, jobject, jobject, jint);
+ *
+ *     // The original JDK lookup needs this thread's platform encoding (DNS only)
+ *     static constexpr bool kNeedsPlatformEncoding = false;
+ *
+ *     // Armed slow path: decode the arguments, decide, call original or block
+ *     static jint Intercept(JNIEnv* env, InterceptTrace& trace, NetConnect0Func original, jclass cls, ...);
+ * };
+ *
+ * void* InstallNetConnect0Wrapper(void* original) {
+ *     return Interceptor<NetConnect0Traits>::Install(original);
+ * }
+ * ```
+ *
+ * The gate is one relaxed atomic load (IsInterceptionBypassed()): while no configuration
+ * is armed anywhere in the JVM and nothing is traced or metered, the wrapper tail-calls the original
+ * without touching the agent context, the trace buffer or JNI. Everything else - VM_INIT,
+ * registration, the policy image, per-thread contexts - is the traits' Intercept().
+ *
+ * Each specialization holds its own original, so a traits template instantiated per slot
+ * (Netty: one per bound library) gets one wrapper and one original per instance. Install()
+ * can run again while other threads are in Wrapper() (attach rebinding, revalidation after
+ * a CRaC restore), so the original is an atomic published with release ordering.
+ */
+
+#if defined(__GNUC__) || defined(__clang__)
+#define AIRGAP_LIKELY(condition) __builtin_expect(!!(condition), 1)
+#else
+#define AIRGAP_LIKELY(condition) (condition)
+#endif
+
+template <typename Traits, typename Signature = typename Traits::Signature>
+class Interceptor;
+
+template <typename Traits, typename Result, typename... Args>
+class Interceptor<Traits, Result(JNIEnv*, Args...)> {
+public:
+    using Function = Result (JNICALL*)(JNIEnv*, Args...);
+
+    /**
+     * Store the original implementation and return the wrapper to bind instead.
+     * Used as the target's install_wrapper (see intercept_targets.h).
+     */
+    static void* Install(void* original_address) {
+        original_.store((Function)original_address, std::memory_order_release);
+        return (void*)&Wrapper;
+    }
+
+    /**
+     * Original implementation, or nullptr before Install().
+     */
+    static Function Original() {
+        return original_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * The JNI entry point bound in place of the original.
+     */
+    static Result JNICALL Wrapper(JNIEnv* env, Args... args) {
+        if (AIRGAP_LIKELY(IsInterceptionBypassed()) &&
+            (!Traits::kNeedsPlatformEncoding || t_platform_encoding_ready)) {
+            // The original is the only data read on this path, so no ordering is needed
+            return original_.load(std::memory_order_relaxed)(env, args...);
+        }
+
+        InterceptTrace trace(Traits::kTarget);
+        return Traits::Intercept(env, trace, original_.load(std::memory_order_acquire), args...);
+    }
+
+private:
+    // Written by every Install(): first before the JVM can call Wrapper(), later (rebinding,
+    // revalidation) while other threads may be reading it
+    static inline std::atomic<Function> original_{nullptr};
+};
+
+#endif // JUNIT_AIRGAP_INTERCEPTOR_H
@@ -0,0 +1,49 @@
+#ifndef JUNIT_AIRGAP_LIBC_INTERCEPTOR_H
+#define JUNIT_AIRGAP_LIBC_INTERCEPTOR_H
+
+/**
+ * libc-Level Interception (libc agent option)
+ *
+ * JNI libraries with their own socket code (Netty's epoll transport, gRPC-netty,
+ * ...) call connect() directly and never reach sun.nio.ch.Net.connect0. With the
+ * libc option the agent also redirects the calls those libraries make to
+ *
+ *   connect, sendto, sendmsg, getaddrinfo, gethostbyname
+ *
+ * by patching their GOT entries (the slots the dynamic linker filled with the libc
+ * addresses). Libraries loaded later are found by RescanLoadedLibraries(), which the
+ * agent calls on every native method bind (the libc option keeps bind events on) and
+ * whenever a test arms it. A library loaded with System.loadLibrary() is so patched
+ * before its first native method runs; its ELF constructors and JNI_OnLoad run
+ * unpatched, and a library another native library loads is patched by the next bind
+ * or test start.
+ *
+ * Verdicts come from the native policy engine only - the JVM-wide host policy (the
+ * most recently started test's) while a configuration is armed, the policy image
+ * before NetworkBlockerContext registers - so the hooks never call into Java and an
+ * allowed call costs a policy lookup. A blocked connect/sendto/sendmsg fails with EACCES, a blocked lookup with
+ * EAI_NONAME / HOST_NOT_FOUND; the library surfaces that as its own I/O error.
+ * Hosts overrides and the Robolectric exemption are not applied at this level.
+ *
+ * Not patched: the JDK's own libraries (covered by the JNI wrappers, which keep
+ * NetworkBlockerContext as the final authority), libc, the dynamic linker, the NSS
+ * and resolver libraries (DNS traffic of an allowed lookup) and the agent itself.
+ *
+ * Linux on x86_64 and aarch64 only; elsewhere the option is reported and ignored.
+ */
+
+/**
+ * Patch every loaded library.
+ * Called from Agent_OnLoad when the libc option is set.
+ *
+ * @return true if interception is active
+ */
+bool InstallLibcInterception();
+
+/**
+ * Patch the libraries loaded since the last scan. One dl_iterate_phdr() step when
+ * none were; does nothing unless InstallLibcInterception() succeeded.
+ */
+void RescanLoadedLibraries();
+
+#endif // JUNIT_AIRGAP_LIBC_INTERCEPTOR_H
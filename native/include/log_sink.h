@@ -0,0 +1,139 @@
+#ifndef JUNIT_AIRGAP_LOG_SINK_H
+#define JUNIT_AIRGAP_LOG_SINK_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Native Log Sink
+ *
+ * Levelled, per-category diagnostic logging that is cheap enough to leave compiled in.
+ *
+ * ## Levels and categories
+ *
+ * Each category has its own runtime level, parsed from the agent options
+ * (log=<level> for all, log=socket:debug+bind:trace per category, see agent_options.h).
+ * A disabled site costs one byte load and compare. Sites above
+ * JUNIT_AIRGAP_LOG_MAX_LEVEL are removed at compile time (Release builds drop Trace).
+ *
+ * ## Asynchronous output
+ *
+ * Messages are formatted on the calling thread into a preallocated slot of a bounded
+ * multi-producer queue and written to stderr in batches by a background thread, so a
+ * log line in a JNI path never waits on stderr. A full queue drops the message and
+ * counts it. The queue is flushed at Agent_OnUnload and at process exit.
+ *
+ * ## Rate limiting
+ *
+ * Each call site lets through at most logRate messages per second (agent option,
+ * default 50) and reports how many it suppressed when its next window opens.
+ *
+ * Errors and warnings still go straight to stderr with fprintf: they are rare and
+ * must survive a crash. A warning that an interception can repeat (one per blocked
+ * call from a native loop) uses LOG_WARNING instead: still written directly and
+ * regardless of the log levels, but under the same per-site rate limit.
+ */
+
+enum class LogLevel : uint8_t {
+    Off,
+    Info,    // Lifecycle milestones
+    Debug,   // Decisions, one or a few lines per interception
+    Trace    // Firehose (every native method bind)
+};
+
+enum class LogCategory : uint8_t {
+    Agent,          // Load/unload, JVMTI setup, VM_INIT
+    Bind,           // NativeMethodBind events and wrapper installation
+    Socket,         // Connect interception
+    Dns,            // DNS interception
+    Policy,         // Host policy compilation and evaluation
+    Registration,   // NetworkBlockerContext registration and state updates
+    Encoding,       // Platform encoding readiness
+    Count
+};
+
+constexpr size_t kLogCategoryCount = (size_t)LogCategory::Count;
+
+// Highest level compiled in (as an integer, for use in #if and -D)
+#ifndef JUNIT_AIRGAP_LOG_MAX_LEVEL
+#define JUNIT_AIRGAP_LOG_MAX_LEVEL 3
+#endif
+
+// Runtime level per category (set once in Agent_OnLoad, never changed)
+extern LogLevel g_log_levels[kLogCategoryCount];
+
+/**
+ * Check if a site would log.
+ */
+inline bool LogEnabled(LogLevel level, LogCategory category) {
+    return (int)level <= JUNIT_AIRGAP_LOG_MAX_LEVEL && level <= g_log_levels[(size_t)category];
+}
+
+/**
+ * Per-call-site rate limiting state (one static instance per AGENT_LOG site).
+ */
+struct LogSite {
+    std::atomic<uint64_t> window_start_ms{0};
+    std::atomic<uint32_t> window_count{0};
+    std::atomic<uint32_t> suppressed{0};
+};
+
+/**
+ * Configure the sink and start the writer thread if any category is enabled.
+ * Called once from Agent_OnLoad.
+ *
+ * @param levels Level per category
+ * @param messages_per_second Rate limit per call site (0 = unlimited)
+ */
+void InitLogSink(const LogLevel levels[kLogCategoryCount], uint32_t messages_per_second);
+
+/**
+ * Format and enqueue one message. Use through AGENT_LOG, which checks LogEnabled() first.
+ */
+void WriteLog(LogSite* site, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * Write one "WARNING: <message>" line straight to stderr, subject to the site's rate
+ * limit. Use through LOG_WARNING.
+ */
+void WriteWarning(LogSite* site, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * Write every queued message to stderr now (Agent_OnUnload, process exit).
+ */
+void FlushLogs();
+
+/**
+ * Parse a level name ("off", "info", "debug", "trace").
+ *
+ * @return false if the name is unknown
+ */
+bool ParseLogLevel(const char* name, LogLevel* level);
+
+/**
+ * Parse a category name ("agent", "bind", "socket", "dns", "policy", "registration", "encoding").
+ *
+ * @return false if the name is unknown
+ */
+bool ParseLogCategory(const char* name, LogCategory* category);
+
+#define AGENT_LOG(level, category, ...)                              \
+    do {                                                             \
+        if (LogEnabled(level, category)) {                           \
+            static LogSite agent_log_site;                           \
+            WriteLog(&agent_log_site, __VA_ARGS__);                  \
+        }                                                            \
+    } while (0)
+
+#define LOG_WARNING(...)                                             \
+    do {                                                             \
+        static LogSite agent_log_site;                               \
+        WriteWarning(&agent_log_site, __VA_ARGS__);                  \
+    } while (0)
+
+#define LOG_INFO(category, ...) AGENT_LOG(LogLevel::Info, LogCategory::category, __VA_ARGS__)
+#define LOG_DEBUG(category, ...) AGENT_LOG(LogLevel::Debug, LogCategory::category, __VA_ARGS__)
+#define LOG_TRACE(category, ...) AGENT_LOG(LogLevel::Trace, LogCategory::category, __VA_ARGS__)
+
+#endif // JUNIT_AIRGAP_LOG_SINK_H
@@ -0,0 +1,85 @@
+#ifndef JUNIT_AIRGAP_POLICY_IMAGE_H
+#define JUNIT_AIRGAP_POLICY_IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Precompiled Policy Image
+ *
+ * The Gradle plugin (PolicyImageWriter) compiles the junitAirgap { allowedHosts,
+ * blockedHosts } lists into a binary file, and passes it as policy=<file> to every
+ * forked test JVM. Each agent maps it read-only (MAP_SHARED), so all forks share the
+ * same page-cache pages and none of them parses or compiles anything at startup.
+ *
+ * The image is enforced from the first intercepted connect or lookup until
+ * NetworkBlockerContext registers; from then on NetworkBlockerContext and the
+ * per-test policy it publishes take over, exactly as without an image.
+ *
+ * ## Format (version 2, all integers little-endian)
+ *
+ *   Header (56 bytes)
+ *     0   char[8]  magic "AIRGAPPI"
+ *     8   u32      version
+ *     12  u32      file size in bytes
+ *     16  u32[5]   allowed pattern set (below)
+ *     36  u32[5]   blocked pattern set
+ *
+ *   Pattern set: flags (bit 0 = "*", matches everything), then the offsets of
+ *     exact table   u32 bucket count (power of two, or 0), then per bucket
+ *                   u32 FNV-1a hash, u32 string offset (0 = empty bucket)
+ *     suffix list   u32 count, then count × u32 string offset ("*.example.com" → ".example.com")
+ *     glob list     u32 count, then count × u32 string offset (any other pattern with '*')
+ *     range list    u32 count, then count × u32 string offset (patterns with '/' and no '*')
+ *
+ *   String: u16 length, then that many bytes (lowercased, not NUL-terminated)
+ *
+ * Patterns are classified exactly like HostPatternSet::Add(), except that range list
+ * entries are only CIDR candidates: they are few, so the agent compiles them with
+ * HostPatternSet::Add() at load (into a radix tree, or an exact name if they are not
+ * a valid range) instead of the writer having to parse IP literals. The exact table
+ * uses linear probing and always has at least one empty bucket. Every offset, length
+ * and table is validated once at load, so matching reads the mapping without checks.
+ */
+
+/**
+ * One pattern set inside a mapped image (a view; the mapping is never unmapped).
+ */
+struct PolicyImagePatternSet {
+    const uint8_t* image = nullptr;   // nullptr = no image patterns
+    uint32_t flags = 0;
+    uint32_t exact_table = 0;
+    uint32_t suffix_list = 0;
+    uint32_t glob_list = 0;
+    uint32_t range_list = 0;
+
+    /**
+     * Check if a host matches any pattern in the set.
+     *
+     * @param host Lowercase hostname or IP address
+     */
+    bool Matches(const std::string& host) const;
+
+    bool Empty() const;
+};
+
+struct HostPolicy;
+
+/**
+ * Map and validate a policy image. Called from Agent_OnLoad when policy=<file> is given.
+ * A missing or invalid image is reported on stderr and the agent runs without it.
+ *
+ * @param path Image file path
+ * @return true if the image was loaded
+ */
+bool LoadPolicyImage(const char* path);
+
+/**
+ * Get the policy compiled into the loaded image.
+ *
+ * @return Image policy (valid for the lifetime of the process), or nullptr if no image is loaded
+ */
+const HostPolicy* GetPolicyImagePolicy();
+
+#endif // JUNIT_AIRGAP_POLICY_IMAGE_H
@@ -0,0 +1,128 @@
+#ifndef JUNIT_AIRGAP_SHARED_EVENT_RING_H
+#define JUNIT_AIRGAP_SHARED_EVENT_RING_H
+
+#include "inet_address.h"
+#include "intercept_targets.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Shared Event Ring
+ *
+ * One memory-mapped ring file shared by every forked test JVM of a Gradle test task,
+ * enabled with the agent option events=<file> (the Gradle plugin passes it when
+ * junitAirgap { interceptionSummary } is set). Each agent appends one fixed-size
+ * record per enforced interception; after the test task, the plugin reads the file
+ * once and aggregates it into a summary, so no fork writes report files and nothing
+ * parses stderr.
+ *
+ * ## Recording
+ *
+ * Interceptions that went through a host policy are recorded (the policy image,
+ * verdict and DNS caches, hosts overrides, native policy and NetworkBlockerContext
+ * paths); VM_INIT, unregistered, disarmed and unconfigured interceptions are not,
+ * since nothing was enforced. A writer claims a slot with one fetch_add on the
+ * header's write index, fills it in and publishes it by storing its sequence last
+ * (release), so recording takes no lock and makes no system call, across threads
+ * and processes alike. Once the ring is full, new records overwrite the oldest.
+ *
+ * ## File format (version 1, native byte order, little-endian on every supported platform)
+ *
+ *   Header (64 bytes)
+ *     0   char[8]  magic "AIRGAPEV"
+ *     8   u32      version
+ *     12  u32      record size (128)
+ *     16  u64      capacity in records (power of two)
+ *     24  u64      write index: records ever claimed (atomic)
+ *     32  ...      reserved (zero)
+ *
+ *   Record `i` at 64 + (i & (capacity - 1)) * 128
+ *     0   u64      sequence: i + 1 once complete (0 = never written)
+ *     8   u64      wall-clock time, nanoseconds since the epoch
+ *     16  i64      test context ID (NetworkConfiguration.generation, 0 = none/shared)
+ *     24  u32      process ID of the fork
+ *     28  u16      port (0 for DNS lookups)
+ *     30  u8       target (InterceptTarget)
+ *     31  u8       verdict (TraceVerdict)
+ *     32  u8       path (TracePath)
+ *     33  u8       address length (0, 4 or 16)
+ *     34  u8       hostname length
+ *     35  u8       reserved
+ *     36  u8[16]   address bytes
+ *     52  char[76] hostname (UTF-8, truncated, not NUL-terminated)
+ *
+ * The first agent to open an empty (or missing) file sizes it and writes the header,
+ * under flock() so forks starting together agree; later agents validate the header
+ * and use the file's capacity.
+ *
+ * ## Checkpoint/restore
+ *
+ * A file mapping can't be carried into a restored process (the file may be gone, or
+ * belong to another test task by then), so SuspendSharedEventRing() unmaps it before a
+ * checkpoint and ResumeSharedEventRing() maps the file again, under the new process ID.
+ * Writers count themselves in around each record, so the mapping is never removed
+ * under one.
+ */
+
+// Defined in trace_buffer.h
+enum class TracePath : uint8_t;
+enum class TraceVerdict : uint8_t;
+
+// Bytes of a hostname kept per record
+constexpr size_t kSharedEventHostnameLength = 76;
+
+// Whether the event ring is enabled (set in Agent_OnLoad; off between a checkpoint and its restore)
+extern bool g_event_ring_enabled;
+
+/**
+ * Map the ring file, creating and sizing it if empty. Called from Agent_OnLoad when
+ * events=<file> is given.
+ *
+ * @param path Ring file path
+ * @param capacity Records, rounded up to a power of two (used only when creating the file)
+ * @return true if the ring is mapped; false (with a warning) leaves recording off
+ */
+bool InitSharedEventRing(const char* path, uint32_t capacity);
+
+/**
+ * Stop recording and unmap the ring, once every record in progress is complete.
+ * Called before a checkpoint; does nothing if the ring isn't mapped.
+ */
+void SuspendSharedEventRing();
+
+/**
+ * Map the ring file again after a restore (events=<file>), like InitSharedEventRing().
+ *
+ * @return true if the ring is mapped (or was never enabled)
+ */
+bool ResumeSharedEventRing();
+
+/**
+ * Whether interceptions decided by this path are recorded.
+ */
+bool IsSharedEventPath(TracePath path);
+
+/**
+ * Append one record to the ring.
+ *
+ * @param target Interception target
+ * @param path Path that decided the verdict
+ * @param verdict Verdict
+ * @param context_id Test context ID
+ * @param address Connect address (length 0 for DNS lookups)
+ * @param port Connect port
+ * @param hostname Hostname (not NUL-terminated)
+ * @param hostname_length Bytes in hostname, at most kSharedEventHostnameLength
+ */
+void RecordSharedEvent(
+    InterceptTarget target,
+    TracePath path,
+    TraceVerdict verdict,
+    int64_t context_id,
+    const InetAddressBytes& address,
+    int32_t port,
+    const char* hostname,
+    size_t hostname_length
+);
+
+#endif // JUNIT_AIRGAP_SHARED_EVENT_RING_H
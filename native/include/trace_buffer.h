@@ -0,0 +1,230 @@
+#ifndef JUNIT_AIRGAP_TRACE_BUFFER_H
+#define JUNIT_AIRGAP_TRACE_BUFFER_H
+
+#include <jni.h>
+#include "inet_address.h"
+#include "intercept_targets.h"
+#include "interception_metrics.h"
+#include "shared_event_ring.h"
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Interception Trace Buffer
+ *
+ * Low-overhead alternative to DEBUG_LOG for profiling the agent on full test suites.
+ * Enabled with the agent option trace=<file>; off by default, and then the only cost
+ * in the interceptors is one branch on g_trace_enabled.
+ *
+ * ## Recording
+ *
+ * Every intercepted connect and DNS lookup writes one fixed-size record (monotonic
+ * timestamp, target, verdict, decision path, time to verdict, time in JNI upcalls,
+ * address bytes and port) to a ring buffer owned by the calling thread. The owning
+ * thread is the only writer, so recording takes no lock and makes no system call.
+ * When a ring wraps, the oldest undrained records are overwritten and reported as
+ * dropped.
+ *
+ * ## Draining
+ *
+ * DrainTraceBuffers() appends every undrained record as one NDJSON line to the trace
+ * file. It runs at Agent_OnUnload and on demand via NetworkBlockerContext.dumpTrace().
+ * Records are read through a per-slot seqlock, so draining never blocks recording
+ * threads; a record overwritten mid-read is counted as dropped. A ring outlives its
+ * thread until its last records are drained, and is then freed or reused by the next
+ * new thread.
+ *
+ * ## Output
+ *
+ *   {"ts":1532211,"thread":2,"target":"sun.nio.ch.Net.connect0","verdict":"allowed","path":"verdict-cache",
+ *    "decisionNs":310,"upcallNs":0,"address":"127.0.0.1","port":8080}
+ *
+ * ts is nanoseconds since the agent loaded, thread a per-process thread index.
+ * address and port are omitted for DNS lookups.
+ */
+
+/**
+ * Outcome of an interception.
+ */
+enum class TraceVerdict : uint8_t {
+    Allowed,
+    Blocked
+};
+
+/**
+ * Which check decided the verdict (the fast path taken).
+ */
+enum class TracePath : uint8_t {
+    VmInitPending,     // VM_INIT not complete yet
+    Unregistered,      // NetworkBlockerContext not registered with the agent
+    PolicyImage,       // Policy image, before NetworkBlockerContext registered
+    Disarmed,          // No configuration anywhere in the JVM
+    NoConfiguration,   // hasActiveConfiguration() returned false
+    VerdictCache,      // Per-thread verdict cache hit
+    DnsCache,          // DNS result cache hit
+    HostOverride,      // Hosts override (synthetic addresses)
+    Policy,            // Native host policy
+    Java               // Deferred to NetworkBlockerContext.checkConnection()
+};
+
+constexpr size_t kTracePathCount = (size_t)TracePath::Java + 1;
+
+/**
+ * One interception, as recorded.
+ */
+struct TraceEvent {
+    uint64_t timestamp_ns;   // Start, nanoseconds since agent load
+    uint64_t decision_ns;    // Start to verdict (excludes the original native call)
+    uint64_t upcall_ns;      // Time inside JNI upcalls into NetworkBlockerContext
+    InterceptTarget target;
+    TraceVerdict verdict;
+    TracePath path;
+    InetAddressBytes address;  // length 0 if none
+    jint port;
+};
+
+// Whether tracing is enabled (set once in Agent_OnLoad, never changed)
+extern bool g_trace_enabled;
+
+/**
+ * Enable tracing to a file. Called from Agent_OnLoad when trace=<file> is given.
+ *
+ * "%p" in the path is replaced with the process id, so forked test JVMs sharing
+ * one option string write separate files. The file is truncated.
+ *
+ * @param path Trace file path
+ * @param records_per_thread Ring capacity (rounded up to a power of two)
+ * @return true if the trace file could be created
+ */
+bool InitTraceBuffers(const char* path, uint32_t records_per_thread);
+
+/**
+ * Monotonic nanoseconds since InitTraceBuffers().
+ */
+uint64_t TraceNow();
+
+/**
+ * Append an event to the calling thread's ring (allocated on first use).
+ */
+void RecordTraceEvent(const TraceEvent& event);
+
+/**
+ * Append every undrained record to the trace file.
+ *
+ * @return Number of records written, or -1 if tracing is disabled or the file
+ *         can't be opened
+ */
+int64_t DrainTraceBuffers();
+
+/**
+ * Records one interception. Construct at the top of a wrapper; the event is
+ * committed to the trace buffer, the metrics (interception_metrics.h) and the
+ * shared event ring (shared_event_ring.h) when the scope ends. All members are
+ * no-ops unless one of them is enabled.
+ */
+struct InterceptTrace {
+    bool enabled;
+    bool decided = false;
+    TraceEvent event;
+    int64_t context_id = 0;      // Shared event ring only
+    size_t hostname_length = 0;  // Shared event ring only
+    char hostname[kSharedEventHostnameLength];
+
+    explicit InterceptTrace(InterceptTarget target)
+        : enabled(g_trace_enabled || g_metrics_enabled || g_event_ring_enabled), event() {
+        if (enabled) {
+            event.target = target;
+            event.timestamp_ns = TraceNow();
+        }
+    }
+
+    ~InterceptTrace() {
+        if (enabled) {
+            if (!decided) {
+                Decide(TracePath::Java, TraceVerdict::Allowed);
+            }
+            if (g_metrics_enabled) {
+                // The scope ends right after the original native returns
+                uint64_t after_verdict_ns = TraceNow() - event.timestamp_ns - event.decision_ns;
+                RecordInterceptionMetrics(event.target, event.path, event.verdict, event.upcall_ns,
+                                          after_verdict_ns);
+            }
+            if (g_trace_enabled) {
+                RecordTraceEvent(event);
+            }
+            if (g_event_ring_enabled && IsSharedEventPath(event.path)) {
+                RecordSharedEvent(event.target, event.path, event.verdict, context_id, event.address, event.port,
+                                  hostname, hostname_length);
+            }
+        }
+    }
+
+    InterceptTrace(const InterceptTrace&) = delete;
+    InterceptTrace& operator=(const InterceptTrace&) = delete;
+
+    /**
+     * Set the connection target.
+     */
+    void Target(const InetAddressBytes& address, jint port) {
+        if (enabled) {
+            event.address = address;
+            event.port = port;
+        }
+    }
+
+    /**
+     * Set the test context the interception is evaluated against.
+     */
+    void Context(int64_t id) {
+        if (enabled) {
+            context_id = id;
+        }
+    }
+
+    /**
+     * Set the hostname (copied, truncated; kept only for the shared event ring).
+     */
+    void Host(const char* name) {
+        if (g_event_ring_enabled && name != nullptr) {
+            size_t length = strlen(name);
+            hostname_length = length < kSharedEventHostnameLength ? length : kSharedEventHostnameLength;
+            memcpy(hostname, name, hostname_length);
+        }
+    }
+
+    /**
+     * Set the verdict and the path that produced it. Call before invoking the
+     * original native function, so its duration isn't counted as agent time.
+     */
+    void Decide(TracePath path, TraceVerdict verdict) {
+        if (enabled) {
+            event.path = path;
+            event.verdict = verdict;
+            event.decision_ns = TraceNow() - event.timestamp_ns;
+            decided = true;
+        }
+    }
+
+    /**
+     * Bracket a JNI upcall: pass BeginUpcall()'s result to EndUpcall().
+     */
+    uint64_t BeginUpcall() const {
+        return enabled ? TraceNow() : 0;
+    }
+
+    void EndUpcall(uint64_t begin) {
+        if (enabled) {
+            event.upcall_ns += TraceNow() - begin;
+        }
+    }
+};
+
+// JNI entry points called from NetworkBlockerContext
+extern "C" {
+    JNIEXPORT jlong JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_dumpAgentTrace(
+        JNIEnv* env,
+        jclass clazz
+    );
+}
+
+#endif // JUNIT_AIRGAP_TRACE_BUFFER_H
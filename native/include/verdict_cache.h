@@ -0,0 +1,84 @@
+#ifndef JUNIT_AIRGAP_VERDICT_CACHE_H
+#define JUNIT_AIRGAP_VERDICT_CACHE_H
+
+#include <jni.h>
+#include "agent.h"
+#include "inet_address.h"
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Native Connect Verdict Cache
+ *
+ * Connection pools and retry loops hit the same few (address, port) tuples over and
+ * over. The verdict cache remembers "allowed" verdicts per thread so a repeated connect
+ * skips getHostName()/GetStringUTFChars, address formatting and policy evaluation.
+ *
+ * ## Invalidation
+ *
+ * Entries are stamped with the configuration generation (mirrored from
+ * NetworkBlockerContext.currentGeneration via setAgentArmState()) and the id of the
+ * host policy snapshot they were computed against. A generation bump or a new policy is
+ * a single atomic store; stale entries simply stop matching - there is no flush.
+ * Entries also carry the test context they were computed in, so a pooled thread that
+ * moves from one parallel test to another never reuses the other test's verdicts.
+ *
+ * ## What is cached
+ *
+ * Only allow verdicts that don't depend on the hostname (the policy has no blocked
+ * hosts and the IP itself was allowed). Blocks always take the full path because they
+ * need the host strings to build the exception.
+ */
+
+/**
+ * Cache key: raw address bytes and port of the connection target.
+ */
+struct VerdictCacheKey {
+    uint8_t address[kInetAddressMaxLength];
+    uint8_t address_length;
+    jint port;
+};
+
+/**
+ * Build a cache key from decoded address bytes and port.
+ *
+ * @param address Raw address (see DecodeInetAddress())
+ * @param port Remote port
+ * @param key Output key
+ */
+void BuildVerdictCacheKey(const InetAddressBytes& address, jint port, VerdictCacheKey* key);
+
+/**
+ * Look up an allow verdict for the current thread.
+ *
+ * Updates the calling thread's hit/miss counters.
+ *
+ * @param key Connection target
+ * @param context_id Test context of the calling thread (see ResolveThreadContext())
+ * @return true if the connection was previously allowed under the current
+ *         generation and the context's current policy
+ */
+bool LookupAllowedVerdict(const VerdictCacheKey& key, int64_t context_id = 0);
+
+/**
+ * Remember an allow verdict for the current thread under the current generation and
+ * the given policy snapshot id of the given test context.
+ */
+void StoreAllowedVerdict(const VerdictCacheKey& key, uint64_t policy_id, int64_t context_id = 0);
+
+/**
+ * Cache statistics, summed over the per-thread counters (approximate under concurrency).
+ * Takes a lock; not for the interception path.
+ */
+uint64_t GetVerdictCacheHits();
+uint64_t GetVerdictCacheMisses();
+
+// JNI entry points called from NetworkBlockerContext
+extern "C" {
+    JNIEXPORT jlongArray JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_getAgentVerdictCacheStats(
+        JNIEnv* env,
+        jclass clazz
+    );
+}
+
+#endif // JUNIT_AIRGAP_VERDICT_CACHE_H
@@ -12,6 +12,13 @@
  * 4. We replace Socket.connect0() and SocketChannel.connect0() with our wrappers
  * 5. Our wrappers check thread-local configuration before calling original
  *
+ * Attached to a running JVM instead (Agent_OnAttach()), the agent does the same setup,
+ * then rebinds the targets that are already bound with RegisterNatives().
+ *
+ * A JVM checkpointed with CRaC keeps its bound wrappers: NetworkBlockerContext quiesces
+ * the agent before the checkpoint and revalidates its state after the restore
+ * (quiesceAgentForCheckpoint()/restoreAgentAfterCheckpoint()), without bind events.
+ *
  * ## Architecture
  *
  * ```
@@ -21,7 +28,7 @@
  *     ↓
  * JVMTI Callback: NativeMethodBindCallback()
  *     ↓
- * Our Wrapper: wrapped_Socket_connect0()
+ * Our Wrapper: Interceptor<NetConnect0Traits>::Wrapper() (interceptor.h)
  *     ↓ (if allowed)
  * Original Native: socket_connect0_original()
  * ```
@@ -30,7 +37,9 @@
  *
  * - Configuration is ThreadLocal (managed by Kotlin NetworkBlockerContext)
  * - Native method replacement is atomic (JVMTI guarantee)
- * - Original function pointers are stored in thread-safe map
+ * - Original function pointers are stored in an atomic array indexed by InterceptTarget
+ * - Cached class/method/string references are an immutable AgentContext snapshot
+ *   published through an atomic pointer (lock-free reads)
  *
  * ## Test-First Approach
  *
@@ -40,59 +49,241 @@
  */
 
 #include "agent.h"
+#include "agent_options.h"
+#include "dns_result_cache.h"
+#include "libc_interceptor.h"
+#include "policy_image.h"
+#include "shared_event_ring.h"
+#include "trace_buffer.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
 #include <cstring>
-#include <unistd.h>  // for usleep()
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+// Category for DEBUG_LOG/DEBUG_LOGF in this file
+static constexpr LogCategory kLogCategory = LogCategory::Agent;
 
 // Global state
 jvmtiEnv *g_jvmti = nullptr;
 JavaVM *g_jvm = nullptr;
-bool g_debug_mode = false;
 
-// Original function storage
-std::map<std::string, void*> g_original_functions;
-std::mutex g_functions_mutex;
+// Original function storage, indexed by InterceptTarget
+static std::atomic<void*> g_original_functions[kInterceptTargetCount];
+
+/**
+ * Build a table row, hashing the names at compile time.
+ */
+static constexpr InterceptTargetSpec MakeInterceptTarget(
+    InterceptTarget target,
+    const char* class_signature,
+    const char* method_name,
+    const char* display_name,
+    uint32_t bind_group,
+    void* (*install_wrapper)(void*),
+    const char* jdk_library,
+    bool match_class_suffix = false,
+    const char* method_signature = nullptr
+) {
+    return InterceptTargetSpec{
+        target,
+        class_signature,
+        method_name,
+        HashName(class_signature),
+        HashName(method_name),
+        display_name,
+        match_class_suffix,
+        method_signature,
+        bind_group,
+        install_wrapper,
+        jdk_library,
+    };
+}
+
+// Interception targets, in InterceptTarget order
+static constexpr InterceptTargetSpec kInterceptTargets[] = {
+    // Used by ALL modern Socket/SocketChannel implementations
+    MakeInterceptTarget(InterceptTarget::NetConnect0,
+                        "Lsun/nio/ch/Net;", "connect0",
+                        "sun.nio.ch.Net.connect0", kBindGroupConnect, &InstallNetConnect0Wrapper, "nio"),
+    // Legacy (pre-Java 7) - original recorded only
+    MakeInterceptTarget(InterceptTarget::SocketConnect0,
+                        "Ljava/net/Socket;", "socketConnect0",
+                        "java.net.Socket.socketConnect0", kBindGroupNone, nullptr, nullptr),
+    // Original recorded only (connects go through Net.connect0)
+    MakeInterceptTarget(InterceptTarget::SocketChannelConnect0,
+                        "Lsun/nio/ch/SocketChannelImpl;", "connect0",
+                        "sun.nio.ch.SocketChannelImpl.connect0", kBindGroupNone, nullptr, nullptr),
+    // DNS resolution - the JDK uses one of the two, so either satisfies the group
+    MakeInterceptTarget(InterceptTarget::Inet6LookupAllHostAddr,
+                        "Ljava/net/Inet6AddressImpl;", "lookupAllHostAddr",
+                        "java.net.Inet6AddressImpl.lookupAllHostAddr", kBindGroupDns, &InstallInet6LookupWrapper,
+                        "net"),
+    MakeInterceptTarget(InterceptTarget::Inet4LookupAllHostAddr,
+                        "Ljava/net/Inet4AddressImpl;", "lookupAllHostAddr",
+                        "java.net.Inet4AddressImpl.lookupAllHostAddr", kBindGroupDns, &InstallInet4LookupWrapper,
+                        "net"),
+    // Netty epoll/kqueue transports (BsdSocket/LinuxSocket inherit it), under any shading prefix:
+    // static native int connect(int fd, boolean ipv6, byte[] address, int scopeId, int port)
+    // Netty registers it from JNI_OnLoad under a private symbol, so it is not rebound on attach
+    MakeInterceptTarget(InterceptTarget::NettySocketConnect,
+                        "io/netty/channel/unix/Socket;", "connect",
+                        "io.netty.channel.unix.Socket.connect", kBindGroupNetty, &InstallNettySocketConnectWrapper,
+                        nullptr, true, "(IZ[BII)I"),
+};
+
+static constexpr bool InterceptTargetsInEnumOrder() {
+    for (size_t i = 0; i < kInterceptTargetCount; i++) {
+        if ((size_t)kInterceptTargets[i].target != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(sizeof(kInterceptTargets) / sizeof(kInterceptTargets[0]) == kInterceptTargetCount,
+              "kInterceptTargets must have one row per InterceptTarget");
+static_assert(InterceptTargetsInEnumOrder(), "kInterceptTargets must be in InterceptTarget order");
+
+// Bind groups with at least one bound target, and whether bind events were switched off
+static std::atomic<uint32_t> g_bound_bind_groups{kBindGroupNone};
+static std::atomic<bool> g_bind_events_disarmed{false};
+
+// NativeMethodBind events received (diagnostics, reported at unload in debug mode)
+static std::atomic<uint64_t> g_native_bind_events{0};
+
+// Target this thread is rebinding with RegisterNatives(), whose bind event carries our
+// own wrapper and must not be taken for the original
+static thread_local const InterceptTargetSpec* t_rebinding_target = nullptr;
 
-// Cached NetworkBlockerContext class and method references
-jclass g_network_blocker_context_class = nullptr;
-jmethodID g_check_connection_method = nullptr;
-jmethodID g_is_explicitly_blocked_method = nullptr;
-jmethodID g_has_active_configuration_method = nullptr;
-std::mutex g_context_mutex;
+// Agent context snapshot (starts out empty, never nullptr)
+static const AgentContext g_empty_agent_context = {};
+static std::atomic<const AgentContext*> g_agent_context{&g_empty_agent_context};
 
-// Cached string constants (initialized during VM_INIT)
-jstring g_caller_agent_string = nullptr;
-jstring g_caller_dns_string = nullptr;
-std::mutex g_strings_mutex;
+// Serializes publishers only (readers never lock)
+static std::mutex g_agent_context_publish_mutex;
 
 // VM initialization state
 bool g_vm_init_complete = false;
 
+// Checkpoint/restore state (see quiesceAgentForCheckpoint())
+static std::atomic<bool> g_checkpoint_quiesced{false};
+static std::atomic<uint32_t> g_restore_count{0};
+
+// Mirror of NetworkBlockerContext.currentGeneration
+std::atomic<int64_t> g_configuration_generation{0};
+std::atomic<AgentArmState> g_agent_arm_state{AgentArmState::Unknown};
+std::atomic<bool> g_interception_bypassed{false};
+std::atomic<bool> g_agent_shared_context{false};
+
 /**
  * Store original function pointer for later use.
  *
- * @param key Unique identifier (e.g., "java.net.Socket.socketConnect0")
+ * @param target Interception target
  * @param address Original function pointer
  */
-void StoreOriginalFunction(const std::string& key, void* address) {
-    std::lock_guard<std::mutex> lock(g_functions_mutex);
-    g_original_functions[key] = address;
-    DEBUG_LOGF("Stored original function: %s -> %p", key.c_str(), address);
+void StoreOriginalFunction(InterceptTarget target, void* address) {
+    g_original_functions[(size_t)target].store(address, std::memory_order_release);
+    LOG_DEBUG(Bind, "Stored original function: %s -> %p", kInterceptTargets[(size_t)target].display_name, address);
 }
 
 /**
  * Get original function pointer.
  *
- * @param key Unique identifier
- * @return Original function pointer, or nullptr if not found
+ * @param target Interception target
+ * @return Original function pointer, or nullptr if not bound yet
+ */
+void* GetOriginalFunction(InterceptTarget target) {
+    return g_original_functions[(size_t)target].load(std::memory_order_acquire);
+}
+
+const char* GetInterceptTargetName(InterceptTarget target) {
+    return (size_t)target < kInterceptTargetCount ? kInterceptTargets[(size_t)target].display_name : "unknown";
+}
+
+const AgentContext* GetAgentContext() {
+    return g_agent_context.load(std::memory_order_acquire);
+}
+
+/**
+ * Publish a modified copy of the current agent context snapshot.
+ *
+ * Caller must hold g_agent_context_publish_mutex. Superseded snapshots are
+ * intentionally never freed: a reader may still hold the pointer it loaded, and
+ * there are only a handful of publishes per JVM (VM_INIT plus one per
+ * NetworkBlockerContext class loaded).
+ *
+ * @param context New snapshot contents
  */
-void* GetOriginalFunction(const std::string& key) {
-    std::lock_guard<std::mutex> lock(g_functions_mutex);
-    auto it = g_original_functions.find(key);
-    if (it != g_original_functions.end()) {
-        return it->second;
+static void PublishAgentContext(const AgentContext& context) {
+    g_agent_context.store(new AgentContext(context), std::memory_order_release);
+}
+
+bool ResolveThreadContext(JNIEnv* env, const AgentContext* agentContext, int64_t* contextId) {
+    *contextId = 0;
+    if (IsAgentContextShared()) {
+        return true;
+    }
+
+    jclass contextClass = agentContext->network_blocker_context_class;
+    if (agentContext->active_context_id_method != nullptr) {
+        *contextId = env->CallStaticLongMethod(contextClass, agentContext->active_context_id_method);
+        return *contextId != 0;
+    }
+    if (agentContext->has_active_configuration_method == nullptr) {
+        // Method not registered - assume no configuration
+        DEBUG_LOG("hasActiveConfiguration method not registered - assuming no configuration");
+        return false;
+    }
+    return env->CallStaticBooleanMethod(contextClass, agentContext->has_active_configuration_method) == JNI_TRUE;
+}
+
+bool ConfirmBlockedRequest(
+    JNIEnv* env,
+    const AgentContext* agentContext,
+    jstring hostname,
+    jstring address,
+    jint port,
+    jstring caller,
+    bool hostnameIsCulprit
+) {
+    jclass contextClass = agentContext->network_blocker_context_class;
+
+    if (agentContext->evaluate_method == nullptr) {
+        // checkConnection() throws NetworkRequestAttemptedException if still blocked
+        jstring culprit = hostnameIsCulprit || address == nullptr ? hostname : address;
+        if (agentContext->check_connection_method == nullptr || culprit == nullptr) {
+            DEBUG_LOG("checkConnection method not registered - allowing request");
+            return false;
+        }
+        env->CallStaticVoidMethod(contextClass, agentContext->check_connection_method, culprit, port, caller);
+        return env->ExceptionCheck();
     }
-    return nullptr;
+
+    jint verdict = env->CallStaticIntMethod(contextClass, agentContext->evaluate_method, hostname, address, port);
+    if (env->ExceptionCheck()) {
+        // Whatever evaluate() threw propagates in place of the request
+        return true;
+    }
+    if (verdict == kVerdictAllow) {
+        DEBUG_LOG("Request allowed by NetworkBlockerContext.evaluate()");
+        return false;
+    }
+
+    jstring culprit = (verdict == kVerdictBlockHostname && hostname != nullptr) || address == nullptr ? hostname : address;
+    jobject exception = env->CallStaticObjectMethod(
+        contextClass, agentContext->blocked_request_exception_method, culprit, port, caller);
+    if (exception != nullptr && !env->ExceptionCheck()) {
+        env->Throw((jthrowable)exception);
+        env->DeleteLocalRef(exception);
+    }
+    return env->ExceptionCheck();
 }
 
 /**
@@ -187,51 +378,220 @@ bool InitializeJVMTI(jvmtiEnv *jvmti) {
     return true;
 }
 
+// Platform encoding readiness
+//
+// Tracked once for the process (g_platform_encoding_ready, set by the first thread
+// that converts a string successfully) and cached per thread (t_platform_encoding_ready),
+// so EnsurePlatformEncodingReady() costs one branch in the steady state.
+// Threads that are still waiting block on g_platform_encoding_cv and are woken as
+// soon as any thread observes readiness; a capped backoff re-probe covers the case
+// where readiness only changes for the waiting thread itself.
+thread_local bool t_platform_encoding_ready = false;
+static std::atomic<bool> g_platform_encoding_ready{false};
+static std::mutex g_platform_encoding_mutex;
+static std::condition_variable g_platform_encoding_cv;
+
+// Wait budgets (same totals as the former fixed-interval retry loops)
+static constexpr std::chrono::milliseconds kVmInitEncodingTimeout{500};
+static constexpr std::chrono::milliseconds kThreadEncodingTimeout{5000};
+static constexpr std::chrono::milliseconds kEncodingReprobeInitial{1};
+static constexpr std::chrono::milliseconds kEncodingReprobeMax{50};
+
+enum class EncodingProbe {
+    Ready,
+    NotReady,
+    OtherError  // non-encoding exception, re-thrown to the caller
+};
+
+/**
+ * Mark platform encoding ready for this thread and, the first time, for the process.
+ */
+static void MarkPlatformEncodingReady() {
+    t_platform_encoding_ready = true;
+    if (!g_platform_encoding_ready.exchange(true, std::memory_order_acq_rel)) {
+        // Take the lock so a waiter between its predicate check and wait() can't miss this
+        std::lock_guard<std::mutex> lock(g_platform_encoding_mutex);
+        g_platform_encoding_cv.notify_all();
+    }
+}
+
 /**
- * JVMTI callback for VM initialization.
+ * Try one string conversion on the current thread.
  *
- * This is called when the JVM is fully initialized and ready to run Java code.
- * We use this to initialize string constants that require platform encoding,
- * which may not be available during earlier initialization phases.
+ * @param env JNI environment for current thread
+ * @param probe Any cached string (caller_agent_string)
+ * @param internal_error_class Cached InternalError class (may be nullptr)
+ * @param rethrow_other If true, exceptions other than InternalError are re-thrown
+ *                      and reported as OtherError; otherwise any failure is NotReady
+ */
+static EncodingProbe ProbePlatformEncoding(
+    JNIEnv* env,
+    jstring probe,
+    jclass internal_error_class,
+    bool rethrow_other
+) {
+    const char* chars = env->GetStringUTFChars(probe, nullptr);
+    if (chars != nullptr) {
+        env->ReleaseStringUTFChars(probe, chars);
+        return EncodingProbe::Ready;
+    }
+
+    if (!env->ExceptionCheck()) {
+        return EncodingProbe::NotReady;
+    }
+
+    jthrowable exception = env->ExceptionOccurred();
+    env->ExceptionClear();
+
+    // InternalError is the "platform encoding not initialized" failure
+    bool is_encoding_error = internal_error_class == nullptr ||
+                             env->IsInstanceOf(exception, internal_error_class);
+    if (!rethrow_other || is_encoding_error) {
+        env->DeleteLocalRef(exception);
+        return EncodingProbe::NotReady;
+    }
+
+    // Different error - not a platform encoding issue
+    env->Throw(exception);
+    env->DeleteLocalRef(exception);
+    return EncodingProbe::OtherError;
+}
+
+/**
+ * Probe platform encoding until it works on this thread or the timeout expires.
  *
- * This fixes "platform encoding not initialized" errors when running tests
- * via IntelliJ IDEA, which loads classes earlier than command-line Gradle.
+ * Between probes the thread blocks on g_platform_encoding_cv, so it re-probes
+ * immediately when another thread first observes readiness instead of sleeping
+ * out a fixed interval.
  *
- * @param jvmti_env JVMTI environment
- * @param jni_env JNI environment
- * @param thread Current thread
+ * @param env JNI environment for current thread
+ * @param timeout Maximum total wait
+ * @param rethrow_other See ProbePlatformEncoding()
+ * @return true if platform encoding is ready on this thread
  */
-void JNICALL VMInitCallback(
-    jvmtiEnv *jvmti_env,
-    JNIEnv* jni_env,
-    jthread thread
-) {
-    DEBUG_LOG("VM_INIT callback - initializing cached string constants");
+static bool WaitForPlatformEncoding(JNIEnv* env, std::chrono::milliseconds timeout, bool rethrow_other) {
+    const AgentContext* context = GetAgentContext();
+    jstring probe = context->caller_agent_string;
+    if (probe == nullptr) {
+        return false;
+    }
 
-    std::lock_guard<std::mutex> lock(g_strings_mutex);
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    std::chrono::milliseconds reprobe = kEncodingReprobeInitial;
 
-    // Create "Native-Agent" string constant (caller identifier for NetworkBlockerContext)
-    if (g_caller_agent_string == nullptr) {
-        jstring local_agent = jni_env->NewStringUTF("Native-Agent");
-        if (local_agent != nullptr) {
-            g_caller_agent_string = (jstring)jni_env->NewGlobalRef(local_agent);
-            jni_env->DeleteLocalRef(local_agent);
-            DEBUG_LOG("Cached caller agent string: Native-Agent");
-        } else {
-            fprintf(stderr, "[junit-airgap:native] ERROR: Failed to create caller agent string\n");
+    for (int attempt = 1; ; attempt++) {
+        // Sampled before probing: if the process was already ready, a failed probe
+        // means only this thread lags, so don't let the predicate spin
+        bool process_ready_before = g_platform_encoding_ready.load(std::memory_order_acquire);
+
+        switch (ProbePlatformEncoding(env, probe, context->internal_error_class, rethrow_other)) {
+            case EncodingProbe::Ready:
+                if (attempt > 1) {
+                    LOG_DEBUG(Encoding, "Platform encoding ready after %d attempt(s)", attempt);
+                }
+                MarkPlatformEncodingReady();
+                return true;
+            case EncodingProbe::OtherError:
+                return false;
+            case EncodingProbe::NotReady:
+                break;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            LOG_DEBUG(Encoding, "Platform encoding still not ready after %d attempt(s)", attempt);
+            return false;
         }
+
+        auto wake_at = std::min(deadline, now + reprobe);
+        {
+            std::unique_lock<std::mutex> lock(g_platform_encoding_mutex);
+            g_platform_encoding_cv.wait_until(lock, wake_at, [process_ready_before] {
+                return !process_ready_before && g_platform_encoding_ready.load(std::memory_order_acquire);
+            });
+        }
+        reprobe = std::min(reprobe * 2, kEncodingReprobeMax);
     }
+}
 
-    // Create "Native-DNS" string constant
-    if (g_caller_dns_string == nullptr) {
-        jstring local_dns = jni_env->NewStringUTF("Native-DNS");
-        if (local_dns != nullptr) {
-            g_caller_dns_string = (jstring)jni_env->NewGlobalRef(local_dns);
-            jni_env->DeleteLocalRef(local_dns);
-            DEBUG_LOG("Cached caller DNS string: Native-DNS");
-        } else {
-            fprintf(stderr, "[junit-airgap:native] ERROR: Failed to create caller DNS string\n");
+/**
+ * Cache a bootstrap exception class as a global ref (left nullptr if it can't be found).
+ */
+static void CacheExceptionClass(JNIEnv* env, const char* name, jclass* out) {
+    if (*out != nullptr) {
+        return;
+    }
+
+    jclass local_class = env->FindClass(name);
+    if (local_class != nullptr) {
+        *out = (jclass)env->NewGlobalRef(local_class);
+        env->DeleteLocalRef(local_class);
+    } else if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+    }
+}
+
+/**
+ * Initialize the state that needs a running VM: cached string constants, exception
+ * classes and platform encoding. Run from VM_INIT, or directly when attached to a live VM.
+ *
+ * @param jni_env JNI environment
+ */
+static void InitializeLiveVmState(JNIEnv* jni_env) {
+    DEBUG_LOG("Initializing cached string constants");
+
+    {
+        std::lock_guard<std::mutex> lock(g_agent_context_publish_mutex);
+        AgentContext context = *GetAgentContext();
+
+        // Create "Native-Agent" string constant (caller identifier for NetworkBlockerContext)
+        if (context.caller_agent_string == nullptr) {
+            jstring local_agent = jni_env->NewStringUTF("Native-Agent");
+            if (local_agent != nullptr) {
+                context.caller_agent_string = (jstring)jni_env->NewGlobalRef(local_agent);
+                jni_env->DeleteLocalRef(local_agent);
+                DEBUG_LOG("Cached caller agent string: Native-Agent");
+            } else {
+                fprintf(stderr, "[junit-airgap:native] ERROR: Failed to create caller agent string\n");
+            }
+        }
+
+        // Create "Native-DNS" string constant
+        if (context.caller_dns_string == nullptr) {
+            jstring local_dns = jni_env->NewStringUTF("Native-DNS");
+            if (local_dns != nullptr) {
+                context.caller_dns_string = (jstring)jni_env->NewGlobalRef(local_dns);
+                jni_env->DeleteLocalRef(local_dns);
+                DEBUG_LOG("Cached caller DNS string: Native-DNS");
+            } else {
+                fprintf(stderr, "[junit-airgap:native] ERROR: Failed to create caller DNS string\n");
+            }
+        }
+
+        // Cache InternalError so readiness probes don't FindClass on every failure
+        if (context.internal_error_class == nullptr) {
+            jclass local_error = jni_env->FindClass("java/lang/InternalError");
+            if (local_error != nullptr) {
+                context.internal_error_class = (jclass)jni_env->NewGlobalRef(local_error);
+                jni_env->DeleteLocalRef(local_error);
+            } else if (jni_env->ExceptionCheck()) {
+                jni_env->ExceptionClear();
+            }
+        }
+
+        // A policy image is enforced before NetworkBlockerContext registers, so that path
+        // needs its exception classes and the InetAddress layout now
+        if (GetPolicyImagePolicy() != nullptr) {
+            CacheExceptionClass(jni_env, "java/net/ConnectException", &context.connect_exception_class);
+            CacheExceptionClass(jni_env, "java/net/UnknownHostException", &context.unknown_host_exception_class);
+            if (context.inet_address.get_address == nullptr &&
+                !LookupInetAddressFields(jni_env, &context.inet_address)) {
+                fprintf(stderr, "[junit-airgap:native] WARNING: Failed to find java.net.InetAddress methods - "
+                                "policy image only applies to DNS lookups\n");
+            }
         }
+
+        PublishAgentContext(context);
     }
 
     DEBUG_LOG("String constants initialized successfully");
@@ -240,38 +600,10 @@ void JNICALL VMInitCallback(
     // This ensures platform encoding is fully ready before we allow any interception
     //
     // IMPORTANT: In Android Studio's test runner, platform encoding may not be fully
-    // ready immediately after VM_INIT. We need to poll/retry until it's actually working.
+    // ready immediately after VM_INIT. We wait (bounded) until it's actually working.
     // Without this, tests with @AllowNetworkRequests fail with "platform encoding not initialized"
     // because even the JVM's own DNS code can't run yet.
-    bool encoding_ready = false;
-    int max_attempts = 50;  // Try for ~500ms (50 attempts * 10ms sleep)
-
-    for (int attempt = 0; attempt < max_attempts && !encoding_ready; attempt++) {
-        if (g_caller_agent_string != nullptr) {
-            const char* test_str = jni_env->GetStringUTFChars(g_caller_agent_string, nullptr);
-            if (test_str != nullptr) {
-                if (attempt > 0) {
-                    DEBUG_LOGF("Platform encoding ready after %d attempts", attempt + 1);
-                }
-                jni_env->ReleaseStringUTFChars(g_caller_agent_string, test_str);
-                encoding_ready = true;
-            } else {
-                // Clear any exception from the failed GetStringUTFChars
-                if (jni_env->ExceptionCheck()) {
-                    jni_env->ExceptionClear();
-                }
-
-                if (attempt < max_attempts - 1) {
-                    // Sleep for 10ms before retrying (usleep takes microseconds)
-                    usleep(10000);
-                } else {
-                    fprintf(stderr, "[junit-airgap:native] WARNING: Platform encoding still not ready after %d attempts\n", max_attempts);
-                }
-            }
-        }
-    }
-
-    if (!encoding_ready) {
+    if (!WaitForPlatformEncoding(jni_env, kVmInitEncodingTimeout, false)) {
         fprintf(stderr, "[junit-airgap:native] WARNING: Proceeding without confirmed platform encoding readiness\n");
         fprintf(stderr, "[junit-airgap:native] WARNING: String operations may fail with 'platform encoding not initialized' errors\n");
     }
@@ -282,13 +614,13 @@ void JNICALL VMInitCallback(
     DEBUG_LOG("VM initialization complete - all JNI operations now safe");
 
     // CRITICAL FIX: Check if DNS native methods were bound before agent initialization
-    // If they were, we have a fundamental limitation: JVMTI can't rebind native methods
-    // after they're already bound. The only solution is to use ByteBuddy at the Java layer.
+    // If they were, JVMTI bind events can't catch them any more (only an attach rebinds
+    // them, see RebindLoadedTargets()). The fallback is ByteBuddy at the Java layer.
     DEBUG_LOG("Checking DNS native method interception status...");
 
     // Check if we successfully intercepted DNS methods during Agent_OnLoad
-    bool hasInet6Wrapper = (GetOriginalFunction("java.net.Inet6AddressImpl.lookupAllHostAddr") != nullptr);
-    bool hasInet4Wrapper = (GetOriginalFunction("java.net.Inet4AddressImpl.lookupAllHostAddr") != nullptr);
+    bool hasInet6Wrapper = (GetOriginalFunction(InterceptTarget::Inet6LookupAllHostAddr) != nullptr);
+    bool hasInet4Wrapper = (GetOriginalFunction(InterceptTarget::Inet4LookupAllHostAddr) != nullptr);
 
     if (hasInet6Wrapper) {
         DEBUG_LOG("Inet6AddressImpl.lookupAllHostAddr() successfully intercepted");
@@ -304,12 +636,103 @@ void JNICALL VMInitCallback(
     DEBUG_LOG("DNS native method interception check complete");
 }
 
+/**
+ * JVMTI callback for VM initialization.
+ *
+ * This is called when the JVM is fully initialized and ready to run Java code.
+ * We use this to initialize string constants that require platform encoding,
+ * which may not be available during earlier initialization phases.
+ *
+ * This fixes "platform encoding not initialized" errors when running tests
+ * via IntelliJ IDEA, which loads classes earlier than command-line Gradle.
+ *
+ * @param jvmti_env JVMTI environment
+ * @param jni_env JNI environment
+ * @param thread Current thread
+ */
+void JNICALL VMInitCallback(
+    jvmtiEnv *jvmti_env,
+    JNIEnv* jni_env,
+    jthread thread
+) {
+    DEBUG_LOG("VM_INIT callback");
+    InitializeLiveVmState(jni_env);
+}
+
+/**
+ * Record that a target was bound, and switch NativeMethodBind events off once every
+ * required group (agent option requiredBinds) is bound.
+ *
+ * The JVM keeps binding natives for its whole life; once our targets are in place,
+ * every further event is three JVMTI calls and allocations for nothing. The libc
+ * option keeps them on: a bind is where it patches a newly loaded JNI library.
+ *
+ * @param jvmti_env JVMTI environment
+ * @param spec Target that was just bound
+ */
+static void OnInterceptTargetBound(jvmtiEnv* jvmti_env, const InterceptTargetSpec& spec) {
+    uint32_t bound = g_bound_bind_groups.fetch_or(spec.bind_group, std::memory_order_acq_rel) | spec.bind_group;
+    uint32_t required = g_agent_options.required_bind_groups;
+
+    if (g_agent_options.bind_events != BindEventMode::Auto || g_agent_options.libc_interception ||
+        (bound & required) != required) {
+        return;
+    }
+    if (g_bind_events_disarmed.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    jvmtiError error = jvmti_env->SetEventNotificationMode(JVMTI_DISABLE, JVMTI_EVENT_NATIVE_METHOD_BIND, nullptr);
+    if (error != JVMTI_ERROR_NONE) {
+        fprintf(stderr, "[junit-airgap:native] WARNING: Failed to disable native method bind events: %d\n", error);
+        g_bind_events_disarmed.store(false, std::memory_order_release);
+        return;
+    }
+
+    LOG_DEBUG(Bind, "All required interception targets bound - native method bind events disabled after %llu events",
+               (unsigned long long)g_native_bind_events.load(std::memory_order_relaxed));
+}
+
+/**
+ * Check whether a bound method's declaring class matches a target.
+ */
+static bool InterceptClassMatches(const InterceptTargetSpec& spec, const char* class_signature, uint32_t class_hash) {
+    if (!spec.match_class_suffix) {
+        return spec.class_hash == class_hash && strcmp(spec.class_signature, class_signature) == 0;
+    }
+
+    // "Lio/netty/channel/unix/Socket;" or "Lcom/example/shaded/io/netty/channel/unix/Socket;"
+    size_t length = strlen(class_signature);
+    size_t suffix_length = strlen(spec.class_signature);
+    if (length <= suffix_length || strcmp(class_signature + length - suffix_length, spec.class_signature) != 0) {
+        return false;
+    }
+    char before = class_signature[length - suffix_length - 1];
+    return before == 'L' || before == '/';
+}
+
+/**
+ * Check whether any interception target has this method name.
+ */
+static bool IsInterceptedMethodName(const char* method_name, uint32_t method_hash) {
+    for (const InterceptTargetSpec& spec : kInterceptTargets) {
+        if (spec.method_hash == method_hash && strcmp(spec.method_name, method_name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * JVMTI callback for native method binding.
  *
  * This is called when a native method is about to be bound to its implementation.
  * We can replace the function pointer here to intercept the call.
  *
+ * The JVM binds thousands of natives during startup, so a non-matching bind is
+ * rejected on the method name alone (one hash comparison per target) before the
+ * declaring class and its signature are fetched.
+ *
  * @param jvmti_env JVMTI environment
  * @param jni_env JNI environment
  * @param thread Current thread
@@ -333,17 +756,33 @@ void JNICALL NativeMethodBindCallback(
 
     jvmtiError error;
 
-    // Get method info
-    error = jvmti_env->GetMethodName(method, &method_name, &method_signature, nullptr);
+    g_native_bind_events.fetch_add(1, std::memory_order_relaxed);
+
+    // The method's library may be new: patch it before the method first runs (libc option)
+    RescanLoadedLibraries();
+
+    // Every bind is only logged at bind:trace (compiled out of Release builds)
+    bool trace_binds = LogEnabled(LogLevel::Trace, LogCategory::Bind);
+
+    // Get method info (signature only needed for trace logging)
+    error = jvmti_env->GetMethodName(method, &method_name, trace_binds ? &method_signature : nullptr, nullptr);
     if (error != JVMTI_ERROR_NONE) {
-        DEBUG_LOG("Failed to get method name");
+        LOG_DEBUG(Bind, "Failed to get method name");
+        return;
+    }
+
+    // Fast reject: not a method name we intercept (bind tracing logs every bind, so
+    // it always takes the full path)
+    uint32_t method_hash = HashName(method_name);
+    if (!IsInterceptedMethodName(method_name, method_hash) && !trace_binds) {
+        jvmti_env->Deallocate((unsigned char*)method_name);
         return;
     }
 
     // Get declaring class
     error = jvmti_env->GetMethodDeclaringClass(method, &declaring_class);
     if (error != JVMTI_ERROR_NONE) {
-        DEBUG_LOG("Failed to get declaring class");
+        LOG_DEBUG(Bind, "Failed to get declaring class");
         jvmti_env->Deallocate((unsigned char*)method_name);
         jvmti_env->Deallocate((unsigned char*)method_signature);
         return;
@@ -352,124 +791,297 @@ void JNICALL NativeMethodBindCallback(
     // Get class signature
     error = jvmti_env->GetClassSignature(declaring_class, &class_signature, nullptr);
     if (error != JVMTI_ERROR_NONE) {
-        DEBUG_LOG("Failed to get class signature");
+        LOG_DEBUG(Bind, "Failed to get class signature");
         jvmti_env->Deallocate((unsigned char*)method_name);
         jvmti_env->Deallocate((unsigned char*)method_signature);
         return;
     }
 
     // Log the binding (for debugging)
-    DEBUG_LOGF("Native method bind: %s.%s%s -> %p",
-               class_signature, method_name, method_signature, address);
+    LOG_TRACE(Bind, "Native method bind: %s.%s%s -> %p",
+              class_signature, method_name, method_signature != nullptr ? method_signature : "", address);
+
+    uint32_t class_hash = HashName(class_signature);
+    for (const InterceptTargetSpec& spec : kInterceptTargets) {
+        if (spec.method_hash != method_hash || strcmp(spec.method_name, method_name) != 0 ||
+            !InterceptClassMatches(spec, class_signature, class_hash)) {
+            continue;
+        }
 
-    // Check if this is sun.nio.ch.Net.connect0() - used by modern Socket implementation
-    if (strcmp(class_signature, "Lsun/nio/ch/Net;") == 0 &&
-        strcmp(method_name, "connect0") == 0) {
+        if (t_rebinding_target == &spec) {
+            break;
+        }
+
+        // Library natives change between versions: only wrap the signature we know
+        if (spec.method_signature != nullptr) {
+            if (method_signature == nullptr &&
+                jvmti_env->GetMethodName(method, nullptr, &method_signature, nullptr) != JVMTI_ERROR_NONE) {
+                method_signature = nullptr;
+            }
+            if (method_signature == nullptr || strcmp(spec.method_signature, method_signature) != 0) {
+                LOG_DEBUG(Bind, "Not intercepting %s%s (expected %s)", spec.display_name,
+                          method_signature != nullptr ? method_signature : "", spec.method_signature);
+                break;
+            }
+        }
 
-        DEBUG_LOG("Intercepted sun.nio.ch.Net.connect0() binding");
+        LOG_DEBUG(Bind, "Intercepted %s() binding", spec.display_name);
 
         // Store original function pointer
-        std::string key = "sun.nio.ch.Net.connect0";
-        StoreOriginalFunction(key, address);
+        StoreOriginalFunction(spec.target, address);
 
         // Replace with wrapper function
-        void* wrapper_address = InstallNetConnect0Wrapper(address);
-        *new_address_ptr = wrapper_address;
+        if (spec.install_wrapper != nullptr) {
+            void* wrapper_address = spec.install_wrapper(address);
+            *new_address_ptr = wrapper_address;
+            LOG_DEBUG(Bind, "Replaced %s() with wrapper at %p", spec.display_name, wrapper_address);
+        }
 
-        DEBUG_LOGF("Replaced Net.connect0() with wrapper at %p", wrapper_address);
+        OnInterceptTargetBound(jvmti_env, spec);
+        break;
     }
 
-    // Check if this is Socket.socketConnect0() (legacy, pre-Java 7)
-    if (strcmp(class_signature, "Ljava/net/Socket;") == 0 &&
-        strcmp(method_name, "socketConnect0") == 0) {
+    // Cleanup
+    jvmti_env->Deallocate((unsigned char*)method_name);
+    jvmti_env->Deallocate((unsigned char*)method_signature);
+    jvmti_env->Deallocate((unsigned char*)class_signature);
+}
 
-        DEBUG_LOG("Intercepted Socket.socketConnect0() binding");
+/**
+ * JNI symbol of a target's native implementation, e.g. "Java_sun_nio_ch_Net_connect0".
+ */
+static std::string JniSymbolName(const InterceptTargetSpec& spec) {
+    std::string symbol = "Java_";
+    auto mangle = [&symbol](const char* name) {
+        for (const char* p = name; *p != '\0'; p++) {
+            if (*p == '/') {
+                symbol += '_';
+            } else if (*p == '_') {
+                symbol += "_1";
+            } else {
+                symbol += *p;
+            }
+        }
+    };
+
+    // "Lsun/nio/ch/Net;" -> "sun_nio_ch_Net"
+    std::string class_name(spec.class_signature + 1, strlen(spec.class_signature) - 2);
+    mangle(class_name.c_str());
+    symbol += '_';
+    mangle(spec.method_name);
+    return symbol;
+}
 
-        // Store original function pointer
-        std::string key = "java.net.Socket.socketConnect0";
-        StoreOriginalFunction(key, address);
+/**
+ * Look up a JNI symbol in an already loaded JDK library, without loading it.
+ *
+ * @param java_home java.home of the running VM (may be nullptr)
+ * @param library Library base name, e.g. "nio"
+ * @param symbol JNI symbol name
+ * @return Function address, or nullptr if the library isn't loaded or lacks the symbol
+ */
+static void* ResolveJdkNative(const char* java_home, const char* library, const char* symbol) {
+#ifdef _WIN32
+    HMODULE module = GetModuleHandleA((std::string(library) + ".dll").c_str());
+    return module != nullptr ? (void*)GetProcAddress(module, symbol) : nullptr;
+#else
+#ifdef __APPLE__
+    std::string file_name = std::string("lib") + library + ".dylib";
+#else
+    std::string file_name = std::string("lib") + library + ".so";
+#endif
+    // The JDK opens its libraries RTLD_LOCAL, so find the handle by path before trying the soname
+    void* handle = nullptr;
+    if (java_home != nullptr) {
+        handle = dlopen((std::string(java_home) + "/lib/" + file_name).c_str(), RTLD_LAZY | RTLD_NOLOAD);
+    }
+    if (handle == nullptr) {
+        handle = dlopen(file_name.c_str(), RTLD_LAZY | RTLD_NOLOAD);
+    }
+    if (handle == nullptr) {
+        return nullptr;
     }
 
-    // Check if this is SocketChannelImpl.connect0()
-    if (strcmp(class_signature, "Lsun/nio/ch/SocketChannelImpl;") == 0 &&
-        strcmp(method_name, "connect0") == 0) {
+    void* address = dlsym(handle, symbol);
+    dlclose(handle);  // Drops the reference RTLD_NOLOAD took; the JDK still holds its own
+    return address;
+#endif
+}
 
-        DEBUG_LOG("Intercepted SocketChannel.connect0() binding");
+/**
+ * JNI signature of a class's native method with this name.
+ *
+ * @return Signature (JVMTI-allocated, caller deallocates), or nullptr if there is none
+ */
+static char* FindNativeMethodSignature(jvmtiEnv* jvmti, jclass klass, const char* method_name) {
+    static constexpr jint kAccNative = 0x0100;
 
-        // Store original function pointer
-        std::string key = "sun.nio.ch.SocketChannelImpl.connect0";
-        StoreOriginalFunction(key, address);
+    jint method_count = 0;
+    jmethodID* methods = nullptr;
+    if (jvmti->GetClassMethods(klass, &method_count, &methods) != JVMTI_ERROR_NONE) {
+        return nullptr;
     }
 
-    // Check if this is Inet6AddressImpl.lookupAllHostAddr() - DNS resolution
-    if (strcmp(class_signature, "Ljava/net/Inet6AddressImpl;") == 0 &&
-        strcmp(method_name, "lookupAllHostAddr") == 0) {
-
-        DEBUG_LOG("Intercepted Inet6AddressImpl.lookupAllHostAddr() binding");
+    char* found = nullptr;
+    for (jint i = 0; i < method_count && found == nullptr; i++) {
+        jint modifiers = 0;
+        if (jvmti->GetMethodModifiers(methods[i], &modifiers) != JVMTI_ERROR_NONE || (modifiers & kAccNative) == 0) {
+            continue;
+        }
 
-        // Store original function pointer
-        std::string key = "java.net.Inet6AddressImpl.lookupAllHostAddr";
-        StoreOriginalFunction(key, address);
+        char* name = nullptr;
+        char* signature = nullptr;
+        if (jvmti->GetMethodName(methods[i], &name, &signature, nullptr) != JVMTI_ERROR_NONE) {
+            continue;
+        }
+        if (strcmp(name, method_name) == 0) {
+            found = signature;
+        } else {
+            jvmti->Deallocate((unsigned char*)signature);
+        }
+        jvmti->Deallocate((unsigned char*)name);
+    }
 
-        // Replace with wrapper function
-        void* wrapper_address = InstallInet6LookupWrapper(address);
-        *new_address_ptr = wrapper_address;
+    jvmti->Deallocate((unsigned char*)methods);
+    return found;
+}
 
-        DEBUG_LOGF("Replaced Inet6AddressImpl.lookupAllHostAddr() with wrapper at %p", wrapper_address);
+/**
+ * Bind a target's wrapper over the JDK implementation of an already loaded class.
+ *
+ * Works whether the JVM has linked the native yet or not. A target whose library isn't
+ * loaded yet is left to the NativeMethodBind event, like at startup.
+ *
+ * @return true if the wrapper is now bound
+ */
+static bool RebindLoadedTarget(
+    jvmtiEnv* jvmti,
+    JNIEnv* env,
+    jclass klass,
+    const InterceptTargetSpec& spec,
+    const char* java_home
+) {
+    if (GetOriginalFunction(spec.target) != nullptr) {
+        return false;  // Bind event got there first
     }
 
-    // Check if this is Inet4AddressImpl.lookupAllHostAddr() - DNS resolution
-    if (strcmp(class_signature, "Ljava/net/Inet4AddressImpl;") == 0 &&
-        strcmp(method_name, "lookupAllHostAddr") == 0) {
+    std::string symbol = JniSymbolName(spec);
+    void* original = ResolveJdkNative(java_home, spec.jdk_library, symbol.c_str());
+    if (original == nullptr) {
+        LOG_DEBUG(Bind, "%s not found in %s - left to the bind event", symbol.c_str(), spec.jdk_library);
+        return false;
+    }
 
-        DEBUG_LOG("Intercepted Inet4AddressImpl.lookupAllHostAddr() binding");
+    char* method_signature = FindNativeMethodSignature(jvmti, klass, spec.method_name);
+    if (method_signature == nullptr) {
+        LOG_DEBUG(Bind, "%s() is not a native method of the loaded class", spec.display_name);
+        return false;
+    }
 
-        // Store original function pointer
-        std::string key = "java.net.Inet4AddressImpl.lookupAllHostAddr";
-        StoreOriginalFunction(key, address);
+    StoreOriginalFunction(spec.target, original);
+    void* wrapper_address = spec.install_wrapper(original);
 
-        // Replace with wrapper function
-        void* wrapper_address = InstallInet4LookupWrapper(address);
-        *new_address_ptr = wrapper_address;
+    JNINativeMethod method = {(char*)spec.method_name, method_signature, wrapper_address};
+    t_rebinding_target = &spec;
+    jint result = env->RegisterNatives(klass, &method, 1);
+    t_rebinding_target = nullptr;
+    jvmti->Deallocate((unsigned char*)method_signature);
 
-        DEBUG_LOGF("Replaced Inet4AddressImpl.lookupAllHostAddr() with wrapper at %p", wrapper_address);
+    if (result != JNI_OK) {
+        if (env->ExceptionCheck()) {
+            env->ExceptionClear();
+        }
+        fprintf(stderr, "[junit-airgap:native] WARNING: Failed to rebind %s(): %d\n", spec.display_name, result);
+        return false;
     }
 
-    // Cleanup
-    jvmti_env->Deallocate((unsigned char*)method_name);
-    jvmti_env->Deallocate((unsigned char*)method_signature);
-    jvmti_env->Deallocate((unsigned char*)class_signature);
+    LOG_DEBUG(Bind, "Rebound %s() to wrapper at %p", spec.display_name, wrapper_address);
+    OnInterceptTargetBound(jvmti, spec);
+    return true;
 }
 
 /**
- * Agent entry point.
+ * Rebind every target whose class the running VM has already loaded.
  *
- * Called when the agent is loaded via -agentpath or -agentlib.
+ * Bind events only see natives the JVM links after the agent is loaded; when attached
+ * late, Net.connect0 and lookupAllHostAddr have usually been linked long before.
+ *
+ * @return Number of targets rebound
+ */
+static int RebindLoadedTargets(jvmtiEnv* jvmti, JNIEnv* env) {
+    jint class_count = 0;
+    jclass* classes = nullptr;
+    jvmtiError error = jvmti->GetLoadedClasses(&class_count, &classes);
+    if (error != JVMTI_ERROR_NONE) {
+        fprintf(stderr, "[junit-airgap:native] WARNING: Failed to list loaded classes: %d\n", error);
+        return 0;
+    }
+
+    char* java_home = nullptr;
+    if (jvmti->GetSystemProperty("java.home", &java_home) != JVMTI_ERROR_NONE) {
+        java_home = nullptr;
+    }
+
+    int rebound = 0;
+    for (jint i = 0; i < class_count; i++) {
+        char* class_signature = nullptr;
+        if (jvmti->GetClassSignature(classes[i], &class_signature, nullptr) == JVMTI_ERROR_NONE) {
+            uint32_t class_hash = HashName(class_signature);
+            for (const InterceptTargetSpec& spec : kInterceptTargets) {
+                if (spec.jdk_library != nullptr && spec.install_wrapper != nullptr &&
+                    InterceptClassMatches(spec, class_signature, class_hash) &&
+                    RebindLoadedTarget(jvmti, env, classes[i], spec, java_home)) {
+                    rebound++;
+                }
+            }
+            jvmti->Deallocate((unsigned char*)class_signature);
+        }
+        env->DeleteLocalRef(classes[i]);
+    }
+
+    jvmti->Deallocate((unsigned char*)java_home);
+    jvmti->Deallocate((unsigned char*)classes);
+    return rebound;
+}
+
+/**
+ * Setup shared by Agent_OnLoad() and Agent_OnAttach(): options, log sink, optional
+ * subsystems and the JVMTI environment with its bind events.
  *
- * @param vm Java VM instance
- * @param options Agent options string (from -agentpath:path=options)
- * @param reserved Reserved for future use
  * @return JNI_OK on success, JNI_ERR on failure
  */
-JNIEXPORT jint JNICALL Agent_OnLoad(JavaVM *vm, char *options, void *reserved) {
+static jint LoadAgent(JavaVM* vm, char* options) {
     g_jvm = vm;
 
-    // Parse options
-    if (options != nullptr && strstr(options, "debug") != nullptr) {
-        g_debug_mode = true;
+    // Parse options (see agent_options.h)
+    ParseAgentOptions(options, &g_agent_options);
+    InitLogSink(g_agent_options.log_levels, g_agent_options.log_rate);
+
+    if (!g_agent_options.trace_path.empty()) {
+        InitTraceBuffers(g_agent_options.trace_path.c_str(), g_agent_options.trace_records_per_thread);
+    }
+
+    if (!g_agent_options.policy_path.empty()) {
+        LoadPolicyImage(g_agent_options.policy_path.c_str());
     }
 
-    // Display version banner (only in debug mode)
-    if (g_debug_mode) {
-        fprintf(stderr, "\n");
-        fprintf(stderr, "================================================================================\n");
-        fprintf(stderr, "[junit-airgap:native] junit-airgap Native Agent\n");
-        fprintf(stderr, "[junit-airgap:native] Version: 2024-10-31 (platform encoding fix)\n");
-        fprintf(stderr, "[junit-airgap:native] Build time: %s %s\n", __DATE__, __TIME__);
-        fprintf(stderr, "================================================================================\n");
-        fprintf(stderr, "\n");
+    if (g_agent_options.libc_interception) {
+        InstallLibcInterception();
     }
 
+    g_metrics_enabled = g_agent_options.metrics;
+
+    if (!g_agent_options.events_path.empty()) {
+        InitSharedEventRing(g_agent_options.events_path.c_str(), g_agent_options.events_capacity);
+    }
+
+    // Display version banner (agent:info and above)
+    LOG_INFO(Agent, "================================================================================");
+    LOG_INFO(Agent, "junit-airgap Native Agent");
+    LOG_INFO(Agent, "Version: 2024-10-31 (platform encoding fix)");
+    LOG_INFO(Agent, "Build time: %s %s", __DATE__, __TIME__);
+    LOG_INFO(Agent, "================================================================================");
+
     DEBUG_LOG("JVMTI Agent loading...");
 
     // Get JVMTI environment
@@ -492,145 +1104,115 @@ JNIEXPORT jint JNICALL Agent_OnLoad(JavaVM *vm, char *options, void *reserved) {
 }
 
 /**
- * Agent unload callback.
+ * Agent entry point.
  *
- * Called when the JVM shuts down.
+ * Called when the agent is loaded via -agentpath or -agentlib.
  *
  * @param vm Java VM instance
+ * @param options Agent options string (from -agentpath:path=options)
+ * @param reserved Reserved for future use
+ * @return JNI_OK on success, JNI_ERR on failure
  */
-JNIEXPORT void JNICALL Agent_OnUnload(JavaVM *vm) {
-    DEBUG_LOG("JVMTI Agent unloading...");
-
-    // Clean up global references
-    if (g_network_blocker_context_class != nullptr) {
-        JNIEnv* env = GetJNIEnv();
-        if (env != nullptr) {
-            env->DeleteGlobalRef(g_network_blocker_context_class);
-            g_network_blocker_context_class = nullptr;
-        }
-    }
-
-    g_jvmti = nullptr;
-    g_jvm = nullptr;
+JNIEXPORT jint JNICALL Agent_OnLoad(JavaVM *vm, char *options, void *reserved) {
+    return LoadAgent(vm, options);
 }
 
 /**
- * Get cached NetworkBlockerContext class reference.
+ * Agent entry point for a running JVM.
  *
- * @return Cached class reference, or nullptr if not registered
- */
-jclass GetNetworkBlockerContextClass() {
-    std::lock_guard<std::mutex> lock(g_context_mutex);
-    return g_network_blocker_context_class;
-}
-
-/**
- * Get cached checkConnection method ID.
+ * Called when the agent is loaded through the Attach API (VirtualMachine.loadAgentPath(),
+ * jcmd JVMTI.agent_load). VM_INIT has already happened, so its work runs here, after
+ * the targets the JVM has already bound are rebound to the wrappers.
  *
- * @return Cached method ID, or nullptr if not registered
- */
-jmethodID GetCheckConnectionMethod() {
-    std::lock_guard<std::mutex> lock(g_context_mutex);
-    return g_check_connection_method;
-}
-
-/**
- * Get cached isExplicitlyBlocked method ID.
+ * Netty natives that were registered before the attach are not intercepted (use the
+ * libc option for those). The JVM logs a "Re-registering of platform native method"
+ * warning for each rebound JDK method.
  *
- * @return Cached method ID, or nullptr if not registered
+ * @param vm Java VM instance
+ * @param options Agent options string (same syntax as for Agent_OnLoad())
+ * @param reserved Reserved for future use
+ * @return JNI_OK on success, JNI_ERR on failure
  */
-jmethodID GetIsExplicitlyBlockedMethod() {
-    std::lock_guard<std::mutex> lock(g_context_mutex);
-    return g_is_explicitly_blocked_method;
-}
+JNIEXPORT jint JNICALL Agent_OnAttach(JavaVM *vm, char *options, void *reserved) {
+    if (g_jvmti != nullptr) {
+        DEBUG_LOG("JVMTI Agent already loaded - ignoring attach");
+        return JNI_OK;
+    }
 
-/**
- * Get cached hasActiveConfiguration method.
- *
- * @return Cached method ID, or nullptr if not registered
- */
-jmethodID GetHasActiveConfigurationMethod() {
-    std::lock_guard<std::mutex> lock(g_context_mutex);
-    return g_has_active_configuration_method;
-}
+    jint result = LoadAgent(vm, options);
+    if (result != JNI_OK) {
+        return result;
+    }
 
-/**
- * Get cached caller agent string constant.
- *
- * @return Cached "Native-Agent" string, or nullptr if not initialized
- */
-jstring GetCallerAgentString() {
-    std::lock_guard<std::mutex> lock(g_strings_mutex);
-    return g_caller_agent_string;
+    JNIEnv* env = nullptr;
+    if (vm->GetEnv((void**)&env, JNI_VERSION_1_8) != JNI_OK || env == nullptr) {
+        fprintf(stderr, "[junit-airgap:native] ERROR: Failed to get JNI environment on attach\n");
+        return JNI_ERR;
+    }
+
+    int rebound = RebindLoadedTargets(g_jvmti, env);
+    InitializeLiveVmState(env);
+
+    LOG_INFO(Agent, "Attached to running JVM - %d already loaded native method(s) rebound", rebound);
+    return JNI_OK;
 }
 
 /**
- * Get cached caller DNS string constant.
+ * Agent unload callback.
  *
- * @return Cached "Native-DNS" string, or nullptr if not initialized
+ * Called when the JVM shuts down.
+ *
+ * @param vm Java VM instance
  */
-jstring GetCallerDnsString() {
-    std::lock_guard<std::mutex> lock(g_strings_mutex);
-    return g_caller_dns_string;
+JNIEXPORT void JNICALL Agent_OnUnload(JavaVM *vm) {
+    DEBUG_LOGF("JVMTI Agent unloading... (%llu native method bind events received%s)",
+               (unsigned long long)g_native_bind_events.load(std::memory_order_relaxed),
+               g_bind_events_disarmed.load(std::memory_order_relaxed) ? ", disarmed" : "");
+
+    // Write out whatever the interceptors traced since the last on-demand dump
+    if (g_trace_enabled) {
+        DrainTraceBuffers();
+    }
+
+    // Clean up global references
+    const AgentContext* context = GetAgentContext();
+    if (context->network_blocker_context_class != nullptr) {
+        JNIEnv* env = GetJNIEnv();
+        if (env != nullptr) {
+            g_agent_context.store(&g_empty_agent_context, std::memory_order_release);
+            env->DeleteGlobalRef(context->network_blocker_context_class);
+            if (context->internal_error_class != nullptr) {
+                env->DeleteGlobalRef(context->internal_error_class);
+            }
+            if (context->connect_exception_class != nullptr) {
+                env->DeleteGlobalRef(context->connect_exception_class);
+            }
+            if (context->unknown_host_exception_class != nullptr) {
+                env->DeleteGlobalRef(context->unknown_host_exception_class);
+            }
+        }
+    }
+
+    g_jvmti = nullptr;
+    g_jvm = nullptr;
+
+    FlushLogs();
 }
 
 /**
- * Ensure platform encoding is ready for the current thread.
+ * Slow path of EnsurePlatformEncodingReady() for a thread that hasn't seen
+ * platform encoding working yet.
  *
  * Platform encoding initialization is per-thread in the JVM. When a new thread
  * (like Android Studio's "Test worker") is created, platform encoding may not be
  * ready immediately, even if VM_INIT has completed and NetworkBlockerContext is registered.
  *
- * This function triggers platform encoding initialization by attempting a simple
- * string operation (GetStringUTFChars) and retrying if it fails.
- *
  * @param env JNI environment for current thread
- * @return true if platform encoding is ready, false if failed after retries
+ * @return true if platform encoding is ready, false if still not ready after the deadline
+ *         (or a non-encoding exception was re-thrown)
  */
-bool EnsurePlatformEncodingReady(JNIEnv* env) {
-    // Try to use a cached string to trigger platform encoding initialization
-    jstring test_string = GetCallerAgentString();
-    if (test_string == nullptr) {
-        return false;
-    }
-
-    int max_attempts = 100;  // Up to 5 seconds (100 attempts * 50ms)
-    for (int attempt = 0; attempt < max_attempts; attempt++) {
-        const char* test_chars = env->GetStringUTFChars(test_string, nullptr);
-
-        if (test_chars != nullptr) {
-            // Success! Platform encoding is ready
-            if (attempt > 0) {
-                DEBUG_LOGF("Platform encoding ready after %d attempt(s)", attempt + 1);
-            }
-            env->ReleaseStringUTFChars(test_string, test_chars);
-            return true;
-        }
-
-        // Failed - check if it's a platform encoding error
-        if (env->ExceptionCheck()) {
-            jthrowable exception = env->ExceptionOccurred();
-            env->ExceptionClear();
-
-            // Check if it's InternalError (platform encoding error)
-            jclass errorClass = env->FindClass("java/lang/InternalError");
-            if (errorClass != nullptr && env->IsInstanceOf(exception, errorClass)) {
-                if (attempt < max_attempts - 1) {
-                    usleep(50000);  // Sleep 50ms
-                    continue;
-                } else {
-                    DEBUG_LOG("Platform encoding still not ready after retries");
-                    return false;
-                }
-            } else {
-                // Different error - not a platform encoding issue
-                env->Throw(exception);  // Re-throw
-                return false;
-            }
-        }
-    }
-
-    return false;
+bool WaitForPlatformEncodingReady(JNIEnv* env) {
+    return WaitForPlatformEncoding(env, kThreadEncodingTimeout, true);
 }
 
 /**
@@ -650,55 +1232,55 @@ JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_Netwo
     JNIEnv* env,
     jclass clazz
 ) {
-    std::lock_guard<std::mutex> lock(g_context_mutex);
+    std::lock_guard<std::mutex> lock(g_agent_context_publish_mutex);
+
+    LOG_DEBUG(Registration, "Registering NetworkBlockerContext with JVMTI agent...");
 
-    DEBUG_LOG("Registering NetworkBlockerContext with JVMTI agent...");
+    // Work on a copy; nothing is visible to interceptors until it is published
+    AgentContext context = *GetAgentContext();
 
     // Create global reference to the class
     // (local reference will be invalid after this function returns)
-    g_network_blocker_context_class = (jclass)env->NewGlobalRef(clazz);
+    jclass context_class = (jclass)env->NewGlobalRef(clazz);
 
-    if (g_network_blocker_context_class == nullptr) {
+    if (context_class == nullptr) {
         fprintf(stderr, "[junit-airgap:native] ERROR: Failed to create global reference to NetworkBlockerContext\n");
         return;
     }
 
     // Get checkConnection method
-    g_check_connection_method = env->GetStaticMethodID(
-        g_network_blocker_context_class,
+    jmethodID check_connection_method = env->GetStaticMethodID(
+        context_class,
         "checkConnection",
         "(Ljava/lang/String;ILjava/lang/String;)V"
     );
 
-    if (g_check_connection_method == nullptr) {
+    if (check_connection_method == nullptr) {
         fprintf(stderr, "[junit-airgap:native] ERROR: Failed to find checkConnection method\n");
         if (env->ExceptionCheck()) {
             fprintf(stderr, "[junit-airgap:native] JNI Exception occurred:\n");
             env->ExceptionDescribe();
             env->ExceptionClear();
         }
-        env->DeleteGlobalRef(g_network_blocker_context_class);
-        g_network_blocker_context_class = nullptr;
+        env->DeleteGlobalRef(context_class);
         return;
     }
 
     // Get isExplicitlyBlocked method
-    g_is_explicitly_blocked_method = env->GetStaticMethodID(
-        g_network_blocker_context_class,
+    jmethodID is_explicitly_blocked_method = env->GetStaticMethodID(
+        context_class,
         "isExplicitlyBlocked",
         "(Ljava/lang/String;)Z"
     );
 
-    if (g_is_explicitly_blocked_method == nullptr) {
+    if (is_explicitly_blocked_method == nullptr) {
         fprintf(stderr, "[junit-airgap:native] ERROR: Failed to find isExplicitlyBlocked method\n");
         if (env->ExceptionCheck()) {
             fprintf(stderr, "[junit-airgap:native] JNI Exception occurred:\n");
             env->ExceptionDescribe();
             env->ExceptionClear();
         }
-        env->DeleteGlobalRef(g_network_blocker_context_class);
-        g_network_blocker_context_class = nullptr;
-        g_check_connection_method = nullptr;
+        env->DeleteGlobalRef(context_class);
         return;
     }
 
@@ -707,13 +1289,13 @@ JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_Netwo
     // no active configuration if the method is unavailable (e.g., during class initialization).
     // On some platforms (Linux), this method lookup may fail during class initialization,
     // so we make it non-fatal and just log a warning.
-    g_has_active_configuration_method = env->GetStaticMethodID(
-        g_network_blocker_context_class,
+    jmethodID has_active_configuration_method = env->GetStaticMethodID(
+        context_class,
         "hasActiveConfiguration",
         "()Z"
     );
 
-    if (g_has_active_configuration_method == nullptr) {
+    if (has_active_configuration_method == nullptr) {
         fprintf(stderr, "[junit-airgap:native] WARNING: Failed to find hasActiveConfiguration method (optional)\n");
         // Check if there's a pending JNI exception that explains the failure
         if (env->ExceptionCheck()) {
@@ -725,5 +1307,254 @@ JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_Netwo
         // Continue anyway - interceptors can handle hasActiveConfiguration being null
     }
 
-    DEBUG_LOG("NetworkBlockerContext registered - network blocking enabled");
+    // Get activeContextId (optional: without it every thread with a configuration
+    // uses the JVM-wide context, e.g. for the native test stub)
+    jmethodID active_context_id_method = env->GetStaticMethodID(
+        context_class,
+        "activeContextId",
+        "()J"
+    );
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+    }
+    if (active_context_id_method == nullptr) {
+        LOG_DEBUG(Registration, "activeContextId() not found - all configurations share the JVM-wide context");
+    }
+
+    // Get evaluate/blockedRequestException (optional: without them a block falls back
+    // to checkConnection(), e.g. for the native test stub)
+    jmethodID evaluate_method = env->GetStaticMethodID(
+        context_class,
+        "evaluate",
+        "(Ljava/lang/String;Ljava/lang/String;I)I"
+    );
+    jmethodID blocked_request_exception_method = evaluate_method == nullptr ? nullptr : env->GetStaticMethodID(
+        context_class,
+        "blockedRequestException",
+        "(Ljava/lang/String;ILjava/lang/String;)Lio/github/garryjeromson/junit/airgap/NetworkRequestAttemptedException;"
+    );
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+    }
+    if (blocked_request_exception_method == nullptr) {
+        evaluate_method = nullptr;
+        LOG_DEBUG(Registration, "evaluate() not found - blocks use checkConnection()");
+    }
+
+    // Cache InetAddress field IDs so the connect path can read addresses without
+    // FindClass/GetMethodID lookups or String allocations
+    InetAddressFields inet_address_fields;
+    if (!LookupInetAddressFields(env, &inet_address_fields)) {
+        fprintf(stderr, "[junit-airgap:native] ERROR: Failed to find java.net.InetAddress methods\n");
+        env->DeleteGlobalRef(context_class);
+        return;
+    }
+
+    // Hosts overrides throw UnknownHostException for a host with no address of the
+    // requested family; cached here so the lookup path never calls FindClass
+    CacheExceptionClass(env, "java/net/UnknownHostException", &context.unknown_host_exception_class);
+
+    // Publish class and methods together so interceptors never see a partial registration
+    context.network_blocker_context_class = context_class;
+    context.inet_address = inet_address_fields;
+    context.check_connection_method = check_connection_method;
+    context.is_explicitly_blocked_method = is_explicitly_blocked_method;
+    context.has_active_configuration_method = has_active_configuration_method;
+    context.active_context_id_method = active_context_id_method;
+    context.evaluate_method = evaluate_method;
+    context.blocked_request_exception_method = blocked_request_exception_method;
+    PublishAgentContext(context);
+
+    LOG_INFO(Registration, "NetworkBlockerContext registered - network blocking enabled");
+}
+
+/**
+ * Mirror NetworkBlockerContext's configuration state into the agent.
+ *
+ * Called from NetworkBlockerContext when it registers (disarmed), from
+ * setConfiguration() (armed) and from clearConfiguration() after the generation
+ * bump (disarmed). The generation store invalidates every generation-scoped native
+ * cache (verdicts, DNS bindings); the arm state lets interceptors skip the
+ * hasActiveConfiguration() upcall while nothing is configured. Arming also patches
+ * the libraries loaded since the last rescan (libc option).
+ *
+ * Java signature: private external fun setAgentArmState(armed: Boolean, generation: Long)
+ * JNI signature: (ZJ)V
+ */
+JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_setAgentArmState(
+    JNIEnv* env,
+    jclass clazz,
+    jboolean armed,
+    jlong generation
+) {
+    g_configuration_generation.store(generation, std::memory_order_release);
+    g_agent_arm_state.store(armed ? AgentArmState::Armed : AgentArmState::Disarmed, std::memory_order_release);
+    // A traced or metered agent records disarmed decisions too, so it never bypasses the wrappers
+    g_interception_bypassed.store(!armed && !g_trace_enabled && !g_metrics_enabled, std::memory_order_release);
+    if (armed) {
+        RescanLoadedLibraries();
+    }
+    LOG_DEBUG(Registration, "Agent %s, configuration generation is now %lld", armed ? "armed" : "disarmed", (long long)generation);
+}
+
+/**
+ * Mirror NetworkBlockerContext's configuration scope into the agent.
+ *
+ * Called from setConfiguration() before the agent is armed. When shared, the
+ * configuration is one JVM-wide test context rather than per-thread state, and
+ * interceptors skip the hasActiveConfiguration() upcall while armed (see
+ * IsAgentContextShared()).
+ *
+ * Java signature: private external fun setAgentSharedContext(shared: Boolean)
+ * JNI signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_setAgentSharedContext(
+    JNIEnv* env,
+    jclass clazz,
+    jboolean shared
+) {
+    g_agent_shared_context.store(shared == JNI_TRUE, std::memory_order_release);
+    LOG_DEBUG(Registration, "Configuration scope is now %s", shared ? "shared (JVM-wide)" : "per-thread");
+}
+
+/**
+ * Get the number of NativeMethodBind events the agent has handled so far.
+ *
+ * Stops growing once bind events are disarmed (see OnInterceptTargetBound()), so it is
+ * the startup cost the bind callback added to this JVM. Used by the startup benchmark
+ * (native/test/StartupBenchmark.java).
+ *
+ * Java signature: private static native long getAgentNativeBindEventCount()
+ * JNI signature: ()J
+ */
+JNIEXPORT jlong JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_getAgentNativeBindEventCount(
+    JNIEnv* env,
+    jclass clazz
+) {
+    return (jlong)g_native_bind_events.load(std::memory_order_relaxed);
+}
+
+/**
+ * Check that a bound target's original implementation is still mapped code, and
+ * resolve a JDK native again if it isn't (the library was mapped elsewhere on restore).
+ *
+ * @return false if the original can't be called any more
+ */
+static bool RevalidateOriginalFunction(const InterceptTargetSpec& spec, const char* java_home) {
+    void* original = GetOriginalFunction(spec.target);
+    if (original == nullptr) {
+        return true;  // Not bound (yet); a later bind event still works as usual
+    }
+#ifdef _WIN32
+    HMODULE module = nullptr;
+    if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                           (LPCSTR)original, &module)) {
+        return true;
+    }
+#else
+    Dl_info info;
+    if (dladdr(original, &info) != 0) {
+        return true;
+    }
+#endif
+
+    void* resolved = nullptr;
+    if (spec.jdk_library != nullptr && spec.install_wrapper != nullptr) {
+        resolved = ResolveJdkNative(java_home, spec.jdk_library, JniSymbolName(spec).c_str());
+    }
+    if (resolved == nullptr) {
+        fprintf(stderr, "[junit-airgap:native] ERROR: Original %s() is not mapped after restore\n",
+                spec.display_name);
+        return false;
+    }
+
+    // Same wrapper address, so the binding the restored JVM holds stays valid
+    StoreOriginalFunction(spec.target, resolved);
+    spec.install_wrapper(resolved);
+    LOG_INFO(Bind, "Re-resolved original %s() after restore: %p -> %p", spec.display_name, original, resolved);
+    return true;
+}
+
+/**
+ * Quiesce the agent before a CRaC checkpoint.
+ *
+ * Called from NetworkBlockerContext's checkpoint resource (beforeCheckpoint), after it
+ * has disarmed the agent and advanced the generation, so nothing cached before the
+ * checkpoint (verdicts, DNS results and bindings) is used after the restore. Releases
+ * the cached DNS results, writes out the trace recorded so far and unmaps the event
+ * ring, the agent's only file-backed state. Interception keeps working until the checkpoint; it just isn't recorded.
+ *
+ * Java signature: private external fun quiesceAgentForCheckpoint()
+ * JNI signature: ()V
+ */
+JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_quiesceAgentForCheckpoint(
+    JNIEnv* env,
+    jclass clazz
+) {
+    if (g_checkpoint_quiesced.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    if (g_trace_enabled) {
+        DrainTraceBuffers();
+    }
+    SuspendSharedEventRing();
+    FlushAllDnsResults(env);
+    FlushLogs();
+    LOG_INFO(Agent, "Quiesced for checkpoint");
+}
+
+/**
+ * Revalidate the agent's state after a CRaC restore.
+ *
+ * The wrappers stay bound in the restored JVM, so no bind event and no rebinding is
+ * needed. The global references cached at VM_INIT and registration (caller strings,
+ * exception classes, NetworkBlockerContext and its methods) survive too: the restore
+ * brings back the heap with the JVM's handle tables, and there is no safe way to test
+ * a handle anyway. What can change is checked instead: platform encoding on the
+ * restoring thread, and the original implementations the wrappers call. The event
+ * ring is mapped again under the new process ID. NetworkBlockerContext then
+ * republishes its configuration and arms the agent.
+ *
+ * Java signature: private external fun restoreAgentAfterCheckpoint(): Boolean
+ * JNI signature: ()Z
+ *
+ * @return JNI_FALSE if an original can't be called (that target then fails closed on
+ *         the Java side, see ByteBuddy fallback); JNI_TRUE otherwise
+ */
+JNIEXPORT jboolean JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_restoreAgentAfterCheckpoint(
+    JNIEnv* env,
+    jclass clazz
+) {
+    auto start = std::chrono::steady_clock::now();
+    bool complete = true;
+
+    // VM_INIT state: its global references are restored with the heap, only encoding is rechecked
+    if (!g_vm_init_complete) {
+        LOG_INFO(Agent, "Initializing VM_INIT state after restore");
+        InitializeLiveVmState(env);
+    } else if (!WaitForPlatformEncoding(env, kThreadEncodingTimeout, false)) {
+        fprintf(stderr, "[junit-airgap:native] WARNING: Platform encoding not confirmed after restore\n");
+    }
+
+    // Original implementations
+    char* java_home = nullptr;
+    if (g_jvmti == nullptr || g_jvmti->GetSystemProperty("java.home", &java_home) != JVMTI_ERROR_NONE) {
+        java_home = nullptr;
+    }
+    for (const InterceptTargetSpec& spec : kInterceptTargets) {
+        complete = RevalidateOriginalFunction(spec, java_home) && complete;
+    }
+    if (java_home != nullptr) {
+        g_jvmti->Deallocate((unsigned char*)java_home);
+    }
+
+    ResumeSharedEventRing();
+    g_checkpoint_quiesced.store(false, std::memory_order_release);
+
+    uint32_t restores = g_restore_count.fetch_add(1, std::memory_order_relaxed) + 1;
+    LOG_INFO(Agent, "Restored from checkpoint (restore %u, revalidated in %lld us%s)", restores,
+             (long long)std::chrono::duration_cast<std::chrono::microseconds>(
+                 std::chrono::steady_clock::now() - start).count(),
+             complete ? "" : ", incomplete");
+    return complete ? JNI_TRUE : JNI_FALSE;
 }
@@ -0,0 +1,153 @@
+/**
+ * Agent options parsing for junit-airgap JVMTI Agent
+ *
+ * See agent_options.h for the supported options.
+ */
+
+#include "agent_options.h"
+#include <cstdio>
+#include <cstdlib>
+
+AgentOptions g_agent_options;
+
+/**
+ * Split a string on a separator (empty tokens dropped).
+ */
+template <typename Fn>
+static void ForEachToken(const std::string& value, char separator, Fn fn) {
+    size_t start = 0;
+    while (start <= value.size()) {
+        size_t end = value.find(separator, start);
+        if (end == std::string::npos) {
+            end = value.size();
+        }
+        if (end > start) {
+            fn(value.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+}
+
+static void ParseBindGroups(const std::string& value, uint32_t* groups) {
+    *groups = kBindGroupNone;
+    ForEachToken(value, '+', [groups](const std::string& group) {
+        if (group == "connect") {
+            *groups |= kBindGroupConnect;
+        } else if (group == "dns") {
+            *groups |= kBindGroupDns;
+        } else if (group == "netty") {
+            *groups |= kBindGroupNetty;
+        } else {
+            fprintf(stderr, "[junit-airgap:native] WARNING: Unknown requiredBinds group '%s' (expected connect, dns, netty)\n",
+                    group.c_str());
+        }
+    });
+}
+
+static void ParseCount(const std::string& key, const std::string& value, uint32_t min, uint32_t max, uint32_t* count) {
+    char* end = nullptr;
+    unsigned long parsed = strtoul(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || parsed < min || parsed > max) {
+        fprintf(stderr, "[junit-airgap:native] WARNING: Invalid %s '%s' (expected %u..%u)\n",
+                key.c_str(), value.c_str(), min, max);
+        return;
+    }
+    *count = (uint32_t)parsed;
+}
+
+static void SetAllLogLevels(LogLevel level, AgentOptions* out) {
+    for (LogLevel& category_level : out->log_levels) {
+        category_level = level;
+    }
+}
+
+/**
+ * Parse log=<entries>, e.g. "info+socket:debug" (later entries win).
+ */
+static void ParseLogLevels(const std::string& value, AgentOptions* out) {
+    ForEachToken(value, '+', [out](const std::string& entry) {
+        size_t colon = entry.find(':');
+        std::string level_name = colon == std::string::npos ? entry : entry.substr(colon + 1);
+
+        LogLevel level;
+        if (!ParseLogLevel(level_name.c_str(), &level)) {
+            fprintf(stderr, "[junit-airgap:native] WARNING: Unknown log level '%s' (expected off, info, debug, trace)\n",
+                    level_name.c_str());
+            return;
+        }
+
+        if (colon == std::string::npos) {
+            SetAllLogLevels(level, out);
+            return;
+        }
+
+        LogCategory category;
+        std::string category_name = entry.substr(0, colon);
+        if (!ParseLogCategory(category_name.c_str(), &category)) {
+            fprintf(stderr, "[junit-airgap:native] WARNING: Unknown log category '%s'\n", category_name.c_str());
+            return;
+        }
+        out->log_levels[(size_t)category] = level;
+    });
+}
+
+static void ParseOption(const std::string& option, AgentOptions* out) {
+    size_t equals = option.find('=');
+    std::string key = option.substr(0, equals);
+    std::string value = equals == std::string::npos ? std::string() : option.substr(equals + 1);
+
+    if (key == "debug") {
+        SetAllLogLevels(LogLevel::Trace, out);
+    } else if (key == "log") {
+        ParseLogLevels(value, out);
+    } else if (key == "logRate") {
+        ParseCount(key, value, 0, 1u << 20, &out->log_rate);
+    } else if (key == "bindEvents") {
+        if (value == "auto") {
+            out->bind_events = BindEventMode::Auto;
+        } else if (value == "keep") {
+            out->bind_events = BindEventMode::Keep;
+        } else {
+            fprintf(stderr, "[junit-airgap:native] WARNING: Unknown bindEvents value '%s' (expected auto, keep)\n",
+                    value.c_str());
+        }
+    } else if (key == "requiredBinds") {
+        ParseBindGroups(value, &out->required_bind_groups);
+    } else if (key == "trace") {
+        if (value.empty()) {
+            fprintf(stderr, "[junit-airgap:native] WARNING: trace option needs a file path (trace=<file>)\n");
+        }
+        out->trace_path = value;
+    } else if (key == "traceBufferSize") {
+        ParseCount(key, value, 1, 1u << 24, &out->trace_records_per_thread);
+    } else if (key == "policy") {
+        if (value.empty()) {
+            fprintf(stderr, "[junit-airgap:native] WARNING: policy option needs a file path (policy=<file>)\n");
+        }
+        out->policy_path = value;
+    } else if (key == "libc") {
+        out->libc_interception = true;
+    } else if (key == "metrics") {
+        out->metrics = true;
+    } else if (key == "events") {
+        if (value.empty()) {
+            fprintf(stderr, "[junit-airgap:native] WARNING: events option needs a file path (events=<file>)\n");
+        }
+        out->events_path = value;
+    } else if (key == "eventsCapacity") {
+        ParseCount(key, value, 1, 1u << 24, &out->events_capacity);
+    } else {
+        fprintf(stderr, "[junit-airgap:native] WARNING: Unknown agent option '%s'\n", option.c_str());
+    }
+}
+
+void ParseAgentOptions(const char* options, AgentOptions* out) {
+    *out = AgentOptions();
+    if (options == nullptr) {
+        return;
+    }
+
+    ForEachToken(options, ',', [out](const std::string& option) {
+        ParseOption(option, out);
+    });
+}
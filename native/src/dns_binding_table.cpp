@@ -0,0 +1,117 @@
+/**
+ * Forward-DNS Binding Table for junit-airgap JVMTI Agent
+ *
+ * See dns_binding_table.h. Everything a reader touches is a std::atomic word so the
+ * seqlock is free of data races: the key and hostname are packed into uint64_t words
+ * and copied with relaxed loads, validated by the slot's sequence counter.
+ */
+
+#include "agent.h"
+#include "dns_binding_table.h"
+#include <cstring>
+
+// Hostname storage in 64-bit words (including the terminating NUL)
+static constexpr size_t kHostnameWords = (kDnsBindingMaxHostnameLength + 1) / sizeof(uint64_t);
+static_assert((kDnsBindingMaxHostnameLength + 1) % sizeof(uint64_t) == 0, "hostname buffer must be whole words");
+
+/**
+ * One slot. sequence is odd while a writer is updating it; 0 means never written.
+ */
+struct DnsBindingSlot {
+    std::atomic<uint32_t> sequence;
+    std::atomic<int64_t> generation;
+    std::atomic<uint64_t> address[2];
+    std::atomic<uint64_t> address_length;
+    std::atomic<uint64_t> hostname[kHostnameWords];
+};
+
+static DnsBindingSlot g_dns_bindings[kDnsBindingTableSlots];
+
+/**
+ * Pack raw address bytes into two words (zero padded).
+ */
+static void PackAddress(const InetAddressBytes& address, uint64_t words[2]) {
+    uint8_t padded[16] = {};
+    memcpy(padded, address.bytes, address.length);
+    memcpy(words, padded, sizeof(padded));
+}
+
+/**
+ * FNV-1a over the address bytes.
+ */
+static uint32_t SlotIndex(const InetAddressBytes& address) {
+    uint32_t hash = 2166136261u;
+    for (uint8_t i = 0; i < address.length; i++) {
+        hash = (hash ^ address.bytes[i]) * 16777619u;
+    }
+    return hash & (kDnsBindingTableSlots - 1);
+}
+
+void RecordDnsBinding(const InetAddressBytes& address, const char* hostname) {
+    size_t length = strlen(hostname);
+    if (length == 0 || length > kDnsBindingMaxHostnameLength) {
+        return;
+    }
+
+    DnsBindingSlot& slot = g_dns_bindings[SlotIndex(address)];
+
+    // Claim the slot (odd sequence); if another writer holds it, drop this record
+    uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    if ((sequence & 1) != 0 ||
+        !slot.sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire)) {
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint64_t address_words[2];
+    PackAddress(address, address_words);
+
+    uint64_t hostname_words[kHostnameWords] = {};
+    memcpy(hostname_words, hostname, length);
+
+    slot.generation.store(g_configuration_generation.load(std::memory_order_acquire), std::memory_order_relaxed);
+    slot.address[0].store(address_words[0], std::memory_order_relaxed);
+    slot.address[1].store(address_words[1], std::memory_order_relaxed);
+    slot.address_length.store(address.length, std::memory_order_relaxed);
+    for (size_t i = 0; i < kHostnameWords; i++) {
+        slot.hostname[i].store(hostname_words[i], std::memory_order_relaxed);
+    }
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool LookupDnsBinding(const InetAddressBytes& address, char* hostname) {
+    const DnsBindingSlot& slot = g_dns_bindings[SlotIndex(address)];
+
+    uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence == 0 || (sequence & 1) != 0) {
+        return false;
+    }
+
+    uint64_t address_words[2];
+    PackAddress(address, address_words);
+
+    bool matches = slot.generation.load(std::memory_order_relaxed) ==
+                       g_configuration_generation.load(std::memory_order_acquire) &&
+                   slot.address_length.load(std::memory_order_relaxed) == address.length &&
+                   slot.address[0].load(std::memory_order_relaxed) == address_words[0] &&
+                   slot.address[1].load(std::memory_order_relaxed) == address_words[1];
+    if (!matches) {
+        return false;
+    }
+
+    uint64_t hostname_words[kHostnameWords];
+    for (size_t i = 0; i < kHostnameWords; i++) {
+        hostname_words[i] = slot.hostname[i].load(std::memory_order_relaxed);
+    }
+
+    // Discard the copy if a writer touched the slot meanwhile
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+        return false;
+    }
+
+    memcpy(hostname, hostname_words, kDnsBindingMaxHostnameLength + 1);
+    hostname[kDnsBindingMaxHostnameLength] = '\0';
+    return true;
+}
@@ -6,12 +6,18 @@
  * ## Interception Strategy
  *
  * 1. Store original function pointers when NativeMethodBindCallback is called
- * 2. Replace with our wrapper functions
+ * 2. Replace with our wrapper functions, generated by Interceptor<Traits> (interceptor.h)
  * 3. Wrapper functions:
- *    - Get NetworkConfiguration from thread-local storage (via JNI call to Kotlin)
- *    - Check if DNS lookup is allowed for the hostname
- *    - If blocked: throw NetworkRequestAttemptedException
- *    - If allowed: call original native function
+ *    - Before NetworkBlockerContext registers, enforce the policy image if one is loaded
+ *    - Check if the current thread has an active configuration (via JNI call to Kotlin)
+ *    - Check if DNS lookup is allowed for the hostname by the native host policy (no upcall)
+ *    - If blocked: ask NetworkBlockerContext.evaluate() once; throw only if it still blocks
+ *    - If allowed: call original native function and record the resolved
+ *      addresses in the forward-DNS binding table (used by the socket interceptor)
+ *    - If the hostname is overridden, return its synthetic addresses without calling
+ *      the original (see host_overrides.h)
+ *    - If the test enabled the DNS result cache, serve repeated allowed lookups
+ *      from it instead of the original (see dns_result_cache.h)
  *
  * ## Target Methods
  *
@@ -40,38 +46,126 @@
  */
 
 #include "agent.h"
+#include "dns_binding_table.h"
+#include "dns_result_cache.h"
+#include "host_overrides.h"
+#include "host_policy.h"
+#include "interceptor.h"
+#include "policy_image.h"
+#include "trace_buffer.h"
 #include <cstring>
-#include <unistd.h>  // for usleep()
+
+// Category for DEBUG_LOG/DEBUG_LOGF in this file
+static constexpr LogCategory kLogCategory = LogCategory::Dns;
 
 // Function pointer types for lookupAllHostAddr()
 // Signature: (Ljava/lang/String;)[Ljava/net/InetAddress;
-typedef jobjectArray (*LookupAllHostAddrFunc)(JNIEnv*, jobject, jstring);
+typedef jobjectArray (JNICALL *LookupAllHostAddrFunc)(JNIEnv*, jobject, jstring);
+
+/**
+ * Record a forward-DNS binding for every address a lookup returned.
+ *
+ * @param env JNI environment
+ * @param fields Cached InetAddress field IDs
+ * @param addresses InetAddress[] returned by the original lookupAllHostAddr()
+ * @param hostname Hostname that was resolved
+ */
+static void RecordDnsBindings(
+    JNIEnv* env,
+    const InetAddressFields& fields,
+    jobjectArray addresses,
+    const char* hostname
+) {
+    jsize count = env->GetArrayLength(addresses);
+    for (jsize i = 0; i < count; i++) {
+        jobject address = env->GetObjectArrayElement(addresses, i);
+        InetAddressBytes bytes;
+        if (DecodeInetAddress(env, fields, address, &bytes)) {
+            RecordDnsBinding(bytes, hostname);
+        }
+        env->DeleteLocalRef(address);
+    }
+    DEBUG_LOGF("Recorded %d DNS binding(s) for %s", (int)count, hostname);
+}
+
+/**
+ * Resolve a hostname under the policy image (before NetworkBlockerContext registers).
+ *
+ * A blocked lookup throws java.net.UnknownHostException, which is what the caller
+ * would see for a host that doesn't resolve. Allowed lookups record their DNS
+ * bindings so the socket interceptor can match hostname rules for the connect.
+ *
+ * @return Array of InetAddress objects, or nullptr if an exception is pending
+ */
+static jobjectArray LookupUnderPolicyImage(
+    JNIEnv* env,
+    jobject obj,
+    jstring hostname,
+    LookupAllHostAddrFunc original,
+    const AgentContext* agentContext,
+    const HostPolicy& policy,
+    InterceptTrace& trace
+) {
+    const char* hostCStr = nullptr;
+    if (hostname != nullptr && EnsurePlatformEncodingReady(env)) {
+        hostCStr = env->GetStringUTFChars(hostname, nullptr);
+        if (hostCStr == nullptr && env->ExceptionCheck()) {
+            env->ExceptionClear();
+        }
+    }
+    trace.Host(hostCStr);
+
+    if (hostCStr != nullptr && !EvaluateDnsPolicy(policy, hostCStr) &&
+        agentContext->unknown_host_exception_class != nullptr) {
+        DEBUG_LOGF("DNS lookup for %s blocked by policy image", hostCStr);
+        trace.Decide(TracePath::PolicyImage, TraceVerdict::Blocked);
+
+        char message[kDnsBindingMaxHostnameLength + 64];
+        snprintf(message, sizeof(message), "%s: blocked by junit-airgap (policy image)", hostCStr);
+        env->ReleaseStringUTFChars(hostname, hostCStr);
+        if (!env->ExceptionCheck()) {
+            env->ThrowNew(agentContext->unknown_host_exception_class, message);
+        }
+        return nullptr;
+    }
 
-// Storage for original function pointers
-static LookupAllHostAddrFunc original_Inet6_lookupAllHostAddr = nullptr;
-static LookupAllHostAddrFunc original_Inet4_lookupAllHostAddr = nullptr;
+    trace.Decide(TracePath::PolicyImage, TraceVerdict::Allowed);
+    jobjectArray addresses = original != nullptr ? original(env, obj, hostname) : nullptr;
+    if (hostCStr != nullptr) {
+        if (addresses != nullptr && !env->ExceptionCheck() && agentContext->inet_address.get_address != nullptr) {
+            RecordDnsBindings(env, agentContext->inet_address, addresses, hostCStr);
+        }
+        env->ReleaseStringUTFChars(hostname, hostCStr);
+    }
+    return addresses;
+}
 
 /**
- * Wrapper for Inet6AddressImpl.lookupAllHostAddr() and Inet4AddressImpl.lookupAllHostAddr()
+ * Armed path of the Inet6AddressImpl.lookupAllHostAddr() and
+ * Inet4AddressImpl.lookupAllHostAddr() wrappers
  *
  * This wrapper intercepts DNS resolution attempts and checks configuration
  * before allowing the lookup to proceed.
  *
  * @param env JNI environment
+ * @param trace Trace record for this call
  * @param obj InetAddressImpl instance
  * @param hostname Hostname to resolve
  * @param original Original native function to call if allowed
+ * @param target Interception target
  * @param impl_name Name of implementation (for debug logging)
  * @return Array of InetAddress objects, or nullptr if exception thrown
  */
-static jobjectArray wrapped_lookupAllHostAddr(
+static jobjectArray InterceptLookupAllHostAddr(
     JNIEnv* env,
+    InterceptTrace& trace,
     jobject obj,
     jstring hostname,
     LookupAllHostAddrFunc original,
+    InterceptTarget target,
     const char* impl_name
 ) {
-    DEBUG_LOGF("wrapped_lookupAllHostAddr(%s) called", impl_name);
+    DEBUG_LOGF("%s.lookupAllHostAddr() called", impl_name);
 
     // IMPORTANT: Platform encoding initialization happens AFTER VM_INIT
     // Even though VM_INIT completes, platform encoding may not be ready yet
@@ -81,6 +175,7 @@ static jobjectArray wrapped_lookupAllHostAddr(
     // Check 1: VM_INIT must be complete (basic JVM initialization)
     if (!g_vm_init_complete) {
         DEBUG_LOG("VM_INIT not complete - allowing DNS without interception");
+        trace.Decide(TracePath::VmInitPending, TraceVerdict::Allowed);
         if (original != nullptr) {
             return original(env, obj, hostname);
         }
@@ -88,9 +183,17 @@ static jobjectArray wrapped_lookupAllHostAddr(
     }
 
     // Check 2: NetworkBlockerContext must be registered (platform encoding ready)
-    jclass contextClass = GetNetworkBlockerContextClass();
+    // Single lock-free load of the cached class/method/string references
+    const AgentContext* agentContext = GetAgentContext();
+    jclass contextClass = agentContext->network_blocker_context_class;
     if (contextClass == nullptr) {
+        const HostPolicy* imagePolicy = GetPolicyImagePolicy();
+        if (imagePolicy != nullptr) {
+            return LookupUnderPolicyImage(env, obj, hostname, original, agentContext, *imagePolicy, trace);
+        }
+
         DEBUG_LOG("NetworkBlockerContext not registered - allowing DNS without interception (platform encoding may not be ready)");
+        trace.Decide(TracePath::Unregistered, TraceVerdict::Allowed);
         if (original != nullptr) {
             return original(env, obj, hostname);
         }
@@ -100,22 +203,31 @@ static jobjectArray wrapped_lookupAllHostAddr(
     // Both VM_INIT and NetworkBlockerContext ready - safe to proceed
     DEBUG_LOG("VM_INIT complete and NetworkBlockerContext registered - proceeding with DNS interception");
 
-    // Check 3: Is there an active configuration? (optimization to skip string extraction)
+    // Check 3: Is any configuration set anywhere in the JVM? (one relaxed atomic load)
+    // If not, skip the activeContextId() upcall and take the no-configuration path.
+    // The wrapper's gate already took this path unless the agent is tracing or this
+    // thread hasn't seen platform encoding working yet.
+    //
+    // Check 4: Which test context is this thread in, if any? (optimization to skip string extraction)
     // If no configuration is set (e.g., @AllowNetworkRequests tests), we can skip all
     // JNI string operations and immediately allow the DNS lookup. This avoids platform
     // encoding issues in edge cases where VM_INIT is complete but platform encoding
     // might not be fully ready for all string operations.
-    jmethodID hasActiveConfigMethod = GetHasActiveConfigurationMethod();
-    if (hasActiveConfigMethod == nullptr) {
-        // Method not registered yet - assume no configuration and allow
-        DEBUG_LOG("hasActiveConfiguration method not registered - allowing DNS without interception");
-        if (original != nullptr) {
-            return original(env, obj, hostname);
+    bool hasConfig = false;
+    int64_t contextId = 0;
+    if (IsAgentDisarmed()) {
+        DEBUG_LOG("Agent disarmed - skipping activeContextId()");
+        trace.Decide(TracePath::Disarmed, TraceVerdict::Allowed);
+    } else {
+        uint64_t upcallStart = trace.BeginUpcall();
+        hasConfig = ResolveThreadContext(env, agentContext, &contextId);
+        trace.EndUpcall(upcallStart);
+        trace.Context(contextId);
+        if (!hasConfig) {
+            trace.Decide(TracePath::NoConfiguration, TraceVerdict::Allowed);
         }
-        return nullptr;
     }
 
-    jboolean hasConfig = env->CallStaticBooleanMethod(contextClass, hasActiveConfigMethod);
     if (!hasConfig) {
         DEBUG_LOG("No active configuration - allowing DNS without interception");
 
@@ -127,8 +239,10 @@ static jobjectArray wrapped_lookupAllHostAddr(
         if (!EnsurePlatformEncodingReady(env)) {
             DEBUG_LOG("Failed to ensure platform encoding ready - cannot call original DNS function");
             // Throw exception to indicate the issue
-            jclass exClass = env->FindClass("java/lang/InternalError");
-            if (exClass != nullptr) {
+            jclass exClass = agentContext->internal_error_class != nullptr
+                ? agentContext->internal_error_class
+                : env->FindClass("java/lang/InternalError");
+            if (exClass != nullptr && !env->ExceptionCheck()) {
                 env->ThrowNew(exClass, "Platform encoding not ready for DNS resolution");
             }
             return nullptr;
@@ -152,53 +266,100 @@ static jobjectArray wrapped_lookupAllHostAddr(
             DEBUG_LOGF("DNS resolution attempt for hostname: %s", hostCStr);
         }
     }
+    trace.Host(hostCStr);
 
-    // Check NetworkConfiguration via JNI call to Kotlin
-    // IMPORTANT: checkConnection() returns silently if no config (inter-test period)
-    // It only throws if there IS a config AND connection is blocked
-    if (hostname != nullptr && hostCStr != nullptr) {
-        // Get checkConnectionMethod (contextClass already verified above)
-        jmethodID checkConnectionMethod = GetCheckConnectionMethod();
+    // Evaluate the lookup against the native host policy (no upcall when allowed).
+    // A block asks NetworkBlockerContext.evaluate() once; it allows the lookup between
+    // tests (no config) and for infrastructure exemptions, otherwise the exception it
+    // builds is thrown (see ConfirmBlockedRequest()).
+    bool cacheResult = false;
+    if (hostname != nullptr && hostCStr != nullptr && !EvaluateDnsPolicy(hostCStr, contextId)) {
+        DEBUG_LOG("DNS lookup blocked by native policy - asking NetworkBlockerContext");
 
-        if (checkConnectionMethod != nullptr) {
-            DEBUG_LOG("Calling NetworkBlockerContext.checkConnection() for DNS");
+        // Get cached caller string (initialized during VM_INIT)
+        jstring callerString = agentContext->caller_dns_string;
 
-            // Get cached caller string (initialized during VM_INIT)
-            jstring callerString = GetCallerDnsString();
+        // No address and port -1 (DNS doesn't have a port)
+        uint64_t upcallStart = trace.BeginUpcall();
+        bool blocked = ConfirmBlockedRequest(env, agentContext, hostname, nullptr, -1, callerString, true);
+        trace.EndUpcall(upcallStart);
 
-            // Call checkConnection with port -1 (DNS doesn't have a port)
-            // This will throw NetworkRequestAttemptedException if blocked
-            env->CallStaticVoidMethod(contextClass, checkConnectionMethod, hostname, -1, callerString);
+        // A block without a published policy was decided by NetworkBlockerContext
+        TracePath decidedBy = GetContextPolicyId(contextId) == 0 ? TracePath::Java : TracePath::Policy;
 
-            // Check if exception was thrown
-            if (env->ExceptionCheck()) {
-                DEBUG_LOGF("DNS resolution blocked for: %s", hostCStr);
-                // Release hostname string before returning
-                env->ReleaseStringUTFChars(hostname, hostCStr);
-                // Exception will propagate to Java
-                return nullptr;
-            }
+        if (blocked) {
+            DEBUG_LOGF("DNS resolution blocked for: %s", hostCStr);
+            trace.Decide(decidedBy, TraceVerdict::Blocked);
+            // Release hostname string before returning
+            env->ReleaseStringUTFChars(hostname, hostCStr);
+            // Exception will propagate to Java
+            return nullptr;
+        }
 
-            DEBUG_LOGF("DNS resolution allowed for: %s", hostCStr);
-        } else {
-            DEBUG_LOG("checkConnectionMethod not available - allowing DNS");
+        DEBUG_LOGF("DNS resolution allowed by NetworkBlockerContext for: %s", hostCStr);
+        trace.Decide(decidedBy, TraceVerdict::Allowed);
+    } else if (hostCStr != nullptr) {
+        DEBUG_LOGF("DNS resolution allowed by native policy for: %s", hostCStr);
+
+        // Hosts overrides (NetworkConfiguration.hostOverrides): answer with the
+        // synthetic addresses and never call the original resolver
+        jobjectArray synthetic = nullptr;
+        if (HasHostOverrides() &&
+            LookupHostOverride(env, contextId, hostCStr, target == InterceptTarget::Inet4LookupAllHostAddr, &synthetic)) {
+            DEBUG_LOGF("DNS resolution answered by hosts override for: %s", hostCStr);
+            trace.Decide(TracePath::HostOverride, TraceVerdict::Allowed);
+            if (synthetic != nullptr) {
+                RecordDnsBindings(env, agentContext->inet_address, synthetic, hostCStr);
+            } else if (!env->ExceptionCheck() && agentContext->unknown_host_exception_class != nullptr) {
+                env->ThrowNew(agentContext->unknown_host_exception_class, hostCStr);
+            }
+            env->ReleaseStringUTFChars(hostname, hostCStr);
+            return synthetic;
         }
-    }
 
-    // Release hostname string
-    if (hostname != nullptr && hostCStr != nullptr) {
-        env->ReleaseStringUTFChars(hostname, hostCStr);
+        // Opt-in DNS result cache (NetworkConfiguration.dnsCacheTtlMillis):
+        // a hit answers the lookup without calling the original resolver
+        if (IsDnsResultCacheEnabled(contextId)) {
+            cacheResult = true;
+            jobjectArray cached = LookupDnsResult(env, contextId, target, hostCStr);
+            if (cached != nullptr) {
+                DEBUG_LOGF("DNS resolution served from the result cache for: %s", hostCStr);
+                trace.Decide(TracePath::DnsCache, TraceVerdict::Allowed);
+                RecordDnsBindings(env, agentContext->inet_address, cached, hostCStr);
+                env->ReleaseStringUTFChars(hostname, hostCStr);
+                return cached;
+            }
+        }
+        trace.Decide(TracePath::Policy, TraceVerdict::Allowed);
     }
 
     // STEP 2: Connection is allowed - call original DNS resolution
-    // If checkConnection() didn't throw, the connection is allowed
+    // Either the native policy or NetworkBlockerContext allowed it
     // The VM_INIT and NetworkBlockerContext registration checks above already
     // prevent calling this function during JVM initialization when platform
     // encoding might not be ready
     if (original != nullptr) {
         DEBUG_LOGF("Calling original %s.lookupAllHostAddr()", impl_name);
-        return original(env, obj, hostname);
+        jobjectArray addresses = original(env, obj, hostname);
+
+        // STEP 3: Remember which hostname produced these addresses, so the socket
+        // interceptor can match hostname rules without reverse DNS
+        if (addresses != nullptr && hostCStr != nullptr && !env->ExceptionCheck()) {
+            RecordDnsBindings(env, agentContext->inet_address, addresses, hostCStr);
+            if (cacheResult) {
+                StoreDnsResult(env, contextId, target, hostCStr, addresses);
+            }
+        }
+
+        if (hostname != nullptr && hostCStr != nullptr) {
+            env->ReleaseStringUTFChars(hostname, hostCStr);
+        }
+        return addresses;
     } else {
+        if (hostname != nullptr && hostCStr != nullptr) {
+            env->ReleaseStringUTFChars(hostname, hostCStr);
+        }
+
         DEBUG_LOGF("ERROR: Original %s.lookupAllHostAddr() not found!", impl_name);
         // Throw exception if we don't have the original function
         jclass exClass = env->FindClass("java/lang/UnsupportedOperationException");
@@ -210,26 +371,28 @@ static jobjectArray wrapped_lookupAllHostAddr(
 }
 
 /**
- * Wrapper for Inet6AddressImpl.lookupAllHostAddr()
+ * lookupAllHostAddr() of one InetAddressImpl; the JDK binds one of the two.
+ *
+ * The original JDK resolver converts the hostname with this thread's platform
+ * encoding, so the gate also requires this thread to have seen it working.
  */
-jobjectArray JNICALL wrapped_Inet6_lookupAllHostAddr(
-    JNIEnv* env,
-    jobject obj,
-    jstring hostname
-) {
-    return wrapped_lookupAllHostAddr(env, obj, hostname, original_Inet6_lookupAllHostAddr, "Inet6AddressImpl");
-}
+template <InterceptTarget Target>
+struct LookupAllHostAddrTraits {
+    static constexpr InterceptTarget kTarget = Target;
+    using Signature = jobjectArray(JNIEnv*, jobject, jstring);
+    static constexpr bool kNeedsPlatformEncoding = true;
 
-/**
- * Wrapper for Inet4AddressImpl.lookupAllHostAddr()
- */
-jobjectArray JNICALL wrapped_Inet4_lookupAllHostAddr(
-    JNIEnv* env,
-    jobject obj,
-    jstring hostname
-) {
-    return wrapped_lookupAllHostAddr(env, obj, hostname, original_Inet4_lookupAllHostAddr, "Inet4AddressImpl");
-}
+    static jobjectArray Intercept(JNIEnv* env, InterceptTrace& trace, LookupAllHostAddrFunc original,
+                                  jobject obj, jstring hostname) {
+        const char* implName = Target == InterceptTarget::Inet4LookupAllHostAddr
+            ? "Inet4AddressImpl"
+            : "Inet6AddressImpl";
+        return InterceptLookupAllHostAddr(env, trace, obj, hostname, original, Target, implName);
+    }
+};
+
+using Inet6LookupInterceptor = Interceptor<LookupAllHostAddrTraits<InterceptTarget::Inet6LookupAllHostAddr>>;
+using Inet4LookupInterceptor = Interceptor<LookupAllHostAddrTraits<InterceptTarget::Inet4LookupAllHostAddr>>;
 
 /**
  * Install the wrapper for Inet6AddressImpl.lookupAllHostAddr()
@@ -241,8 +404,7 @@ jobjectArray JNICALL wrapped_Inet4_lookupAllHostAddr(
  */
 void* InstallInet6LookupWrapper(void* original_address) {
     DEBUG_LOG("Installing wrapper for Inet6AddressImpl.lookupAllHostAddr()");
-    original_Inet6_lookupAllHostAddr = (LookupAllHostAddrFunc)original_address;
-    return (void*)wrapped_Inet6_lookupAllHostAddr;
+    return Inet6LookupInterceptor::Install(original_address);
 }
 
 /**
@@ -255,6 +417,5 @@ void* InstallInet6LookupWrapper(void* original_address) {
  */
 void* InstallInet4LookupWrapper(void* original_address) {
     DEBUG_LOG("Installing wrapper for Inet4AddressImpl.lookupAllHostAddr()");
-    original_Inet4_lookupAllHostAddr = (LookupAllHostAddrFunc)original_address;
-    return (void*)wrapped_Inet4_lookupAllHostAddr;
+    return Inet4LookupInterceptor::Install(original_address);
 }
@@ -0,0 +1,243 @@
+/**
+ * DNS Result Cache for junit-airgap JVMTI Agent
+ *
+ * See dns_result_cache.h. One JVM-wide map guarded by a mutex: lookups are rare next to
+ * connects and every hit replaces a call into the platform resolver, so a lock held for
+ * a hash lookup and an array copy is cheap by comparison. Nothing here runs unless a
+ * test enabled the cache.
+ *
+ * Global refs are only created and deleted by threads that hold a JNIEnv (the lookup
+ * wrappers and the policy JNI entry points), so every entry is released in the JVM it
+ * came from.
+ */
+
+#include "agent.h"
+#include "dns_result_cache.h"
+#include "host_policy.h"
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Category for DEBUG_LOG/DEBUG_LOGF in this file
+static constexpr LogCategory kLogCategory = LogCategory::Dns;
+
+/**
+ * One cached lookup result.
+ */
+struct DnsResultEntry {
+    jobjectArray addresses;  // Global ref
+    int64_t context_id;
+    int64_t generation;
+    uint64_t policy_id;
+    int64_t expires_ns;      // steady_clock deadline
+};
+
+// Whether any policy has enabled the cache (never reset; the TTL itself is per policy)
+static std::atomic<bool> g_dns_cache_used{false};
+
+static std::mutex g_dns_cache_mutex;
+static std::unordered_map<std::string, DnsResultEntry> g_dns_cache;
+
+// java.lang.InetAddress (global ref), the element type of copied results
+static jclass g_inet_address_class = nullptr;
+
+// Counters on separate cache lines to avoid false sharing between them
+struct alignas(64) DnsResultCacheCounter {
+    std::atomic<uint64_t> value{0};
+};
+static DnsResultCacheCounter g_dns_cache_hits;
+static DnsResultCacheCounter g_dns_cache_misses;
+
+static int64_t NowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Key of (context, hostname, InetAddressImpl): the context id bytes and the target byte,
+ * followed by the hostname.
+ */
+static std::string CacheKey(int64_t context_id, InterceptTarget target, const char* hostname) {
+    std::string key((const char*)&context_id, sizeof(context_id));
+    key += (char)target;
+    key += hostname;
+    return key;
+}
+
+static bool IsLive(const DnsResultEntry& entry, int64_t now) {
+    return entry.generation == g_configuration_generation.load(std::memory_order_acquire) &&
+           entry.policy_id == GetContextPolicyId(entry.context_id) &&
+           now < entry.expires_ns;
+}
+
+/**
+ * Copy an InetAddress[] into a new local array (the elements are shared).
+ */
+static jobjectArray CopyAddresses(JNIEnv* env, jobjectArray addresses) {
+    jsize count = env->GetArrayLength(addresses);
+    jobjectArray copy = env->NewObjectArray(count, g_inet_address_class, nullptr);
+    if (copy == nullptr) {
+        return nullptr;
+    }
+    for (jsize i = 0; i < count; i++) {
+        jobject address = env->GetObjectArrayElement(addresses, i);
+        env->SetObjectArrayElement(copy, i, address);
+        env->DeleteLocalRef(address);
+    }
+    return copy;
+}
+
+bool PrepareDnsResultCache(JNIEnv* env) {
+    std::lock_guard<std::mutex> lock(g_dns_cache_mutex);
+    if (g_inet_address_class == nullptr) {
+        jclass local_class = env->FindClass("java/net/InetAddress");
+        if (local_class == nullptr) {
+            env->ExceptionClear();
+            fprintf(stderr, "[junit-airgap:native] WARNING: java.net.InetAddress not found - DNS result cache disabled\n");
+            return false;
+        }
+        g_inet_address_class = (jclass)env->NewGlobalRef(local_class);
+        env->DeleteLocalRef(local_class);
+    }
+    g_dns_cache_used.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+bool IsDnsResultCacheEnabled(int64_t context_id) {
+    if (!g_dns_cache_used.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    std::shared_ptr<const HostPolicy> policy = GetContextPolicy(context_id);
+    return policy != nullptr && policy->dns_cache_ttl_ns > 0;
+}
+
+jobjectArray LookupDnsResult(JNIEnv* env, int64_t context_id, InterceptTarget target, const char* hostname) {
+    std::string key = CacheKey(context_id, target, hostname);
+    int64_t now = NowNanos();
+
+    std::lock_guard<std::mutex> lock(g_dns_cache_mutex);
+    auto it = g_dns_cache.find(key);
+    if (it == g_dns_cache.end()) {
+        g_dns_cache_misses.value.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    if (!IsLive(it->second, now)) {
+        env->DeleteGlobalRef(it->second.addresses);
+        g_dns_cache.erase(it);
+        g_dns_cache_misses.value.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    jobjectArray copy = CopyAddresses(env, it->second.addresses);
+    if (copy == nullptr) {
+        // OutOfMemoryError pending: let the caller resolve normally after clearing it
+        env->ExceptionClear();
+        g_dns_cache_misses.value.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    g_dns_cache_hits.value.fetch_add(1, std::memory_order_relaxed);
+    return copy;
+}
+
+void StoreDnsResult(JNIEnv* env, int64_t context_id, InterceptTarget target, const char* hostname,
+                    jobjectArray addresses) {
+    std::shared_ptr<const HostPolicy> policy = GetContextPolicy(context_id);
+    if (policy == nullptr || policy->dns_cache_ttl_ns <= 0) {
+        return;
+    }
+
+    std::string key = CacheKey(context_id, target, hostname);
+    int64_t now = NowNanos();
+
+    std::lock_guard<std::mutex> lock(g_dns_cache_mutex);
+    if (g_inet_address_class == nullptr) {
+        return;
+    }
+
+    auto existing = g_dns_cache.find(key);
+    if (existing != g_dns_cache.end()) {
+        env->DeleteGlobalRef(existing->second.addresses);
+        g_dns_cache.erase(existing);
+    } else if (g_dns_cache.size() >= kDnsResultCacheMaxEntries) {
+        // Make room by dropping stale and expired entries; keep live ones
+        for (auto it = g_dns_cache.begin(); it != g_dns_cache.end();) {
+            if (IsLive(it->second, now)) {
+                ++it;
+            } else {
+                env->DeleteGlobalRef(it->second.addresses);
+                it = g_dns_cache.erase(it);
+            }
+        }
+        if (g_dns_cache.size() >= kDnsResultCacheMaxEntries) {
+            DEBUG_LOGF("DNS result cache full - not caching %s", hostname);
+            return;
+        }
+    }
+
+    jobjectArray global = (jobjectArray)env->NewGlobalRef(addresses);
+    if (global == nullptr) {
+        return;
+    }
+    g_dns_cache.emplace(std::move(key), DnsResultEntry{
+        global,
+        context_id,
+        g_configuration_generation.load(std::memory_order_acquire),
+        policy->id,
+        now + policy->dns_cache_ttl_ns,
+    });
+    DEBUG_LOGF("Cached DNS result for %s (context %lld)", hostname, (long long)context_id);
+}
+
+void FlushDnsResults(JNIEnv* env, int64_t context_id) {
+    std::lock_guard<std::mutex> lock(g_dns_cache_mutex);
+    for (auto it = g_dns_cache.begin(); it != g_dns_cache.end();) {
+        if (it->second.context_id == context_id) {
+            env->DeleteGlobalRef(it->second.addresses);
+            it = g_dns_cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void FlushAllDnsResults(JNIEnv* env) {
+    std::lock_guard<std::mutex> lock(g_dns_cache_mutex);
+    for (auto& item : g_dns_cache) {
+        env->DeleteGlobalRef(item.second.addresses);
+    }
+    g_dns_cache.clear();
+}
+
+uint64_t GetDnsResultCacheHits() {
+    return g_dns_cache_hits.value.load(std::memory_order_relaxed);
+}
+
+uint64_t GetDnsResultCacheMisses() {
+    return g_dns_cache_misses.value.load(std::memory_order_relaxed);
+}
+
+/**
+ * Get DNS result cache statistics.
+ *
+ * Java signature: private external fun getAgentDnsCacheStats(): LongArray
+ * JNI signature: ()[J
+ *
+ * @return long[2] = { hits, misses }
+ */
+JNIEXPORT jlongArray JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_getAgentDnsCacheStats(
+    JNIEnv* env,
+    jclass clazz
+) {
+    jlong stats[2] = {
+        (jlong)GetDnsResultCacheHits(),
+        (jlong)GetDnsResultCacheMisses(),
+    };
+
+    jlongArray result = env->NewLongArray(2);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, 2, stats);
+    }
+    return result;
+}
@@ -0,0 +1,257 @@
+/**
+ * Native Hosts Override Table for junit-airgap JVMTI Agent
+ *
+ * See host_overrides.h. A context's table is only replaced from setAgentHostOverrides()
+ * (once per setConfiguration()/clearConfiguration()) and read by the DNS wrappers, so a mutex
+ * held for a hash lookup and an array build is enough. Lookups skip it entirely while
+ * no override is installed.
+ */
+
+#include "agent.h"
+#include "host_overrides.h"
+#include "host_policy.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Category for DEBUG_LOG/DEBUG_LOGF in this file
+static constexpr LogCategory kLogCategory = LogCategory::Dns;
+
+/**
+ * One synthetic address of an overridden hostname.
+ */
+struct HostOverrideAddress {
+    jobject address;  // InetAddress (global ref)
+    bool ipv4;
+};
+
+static std::atomic<bool> g_host_overrides_active{false};
+
+using HostOverrideTable = std::unordered_map<std::string, std::vector<HostOverrideAddress>>;
+
+static std::mutex g_host_overrides_mutex;
+// Tables by test context id; lookups in context 0 use g_latest_override_context's
+static std::unordered_map<int64_t, HostOverrideTable> g_host_overrides;
+static int64_t g_latest_override_context = 0;
+
+// java.net.InetAddress (global ref) and InetAddress.getByAddress(String, byte[])
+static jclass g_inet_address_class = nullptr;
+static jmethodID g_get_by_address_method = nullptr;
+
+/**
+ * Parse an IPv4 or IPv6 literal ("127.0.0.1", "::1", "[::1]").
+ *
+ * @param literal Address literal
+ * @param bytes Output buffer of 16 bytes
+ * @return Number of address bytes (4 or 16), or 0 if literal is not an IP address
+ */
+static int ParseAddressLiteral(const char* literal, uint8_t bytes[16]) {
+    if (inet_pton(AF_INET, literal, bytes) == 1) {
+        return 4;
+    }
+
+    std::string unbracketed(literal);
+    if (unbracketed.size() > 2 && unbracketed.front() == '[' && unbracketed.back() == ']') {
+        unbracketed = unbracketed.substr(1, unbracketed.size() - 2);
+    }
+    if (inet_pton(AF_INET6, unbracketed.c_str(), bytes) == 1) {
+        return 16;
+    }
+    return 0;
+}
+
+/**
+ * Build InetAddress.getByAddress(hostname, bytes) as a global ref.
+ *
+ * @return Global ref, or nullptr on failure (no exception left pending)
+ */
+static jobject NewSyntheticAddress(JNIEnv* env, jstring hostname, const uint8_t* bytes, int length) {
+    jbyteArray raw = env->NewByteArray(length);
+    if (raw == nullptr) {
+        env->ExceptionClear();
+        return nullptr;
+    }
+    env->SetByteArrayRegion(raw, 0, length, (const jbyte*)bytes);
+
+    jobject local = env->CallStaticObjectMethod(g_inet_address_class, g_get_by_address_method, hostname, raw);
+    env->DeleteLocalRef(raw);
+    if (env->ExceptionCheck() || local == nullptr) {
+        env->ExceptionClear();
+        return nullptr;
+    }
+
+    jobject global = env->NewGlobalRef(local);
+    env->DeleteLocalRef(local);
+    return global;
+}
+
+/**
+ * Drop a context's overrides and release their global refs. Caller holds g_host_overrides_mutex.
+ */
+static void ClearLocked(JNIEnv* env, int64_t context_id) {
+    auto table = g_host_overrides.find(context_id);
+    if (table != g_host_overrides.end()) {
+        for (auto& item : table->second) {
+            for (HostOverrideAddress& entry : item.second) {
+                env->DeleteGlobalRef(entry.address);
+            }
+        }
+        g_host_overrides.erase(table);
+    }
+    if (g_latest_override_context == context_id) {
+        g_latest_override_context = 0;
+    }
+    g_host_overrides_active.store(!g_host_overrides.empty(), std::memory_order_relaxed);
+}
+
+/**
+ * Cache InetAddress and getByAddress() on first use. Caller holds g_host_overrides_mutex.
+ */
+static bool EnsureInetAddressReferences(JNIEnv* env) {
+    if (g_get_by_address_method != nullptr) {
+        return true;
+    }
+
+    jclass local_class = env->FindClass("java/net/InetAddress");
+    if (local_class == nullptr) {
+        env->ExceptionClear();
+        return false;
+    }
+    jmethodID method = env->GetStaticMethodID(local_class, "getByAddress", "(Ljava/lang/String;[B)Ljava/net/InetAddress;");
+    if (method == nullptr) {
+        env->ExceptionClear();
+        env->DeleteLocalRef(local_class);
+        return false;
+    }
+
+    g_inet_address_class = (jclass)env->NewGlobalRef(local_class);
+    env->DeleteLocalRef(local_class);
+    g_get_by_address_method = method;
+    return g_inet_address_class != nullptr;
+}
+
+bool HasHostOverrides() {
+    return g_host_overrides_active.load(std::memory_order_relaxed);
+}
+
+bool LookupHostOverride(JNIEnv* env, int64_t context_id, const char* hostname, bool ipv4_only, jobjectArray* addresses) {
+    *addresses = nullptr;
+    std::string key = NormalizeHost(hostname);
+
+    std::lock_guard<std::mutex> lock(g_host_overrides_mutex);
+    auto table = g_host_overrides.find(context_id != 0 ? context_id : g_latest_override_context);
+    if (table == g_host_overrides.end()) {
+        return false;
+    }
+    auto it = table->second.find(key);
+    if (it == table->second.end()) {
+        return false;
+    }
+
+    jsize count = 0;
+    for (const HostOverrideAddress& entry : it->second) {
+        if (entry.ipv4 || !ipv4_only) {
+            count++;
+        }
+    }
+    if (count == 0) {
+        return true;
+    }
+
+    jobjectArray result = env->NewObjectArray(count, g_inet_address_class, nullptr);
+    if (result == nullptr) {
+        return true;
+    }
+    jsize index = 0;
+    for (const HostOverrideAddress& entry : it->second) {
+        if (entry.ipv4 || !ipv4_only) {
+            env->SetObjectArrayElement(result, index++, entry.address);
+        }
+    }
+    *addresses = result;
+    return true;
+}
+
+/**
+ * Install the hosts overrides of a test context, replacing any previous ones.
+ *
+ * Addresses that are not IP literals are skipped with a warning (an override must never
+ * need the resolver). Empty arrays clear the context's table.
+ *
+ * Called from NetworkBlockerContext.setConfiguration() and clearConfiguration().
+ *
+ * Java signature: private external fun setAgentHostOverrides(contextId: Long, hostnames: Array<String>, addresses: Array<String>)
+ * JNI signature: (J[Ljava/lang/String;[Ljava/lang/String;)V
+ *
+ * @param contextId Test context the overrides belong to
+ * @param hostnames Overridden hostnames
+ * @param addresses IP literal for each hostname (same index)
+ */
+JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_setAgentHostOverrides(
+    JNIEnv* env,
+    jclass clazz,
+    jlong contextId,
+    jobjectArray hostnames,
+    jobjectArray addresses
+) {
+    std::lock_guard<std::mutex> lock(g_host_overrides_mutex);
+    ClearLocked(env, contextId);
+
+    jsize count = hostnames != nullptr && addresses != nullptr ? env->GetArrayLength(hostnames) : 0;
+    if (count == 0) {
+        DEBUG_LOG("Cleared hosts overrides");
+        return;
+    }
+    if (env->GetArrayLength(addresses) != count) {
+        fprintf(stderr, "[junit-airgap:native] ERROR: Hosts overrides have %d hostnames but %d addresses\n",
+                (int)count, (int)env->GetArrayLength(addresses));
+        return;
+    }
+    if (!EnsureInetAddressReferences(env)) {
+        fprintf(stderr, "[junit-airgap:native] ERROR: InetAddress.getByAddress() not found - hosts overrides disabled\n");
+        return;
+    }
+
+    size_t installed = 0;
+    HostOverrideTable table;
+    for (jsize i = 0; i < count; i++) {
+        jstring hostname = (jstring)env->GetObjectArrayElement(hostnames, i);
+        jstring address = (jstring)env->GetObjectArrayElement(addresses, i);
+        const char* hostChars = hostname != nullptr ? env->GetStringUTFChars(hostname, nullptr) : nullptr;
+        const char* addressChars = address != nullptr ? env->GetStringUTFChars(address, nullptr) : nullptr;
+
+        uint8_t bytes[16];
+        int length = addressChars != nullptr ? ParseAddressLiteral(addressChars, bytes) : 0;
+        if (hostChars != nullptr && length == 0) {
+            fprintf(stderr, "[junit-airgap:native] WARNING: Ignoring hosts override %s=%s (not an IP address)\n",
+                    hostChars, addressChars != nullptr ? addressChars : "null");
+        } else if (hostChars != nullptr) {
+            jobject synthetic = NewSyntheticAddress(env, hostname, bytes, length);
+            if (synthetic != nullptr) {
+                table[NormalizeHost(hostChars)].push_back(HostOverrideAddress{synthetic, length == 4});
+                installed++;
+                DEBUG_LOGF("Hosts override: %s -> %s", hostChars, addressChars);
+            }
+        }
+
+        if (hostChars != nullptr) {
+            env->ReleaseStringUTFChars(hostname, hostChars);
+        }
+        if (addressChars != nullptr) {
+            env->ReleaseStringUTFChars(address, addressChars);
+        }
+        env->DeleteLocalRef(hostname);
+        env->DeleteLocalRef(address);
+    }
+
+    if (!table.empty()) {
+        g_host_overrides[contextId] = std::move(table);
+        g_latest_override_context = contextId;
+    }
+    g_host_overrides_active.store(!g_host_overrides.empty(), std::memory_order_relaxed);
+    LOG_DEBUG(Dns, "Installed %zu hosts override(s) for context %lld", installed, (long long)contextId);
+}
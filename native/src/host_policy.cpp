@@ -0,0 +1,544 @@
+/**
+ * Native Host Policy Engine for junit-airgap JVMTI Agent
+ *
+ * Compiles NetworkConfiguration host patterns into a HostPolicy and evaluates
+ * connections and DNS lookups against it without any JNI upcalls.
+ *
+ * ## Publication
+ *
+ * The policy is an immutable snapshot held in a std::shared_ptr and swapped with
+ * std::atomic_store / std::atomic_load. setConfiguration() publishes once per test;
+ * every intercepted connect only performs an atomic load.
+ *
+ * ## Pattern Semantics
+ *
+ * These must stay in sync with HostMatcher in Kotlin: the same classification in
+ * HostPatternSet::Add(), the same glob rules, and the same IP literal parsing.
+ */
+
+#include "agent.h"
+#include "dns_result_cache.h"
+#include "host_policy.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+// Category for DEBUG_LOG/DEBUG_LOGF in this file
+static constexpr LogCategory kLogCategory = LogCategory::Policy;
+
+// Currently published policy (accessed only via std::atomic_load/atomic_store)
+static std::shared_ptr<const HostPolicy> g_host_policy;
+
+// Id of the published policy (0 = none) and id allocator
+static std::atomic<uint64_t> g_host_policy_id{0};
+static std::atomic<uint64_t> g_next_host_policy_id{1};
+
+// Per-test-context policies, indexed by context id (power of two)
+static constexpr size_t kContextPolicySlots = 64;
+
+struct ContextPolicySlot {
+    std::shared_ptr<const HostPolicy> policy;  // std::atomic_load/atomic_store only
+    std::atomic<uint64_t> policy_id{0};
+};
+
+static ContextPolicySlot g_context_policies[kContextPolicySlots];
+
+static ContextPolicySlot& ContextSlot(int64_t context_id) {
+    return g_context_policies[(uint64_t)context_id & (kContextPolicySlots - 1)];
+}
+
+std::string NormalizeHost(const char* host) {
+    std::string normalized(host);
+    for (char& c : normalized) {
+        c = (char)tolower((unsigned char)c);
+    }
+    return normalized;
+}
+
+/**
+ * Iterative with single backtrack point, O(n*m) worst case.
+ */
+bool GlobMatches(const char* pattern, size_t pattern_length, const std::string& host) {
+    size_t p = 0;
+    size_t h = 0;
+    size_t star = std::string::npos;
+    size_t star_h = 0;
+
+    while (h < host.size()) {
+        if (p < pattern_length && pattern[p] == '*') {
+            star = p++;
+            star_h = h;
+        } else if (p < pattern_length && pattern[p] == host[h]) {
+            p++;
+            h++;
+        } else if (star != std::string::npos) {
+            p = star + 1;
+            h = ++star_h;
+        } else {
+            return false;
+        }
+    }
+
+    while (p < pattern_length && pattern[p] == '*') {
+        p++;
+    }
+    return p == pattern_length;
+}
+
+static int AddressBit(const uint8_t* bytes, int bit) {
+    return (bytes[bit / 8] >> (7 - bit % 8)) & 1;
+}
+
+void CidrTree::Insert(const uint8_t* bytes, int length, int prefix_bits) {
+    std::vector<Node>& nodes = length == 4 ? ipv4 : ipv6;
+    if (nodes.empty()) {
+        nodes.emplace_back();
+    }
+
+    size_t node = 0;
+    for (int bit = 0; bit < prefix_bits; bit++) {
+        if (nodes[node].terminal) {
+            // Already covered by a shorter range
+            return;
+        }
+        int branch = AddressBit(bytes, bit);
+        if (nodes[node].children[branch] < 0) {
+            nodes[node].children[branch] = (int32_t)nodes.size();
+            nodes.emplace_back();
+        }
+        node = (size_t)nodes[node].children[branch];
+    }
+    nodes[node].terminal = true;
+}
+
+bool CidrTree::Contains(const uint8_t* bytes, int length) const {
+    const std::vector<Node>& nodes = length == 4 ? ipv4 : ipv6;
+    if (nodes.empty()) {
+        return false;
+    }
+
+    int32_t node = 0;
+    for (int bit = 0; node >= 0; bit++) {
+        if (nodes[node].terminal) {
+            return true;
+        }
+        if (bit == length * 8) {
+            return false;
+        }
+        node = nodes[node].children[AddressBit(bytes, bit)];
+    }
+    return false;
+}
+
+bool CidrTree::Empty() const {
+    return ipv4.empty() && ipv6.empty();
+}
+
+int ParseIpLiteral(const std::string& host, uint8_t bytes[16]) {
+    std::string literal = host;
+    if (literal.size() > 2 && literal.front() == '[' && literal.back() == ']') {
+        literal = literal.substr(1, literal.size() - 2);
+    }
+
+    if (inet_pton(AF_INET, literal.c_str(), bytes) == 1) {
+        return 4;
+    }
+
+    // IPv6 zone ("fe80::1%eth0") does not take part in matching
+    size_t zone = literal.find('%');
+    if (zone != std::string::npos) {
+        literal.resize(zone);
+    }
+    if (inet_pton(AF_INET6, literal.c_str(), bytes) == 1) {
+        return 16;
+    }
+    return 0;
+}
+
+/**
+ * Parse "address/prefix" with a decimal prefix of at most the address width.
+ *
+ * @return true if pattern is a CIDR range
+ */
+static bool ParseCidrPattern(const std::string& pattern, uint8_t bytes[16], int* length, int* prefix_bits) {
+    size_t slash = pattern.rfind('/');
+    if (slash == std::string::npos || slash + 1 == pattern.size() || pattern.size() - slash > 4) {
+        return false;
+    }
+    for (size_t i = slash + 1; i < pattern.size(); i++) {
+        if (!isdigit((unsigned char)pattern[i])) {
+            return false;
+        }
+    }
+
+    *length = ParseIpLiteral(pattern.substr(0, slash), bytes);
+    *prefix_bits = atoi(pattern.c_str() + slash + 1);
+    return *length != 0 && *prefix_bits <= *length * 8;
+}
+
+void HostPatternSet::Add(const std::string& raw_pattern) {
+    if (raw_pattern.empty()) {
+        return;
+    }
+
+    std::string pattern = NormalizeHost(raw_pattern.c_str());
+
+    if (pattern == "*") {
+        match_all = true;
+        return;
+    }
+
+    uint8_t bytes[16];
+    int length;
+    int prefix_bits;
+    size_t first_star = pattern.find('*');
+    if (first_star == std::string::npos && ParseCidrPattern(pattern, bytes, &length, &prefix_bits)) {
+        ranges.Insert(bytes, length, prefix_bits);
+    } else if (first_star == std::string::npos) {
+        exact.insert(pattern);
+    } else if (first_star == 0 && pattern.find('*', 1) == std::string::npos) {
+        // "*.example.com" → any host ending in ".example.com"
+        suffixes.push_back(pattern.substr(1));
+    } else {
+        globs.push_back(pattern);
+    }
+}
+
+bool HostPatternSet::Matches(const std::string& host) const {
+    if (match_all) {
+        return true;
+    }
+
+    if (exact.find(host) != exact.end()) {
+        return true;
+    }
+
+    for (const std::string& suffix : suffixes) {
+        if (host.size() >= suffix.size() &&
+            host.compare(host.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            return true;
+        }
+    }
+
+    for (const std::string& glob : globs) {
+        if (GlobMatches(glob.data(), glob.size(), host)) {
+            return true;
+        }
+    }
+
+    if (!ranges.Empty()) {
+        uint8_t bytes[16];
+        int length = ParseIpLiteral(host, bytes);
+        if (length != 0 && ranges.Contains(bytes, length)) {
+            return true;
+        }
+    }
+
+    return mapped.Matches(host);
+}
+
+bool HostPatternSet::Empty() const {
+    return !match_all && exact.empty() && suffixes.empty() && globs.empty() && ranges.Empty() && mapped.Empty();
+}
+
+bool HostPolicy::IsAllowed(const std::string& host) const {
+    // Blocked hosts take precedence
+    if (blocked.Matches(host)) {
+        return false;
+    }
+
+    // No allowed hosts means block everything
+    if (allowed.Empty()) {
+        return false;
+    }
+
+    return allowed.Matches(host);
+}
+
+bool HostPolicy::IsExplicitlyBlocked(const std::string& host) const {
+    return blocked.Matches(host);
+}
+
+void PublishHostPolicy(std::shared_ptr<const HostPolicy> policy) {
+    uint64_t id = policy != nullptr ? policy->id : 0;
+    std::atomic_store(&g_host_policy, std::move(policy));
+    g_host_policy_id.store(id, std::memory_order_release);
+}
+
+uint64_t NextHostPolicyId() {
+    return g_next_host_policy_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t GetHostPolicyId() {
+    return g_host_policy_id.load(std::memory_order_acquire);
+}
+
+std::shared_ptr<const HostPolicy> GetHostPolicy() {
+    return std::atomic_load(&g_host_policy);
+}
+
+void PublishContextPolicy(std::shared_ptr<const HostPolicy> policy) {
+    ContextPolicySlot& slot = ContextSlot(policy->context_id);
+    uint64_t id = policy->id;
+    std::atomic_store(&slot.policy, std::move(policy));
+    slot.policy_id.store(id, std::memory_order_release);
+}
+
+void RetireContextPolicy(int64_t context_id) {
+    ContextPolicySlot& slot = ContextSlot(context_id);
+    std::shared_ptr<const HostPolicy> current = std::atomic_load(&slot.policy);
+    // A newer context sharing the slot keeps its policy
+    if (current != nullptr && current->context_id == context_id &&
+        std::atomic_compare_exchange_strong(&slot.policy, &current, std::shared_ptr<const HostPolicy>())) {
+        slot.policy_id.store(0, std::memory_order_release);
+    }
+}
+
+std::shared_ptr<const HostPolicy> GetContextPolicy(int64_t context_id) {
+    if (context_id == 0) {
+        return GetHostPolicy();
+    }
+    std::shared_ptr<const HostPolicy> policy = std::atomic_load(&ContextSlot(context_id).policy);
+    if (policy == nullptr || policy->context_id != context_id) {
+        return nullptr;
+    }
+    return policy;
+}
+
+uint64_t GetContextPolicyId(int64_t context_id) {
+    if (context_id == 0) {
+        return GetHostPolicyId();
+    }
+    return ContextSlot(context_id).policy_id.load(std::memory_order_acquire);
+}
+
+PolicyVerdict EvaluateConnectPolicy(const char* hostname, const char* address, int64_t context_id) {
+    PolicyCulprit fallback_culprit = address != nullptr
+        ? PolicyCulprit::Address
+        : (hostname != nullptr ? PolicyCulprit::Hostname : PolicyCulprit::None);
+
+    if (hostname == nullptr && address == nullptr) {
+        // No host information available - allow by default
+        return PolicyVerdict{false, PolicyCulprit::None, false, 0};
+    }
+
+    std::shared_ptr<const HostPolicy> policy = GetContextPolicy(context_id);
+    if (policy == nullptr) {
+        DEBUG_LOG("No native host policy published - deferring verdict to NetworkBlockerContext");
+        return PolicyVerdict{true, fallback_culprit, false, 0};
+    }
+
+    return EvaluateConnectPolicy(*policy, hostname, address);
+}
+
+PolicyVerdict EvaluateConnectPolicy(const HostPolicy& policy, const char* hostname, const char* address) {
+    PolicyCulprit fallback_culprit = address != nullptr
+        ? PolicyCulprit::Address
+        : (hostname != nullptr ? PolicyCulprit::Hostname : PolicyCulprit::None);
+
+    if (hostname == nullptr && address == nullptr) {
+        return PolicyVerdict{false, PolicyCulprit::None, false, 0};
+    }
+
+    std::string normalized_hostname = hostname != nullptr ? NormalizeHost(hostname) : std::string();
+    std::string normalized_address = address != nullptr ? NormalizeHost(address) : std::string();
+
+    // 1. Explicitly blocked hostname or IP always wins
+    if (hostname != nullptr && policy.IsExplicitlyBlocked(normalized_hostname)) {
+        DEBUG_LOGF("Host %s is explicitly blocked", hostname);
+        return PolicyVerdict{true, PolicyCulprit::Hostname, false, policy.id};
+    }
+    if (address != nullptr && policy.IsExplicitlyBlocked(normalized_address)) {
+        DEBUG_LOGF("Host %s is explicitly blocked", address);
+        return PolicyVerdict{true, PolicyCulprit::Address, false, policy.id};
+    }
+
+    // 2./3. IP first (actual connection target), then hostname
+    if (address != nullptr && policy.IsAllowed(normalized_address)) {
+        DEBUG_LOG("IP address allowed by native policy");
+        // Hostname only matters for explicit blocks, so with no blocked hosts
+        // the verdict is a function of the address alone
+        return PolicyVerdict{false, PolicyCulprit::None, policy.blocked.Empty(), policy.id};
+    }
+    if (hostname != nullptr && policy.IsAllowed(normalized_hostname)) {
+        DEBUG_LOG("Hostname allowed by native policy (IP address was not)");
+        return PolicyVerdict{false, PolicyCulprit::None, false, policy.id};
+    }
+
+    // 4. Neither identifier allowed
+    return PolicyVerdict{true, fallback_culprit, false, policy.id};
+}
+
+bool EvaluateDnsPolicy(const char* hostname, int64_t context_id) {
+    if (hostname == nullptr) {
+        return true;
+    }
+
+    std::shared_ptr<const HostPolicy> policy = GetContextPolicy(context_id);
+    if (policy == nullptr) {
+        DEBUG_LOG("No native host policy published - deferring DNS verdict to NetworkBlockerContext");
+        return false;
+    }
+
+    return EvaluateDnsPolicy(*policy, hostname);
+}
+
+bool EvaluateDnsPolicy(const HostPolicy& policy, const char* hostname) {
+    if (hostname == nullptr) {
+        return true;
+    }
+
+    return policy.IsAllowed(NormalizeHost(hostname));
+}
+
+/**
+ * Add every String element of a Java String[] to a pattern set.
+ *
+ * @return false if a JNI error occurred
+ */
+static bool AddPatterns(JNIEnv* env, jobjectArray hosts, HostPatternSet& set) {
+    if (hosts == nullptr) {
+        return true;
+    }
+
+    jsize count = env->GetArrayLength(hosts);
+    for (jsize i = 0; i < count; i++) {
+        jstring host = (jstring)env->GetObjectArrayElement(hosts, i);
+        if (host == nullptr) {
+            continue;
+        }
+
+        const char* chars = env->GetStringUTFChars(host, nullptr);
+        if (chars == nullptr) {
+            env->DeleteLocalRef(host);
+            return false;
+        }
+
+        set.Add(chars);
+        env->ReleaseStringUTFChars(host, chars);
+        env->DeleteLocalRef(host);
+    }
+    return true;
+}
+
+/**
+ * Compile allowed/blocked host arrays into a new policy snapshot.
+ *
+ * @return The policy, or nullptr with the JNI exception left pending
+ */
+static std::shared_ptr<HostPolicy> CompileHostPolicy(
+    JNIEnv* env,
+    jobjectArray allowedHosts,
+    jobjectArray blockedHosts,
+    int64_t contextId,
+    jlong dnsCacheTtlMillis
+) {
+    std::shared_ptr<HostPolicy> policy = std::make_shared<HostPolicy>();
+    policy->id = NextHostPolicyId();
+    policy->context_id = contextId;
+    if (dnsCacheTtlMillis > 0 && PrepareDnsResultCache(env)) {
+        policy->dns_cache_ttl_ns = (int64_t)dnsCacheTtlMillis * 1000000;
+    }
+
+    if (!AddPatterns(env, allowedHosts, policy->allowed) ||
+        !AddPatterns(env, blockedHosts, policy->blocked)) {
+        fprintf(stderr, "[junit-airgap:native] ERROR: Failed to compile host policy\n");
+        return nullptr;
+    }
+
+    DEBUG_LOGF("Compiled native host policy for context %lld: %zu exact/%zu suffix/%zu glob allowed, %zu exact/%zu suffix/%zu glob blocked",
+               (long long)contextId,
+               policy->allowed.exact.size(), policy->allowed.suffixes.size(), policy->allowed.globs.size(),
+               policy->blocked.exact.size(), policy->blocked.suffixes.size(), policy->blocked.globs.size());
+    return policy;
+}
+
+/**
+ * Compile and publish the JVM-wide host policy (the most recently started test's),
+ * dropping the DNS results cached under the previous one.
+ *
+ * Called from NetworkBlockerContext.setConfiguration() and from clearConfiguration()
+ * while other tests are still running.
+ *
+ * Java signature: private external fun setAgentHostPolicy(allowedHosts: Array<String>, blockedHosts: Array<String>, dnsCacheTtlMillis: Long)
+ * JNI signature: ([Ljava/lang/String;[Ljava/lang/String;J)V
+ */
+JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_setAgentHostPolicy(
+    JNIEnv* env,
+    jclass clazz,
+    jobjectArray allowedHosts,
+    jobjectArray blockedHosts,
+    jlong dnsCacheTtlMillis
+) {
+    // On failure make sure no stale policy from a previous test survives
+    // (the JNI exception stays pending for the Java caller)
+    PublishHostPolicy(CompileHostPolicy(env, allowedHosts, blockedHosts, 0, dnsCacheTtlMillis));
+    FlushDnsResults(env, 0);
+}
+
+/**
+ * Clear the published JVM-wide host policy.
+ *
+ * Called from NetworkBlockerContext.clearConfiguration() once no test is running.
+ *
+ * Java signature: private external fun clearAgentHostPolicy()
+ * JNI signature: ()V
+ */
+JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_clearAgentHostPolicy(
+    JNIEnv* env,
+    jclass clazz
+) {
+    PublishHostPolicy(nullptr);
+    FlushDnsResults(env, 0);
+    DEBUG_LOG("Cleared native host policy");
+}
+
+/**
+ * Compile and publish the host policy of one test context, with its DNS result cache TTL.
+ *
+ * Called from NetworkBlockerContext.setConfiguration().
+ *
+ * Java signature: private external fun setAgentContextPolicy(contextId: Long, allowedHosts: Array<String>, blockedHosts: Array<String>, dnsCacheTtlMillis: Long)
+ * JNI signature: (J[Ljava/lang/String;[Ljava/lang/String;J)V
+ */
+JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_setAgentContextPolicy(
+    JNIEnv* env,
+    jclass clazz,
+    jlong contextId,
+    jobjectArray allowedHosts,
+    jobjectArray blockedHosts,
+    jlong dnsCacheTtlMillis
+) {
+    if (contextId == 0) {
+        return;
+    }
+    FlushDnsResults(env, contextId);
+    std::shared_ptr<HostPolicy> policy =
+        CompileHostPolicy(env, allowedHosts, blockedHosts, contextId, dnsCacheTtlMillis);
+    if (policy == nullptr) {
+        // The context's requests are then decided by NetworkBlockerContext
+        RetireContextPolicy(contextId);
+        return;
+    }
+    PublishContextPolicy(std::move(policy));
+}
+
+/**
+ * Drop the host policy and the cached DNS results of a finished test context.
+ *
+ * Called from NetworkBlockerContext.clearConfiguration().
+ *
+ * Java signature: private external fun clearAgentContextPolicy(contextId: Long)
+ * JNI signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_clearAgentContextPolicy(
+    JNIEnv* env,
+    jclass clazz,
+    jlong contextId
+) {
+    RetireContextPolicy(contextId);
+    FlushDnsResults(env, contextId);
+    DEBUG_LOGF("Cleared native host policy of context %lld", (long long)contextId);
+}
@@ -0,0 +1,195 @@
+/**
+ * Allocation-free InetAddress decoding for junit-airgap JVMTI Agent
+ *
+ * See inet_address.h for the JDK fields this relies on.
+ */
+
+#include "agent.h"
+#include "inet_address.h"
+#include <cstdio>
+#include <cstring>
+
+// Category for DEBUG_LOG/DEBUG_LOGF in this file
+static constexpr LogCategory kLogCategory = LogCategory::Registration;
+
+// InetAddress.IPv4 / InetAddress.IPv6 family constants
+static constexpr jint kFamilyIPv4 = 1;
+static constexpr jint kFamilyIPv6 = 2;
+
+/**
+ * Look up an instance field, clearing the NoSuchFieldError if it doesn't exist.
+ */
+static jfieldID LookupField(JNIEnv* env, const char* class_name, const char* name, const char* signature) {
+    jclass clazz = env->FindClass(class_name);
+    if (clazz == nullptr) {
+        env->ExceptionClear();
+        DEBUG_LOGF("InetAddress decoding: class %s not found", class_name);
+        return nullptr;
+    }
+
+    jfieldID field = env->GetFieldID(clazz, name, signature);
+    env->DeleteLocalRef(clazz);
+    if (field == nullptr) {
+        env->ExceptionClear();
+        DEBUG_LOGF("InetAddress decoding: field %s.%s not found", class_name, name);
+    }
+    return field;
+}
+
+bool LookupInetAddressFields(JNIEnv* env, InetAddressFields* fields) {
+    memset(fields, 0, sizeof(*fields));
+
+    fields->holder = LookupField(env, "java/net/InetAddress", "holder", "Ljava/net/InetAddress$InetAddressHolder;");
+    fields->holder_address = LookupField(env, "java/net/InetAddress$InetAddressHolder", "address", "I");
+    fields->holder_family = LookupField(env, "java/net/InetAddress$InetAddressHolder", "family", "I");
+    fields->holder_host_name = LookupField(env, "java/net/InetAddress$InetAddressHolder", "hostName", "Ljava/lang/String;");
+    fields->holder6 = LookupField(env, "java/net/Inet6Address", "holder6", "Ljava/net/Inet6Address$Inet6AddressHolder;");
+    fields->holder6_ipaddress = LookupField(env, "java/net/Inet6Address$Inet6AddressHolder", "ipaddress", "[B");
+
+    if (fields->holder == nullptr || fields->holder_address == nullptr || fields->holder_family == nullptr ||
+        fields->holder_host_name == nullptr || fields->holder6 == nullptr || fields->holder6_ipaddress == nullptr) {
+        DEBUG_LOG("InetAddress holder layout not recognized - falling back to InetAddress.getAddress()");
+        fields->holder = nullptr;
+    }
+
+    jclass inetAddressClass = env->FindClass("java/net/InetAddress");
+    if (inetAddressClass == nullptr) {
+        env->ExceptionClear();
+        return false;
+    }
+    fields->get_address = env->GetMethodID(inetAddressClass, "getAddress", "()[B");
+    fields->get_host_name = env->GetMethodID(inetAddressClass, "getHostName", "()Ljava/lang/String;");
+    env->DeleteLocalRef(inetAddressClass);
+
+    if (fields->get_address == nullptr || fields->get_host_name == nullptr) {
+        env->ExceptionClear();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Copy a Java byte[] address into the output, if it has a valid length.
+ */
+static bool CopyAddressBytes(JNIEnv* env, jbyteArray bytes, InetAddressBytes* out) {
+    jsize length = env->GetArrayLength(bytes);
+    if (length != 4 && length != kInetAddressMaxLength) {
+        return false;
+    }
+    env->GetByteArrayRegion(bytes, 0, length, (jbyte*)out->bytes);
+    out->length = (uint8_t)length;
+    return true;
+}
+
+/**
+ * Slow path: InetAddress.getAddress() allocates a fresh byte[].
+ */
+static bool DecodeViaGetAddress(JNIEnv* env, const InetAddressFields& fields, jobject address, InetAddressBytes* out) {
+    if (fields.get_address == nullptr) {
+        return false;
+    }
+
+    jbyteArray bytes = (jbyteArray)env->CallObjectMethod(address, fields.get_address);
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        return false;
+    }
+    if (bytes == nullptr) {
+        return false;
+    }
+
+    bool ok = CopyAddressBytes(env, bytes, out);
+    env->DeleteLocalRef(bytes);
+    return ok;
+}
+
+bool DecodeInetAddress(JNIEnv* env, const InetAddressFields& fields, jobject address, InetAddressBytes* out) {
+    if (address == nullptr) {
+        return false;
+    }
+
+    if (fields.holder == nullptr) {
+        return DecodeViaGetAddress(env, fields, address, out);
+    }
+
+    jobject holder = env->GetObjectField(address, fields.holder);
+    if (holder == nullptr) {
+        return false;
+    }
+    jint family = env->GetIntField(holder, fields.holder_family);
+
+    bool ok = false;
+    if (family == kFamilyIPv4) {
+        // Stored as a big-endian int: first octet in the high byte
+        uint32_t value = (uint32_t)env->GetIntField(holder, fields.holder_address);
+        out->bytes[0] = (uint8_t)(value >> 24);
+        out->bytes[1] = (uint8_t)(value >> 16);
+        out->bytes[2] = (uint8_t)(value >> 8);
+        out->bytes[3] = (uint8_t)value;
+        out->length = 4;
+        ok = true;
+    } else if (family == kFamilyIPv6) {
+        jobject holder6 = env->GetObjectField(address, fields.holder6);
+        if (holder6 != nullptr) {
+            jbyteArray bytes = (jbyteArray)env->GetObjectField(holder6, fields.holder6_ipaddress);
+            if (bytes != nullptr) {
+                ok = CopyAddressBytes(env, bytes, out);
+                env->DeleteLocalRef(bytes);
+            }
+            env->DeleteLocalRef(holder6);
+        }
+    }
+
+    env->DeleteLocalRef(holder);
+    return ok;
+}
+
+jstring GetInetAddressHostName(JNIEnv* env, const InetAddressFields& fields, jobject address) {
+    if (address == nullptr) {
+        return nullptr;
+    }
+
+    if (fields.holder == nullptr) {
+        jstring hostName = (jstring)env->CallObjectMethod(address, fields.get_host_name);
+        if (env->ExceptionCheck()) {
+            env->ExceptionClear();
+            return nullptr;
+        }
+        return hostName;
+    }
+
+    jobject holder = env->GetObjectField(address, fields.holder);
+    if (holder == nullptr) {
+        return nullptr;
+    }
+    jstring hostName = (jstring)env->GetObjectField(holder, fields.holder_host_name);
+    env->DeleteLocalRef(holder);
+    return hostName;
+}
+
+void FormatInetAddress(const InetAddressBytes& address, char* out) {
+    if (address.length == 4) {
+        snprintf(out, kInetAddressTextMaxLength, "%u.%u.%u.%u",
+                 address.bytes[0], address.bytes[1], address.bytes[2], address.bytes[3]);
+        return;
+    }
+
+    // Same as Inet6Address.numericToTextFormat(): every group, no "::" compression
+    static const char kHexDigits[] = "0123456789abcdef";
+    char* p = out;
+    for (int group = 0; group < 8; group++) {
+        unsigned value = ((unsigned)address.bytes[group * 2] << 8) | address.bytes[group * 2 + 1];
+        bool started = false;
+        for (int shift = 12; shift >= 0; shift -= 4) {
+            unsigned digit = (value >> shift) & 0xf;
+            if (digit != 0 || started || shift == 0) {
+                *p++ = kHexDigits[digit];
+                started = true;
+            }
+        }
+        if (group < 7) {
+            *p++ = ':';
+        }
+    }
+    *p = '\0';
+}
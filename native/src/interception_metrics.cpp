@@ -0,0 +1,156 @@
+/**
+ * Interception Metrics for junit-airgap JVMTI Agent
+ *
+ * Sharded relaxed counters (see interception_metrics.h). A thread picks its shard
+ * once; recording is a handful of fetch_adds on that shard's cache lines and never
+ * takes a lock.
+ */
+
+#include "interception_metrics.h"
+#include "trace_buffer.h"
+#include <atomic>
+
+bool g_metrics_enabled = false;
+
+/**
+ * One shard of counters. Aligned so no two shards share a cache line.
+ */
+struct alignas(64) MetricsShard {
+    std::atomic<uint64_t> calls[kInterceptTargetCount];
+    std::atomic<uint64_t> allowed[kInterceptTargetCount];
+    std::atomic<uint64_t> blocked[kInterceptTargetCount];
+    std::atomic<uint64_t> paths[kTracePathCount];
+    std::atomic<uint64_t> upcall_histogram[kMetricsHistogramBuckets];
+    std::atomic<uint64_t> original_histogram[kMetricsHistogramBuckets];
+    std::atomic<uint64_t> upcall_total_ns;
+    std::atomic<uint64_t> original_total_ns;
+};
+
+// Zero-initialized (static storage)
+static MetricsShard g_metrics_shards[kMetricsShards];
+static std::atomic<uint32_t> g_next_metrics_shard{0};
+
+// Shard of the calling thread, assigned on first use (kMetricsShards = none yet)
+static thread_local uint32_t t_metrics_shard = kMetricsShards;
+
+static MetricsShard& CurrentShard() {
+    if (t_metrics_shard == kMetricsShards) {
+        t_metrics_shard = g_next_metrics_shard.fetch_add(1, std::memory_order_relaxed) % kMetricsShards;
+    }
+    return g_metrics_shards[t_metrics_shard];
+}
+
+/**
+ * Log2 bucket of a duration: floor(log2(ns)), 0 for 0 and 1 ns.
+ */
+static size_t HistogramBucket(uint64_t ns) {
+    size_t bucket = 0;
+    while (ns > 1 && bucket < kMetricsHistogramBuckets - 1) {
+        ns >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static void Add(std::atomic<uint64_t>& counter, uint64_t amount) {
+    counter.fetch_add(amount, std::memory_order_relaxed);
+}
+
+void RecordInterceptionMetrics(
+    InterceptTarget target,
+    TracePath path,
+    TraceVerdict verdict,
+    uint64_t upcall_ns,
+    uint64_t original_ns
+) {
+    MetricsShard& shard = CurrentShard();
+    size_t index = (size_t)target;
+
+    Add(shard.calls[index], 1);
+    Add(verdict == TraceVerdict::Blocked ? shard.blocked[index] : shard.allowed[index], 1);
+    Add(shard.paths[(size_t)path], 1);
+
+    if (upcall_ns > 0) {
+        Add(shard.upcall_histogram[HistogramBucket(upcall_ns)], 1);
+        Add(shard.upcall_total_ns, upcall_ns);
+    }
+    if (verdict == TraceVerdict::Allowed) {
+        Add(shard.original_histogram[HistogramBucket(original_ns)], 1);
+        Add(shard.original_total_ns, original_ns);
+    }
+}
+
+/**
+ * Sum one counter over every shard.
+ */
+template <typename Field>
+static jlong SumShards(Field field) {
+    uint64_t sum = 0;
+    for (const MetricsShard& shard : g_metrics_shards) {
+        sum += field(shard).load(std::memory_order_relaxed);
+    }
+    return (jlong)sum;
+}
+
+// Header of the getAgentMetrics() array; bump kMetricsLayoutVersion when the layout changes
+static constexpr jlong kMetricsLayoutVersion = 1;
+static constexpr size_t kMetricsHeaderLength = 4;
+static constexpr size_t kMetricsArrayLength =
+    kMetricsHeaderLength + 3 * kInterceptTargetCount + kTracePathCount + 2 * kMetricsHistogramBuckets + 2;
+
+/**
+ * Get the interception metrics, summed over all shards.
+ *
+ * Java signature: private external fun getAgentMetrics(): LongArray?
+ * JNI signature: ()[J
+ *
+ * @return long[] = { layout version, target count T, path count P, bucket count B,
+ *                    calls[T], allowed[T], blocked[T], paths[P],
+ *                    upcall histogram[B], original histogram[B],
+ *                    upcall total ns, original total ns },
+ *         or null if metrics are disabled
+ */
+JNIEXPORT jlongArray JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_getAgentMetrics(
+    JNIEnv* env,
+    jclass clazz
+) {
+    if (!g_metrics_enabled) {
+        return nullptr;
+    }
+
+    jlong values[kMetricsArrayLength];
+    size_t n = 0;
+    values[n++] = kMetricsLayoutVersion;
+    values[n++] = (jlong)kInterceptTargetCount;
+    values[n++] = (jlong)kTracePathCount;
+    values[n++] = (jlong)kMetricsHistogramBuckets;
+
+    for (size_t i = 0; i < kInterceptTargetCount; i++) {
+        values[n++] = SumShards([i](const MetricsShard& s) -> const std::atomic<uint64_t>& { return s.calls[i]; });
+    }
+    for (size_t i = 0; i < kInterceptTargetCount; i++) {
+        values[n++] = SumShards([i](const MetricsShard& s) -> const std::atomic<uint64_t>& { return s.allowed[i]; });
+    }
+    for (size_t i = 0; i < kInterceptTargetCount; i++) {
+        values[n++] = SumShards([i](const MetricsShard& s) -> const std::atomic<uint64_t>& { return s.blocked[i]; });
+    }
+    for (size_t i = 0; i < kTracePathCount; i++) {
+        values[n++] = SumShards([i](const MetricsShard& s) -> const std::atomic<uint64_t>& { return s.paths[i]; });
+    }
+    for (size_t i = 0; i < kMetricsHistogramBuckets; i++) {
+        values[n++] = SumShards(
+            [i](const MetricsShard& s) -> const std::atomic<uint64_t>& { return s.upcall_histogram[i]; });
+    }
+    for (size_t i = 0; i < kMetricsHistogramBuckets; i++) {
+        values[n++] = SumShards(
+            [i](const MetricsShard& s) -> const std::atomic<uint64_t>& { return s.original_histogram[i]; });
+    }
+    values[n++] = SumShards([](const MetricsShard& s) -> const std::atomic<uint64_t>& { return s.upcall_total_ns; });
+    values[n++] = SumShards([](const MetricsShard& s) -> const std::atomic<uint64_t>& { return s.original_total_ns; });
+
+    jlongArray result = env->NewLongArray((jsize)n);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, (jsize)n, values);
+    }
+    return result;
+}
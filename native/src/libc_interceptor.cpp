@@ -0,0 +1,495 @@
+/**
+ * libc-Level Interception for junit-airgap JVMTI Agent
+ *
+ * See libc_interceptor.h. Every loaded ELF object is walked with dl_iterate_phdr();
+ * its JUMP_SLOT and GLOB_DAT relocations against the hooked symbols are rewritten to
+ * point at the Hooked_* functions below, which evaluate the native policy and then
+ * call the libc function resolved with dlsym(RTLD_DEFAULT). A slot that already holds
+ * the hook is left alone, so a rescan is idempotent.
+ *
+ * dlopen() itself is deliberately not hooked: glibc resolves a dlopen() against its
+ * caller (RUNPATH, $ORIGIN, linker namespace), so forwarding every library's dlopen()
+ * through the agent would break libraries that load their dependencies relative to
+ * themselves. New objects are found instead by polling the loader's count of objects
+ * ever added (dl_phdr_info.dlpi_adds), see RescanLoadedLibraries().
+ *
+ * Nothing here calls into the JVM: the hooks run on threads the JVM may not know
+ * about, inside libraries that may hold their own locks.
+ */
+
+#include "agent.h"
+#include "libc_interceptor.h"
+#include <cstdio>
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+
+#include "dns_binding_table.h"
+#include "host_policy.h"
+#include "inet_address.h"
+#include "policy_image.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <dlfcn.h>
+#include <elf.h>
+#include <link.h>
+#include <mutex>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Category for DEBUG_LOG/DEBUG_LOGF in this file
+static constexpr LogCategory kLogCategory = LogCategory::Socket;
+
+#if defined(__x86_64__)
+static constexpr uint32_t kRelocJumpSlot = R_X86_64_JUMP_SLOT;
+static constexpr uint32_t kRelocGlobDat = R_X86_64_GLOB_DAT;
+#else
+static constexpr uint32_t kRelocJumpSlot = R_AARCH64_JUMP_SLOT;
+static constexpr uint32_t kRelocGlobDat = R_AARCH64_GLOB_DAT;
+#endif
+
+using ConnectFunction = int (*)(int, const struct sockaddr*, socklen_t);
+using SendToFunction = ssize_t (*)(int, const void*, size_t, int, const struct sockaddr*, socklen_t);
+using SendMsgFunction = ssize_t (*)(int, const struct msghdr*, int);
+using GetAddrInfoFunction = int (*)(const char*, const char*, const struct addrinfo*, struct addrinfo**);
+using GetHostByNameFunction = struct hostent* (*)(const char*);
+
+// libc implementations, resolved once in InstallLibcInterception()
+static ConnectFunction g_real_connect = nullptr;
+static SendToFunction g_real_sendto = nullptr;
+static SendMsgFunction g_real_sendmsg = nullptr;
+static GetAddrInfoFunction g_real_getaddrinfo = nullptr;
+static GetHostByNameFunction g_real_gethostbyname = nullptr;
+
+// Whether InstallLibcInterception() succeeded (rescans do nothing otherwise)
+static bool g_libc_interception_active = false;
+
+// Serializes GOT rewrites (initial scan and rescans)
+static std::mutex g_libc_patch_mutex;
+
+// dlpi_adds when the last scan started (0: unknown, always rescan)
+static std::atomic<unsigned long long> g_scanned_object_adds{0};
+
+// Path of this agent library and the JDK installation prefix (e.g. "/usr/lib/jvm/jdk-21/")
+static std::string g_self_path;
+static std::string g_jdk_prefix;
+
+// Libraries never patched: libc itself, the dynamic linker, and the resolver/NSS
+// modules whose DNS traffic serves lookups that were already allowed
+static const char* const kSystemLibraryFragments[] = {
+    "/libc.so", "/libc-", "/ld-linux", "/ld-musl", "/libdl.so", "/libpthread",
+    "/libresolv", "/libnss_", "linux-vdso", "linux-gate",
+};
+
+/**
+ * Policy that applies to a libc-level call right now, or nullptr to allow it.
+ *
+ * Mirrors the JNI wrappers: the policy image until NetworkBlockerContext registers,
+ * then the published host policy while a configuration is armed.
+ *
+ * @param holder Keeps a published policy alive while it is evaluated
+ */
+static const HostPolicy* CurrentPolicy(std::shared_ptr<const HostPolicy>* holder) {
+    if (GetAgentContext()->network_blocker_context_class == nullptr) {
+        return GetPolicyImagePolicy();
+    }
+    if (g_agent_arm_state.load(std::memory_order_relaxed) != AgentArmState::Armed) {
+        return nullptr;
+    }
+    *holder = GetHostPolicy();
+    return holder->get();
+}
+
+/**
+ * Decode an AF_INET/AF_INET6 socket address (IPv4-mapped IPv6 as IPv4, as Java does).
+ *
+ * @return false for other families (AF_UNIX, AF_NETLINK, ...) and short addresses
+ */
+static bool DecodeSockaddr(const struct sockaddr* addr, socklen_t length, InetAddressBytes* out, int* port) {
+    if (addr->sa_family == AF_INET && length >= (socklen_t)sizeof(struct sockaddr_in)) {
+        const struct sockaddr_in* in4 = (const struct sockaddr_in*)addr;
+        memcpy(out->bytes, &in4->sin_addr, 4);
+        out->length = 4;
+        *port = ntohs(in4->sin_port);
+        return true;
+    }
+    if (addr->sa_family == AF_INET6 && length >= (socklen_t)sizeof(struct sockaddr_in6)) {
+        const struct sockaddr_in6* in6 = (const struct sockaddr_in6*)addr;
+        if (IN6_IS_ADDR_V4MAPPED(&in6->sin6_addr)) {
+            memcpy(out->bytes, in6->sin6_addr.s6_addr + 12, 4);
+            out->length = 4;
+        } else {
+            memcpy(out->bytes, in6->sin6_addr.s6_addr, 16);
+            out->length = 16;
+        }
+        *port = ntohs(in6->sin6_port);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Check a connect()/sendto()/sendmsg() destination against the native policy.
+ *
+ * @return true if the call must fail
+ */
+static bool IsBlockedDestination(const struct sockaddr* addr, socklen_t length, const char* call) {
+    InetAddressBytes address;
+    int port = 0;
+    if (addr == nullptr || !DecodeSockaddr(addr, length, &address, &port)) {
+        return false;
+    }
+
+    std::shared_ptr<const HostPolicy> holder;
+    const HostPolicy* policy = CurrentPolicy(&holder);
+    if (policy == nullptr) {
+        return false;
+    }
+
+    char addressText[kInetAddressTextMaxLength];
+    FormatInetAddress(address, addressText);
+    char boundHostName[kDnsBindingMaxHostnameLength + 1];
+    const char* hostname = LookupDnsBinding(address, boundHostName) ? boundHostName : nullptr;
+
+    if (!EvaluateConnectPolicy(*policy, hostname, addressText).blocked) {
+        return false;
+    }
+    LOG_WARNING("Blocked %s() to %s:%d (%s) from a native library",
+                call, addressText, port, hostname != nullptr ? hostname : "no hostname");
+    return true;
+}
+
+static bool IsAddressLiteral(const char* host) {
+    uint8_t bytes[16];
+    return inet_pton(AF_INET, host, bytes) == 1 || inet_pton(AF_INET6, host, bytes) == 1;
+}
+
+/**
+ * Check a hostname lookup against the native policy. Literals are left to connect().
+ *
+ * @return true if the lookup must fail
+ */
+static bool IsBlockedLookup(const char* hostname, const char* call) {
+    if (hostname == nullptr || IsAddressLiteral(hostname)) {
+        return false;
+    }
+
+    std::shared_ptr<const HostPolicy> holder;
+    const HostPolicy* policy = CurrentPolicy(&holder);
+    if (policy == nullptr || EvaluateDnsPolicy(*policy, hostname)) {
+        return false;
+    }
+    LOG_WARNING("Blocked %s(%s) from a native library", call, hostname);
+    return true;
+}
+
+static int Hooked_connect(int fd, const struct sockaddr* addr, socklen_t length) {
+    if (IsBlockedDestination(addr, length, "connect")) {
+        errno = EACCES;
+        return -1;
+    }
+    return g_real_connect(fd, addr, length);
+}
+
+static ssize_t Hooked_sendto(int fd, const void* buffer, size_t size, int flags,
+                             const struct sockaddr* addr, socklen_t length) {
+    if (IsBlockedDestination(addr, length, "sendto")) {
+        errno = EACCES;
+        return -1;
+    }
+    return g_real_sendto(fd, buffer, size, flags, addr, length);
+}
+
+static ssize_t Hooked_sendmsg(int fd, const struct msghdr* message, int flags) {
+    if (message != nullptr &&
+        IsBlockedDestination((const struct sockaddr*)message->msg_name, message->msg_namelen, "sendmsg")) {
+        errno = EACCES;
+        return -1;
+    }
+    return g_real_sendmsg(fd, message, flags);
+}
+
+static int Hooked_getaddrinfo(const char* node, const char* service,
+                              const struct addrinfo* hints, struct addrinfo** results) {
+    if (IsBlockedLookup(node, "getaddrinfo")) {
+        return EAI_NONAME;
+    }
+
+    int status = g_real_getaddrinfo(node, service, hints, results);
+    if (status == 0 && node != nullptr && *results != nullptr) {
+        // Record bindings so a later connect() to these addresses matches the hostname
+        for (const struct addrinfo* entry = *results; entry != nullptr; entry = entry->ai_next) {
+            InetAddressBytes address;
+            int port = 0;
+            if (entry->ai_addr != nullptr && DecodeSockaddr(entry->ai_addr, entry->ai_addrlen, &address, &port)) {
+                RecordDnsBinding(address, node);
+            }
+        }
+    }
+    return status;
+}
+
+static struct hostent* Hooked_gethostbyname(const char* name) {
+    if (IsBlockedLookup(name, "gethostbyname")) {
+        h_errno = HOST_NOT_FOUND;
+        return nullptr;
+    }
+
+    struct hostent* result = g_real_gethostbyname(name);
+    if (result != nullptr && result->h_addrtype == AF_INET && result->h_length == 4) {
+        for (char** entry = result->h_addr_list; *entry != nullptr; entry++) {
+            InetAddressBytes address;
+            memcpy(address.bytes, *entry, 4);
+            address.length = 4;
+            RecordDnsBinding(address, name);
+        }
+    }
+    return result;
+}
+
+/**
+ * One hooked symbol.
+ */
+struct LibcHook {
+    const char* symbol;
+    void* hook;
+};
+
+static const LibcHook kLibcHooks[] = {
+    {"connect", (void*)&Hooked_connect},
+    {"sendto", (void*)&Hooked_sendto},
+    {"sendmsg", (void*)&Hooked_sendmsg},
+    {"getaddrinfo", (void*)&Hooked_getaddrinfo},
+    {"gethostbyname", (void*)&Hooked_gethostbyname},
+};
+
+/**
+ * Address from a dynamic section entry: glibc relocates these in place, other
+ * loaders leave them as offsets from the load address.
+ */
+static uintptr_t DynamicAddress(uintptr_t base, ElfW(Addr) value) {
+    return value < base ? base + value : value;
+}
+
+/**
+ * Store a hook into a GOT slot, lifting RELRO protection for the write if needed.
+ */
+static bool WriteSlot(void** slot, void* value, uintptr_t relro_start, uintptr_t relro_end) {
+    uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+    void* page = (void*)((uintptr_t)slot & ~(page_size - 1));
+    bool relro = (uintptr_t)slot >= relro_start && (uintptr_t)slot < relro_end;
+
+    if (relro && mprotect(page, page_size, PROT_READ | PROT_WRITE) != 0) {
+        return false;
+    }
+    __atomic_store_n(slot, value, __ATOMIC_RELEASE);
+    if (relro) {
+        mprotect(page, page_size, PROT_READ);
+    }
+    return true;
+}
+
+struct PatchScan {
+    size_t patched_slots;
+};
+
+static bool IsSystemLibrary(const char* path) {
+    for (const char* fragment : kSystemLibraryFragments) {
+        if (strstr(path, fragment) != nullptr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * dl_iterate_phdr() callback: rewrite the hooked GOT slots of one object.
+ */
+static int PatchObject(struct dl_phdr_info* info, size_t size, void* data) {
+    PatchScan* scan = (PatchScan*)data;
+    const char* path = info->dlpi_name != nullptr ? info->dlpi_name : "";
+    if (g_self_path == path || IsSystemLibrary(path)) {
+        return 0;
+    }
+
+    // The launcher (empty name) and JDK libraries are covered by the JNI wrappers
+    if (path[0] == '\0' ||
+        (!g_jdk_prefix.empty() && strncmp(path, g_jdk_prefix.c_str(), g_jdk_prefix.size()) == 0)) {
+        return 0;
+    }
+
+    uintptr_t base = info->dlpi_addr;
+    const ElfW(Dyn)* dynamic = nullptr;
+    uintptr_t relro_start = 0;
+    uintptr_t relro_end = 0;
+    for (ElfW(Half) i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)& header = info->dlpi_phdr[i];
+        if (header.p_type == PT_DYNAMIC) {
+            dynamic = (const ElfW(Dyn)*)(base + header.p_vaddr);
+        } else if (header.p_type == PT_GNU_RELRO) {
+            relro_start = base + header.p_vaddr;
+            relro_end = relro_start + header.p_memsz;
+        }
+    }
+    if (dynamic == nullptr) {
+        return 0;
+    }
+
+    const ElfW(Sym)* symbols = nullptr;
+    const char* strings = nullptr;
+    const ElfW(Rela)* tables[2] = {nullptr, nullptr};   // DT_JMPREL, DT_RELA
+    size_t table_sizes[2] = {0, 0};
+    bool plt_rela = true;
+    for (const ElfW(Dyn)* entry = dynamic; entry->d_tag != DT_NULL; entry++) {
+        switch (entry->d_tag) {
+            case DT_SYMTAB: symbols = (const ElfW(Sym)*)DynamicAddress(base, entry->d_un.d_ptr); break;
+            case DT_STRTAB: strings = (const char*)DynamicAddress(base, entry->d_un.d_ptr); break;
+            case DT_JMPREL: tables[0] = (const ElfW(Rela)*)DynamicAddress(base, entry->d_un.d_ptr); break;
+            case DT_PLTRELSZ: table_sizes[0] = entry->d_un.d_val; break;
+            case DT_PLTREL: plt_rela = entry->d_un.d_val == DT_RELA; break;
+            case DT_RELA: tables[1] = (const ElfW(Rela)*)DynamicAddress(base, entry->d_un.d_ptr); break;
+            case DT_RELASZ: table_sizes[1] = entry->d_un.d_val; break;
+            default: break;
+        }
+    }
+    if (symbols == nullptr || strings == nullptr || !plt_rela) {
+        return 0;
+    }
+
+    size_t patched_before = scan->patched_slots;
+    for (size_t t = 0; t < 2; t++) {
+        size_t count = tables[t] != nullptr ? table_sizes[t] / sizeof(ElfW(Rela)) : 0;
+        for (size_t r = 0; r < count; r++) {
+            const ElfW(Rela)& relocation = tables[t][r];
+            uint32_t type = ELF64_R_TYPE(relocation.r_info);
+            if (type != kRelocJumpSlot && type != kRelocGlobDat) {
+                continue;
+            }
+            const char* name = strings + symbols[ELF64_R_SYM(relocation.r_info)].st_name;
+
+            for (const LibcHook& hook : kLibcHooks) {
+                if (strcmp(name, hook.symbol) != 0) {
+                    continue;
+                }
+                void** slot = (void**)(base + relocation.r_offset);
+                if (*slot != hook.hook && WriteSlot(slot, hook.hook, relro_start, relro_end)) {
+                    scan->patched_slots++;
+                }
+                break;
+            }
+        }
+    }
+
+    if (scan->patched_slots != patched_before) {
+        LOG_DEBUG(Socket, "libc interception: patched %zu GOT slot(s) in %s",
+                  scan->patched_slots - patched_before, path[0] != '\0' ? path : "(main program)");
+    }
+    return 0;
+}
+
+/**
+ * dl_iterate_phdr() callback: read the loader's count of objects ever added from the
+ * first object (the same for every object).
+ */
+static int ReadObjectAdds(struct dl_phdr_info* info, size_t size, void* data) {
+    unsigned long long* adds = (unsigned long long*)data;
+    *adds = size >= offsetof(struct dl_phdr_info, dlpi_adds) + sizeof(info->dlpi_adds) ? info->dlpi_adds : 0;
+    return 1;
+}
+
+static unsigned long long CurrentObjectAdds() {
+    unsigned long long adds = 0;
+    dl_iterate_phdr(ReadObjectAdds, &adds);
+    return adds;
+}
+
+/**
+ * Patch every loaded object not yet patched.
+ *
+ * @return Number of GOT slots rewritten by this call
+ */
+static size_t PatchLoadedObjects() {
+    std::lock_guard<std::mutex> lock(g_libc_patch_mutex);
+    // Read before the walk: an object added during it is caught by the next rescan
+    g_scanned_object_adds.store(CurrentObjectAdds(), std::memory_order_relaxed);
+    PatchScan scan{0};
+    dl_iterate_phdr(PatchObject, &scan);
+    return scan.patched_slots;
+}
+
+void RescanLoadedLibraries() {
+    if (!g_libc_interception_active) {
+        return;
+    }
+    unsigned long long adds = CurrentObjectAdds();
+    if (adds != 0 && adds == g_scanned_object_adds.load(std::memory_order_relaxed)) {
+        return;
+    }
+    size_t patched = PatchLoadedObjects();
+    if (patched > 0) {
+        LOG_DEBUG(Socket, "libc interception: rescan patched %zu GOT slot(s)", patched);
+    }
+}
+
+/**
+ * dl_iterate_phdr() callback: derive the JDK prefix from libjvm.so's path
+ * (<java.home>/lib/server/libjvm.so).
+ */
+static int FindJdkPrefix(struct dl_phdr_info* info, size_t size, void* data) {
+    const char* path = info->dlpi_name;
+    if (path == nullptr || strstr(path, "/libjvm.so") == nullptr) {
+        return 0;
+    }
+    std::string jvm_path(path);
+    size_t lib = jvm_path.rfind("/lib/");
+    if (lib != std::string::npos) {
+        g_jdk_prefix = jvm_path.substr(0, lib + 1);
+    }
+    return 1;
+}
+
+bool InstallLibcInterception() {
+    g_real_connect = (ConnectFunction)dlsym(RTLD_DEFAULT, "connect");
+    g_real_sendto = (SendToFunction)dlsym(RTLD_DEFAULT, "sendto");
+    g_real_sendmsg = (SendMsgFunction)dlsym(RTLD_DEFAULT, "sendmsg");
+    g_real_getaddrinfo = (GetAddrInfoFunction)dlsym(RTLD_DEFAULT, "getaddrinfo");
+    g_real_gethostbyname = (GetHostByNameFunction)dlsym(RTLD_DEFAULT, "gethostbyname");
+    if (g_real_connect == nullptr || g_real_sendto == nullptr || g_real_sendmsg == nullptr ||
+        g_real_getaddrinfo == nullptr || g_real_gethostbyname == nullptr) {
+        fprintf(stderr, "[junit-airgap:native] ERROR: libc symbols not found - libc interception disabled\n");
+        return false;
+    }
+
+    Dl_info self;
+    if (dladdr((void*)&InstallLibcInterception, &self) != 0 && self.dli_fname != nullptr) {
+        g_self_path = self.dli_fname;
+    }
+    dl_iterate_phdr(FindJdkPrefix, nullptr);
+    if (g_jdk_prefix.empty()) {
+        fprintf(stderr, "[junit-airgap:native] WARNING: libjvm.so not found - libc interception also covers JDK libraries\n");
+    }
+
+    size_t patched = PatchLoadedObjects();
+    g_libc_interception_active = true;
+    LOG_INFO(Agent, "libc interception active (%zu GOT slot(s) patched, JDK %s)", patched,
+             g_jdk_prefix.empty() ? "unknown" : g_jdk_prefix.c_str());
+    return true;
+}
+
+#else
+
+bool InstallLibcInterception() {
+    fprintf(stderr, "[junit-airgap:native] WARNING: The libc option is only supported on Linux (x86_64, aarch64) - ignored\n");
+    return false;
+}
+
+void RescanLoadedLibraries() {
+}
+
+#endif
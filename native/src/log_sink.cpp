@@ -0,0 +1,293 @@
+/**
+ * Native Log Sink for junit-airgap JVMTI Agent
+ *
+ * See log_sink.h. The queue is a bounded array of fixed-size slots with a sequence
+ * number per slot (the classic bounded MPMC queue design, used here with a single
+ * consumer): producers claim a position with a CAS, copy their line in, and publish
+ * it by advancing the slot's sequence. The writer thread only ever reads published
+ * slots, so producers never wait on it or on stderr.
+ */
+
+#include "log_sink.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+LogLevel g_log_levels[kLogCategoryCount] = {};
+
+// Queue geometry (slots must be a power of two)
+static constexpr uint64_t kLogQueueSlots = 1024;
+static constexpr size_t kLogLineMaxLength = 256;
+
+// Writer wakes at least this often; producers wake it early when the queue fills up
+static constexpr std::chrono::milliseconds kLogFlushInterval{10};
+
+static const char kLogPrefix[] = "[junit-airgap:native] ";
+
+struct LogSlot {
+    std::atomic<uint64_t> sequence;
+    uint32_t length;
+    char text[kLogLineMaxLength];
+};
+
+static LogSlot g_log_slots[kLogQueueSlots];
+static std::atomic<uint64_t> g_log_enqueue_position{0};
+static uint64_t g_log_dequeue_position = 0;   // Guarded by g_log_drain_mutex
+static std::atomic<uint64_t> g_log_dequeue_published{0};
+static std::atomic<uint64_t> g_log_dropped{0};
+
+static uint32_t g_log_messages_per_second = 0;
+
+// Never destroyed: the detached writer thread may still use them during process exit
+static std::mutex* g_log_drain_mutex = nullptr;
+static std::mutex* g_log_wakeup_mutex = nullptr;
+static std::condition_variable* g_log_wakeup = nullptr;
+
+// Batch buffer for one write to stderr (guarded by g_log_drain_mutex)
+static char g_log_batch[kLogLineMaxLength * 64];
+
+static const char* const kLogLevelNames[] = {"off", "info", "debug", "trace"};
+static const char* const kLogCategoryNames[] = {
+    "agent", "bind", "socket", "dns", "policy", "registration", "encoding",
+};
+static_assert(sizeof(kLogCategoryNames) / sizeof(kLogCategoryNames[0]) == kLogCategoryCount,
+              "kLogCategoryNames must have one entry per LogCategory");
+
+bool ParseLogLevel(const char* name, LogLevel* level) {
+    for (size_t i = 0; i < sizeof(kLogLevelNames) / sizeof(kLogLevelNames[0]); i++) {
+        if (strcmp(name, kLogLevelNames[i]) == 0) {
+            *level = (LogLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseLogCategory(const char* name, LogCategory* category) {
+    for (size_t i = 0; i < kLogCategoryCount; i++) {
+        if (strcmp(name, kLogCategoryNames[i]) == 0) {
+            *category = (LogCategory)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint64_t NowMs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Claim a slot, copy the line in and publish it.
+ *
+ * @return false if the queue was full (the line is dropped)
+ */
+static bool EnqueueLine(const char* line, uint32_t length) {
+    uint64_t position = g_log_enqueue_position.load(std::memory_order_relaxed);
+    LogSlot* slot;
+    for (;;) {
+        slot = &g_log_slots[position & (kLogQueueSlots - 1)];
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        int64_t lag = (int64_t)(sequence - position);
+        if (lag == 0) {
+            if (g_log_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (lag < 0) {
+            // Slot still holds a line from the previous lap: queue is full
+            g_log_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            position = g_log_enqueue_position.load(std::memory_order_relaxed);
+        }
+    }
+
+    memcpy(slot->text, line, length);
+    slot->length = length;
+    slot->sequence.store(position + 1, std::memory_order_release);
+
+    // Wake the writer early once the queue is three quarters full
+    if (position - g_log_dequeue_published.load(std::memory_order_relaxed) >= kLogQueueSlots * 3 / 4 &&
+        g_log_wakeup != nullptr) {
+        g_log_wakeup->notify_one();
+    }
+    return true;
+}
+
+/**
+ * Format "<prefix><message>\n" into a line buffer (truncated to kLogLineMaxLength).
+ */
+static uint32_t FormatLine(char* line, const char* format, va_list args) {
+    size_t prefix_length = sizeof(kLogPrefix) - 1;
+    memcpy(line, kLogPrefix, prefix_length);
+
+    // Leave room for the newline
+    size_t room = kLogLineMaxLength - prefix_length - 1;
+    int written = vsnprintf(line + prefix_length, room, format, args);
+    size_t length = prefix_length + (written < 0 ? 0 : ((size_t)written < room ? (size_t)written : room - 1));
+    line[length++] = '\n';
+    return (uint32_t)length;
+}
+
+static void EnqueueFormatted(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+static void EnqueueFormatted(const char* format, ...) {
+    char line[kLogLineMaxLength];
+    va_list args;
+    va_start(args, format);
+    uint32_t length = FormatLine(line, format, args);
+    va_end(args);
+    EnqueueLine(line, length);
+}
+
+/**
+ * Apply the per-site rate limit.
+ *
+ * @param suppressed Set to the number of messages suppressed in the window that just
+ *                   ended, for the caller to report (0 if none)
+ * @return true if this message may be logged
+ */
+static bool AdmitMessage(LogSite* site, uint32_t* suppressed) {
+    *suppressed = 0;
+    if (g_log_messages_per_second == 0) {
+        return true;
+    }
+
+    uint64_t now = NowMs();
+    uint64_t window_start = site->window_start_ms.load(std::memory_order_relaxed);
+    if (now - window_start >= 1000 &&
+        site->window_start_ms.compare_exchange_strong(window_start, now, std::memory_order_relaxed)) {
+        site->window_count.store(0, std::memory_order_relaxed);
+        *suppressed = site->suppressed.exchange(0, std::memory_order_relaxed);
+    }
+
+    if (site->window_count.fetch_add(1, std::memory_order_relaxed) >= g_log_messages_per_second) {
+        site->suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void WriteLog(LogSite* site, const char* format, ...) {
+    uint32_t suppressed;
+    bool admitted = AdmitMessage(site, &suppressed);
+    if (suppressed > 0) {
+        EnqueueFormatted("(%u similar message(s) suppressed)", suppressed);
+    }
+    if (!admitted) {
+        return;
+    }
+
+    char line[kLogLineMaxLength];
+    va_list args;
+    va_start(args, format);
+    uint32_t length = FormatLine(line, format, args);
+    va_end(args);
+    EnqueueLine(line, length);
+}
+
+void WriteWarning(LogSite* site, const char* format, ...) {
+    uint32_t suppressed;
+    bool admitted = AdmitMessage(site, &suppressed);
+    if (suppressed > 0) {
+        fprintf(stderr, "%s(%u similar warning(s) suppressed)\n", kLogPrefix, suppressed);
+    }
+    if (!admitted) {
+        return;
+    }
+
+    char message[kLogLineMaxLength];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    fprintf(stderr, "%sWARNING: %s\n", kLogPrefix, message);
+}
+
+/**
+ * Write every published line to stderr in batches. Caller holds g_log_drain_mutex.
+ */
+static void DrainLogQueue() {
+    size_t batch_length = 0;
+
+    for (;;) {
+        LogSlot& slot = g_log_slots[g_log_dequeue_position & (kLogQueueSlots - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != g_log_dequeue_position + 1) {
+            break;  // Empty, or the next producer hasn't published yet
+        }
+
+        if (batch_length + slot.length > sizeof(g_log_batch)) {
+            fwrite(g_log_batch, 1, batch_length, stderr);
+            batch_length = 0;
+        }
+        memcpy(g_log_batch + batch_length, slot.text, slot.length);
+        batch_length += slot.length;
+
+        // Hand the slot to the producer one lap ahead
+        slot.sequence.store(g_log_dequeue_position + kLogQueueSlots, std::memory_order_release);
+        g_log_dequeue_position++;
+    }
+    g_log_dequeue_published.store(g_log_dequeue_position, std::memory_order_relaxed);
+
+    if (batch_length > 0) {
+        fwrite(g_log_batch, 1, batch_length, stderr);
+    }
+
+    uint64_t dropped = g_log_dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        fprintf(stderr, "%s(%llu log message(s) dropped - queue full)\n", kLogPrefix, (unsigned long long)dropped);
+    }
+
+    if (batch_length > 0 || dropped > 0) {
+        fflush(stderr);
+    }
+}
+
+static void LogWriterLoop() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(*g_log_wakeup_mutex);
+            g_log_wakeup->wait_for(lock, kLogFlushInterval);
+        }
+        FlushLogs();
+    }
+}
+
+void FlushLogs() {
+    if (g_log_drain_mutex == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(*g_log_drain_mutex);
+    DrainLogQueue();
+}
+
+void InitLogSink(const LogLevel levels[kLogCategoryCount], uint32_t messages_per_second) {
+    bool any_enabled = false;
+    for (size_t i = 0; i < kLogCategoryCount; i++) {
+        g_log_levels[i] = levels[i];
+        any_enabled = any_enabled || levels[i] != LogLevel::Off;
+    }
+    g_log_messages_per_second = messages_per_second;
+
+    if (!any_enabled || g_log_drain_mutex != nullptr) {
+        return;
+    }
+
+    for (uint64_t i = 0; i < kLogQueueSlots; i++) {
+        g_log_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    g_log_drain_mutex = new std::mutex();
+    g_log_wakeup_mutex = new std::mutex();
+    g_log_wakeup = new std::condition_variable();
+
+    // Detached: the process may exit without Agent_OnUnload; atexit still flushes
+    std::thread(LogWriterLoop).detach();
+    atexit(FlushLogs);
+}
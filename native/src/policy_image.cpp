@@ -0,0 +1,283 @@
+/**
+ * Precompiled Policy Image for junit-airgap JVMTI Agent
+ *
+ * See policy_image.h for the format. The image is mapped once in Agent_OnLoad and
+ * validated completely before anything reads from it; after that, lookups are plain
+ * loads from the shared mapping (no allocation, no locks).
+ */
+
+#include "agent.h"
+#include "host_policy.h"
+#include "policy_image.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Category for DEBUG_LOG/DEBUG_LOGF in this file
+static constexpr LogCategory kLogCategory = LogCategory::Policy;
+
+static const char kPolicyImageMagic[8] = {'A', 'I', 'R', 'G', 'A', 'P', 'P', 'I'};
+static constexpr uint32_t kPolicyImageVersion = 2;
+static constexpr size_t kPolicyImageHeaderSize = 56;
+static constexpr uint32_t kPolicyImageAllowedSetOffset = 16;
+static constexpr uint32_t kPolicyImageBlockedSetOffset = 36;
+static constexpr uint32_t kPolicyImageMatchAll = 1u << 0;
+
+// Policy compiled into the mapped image (never freed; the mapping outlives every reader)
+static const HostPolicy* g_policy_image_policy = nullptr;
+
+static uint32_t ReadU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t ReadU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/**
+ * 32-bit FNV-1a, the same hash as HashName() and PolicyImageWriter.hash().
+ */
+static uint32_t HashPolicyString(const char* bytes, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (uint8_t)bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static const char* ImageString(const uint8_t* image, uint32_t offset, uint16_t* length) {
+    *length = ReadU16(image + offset);
+    return (const char*)(image + offset + 2);
+}
+
+bool PolicyImagePatternSet::Matches(const std::string& host) const {
+    if (image == nullptr) {
+        return false;
+    }
+
+    if (flags & kPolicyImageMatchAll) {
+        return true;
+    }
+
+    uint32_t bucket_count = ReadU32(image + exact_table);
+    if (bucket_count > 0) {
+        uint32_t hash = HashPolicyString(host.data(), host.size());
+        for (uint32_t i = hash & (bucket_count - 1);; i = (i + 1) & (bucket_count - 1)) {
+            const uint8_t* bucket = image + exact_table + 4 + (size_t)i * 8;
+            uint32_t string_offset = ReadU32(bucket + 4);
+            if (string_offset == 0) {
+                break;
+            }
+
+            uint16_t length;
+            const char* pattern = ImageString(image, string_offset, &length);
+            if (ReadU32(bucket) == hash && length == host.size() && memcmp(pattern, host.data(), length) == 0) {
+                return true;
+            }
+        }
+    }
+
+    uint32_t suffix_count = ReadU32(image + suffix_list);
+    for (uint32_t i = 0; i < suffix_count; i++) {
+        uint16_t length;
+        const char* suffix = ImageString(image, ReadU32(image + suffix_list + 4 + (size_t)i * 4), &length);
+        if (host.size() >= length && memcmp(host.data() + host.size() - length, suffix, length) == 0) {
+            return true;
+        }
+    }
+
+    uint32_t glob_count = ReadU32(image + glob_list);
+    for (uint32_t i = 0; i < glob_count; i++) {
+        uint16_t length;
+        const char* glob = ImageString(image, ReadU32(image + glob_list + 4 + (size_t)i * 4), &length);
+        if (GlobMatches(glob, length, host)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool PolicyImagePatternSet::Empty() const {
+    return image == nullptr ||
+           (!(flags & kPolicyImageMatchAll) &&
+            ReadU32(image + exact_table) == 0 &&
+            ReadU32(image + suffix_list) == 0 &&
+            ReadU32(image + glob_list) == 0 &&
+            ReadU32(image + range_list) == 0);
+}
+
+/**
+ * Check that [offset, offset + length) lies inside the image, after the header.
+ */
+static bool InImage(size_t image_size, uint64_t offset, uint64_t length) {
+    return offset >= kPolicyImageHeaderSize && offset + length <= image_size;
+}
+
+static bool ValidateString(const uint8_t* image, size_t image_size, uint32_t offset) {
+    return InImage(image_size, offset, 2) && InImage(image_size, offset, 2 + (uint64_t)ReadU16(image + offset));
+}
+
+static bool ValidateStringList(const uint8_t* image, size_t image_size, uint32_t offset) {
+    if (!InImage(image_size, offset, 4)) {
+        return false;
+    }
+
+    uint32_t count = ReadU32(image + offset);
+    if (!InImage(image_size, offset, 4 + (uint64_t)count * 4)) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (!ValidateString(image, image_size, ReadU32(image + offset + 4 + (size_t)i * 4))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool ValidateExactTable(const uint8_t* image, size_t image_size, uint32_t offset) {
+    if (!InImage(image_size, offset, 4)) {
+        return false;
+    }
+
+    uint32_t bucket_count = ReadU32(image + offset);
+    if (bucket_count == 0) {
+        return true;
+    }
+    if ((bucket_count & (bucket_count - 1)) != 0 || !InImage(image_size, offset, 4 + (uint64_t)bucket_count * 8)) {
+        return false;
+    }
+
+    // Every entry must hash to what it claims (lookups trust the stored hash), and one
+    // empty bucket must end every probe sequence
+    bool has_empty_bucket = false;
+    for (uint32_t i = 0; i < bucket_count; i++) {
+        const uint8_t* bucket = image + offset + 4 + (size_t)i * 8;
+        uint32_t string_offset = ReadU32(bucket + 4);
+        if (string_offset == 0) {
+            has_empty_bucket = true;
+            continue;
+        }
+        if (!ValidateString(image, image_size, string_offset)) {
+            return false;
+        }
+
+        uint16_t length;
+        const char* pattern = ImageString(image, string_offset, &length);
+        if (ReadU32(bucket) != HashPolicyString(pattern, length)) {
+            return false;
+        }
+    }
+    return has_empty_bucket;
+}
+
+/**
+ * Validate and read the pattern set header at set_offset.
+ */
+static bool ReadPatternSet(const uint8_t* image, size_t image_size, uint32_t set_offset, PolicyImagePatternSet* out) {
+    const uint8_t* header = image + set_offset;
+    out->image = image;
+    out->flags = ReadU32(header);
+    out->exact_table = ReadU32(header + 4);
+    out->suffix_list = ReadU32(header + 8);
+    out->glob_list = ReadU32(header + 12);
+    out->range_list = ReadU32(header + 16);
+
+    return (out->flags & ~kPolicyImageMatchAll) == 0 &&
+           ValidateExactTable(image, image_size, out->exact_table) &&
+           ValidateStringList(image, image_size, out->suffix_list) &&
+           ValidateStringList(image, image_size, out->glob_list) &&
+           ValidateStringList(image, image_size, out->range_list);
+}
+
+/**
+ * Compile a validated set's range list into the set's own (unmapped) patterns.
+ */
+static void AddImageRanges(const PolicyImagePatternSet& image_set, HostPatternSet& set) {
+    uint32_t count = ReadU32(image_set.image + image_set.range_list);
+    for (uint32_t i = 0; i < count; i++) {
+        uint16_t length;
+        const char* pattern =
+            ImageString(image_set.image, ReadU32(image_set.image + image_set.range_list + 4 + (size_t)i * 4), &length);
+        set.Add(std::string(pattern, length));
+    }
+}
+
+/**
+ * Validate a mapped image and compile it into a HostPolicy.
+ *
+ * @return nullptr if the image is malformed (error describes why)
+ */
+static HostPolicy* ReadPolicyImage(const uint8_t* image, size_t image_size, const char** error) {
+    if (image_size < kPolicyImageHeaderSize || memcmp(image, kPolicyImageMagic, sizeof(kPolicyImageMagic)) != 0) {
+        *error = "not a policy image";
+        return nullptr;
+    }
+    if (ReadU32(image + 8) != kPolicyImageVersion) {
+        *error = "unsupported version (plugin and agent out of sync)";
+        return nullptr;
+    }
+    if (ReadU32(image + 12) != image_size) {
+        *error = "size mismatch (truncated or still being written)";
+        return nullptr;
+    }
+
+    HostPolicy* policy = new HostPolicy();
+    if (!ReadPatternSet(image, image_size, kPolicyImageAllowedSetOffset, &policy->allowed.mapped) ||
+        !ReadPatternSet(image, image_size, kPolicyImageBlockedSetOffset, &policy->blocked.mapped)) {
+        delete policy;
+        *error = "corrupt pattern table";
+        return nullptr;
+    }
+    AddImageRanges(policy->allowed.mapped, policy->allowed);
+    AddImageRanges(policy->blocked.mapped, policy->blocked);
+
+    policy->id = NextHostPolicyId();
+    return policy;
+}
+
+bool LoadPolicyImage(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "[junit-airgap:native] WARNING: Cannot open policy image %s (%s) - running without it\n",
+                path, strerror(errno));
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0 || (uint64_t)file_stat.st_size > UINT32_MAX) {
+        fprintf(stderr, "[junit-airgap:native] WARNING: Invalid policy image %s (bad size) - running without it\n", path);
+        close(fd);
+        return false;
+    }
+
+    size_t image_size = (size_t)file_stat.st_size;
+    void* mapping = mmap(nullptr, image_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "[junit-airgap:native] WARNING: Cannot map policy image %s (%s) - running without it\n",
+                path, strerror(errno));
+        return false;
+    }
+
+    const char* error = nullptr;
+    HostPolicy* policy = ReadPolicyImage((const uint8_t*)mapping, image_size, &error);
+    if (policy == nullptr) {
+        fprintf(stderr, "[junit-airgap:native] WARNING: Invalid policy image %s (%s) - running without it\n",
+                path, error);
+        munmap(mapping, image_size);
+        return false;
+    }
+
+    g_policy_image_policy = policy;
+    DEBUG_LOGF("Mapped policy image %s (%zu bytes)", path, image_size);
+    return true;
+}
+
+const HostPolicy* GetPolicyImagePolicy() {
+    return g_policy_image_policy;
+}
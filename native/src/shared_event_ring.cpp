@@ -0,0 +1,271 @@
+/**
+ * Shared Event Ring for junit-airgap JVMTI Agent
+ *
+ * See shared_event_ring.h for the format. The file is mapped read-write and
+ * MAP_SHARED, so every fork writes into the same page-cache pages; the write index
+ * is a std::atomic placed in the mapping, which is valid across processes because
+ * 64-bit atomics are lock-free (address-free) on every supported platform.
+ */
+
+#include "agent.h"
+#include "agent_options.h"
+#include "shared_event_ring.h"
+#include "trace_buffer.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+// Category for DEBUG_LOG/DEBUG_LOGF in this file
+static constexpr LogCategory kLogCategory = LogCategory::Agent;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "event ring needs address-free 64-bit atomics");
+
+bool g_event_ring_enabled = false;
+
+static const char kEventRingMagic[8] = {'A', 'I', 'R', 'G', 'A', 'P', 'E', 'V'};
+static constexpr uint32_t kEventRingVersion = 1;
+static constexpr size_t kEventRingHeaderSize = 64;
+
+struct EventRingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;
+    std::atomic<uint64_t> next_index;
+    uint8_t reserved[32];
+};
+
+struct EventRingRecord {
+    std::atomic<uint64_t> sequence;
+    uint64_t wall_clock_ns;
+    int64_t context_id;
+    uint32_t pid;
+    uint16_t port;
+    uint8_t target;
+    uint8_t verdict;
+    uint8_t path;
+    uint8_t address_length;
+    uint8_t hostname_length;
+    uint8_t reserved;
+    uint8_t address[kInetAddressMaxLength];
+    char hostname[kSharedEventHostnameLength];
+};
+
+static_assert(sizeof(EventRingHeader) == kEventRingHeaderSize, "event ring header layout");
+static_assert(sizeof(EventRingRecord) == 128, "event ring record layout");
+static_assert(offsetof(EventRingRecord, address) == 36 && offsetof(EventRingRecord, hostname) == 52,
+              "event ring record layout");
+
+// Mapping (unmapped only by SuspendSharedEventRing(); the rest is set before the header is published)
+static std::atomic<EventRingHeader*> g_event_ring_header{nullptr};
+static EventRingRecord* g_event_ring_records = nullptr;
+static uint64_t g_event_ring_mask = 0;
+static uint32_t g_event_ring_pid = 0;
+static size_t g_event_ring_size = 0;
+
+// Writers between claiming and publishing a record (SuspendSharedEventRing() waits for 0)
+static std::atomic<uint32_t> g_event_ring_writers{0};
+
+static uint64_t RoundUpToPowerOfTwo(uint64_t value) {
+    uint64_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+/**
+ * Size an empty ring file and write its header. Called with the file locked.
+ */
+static bool CreateEventRing(int fd, uint32_t capacity, const char** error) {
+    uint64_t records = RoundUpToPowerOfTwo(capacity > 0 ? capacity : 1);
+    if (ftruncate(fd, (off_t)(kEventRingHeaderSize + records * sizeof(EventRingRecord))) != 0) {
+        *error = strerror(errno);
+        return false;
+    }
+
+    uint8_t header[kEventRingHeaderSize] = {};
+    uint32_t version = kEventRingVersion;
+    uint32_t record_size = (uint32_t)sizeof(EventRingRecord);
+    memcpy(header, kEventRingMagic, sizeof(kEventRingMagic));
+    memcpy(header + 8, &version, sizeof(version));
+    memcpy(header + 12, &record_size, sizeof(record_size));
+    memcpy(header + 16, &records, sizeof(records));
+    if (pwrite(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+        *error = strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Check an existing ring file's header against its size.
+ *
+ * @return Capacity in records, or 0 if the file is not a valid ring
+ */
+static uint64_t ValidateEventRing(int fd, off_t file_size, const char** error) {
+    uint8_t header[kEventRingHeaderSize];
+    if (file_size < (off_t)kEventRingHeaderSize || pread(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+        *error = "truncated header";
+        return 0;
+    }
+
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;
+    memcpy(&version, header + 8, sizeof(version));
+    memcpy(&record_size, header + 12, sizeof(record_size));
+    memcpy(&capacity, header + 16, sizeof(capacity));
+
+    if (memcmp(header, kEventRingMagic, sizeof(kEventRingMagic)) != 0) {
+        *error = "bad magic";
+        return 0;
+    }
+    if (version != kEventRingVersion || record_size != sizeof(EventRingRecord)) {
+        *error = "unsupported version";
+        return 0;
+    }
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        (uint64_t)file_size != kEventRingHeaderSize + capacity * sizeof(EventRingRecord)) {
+        *error = "bad size";
+        return 0;
+    }
+    return capacity;
+}
+
+bool InitSharedEventRing(const char* path, uint32_t capacity) {
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "[junit-airgap:native] WARNING: Cannot open event ring %s (%s) - running without it\n",
+                path, strerror(errno));
+        return false;
+    }
+
+    // Forks start together; the lock makes exactly one of them create the header
+    const char* error = nullptr;
+    uint64_t records = 0;
+    struct stat file_stat;
+    if (flock(fd, LOCK_EX) != 0 || fstat(fd, &file_stat) != 0) {
+        error = strerror(errno);
+    } else if (file_stat.st_size == 0) {
+        if (CreateEventRing(fd, capacity, &error)) {
+            records = RoundUpToPowerOfTwo(capacity > 0 ? capacity : 1);
+        }
+    } else {
+        records = ValidateEventRing(fd, file_stat.st_size, &error);
+    }
+    flock(fd, LOCK_UN);
+
+    if (records == 0) {
+        fprintf(stderr, "[junit-airgap:native] WARNING: Invalid event ring %s (%s) - running without it\n",
+                path, error);
+        close(fd);
+        return false;
+    }
+
+    size_t ring_size = kEventRingHeaderSize + (size_t)records * sizeof(EventRingRecord);
+    void* mapping = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "[junit-airgap:native] WARNING: Cannot map event ring %s (%s) - running without it\n",
+                path, strerror(errno));
+        return false;
+    }
+
+    g_event_ring_records = (EventRingRecord*)((uint8_t*)mapping + kEventRingHeaderSize);
+    g_event_ring_mask = records - 1;
+    g_event_ring_pid = (uint32_t)getpid();
+    g_event_ring_size = ring_size;
+    g_event_ring_header.store((EventRingHeader*)mapping, std::memory_order_seq_cst);
+    g_event_ring_enabled = true;
+    DEBUG_LOGF("Recording interceptions to event ring %s (%llu records)", path, (unsigned long long)records);
+    return true;
+}
+
+void SuspendSharedEventRing() {
+    g_event_ring_enabled = false;
+    EventRingHeader* header = g_event_ring_header.exchange(nullptr, std::memory_order_seq_cst);
+    if (header == nullptr) {
+        return;
+    }
+
+    // A writer that loaded the header before the exchange has counted itself in
+    while (g_event_ring_writers.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+    munmap(header, g_event_ring_size);
+    DEBUG_LOG("Event ring unmapped for checkpoint");
+}
+
+bool ResumeSharedEventRing() {
+    if (g_agent_options.events_path.empty() || g_event_ring_header.load(std::memory_order_acquire) != nullptr) {
+        return true;
+    }
+    return InitSharedEventRing(g_agent_options.events_path.c_str(), g_agent_options.events_capacity);
+}
+
+bool IsSharedEventPath(TracePath path) {
+    switch (path) {
+        case TracePath::PolicyImage:
+        case TracePath::VerdictCache:
+        case TracePath::DnsCache:
+        case TracePath::HostOverride:
+        case TracePath::Policy:
+        case TracePath::Java:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void RecordSharedEvent(
+    InterceptTarget target,
+    TracePath path,
+    TraceVerdict verdict,
+    int64_t context_id,
+    const InetAddressBytes& address,
+    int32_t port,
+    const char* hostname,
+    size_t hostname_length
+) {
+    // Counted in before loading the header, so SuspendSharedEventRing() can't unmap it under us
+    g_event_ring_writers.fetch_add(1, std::memory_order_seq_cst);
+    EventRingHeader* header = g_event_ring_header.load(std::memory_order_seq_cst);
+    if (header == nullptr) {
+        g_event_ring_writers.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+
+    uint64_t index = header->next_index.fetch_add(1, std::memory_order_relaxed);
+    EventRingRecord& record = g_event_ring_records[index & g_event_ring_mask];
+
+    // Unpublish first, so a reader never pairs the old sequence with new fields
+    record.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint8_t address_length = address.length <= kInetAddressMaxLength ? address.length : 0;
+    record.wall_clock_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    record.context_id = context_id;
+    record.pid = g_event_ring_pid;
+    record.port = (uint16_t)port;
+    record.target = (uint8_t)target;
+    record.verdict = (uint8_t)verdict;
+    record.path = (uint8_t)path;
+    record.address_length = address_length;
+    record.hostname_length = (uint8_t)hostname_length;
+    memset(record.address, 0, sizeof(record.address));
+    memcpy(record.address, address.bytes, address_length);
+    memcpy(record.hostname, hostname, hostname_length);
+
+    record.sequence.store(index + 1, std::memory_order_release);
+    g_event_ring_writers.fetch_sub(1, std::memory_order_release);
+}
@@ -6,11 +6,16 @@
  * ## Interception Strategy
  *
  * 1. Store original function pointers when NativeMethodBindCallback is called
- * 2. Replace with our wrapper functions
+ * 2. Replace with our wrapper functions, generated by Interceptor<Traits> (interceptor.h)
+ *    in front of each target's Intercept()
  * 3. Wrapper functions:
- *    - Get NetworkConfiguration from thread-local storage (via JNI call to Kotlin)
- *    - Check if connection is allowed
- *    - If blocked: throw NetworkRequestAttemptedException
+ *    - Before NetworkBlockerContext registers, enforce the policy image if one is loaded
+ *    - Skip everything while no configuration is armed anywhere (native flag, no upcall)
+ *    - Check if the current thread has an active configuration (via JNI call to Kotlin)
+ *    - Check the per-thread verdict cache for a previous allow of (address, port)
+ *    - Resolve the target's hostname from the forward-DNS binding table (never reverse DNS)
+ *    - Check if connection is allowed by the native host policy (no upcall)
+ *    - If blocked: ask NetworkBlockerContext.evaluate() once; throw only if it still blocks
  *    - If allowed: call original native function
  *
  * ## Target Method: sun.nio.ch.Net.connect0()
@@ -23,124 +28,88 @@
  */
 
 #include "agent.h"
+#include "dns_binding_table.h"
+#include "host_policy.h"
+#include "interceptor.h"
+#include "log_sink.h"
+#include "policy_image.h"
+#include "trace_buffer.h"
+#include "verdict_cache.h"
+#include <array>
+#include <cerrno>
 #include <cstring>
+#include <mutex>
+#include <utility>
+
+// Category for DEBUG_LOG/DEBUG_LOGF in this file
+static constexpr LogCategory kLogCategory = LogCategory::Socket;
 
 // Function pointer type for sun.nio.ch.Net.connect0()
 // Signature: (ZLjava/io/FileDescriptor;Ljava/net/InetAddress;I)I
-typedef jint (*NetConnect0Func)(JNIEnv*, jclass, jboolean, jobject, jobject, jint);
+typedef jint (JNICALL *NetConnect0Func)(JNIEnv*, jclass, jboolean, jobject, jobject, jint);
 
-// Storage for original function pointer
-static NetConnect0Func original_Net_connect0 = nullptr;
+struct NetConnect0Traits {
+    static constexpr InterceptTarget kTarget = InterceptTarget::NetConnect0;
+    using Signature = jint(JNIEnv*, jclass, jboolean, jobject, jobject, jint);
+    static constexpr bool kNeedsPlatformEncoding = false;
 
-/**
- * Check if a host (by IP or hostname) is explicitly blocked.
- *
- * @param env JNI environment
- * @param contextClass NetworkBlockerContext class
- * @param isExplicitlyBlockedMethod isExplicitlyBlocked method ID
- * @param hostString The host to check (IP or hostname)
- * @param hostCStr C string representation for logging
- * @return true if host is explicitly blocked, false otherwise
- */
-static bool isHostExplicitlyBlocked(
-    JNIEnv* env,
-    jclass contextClass,
-    jmethodID isExplicitlyBlockedMethod,
-    jstring hostString,
-    const char* hostCStr
-) {
-    if (hostString == nullptr || hostCStr == nullptr) {
-        return false;
-    }
-
-    bool blocked = env->CallStaticBooleanMethod(contextClass, isExplicitlyBlockedMethod, hostString);
-    if (blocked) {
-        DEBUG_LOGF("Host %s is explicitly blocked", hostCStr);
-    }
-    return blocked;
-}
+    static jint Intercept(JNIEnv* env, InterceptTrace& trace, NetConnect0Func original,
+                          jclass cls, jboolean preferIPv6, jobject fd, jobject remote, jint remotePort);
+};
 
 /**
- * Try to allow connection by checking IP address first, then hostname as fallback.
+ * Check a connection against the policy image (before NetworkBlockerContext registers).
  *
- * @param env JNI environment
- * @param contextClass NetworkBlockerContext class
- * @param checkConnectionMethod checkConnection method ID
- * @param ipAddressString IP address to check (may be null)
- * @param ipAddressCStr C string for logging
- * @param hostnameString Hostname to check (may be null)
- * @param hostnameCStr C string for logging
- * @param remotePort Port number
- * @param callerString Caller info for exception messages
- * @return true if connection is blocked, false if allowed
+ * Uses only the address and the forward-DNS binding table (no Java strings), and throws
+ * java.net.ConnectException itself on a block, since there is no NetworkBlockerContext
+ * to build NetworkRequestAttemptedException yet.
+ *
+ * @return true if the connection was blocked (exception pending)
  */
-static bool tryAllowConnection(
+static bool BlockedByPolicyImage(
     JNIEnv* env,
-    jclass contextClass,
-    jmethodID checkConnectionMethod,
-    jstring ipAddressString,
-    const char* ipAddressCStr,
-    jstring hostnameString,
-    const char* hostnameCStr,
+    const AgentContext* agentContext,
+    const HostPolicy& policy,
+    const InetAddressBytes& addressBytes,
     jint remotePort,
-    jstring callerString
+    InterceptTrace& trace
 ) {
-    // Try IP address first (prioritize actual connection target over reverse DNS)
-    if (ipAddressString != nullptr && ipAddressCStr != nullptr) {
-        DEBUG_LOGF("Checking IP address: %s", ipAddressCStr);
-        env->CallStaticVoidMethod(contextClass, checkConnectionMethod, ipAddressString, remotePort, callerString);
-
-        if (!env->ExceptionCheck()) {
-            DEBUG_LOG("IP address allowed");
-            return false; // Connection allowed
-        }
-
-        // IP not allowed, clear exception and try hostname
-        DEBUG_LOGF("IP address %s not allowed, trying hostname", ipAddressCStr);
-        env->ExceptionClear();
-
-        // Try with hostname (if available)
-        if (hostnameString != nullptr && hostnameCStr != nullptr) {
-            DEBUG_LOGF("Checking hostname: %s", hostnameCStr);
-            env->CallStaticVoidMethod(contextClass, checkConnectionMethod, hostnameString, remotePort, callerString);
-
-            if (!env->ExceptionCheck()) {
-                DEBUG_LOG("Hostname allowed (IP address was not)");
-                return false; // Connection allowed
-            }
+    if (agentContext->connect_exception_class == nullptr) {
+        return false;
+    }
+    trace.Target(addressBytes, remotePort);
 
-            DEBUG_LOG("Both IP address and hostname not allowed");
-            return true; // Connection blocked
-        }
+    char addressText[kInetAddressTextMaxLength];
+    FormatInetAddress(addressBytes, addressText);
+    char boundHostName[kDnsBindingMaxHostnameLength + 1];
+    const char* hostName = LookupDnsBinding(addressBytes, boundHostName) ? boundHostName : nullptr;
+    trace.Host(hostName);
 
-        // No hostname to check, connection is blocked
-        // Re-throw the exception from IP check
-        env->CallStaticVoidMethod(contextClass, checkConnectionMethod, ipAddressString, remotePort, callerString);
-        return true; // Connection blocked
+    PolicyVerdict verdict = EvaluateConnectPolicy(policy, hostName, addressText);
+    if (!verdict.blocked) {
+        return false;
     }
 
-    // No IP address available, check hostname only
-    if (hostnameString != nullptr && hostnameCStr != nullptr) {
-        DEBUG_LOGF("Checking hostname only: %s", hostnameCStr);
-        env->CallStaticVoidMethod(contextClass, checkConnectionMethod, hostnameString, remotePort, callerString);
+    const char* culprit = verdict.culprit == PolicyCulprit::Hostname ? hostName : addressText;
+    DEBUG_LOGF("Connection to %s:%d blocked by policy image", culprit, remotePort);
 
-        if (env->ExceptionCheck()) {
-            DEBUG_LOG("Hostname not allowed");
-            return true; // Connection blocked
-        }
-        return false; // Connection allowed
+    char message[kDnsBindingMaxHostnameLength + 96];
+    snprintf(message, sizeof(message), "Network request to %s:%d blocked by junit-airgap (policy image)",
+             culprit, (int)remotePort);
+    if (EnsurePlatformEncodingReady(env) && !env->ExceptionCheck()) {
+        env->ThrowNew(agentContext->connect_exception_class, message);
     }
-
-    // No host information available - allow by default
-    return false;
+    return env->ExceptionCheck();
 }
 
 /**
- * Wrapper for sun.nio.ch.Net.connect0()
+ * Armed path of the sun.nio.ch.Net.connect0() wrapper
  *
  * This wrapper intercepts all socket connections in modern Java.
  *
  * @param env JNI environment
+ * @param trace Trace record for this call
+ * @param original Original Net.connect0() implementation
  * @param cls Class (sun.nio.ch.Net)
  * @param preferIPv6 Whether to prefer IPv6
  * @param fd File descriptor
@@ -148,15 +117,17 @@ static bool tryAllowConnection(
  * @param remotePort Port to connect to
  * @return Connection result (0 = success, -1 = in progress, -2 = error)
  */
-jint JNICALL wrapped_Net_connect0(
+jint NetConnect0Traits::Intercept(
     JNIEnv* env,
+    InterceptTrace& trace,
+    NetConnect0Func original,
     jclass cls,
     jboolean preferIPv6,
     jobject fd,
     jobject remote,
     jint remotePort
 ) {
-    DEBUG_LOG("wrapped_Net_connect0() called - intercepting connection attempt");
+    DEBUG_LOG("Net.connect0() called - intercepting connection attempt");
 
     // IMPORTANT: Platform encoding initialization happens AFTER VM_INIT
     // Even though VM_INIT completes, platform encoding may not be ready yet
@@ -166,18 +137,37 @@ jint JNICALL wrapped_Net_connect0(
     // Check 1: VM_INIT must be complete (basic JVM initialization)
     if (!g_vm_init_complete) {
         DEBUG_LOG("VM_INIT not complete - allowing socket connection without interception");
-        if (original_Net_connect0 != nullptr) {
-            return original_Net_connect0(env, cls, preferIPv6, fd, remote, remotePort);
+        trace.Decide(TracePath::VmInitPending, TraceVerdict::Allowed);
+        if (original != nullptr) {
+            return original(env, cls, preferIPv6, fd, remote, remotePort);
         }
         return -2; // Error if original function not available
     }
 
     // Check 2: NetworkBlockerContext must be registered (platform encoding ready)
-    jclass contextClass = GetNetworkBlockerContextClass();
+    // Single lock-free load of the cached class/method/string references
+    const AgentContext* agentContext = GetAgentContext();
+    jclass contextClass = agentContext->network_blocker_context_class;
     if (contextClass == nullptr) {
+        const HostPolicy* imagePolicy = GetPolicyImagePolicy();
+        InetAddressBytes imageAddress;
+        if (imagePolicy != nullptr && remote != nullptr &&
+            DecodeInetAddress(env, agentContext->inet_address, remote, &imageAddress)) {
+            bool blocked = BlockedByPolicyImage(env, agentContext, *imagePolicy, imageAddress, remotePort, trace);
+            trace.Decide(TracePath::PolicyImage, blocked ? TraceVerdict::Blocked : TraceVerdict::Allowed);
+            if (blocked) {
+                return -2; // Error code, ConnectException is pending
+            }
+            if (original != nullptr) {
+                return original(env, cls, preferIPv6, fd, remote, remotePort);
+            }
+            return -2; // Error if original function not available
+        }
+
         DEBUG_LOG("NetworkBlockerContext not registered - allowing socket connection without interception (platform encoding may not be ready)");
-        if (original_Net_connect0 != nullptr) {
-            return original_Net_connect0(env, cls, preferIPv6, fd, remote, remotePort);
+        trace.Decide(TracePath::Unregistered, TraceVerdict::Allowed);
+        if (original != nullptr) {
+            return original(env, cls, preferIPv6, fd, remote, remotePort);
         }
         return -2; // Error if original function not available
     }
@@ -185,159 +175,172 @@ jint JNICALL wrapped_Net_connect0(
     // Both VM_INIT and NetworkBlockerContext ready - safe to proceed
     DEBUG_LOG("VM_INIT complete and NetworkBlockerContext registered - proceeding with socket interception");
 
-    // Check 3: Is there an active configuration? (optimization to skip string extraction)
-    // If no configuration is set (e.g., @AllowNetworkRequests tests), we can skip all
-    // JNI string operations and immediately allow the connection. This avoids platform
-    // encoding issues in edge cases where VM_INIT is complete but platform encoding
-    // might not be fully ready for all string operations.
-    jmethodID hasActiveConfigMethod = GetHasActiveConfigurationMethod();
-    if (hasActiveConfigMethod == nullptr) {
-        // Method not registered yet - assume no configuration and allow
-        DEBUG_LOG("hasActiveConfiguration method not registered - allowing socket connection without interception");
-        if (original_Net_connect0 != nullptr) {
-            return original_Net_connect0(env, cls, preferIPv6, fd, remote, remotePort);
+    // Check 3: Is any configuration set anywhere in the JVM? (one relaxed atomic load)
+    // Between tests and in tests that never block, nothing can be denied, so skip the
+    // activeContextId() upcall entirely. The wrapper's gate already took this path
+    // unless the agent is tracing.
+    if (IsAgentDisarmed()) {
+        DEBUG_LOG("Agent disarmed - allowing socket connection without interception");
+        trace.Decide(TracePath::Disarmed, TraceVerdict::Allowed);
+        if (original != nullptr) {
+            return original(env, cls, preferIPv6, fd, remote, remotePort);
         }
         return -2; // Error if original function not available
     }
 
-    jboolean hasConfig = env->CallStaticBooleanMethod(contextClass, hasActiveConfigMethod);
+    // Check 4: Which test context is this thread in, if any? (optimization to skip string extraction)
+    // If no configuration is set (e.g., @AllowNetworkRequests tests), we can skip all
+    // JNI string operations and immediately allow the connection. This avoids platform
+    // encoding issues in edge cases where VM_INIT is complete but platform encoding
+    // might not be fully ready for all string operations.
+    //
+    // A shared (JVM-wide) configuration applies to every thread, so there is nothing
+    // per-thread to ask. Otherwise the context selects the policy to evaluate against:
+    // parallel tests each have their own.
+    int64_t contextId = 0;
+    uint64_t contextUpcallStart = trace.BeginUpcall();
+    bool hasConfig = ResolveThreadContext(env, agentContext, &contextId);
+    trace.EndUpcall(contextUpcallStart);
+    trace.Context(contextId);
     if (!hasConfig) {
         DEBUG_LOG("No active configuration - allowing socket connection without interception");
-        if (original_Net_connect0 != nullptr) {
-            return original_Net_connect0(env, cls, preferIPv6, fd, remote, remotePort);
+        trace.Decide(TracePath::NoConfiguration, TraceVerdict::Allowed);
+        if (original != nullptr) {
+            return original(env, cls, preferIPv6, fd, remote, remotePort);
         }
         return -2; // Error if original function not available
     }
     DEBUG_LOG("Active configuration detected - proceeding with interception");
 
+    // Decode the raw target address via cached field IDs (no Java String allocation)
+    InetAddressBytes addressBytes;
+    bool hasAddress = DecodeInetAddress(env, agentContext->inet_address, remote, &addressBytes);
+
+    // Check 5: Was this (address, port) already allowed under the current generation
+    // and this context's policy? Repeated connects (connection pools, retries) skip
+    // string extraction and policy evaluation entirely.
+    VerdictCacheKey cacheKey;
+    if (hasAddress) {
+        trace.Target(addressBytes, remotePort);
+        BuildVerdictCacheKey(addressBytes, remotePort, &cacheKey);
+        if (LookupAllowedVerdict(cacheKey, contextId)) {
+            DEBUG_LOG("Verdict cache hit - allowing socket connection");
+            trace.Decide(TracePath::VerdictCache, TraceVerdict::Allowed);
+            if (original != nullptr) {
+                return original(env, cls, preferIPv6, fd, remote, remotePort);
+            }
+            return -2; // Error if original function not available
+        }
+    }
+
     // Extract both hostname and IP address from InetAddress
     // We need to check BOTH because:
     // 1. User might allowlist "example.com" (hostname)
     // 2. User might allowlist "127.0.0.1" (IP address)
     // 3. DNS interception checks hostname, socket should check both hostname and IP
+    //
+    // The IP text is formatted natively into a stack buffer; a Java String for it is
+    // only created if a block needs it for the exception message.
+    char hostAddressText[kInetAddressTextMaxLength];
+    const char* hostAddressCStr = nullptr;
+    char boundHostName[kDnsBindingMaxHostnameLength + 1];
     jstring hostNameString = nullptr;
-    jstring hostAddressString = nullptr;
     const char* hostNameCStr = nullptr;
-    const char* hostAddressCStr = nullptr;
-
-    if (remote != nullptr) {
-        jclass inetAddressClass = env->FindClass("java/net/InetAddress");
-        if (inetAddressClass != nullptr) {
-            // Get IP address (never does reverse DNS)
-            jmethodID getHostAddressMethod = env->GetMethodID(
-                inetAddressClass,
-                "getHostAddress",
-                "()Ljava/lang/String;"
-            );
-
-            if (getHostAddressMethod != nullptr) {
-                hostAddressString = (jstring)env->CallObjectMethod(remote, getHostAddressMethod);
-                if (hostAddressString != nullptr) {
-                    // Test platform encoding before extracting
-                    const char* testStr = env->GetStringUTFChars(hostAddressString, nullptr);
-                    if (testStr != nullptr) {
-                        hostAddressCStr = testStr;  // Keep the string
-                    } else {
-                        DEBUG_LOG("Platform encoding not ready - skipping IP address extraction");
-                        if (env->ExceptionCheck()) {
-                            env->ExceptionClear();
-                        }
-                    }
-                }
-            }
 
-            // Get hostname (may return cached hostname or do reverse DNS)
-            // IMPORTANT: Only do this if platform encoding is ready (tested above)
-            // getHostName() can trigger reverse DNS which requires platform encoding
-            if (hostAddressCStr != nullptr) {
-                jmethodID getHostNameMethod = env->GetMethodID(
-                    inetAddressClass,
-                    "getHostName",
-                    "()Ljava/lang/String;"
-                );
-
-                if (getHostNameMethod != nullptr) {
-                    hostNameString = (jstring)env->CallObjectMethod(remote, getHostNameMethod);
-                    if (hostNameString != nullptr) {
-                        const char* testStr = env->GetStringUTFChars(hostNameString, nullptr);
-                        if (testStr != nullptr) {
-                            hostNameCStr = testStr;  // Keep the string
-                        } else {
-                            DEBUG_LOG("Platform encoding not ready - skipping hostname extraction");
-                            if (env->ExceptionCheck()) {
-                                env->ExceptionClear();
-                            }
-                        }
-                    }
-                }
+    if (hasAddress) {
+        FormatInetAddress(addressBytes, hostAddressText);
+        hostAddressCStr = hostAddressText;
+
+        // Get hostname without ever triggering reverse DNS:
+        // 1. The hostname the InetAddress was created with (what getHostName() returns
+        //    without a lookup; null for addresses created from a literal IP)
+        // 2. Otherwise the forward-DNS binding recorded by the DNS interceptor
+        //    (where getHostName() would have started a reverse lookup)
+        hostNameString = GetInetAddressHostName(env, agentContext->inet_address, remote);
+        if (hostNameString != nullptr) {
+            const char* testStr = env->GetStringUTFChars(hostNameString, nullptr);
+            if (testStr != nullptr) {
+                hostNameCStr = testStr;  // Keep the string
             } else {
-                DEBUG_LOG("Skipping hostname extraction - platform encoding not ready");
+                DEBUG_LOG("Platform encoding not ready - skipping hostname extraction");
+                if (env->ExceptionCheck()) {
+                    env->ExceptionClear();
+                }
             }
-
-            DEBUG_LOGF("Connection attempt - hostname: %s, IP: %s, port: %d",
-                      hostNameCStr ? hostNameCStr : "(null)",
-                      hostAddressCStr ? hostAddressCStr : "(null)",
-                      remotePort);
+        } else if (LookupDnsBinding(addressBytes, boundHostName)) {
+            hostNameCStr = boundHostName;
+            DEBUG_LOG("Hostname found in forward-DNS binding table");
         }
+
+        trace.Host(hostNameCStr);
+        DEBUG_LOGF("Connection attempt - hostname: %s, IP: %s, port: %d",
+                  hostNameCStr ? hostNameCStr : "(null)",
+                  hostAddressCStr,
+                  remotePort);
     }
 
-    // Check NetworkConfiguration via JNI call to Kotlin
+    // Evaluate the connection against the native host policy
+    // (compiled from NetworkConfiguration in NetworkBlockerContext.setConfiguration()).
     // Logic:
     // 1. If hostname is EXPLICITLY in blockedHosts → block (don't check IP)
     // 2. If IP is EXPLICITLY in blockedHosts → block (don't check hostname)
-    // 3. If hostname is allowed → allow
-    // 4. If IP is allowed → allow
+    // 3. If IP is allowed → allow
+    // 4. If hostname is allowed → allow
     // 5. Otherwise → block
+    //
+    // Allowed connections make no upcalls. A block asks NetworkBlockerContext.evaluate()
+    // once for the final verdict: it stays the authority (e.g. Robolectric artifact
+    // downloads are allowed) and only a real block builds and throws
+    // NetworkRequestAttemptedException. See ConfirmBlockedRequest().
     bool connectionBlocked = false;
     if (remote != nullptr) {
-        // Get cached class and method references
-        jclass contextClass = GetNetworkBlockerContextClass();
-        jmethodID checkConnectionMethod = GetCheckConnectionMethod();
-        jmethodID isExplicitlyBlockedMethod = GetIsExplicitlyBlockedMethod();
-
-        if (contextClass != nullptr && checkConnectionMethod != nullptr && isExplicitlyBlockedMethod != nullptr) {
-            // Get cached caller string (initialized during VM_INIT)
-            jstring callerString = GetCallerAgentString();
-
-            // Check if hostname or IP are explicitly blocked (highest priority)
-            bool hostnameExplicitlyBlocked = isHostExplicitlyBlocked(
-                env, contextClass, isExplicitlyBlockedMethod, hostNameString, hostNameCStr
-            );
-            bool ipExplicitlyBlocked = isHostExplicitlyBlocked(
-                env, contextClass, isExplicitlyBlockedMethod, hostAddressString, hostAddressCStr
-            );
-            bool hostIsExplicitlyBlocked = hostnameExplicitlyBlocked || ipExplicitlyBlocked;
-
-            // If explicitly blocked, block the connection immediately
-            if (hostIsExplicitlyBlocked) {
-                DEBUG_LOG("Connection blocked - host explicitly in blockedHosts");
-                connectionBlocked = true;
-                // Call checkConnection to throw the exception with proper details
-                if (hostNameString != nullptr) {
-                    env->CallStaticVoidMethod(contextClass, checkConnectionMethod, hostNameString, remotePort, callerString);
-                } else if (hostAddressString != nullptr) {
-                    env->CallStaticVoidMethod(contextClass, checkConnectionMethod, hostAddressString, remotePort, callerString);
-                }
+        PolicyVerdict verdict = EvaluateConnectPolicy(hostNameCStr, hostAddressCStr, contextId);
+
+        if (verdict.blocked) {
+            DEBUG_LOGF("Connection blocked by native policy - %s: %s",
+                      verdict.culprit == PolicyCulprit::Hostname ? "hostname" : "IP",
+                      verdict.culprit == PolicyCulprit::Hostname ? hostNameCStr : hostAddressCStr);
+
+            // The binding-table hostname has no Java string yet
+            jstring hostnameArg = hostNameString;
+            if (hostnameArg == nullptr && hostNameCStr != nullptr) {
+                hostnameArg = env->NewStringUTF(hostNameCStr);
+            }
+            jstring addressArg = hostAddressCStr != nullptr ? env->NewStringUTF(hostAddressCStr) : nullptr;
+
+            if (!env->ExceptionCheck()) {
+                // Get cached caller string (initialized during VM_INIT)
+                jstring callerString = agentContext->caller_agent_string;
+                uint64_t upcallStart = trace.BeginUpcall();
+                connectionBlocked = ConfirmBlockedRequest(env, agentContext, hostnameArg, addressArg, remotePort,
+                                                          callerString, verdict.culprit == PolicyCulprit::Hostname);
+                trace.EndUpcall(upcallStart);
             } else {
-                // Not explicitly blocked, check if connection is allowed via allowlist
-                connectionBlocked = tryAllowConnection(
-                    env, contextClass, checkConnectionMethod,
-                    hostAddressString, hostAddressCStr,
-                    hostNameString, hostNameCStr,
-                    remotePort, callerString
-                );
+                // OutOfMemoryError while building the arguments: fail closed
+                connectionBlocked = true;
             }
-        } else {
-            DEBUG_LOG("NetworkBlockerContext not registered - allowing connection (agent may not be loaded or class not initialized yet)");
+
+            if (hostnameArg != nullptr && hostnameArg != hostNameString) {
+                env->DeleteLocalRef(hostnameArg);
+            }
+            if (addressArg != nullptr) {
+                env->DeleteLocalRef(addressArg);
+            }
+        } else if (verdict.cacheable && hasAddress) {
+            StoreAllowedVerdict(cacheKey, verdict.policy_id, contextId);
         }
+
+        // A block without a published policy was decided by NetworkBlockerContext
+        trace.Decide(verdict.blocked && verdict.policy_id == 0 ? TracePath::Java : TracePath::Policy,
+                     connectionBlocked ? TraceVerdict::Blocked : TraceVerdict::Allowed);
     }
 
     // Release strings
     if (hostNameString != nullptr && hostNameCStr != nullptr) {
         env->ReleaseStringUTFChars(hostNameString, hostNameCStr);
     }
-    if (hostAddressString != nullptr && hostAddressCStr != nullptr) {
-        env->ReleaseStringUTFChars(hostAddressString, hostAddressCStr);
+    if (hostNameString != nullptr) {
+        env->DeleteLocalRef(hostNameString);
     }
 
     // If connection is blocked, return error
@@ -347,9 +350,9 @@ jint JNICALL wrapped_Net_connect0(
     }
 
     // Call original function
-    if (original_Net_connect0 != nullptr) {
+    if (original != nullptr) {
         DEBUG_LOG("Calling original Net.connect0()");
-        return original_Net_connect0(env, cls, preferIPv6, fd, remote, remotePort);
+        return original(env, cls, preferIPv6, fd, remote, remotePort);
     } else {
         DEBUG_LOG("ERROR: Original Net.connect0() not found!");
         // Return error if we don't have the original function
@@ -367,6 +370,207 @@ jint JNICALL wrapped_Net_connect0(
  */
 void* InstallNetConnect0Wrapper(void* original_address) {
     DEBUG_LOG("Installing wrapper for sun.nio.ch.Net.connect0()");
-    original_Net_connect0 = (NetConnect0Func)original_address;
-    return (void*)wrapped_Net_connect0;
+    return Interceptor<NetConnect0Traits>::Install(original_address);
+}
+
+// ============================================================================
+// Netty native transports: io.netty.channel.unix.Socket.connect()
+// ============================================================================
+
+// Signature: static native int connect(int fd, boolean ipv6, byte[] address, int scopeId, int port)
+// JNI Signature: (IZ[BII)I
+typedef jint (JNICALL *NettySocketConnectFunc)(JNIEnv*, jclass, jint, jboolean, jbyteArray, jint, jint);
+
+// Each Netty native library (epoll, kqueue, every shaded copy) binds its own
+// implementation, so each gets a wrapper with its own original. The table records
+// which library holds which slot, so a rebind reuses it. Sized for a test classpath
+// carrying Netty's own epoll and kqueue libraries plus shaded copies (gRPC, Reactor,
+// AWS SDK, Elasticsearch, Cassandra driver, ...); beyond that, see NettySocketConnectOverflow().
+constexpr size_t kNettyConnectSlots = 16;
+static std::mutex g_netty_connect_mutex;
+static NettySocketConnectFunc g_netty_connect_originals[kNettyConnectSlots] = {};
+
+/**
+ * Decode Netty's NativeInetAddress bytes: 4 bytes, or 16 with IPv4 as an IPv4-mapped
+ * IPv6 address (which is how it reaches the socket, so it is matched as IPv4).
+ */
+static bool DecodeNettyAddress(JNIEnv* env, jbyteArray address, InetAddressBytes* out) {
+    if (address == nullptr) {
+        return false;
+    }
+    jsize length = env->GetArrayLength(address);
+    if (length != 4 && length != 16) {
+        return false;
+    }
+    env->GetByteArrayRegion(address, 0, length, (jbyte*)out->bytes);
+    out->length = (uint8_t)length;
+
+    static const uint8_t kMappedPrefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+    if (length == 16 && memcmp(out->bytes, kMappedPrefix, sizeof(kMappedPrefix)) == 0) {
+        memmove(out->bytes, out->bytes + 12, 4);
+        out->length = 4;
+    }
+    return true;
+}
+
+/**
+ * Decide a Netty connect. Same checks, in the same order, as NetConnect0Traits::Intercept();
+ * Netty passes raw address bytes, so the hostname always comes from the forward-DNS
+ * binding table (Netty resolves through InetAddress unless configured otherwise).
+ *
+ * @return true if the connection is blocked (exception pending)
+ */
+static bool IsNettyConnectBlocked(JNIEnv* env, jbyteArray address, jint port, InterceptTrace& trace) {
+    if (!g_vm_init_complete) {
+        trace.Decide(TracePath::VmInitPending, TraceVerdict::Allowed);
+        return false;
+    }
+
+    InetAddressBytes addressBytes;
+    if (!DecodeNettyAddress(env, address, &addressBytes)) {
+        DEBUG_LOG("Netty connect with an undecodable address - allowing");
+        return false;
+    }
+    trace.Target(addressBytes, port);
+
+    const AgentContext* agentContext = GetAgentContext();
+    jclass contextClass = agentContext->network_blocker_context_class;
+    if (contextClass == nullptr) {
+        const HostPolicy* imagePolicy = GetPolicyImagePolicy();
+        bool blocked = imagePolicy != nullptr &&
+                       BlockedByPolicyImage(env, agentContext, *imagePolicy, addressBytes, port, trace);
+        trace.Decide(imagePolicy != nullptr ? TracePath::PolicyImage : TracePath::Unregistered,
+                     blocked ? TraceVerdict::Blocked : TraceVerdict::Allowed);
+        return blocked;
+    }
+
+    if (IsAgentDisarmed()) {
+        trace.Decide(TracePath::Disarmed, TraceVerdict::Allowed);
+        return false;
+    }
+
+    int64_t contextId = 0;
+    uint64_t contextUpcallStart = trace.BeginUpcall();
+    bool hasConfig = ResolveThreadContext(env, agentContext, &contextId);
+    trace.EndUpcall(contextUpcallStart);
+    trace.Context(contextId);
+    if (!hasConfig) {
+        trace.Decide(TracePath::NoConfiguration, TraceVerdict::Allowed);
+        return false;
+    }
+
+    VerdictCacheKey cacheKey;
+    BuildVerdictCacheKey(addressBytes, port, &cacheKey);
+    if (LookupAllowedVerdict(cacheKey, contextId)) {
+        trace.Decide(TracePath::VerdictCache, TraceVerdict::Allowed);
+        return false;
+    }
+
+    char addressText[kInetAddressTextMaxLength];
+    FormatInetAddress(addressBytes, addressText);
+    char boundHostName[kDnsBindingMaxHostnameLength + 1];
+    const char* hostName = LookupDnsBinding(addressBytes, boundHostName) ? boundHostName : nullptr;
+    trace.Host(hostName);
+    DEBUG_LOGF("Netty connection attempt - hostname: %s, IP: %s, port: %d",
+              hostName ? hostName : "(null)", addressText, port);
+
+    PolicyVerdict verdict = EvaluateConnectPolicy(hostName, addressText, contextId);
+    bool blocked = false;
+    if (verdict.blocked) {
+        jstring hostnameArg = hostName != nullptr ? env->NewStringUTF(hostName) : nullptr;
+        jstring addressArg = env->NewStringUTF(addressText);
+        if (!env->ExceptionCheck()) {
+            uint64_t upcallStart = trace.BeginUpcall();
+            blocked = ConfirmBlockedRequest(env, agentContext, hostnameArg, addressArg, port,
+                                            agentContext->caller_agent_string,
+                                            verdict.culprit == PolicyCulprit::Hostname);
+            trace.EndUpcall(upcallStart);
+        } else {
+            // OutOfMemoryError while building the arguments: fail closed
+            blocked = true;
+        }
+        if (hostnameArg != nullptr) {
+            env->DeleteLocalRef(hostnameArg);
+        }
+        if (addressArg != nullptr) {
+            env->DeleteLocalRef(addressArg);
+        }
+    } else if (verdict.cacheable) {
+        StoreAllowedVerdict(cacheKey, verdict.policy_id, contextId);
+    }
+
+    trace.Decide(verdict.blocked && verdict.policy_id == 0 ? TracePath::Java : TracePath::Policy,
+                 blocked ? TraceVerdict::Blocked : TraceVerdict::Allowed);
+    return blocked;
+}
+
+/**
+ * io.netty.channel.unix.Socket.connect(), one instance (and so one wrapper and one
+ * original) per bound library.
+ */
+template <size_t Slot>
+struct NettySocketConnectTraits {
+    static constexpr InterceptTarget kTarget = InterceptTarget::NettySocketConnect;
+    using Signature = jint(JNIEnv*, jclass, jint, jboolean, jbyteArray, jint, jint);
+    static constexpr bool kNeedsPlatformEncoding = false;
+
+    /**
+     * @return Netty's result (0 = connected, negative errno otherwise); ignored by the
+     *         caller when a block leaves an exception pending
+     */
+    static jint Intercept(JNIEnv* env, InterceptTrace& trace, NettySocketConnectFunc original,
+                          jclass cls, jint fd, jboolean ipv6, jbyteArray address, jint scopeId, jint port) {
+        if (IsNettyConnectBlocked(env, address, port, trace)) {
+            DEBUG_LOG("Netty connection blocked - exception will propagate");
+            return -1;
+        }
+        return original(env, cls, fd, ipv6, address, scopeId, port);
+    }
+};
+
+template <size_t... Slots>
+static constexpr auto MakeNettyConnectInstallers(std::index_sequence<Slots...>) {
+    using Installer = void* (*)(void*);
+    return std::array<Installer, sizeof...(Slots)>{&Interceptor<NettySocketConnectTraits<Slots>>::Install...};
+}
+
+static constexpr auto kNettyConnectInstallers =
+    MakeNettyConnectInstallers(std::make_index_sequence<kNettyConnectSlots>());
+
+/**
+ * Bound for a Netty library that found every slot taken. There is no original to call,
+ * so every connect through that library fails closed: a blocked host gets the usual
+ * exception, anything else is refused with EACCES (a ConnectException from Netty) and
+ * recorded as blocked, with a rate-limited warning.
+ */
+static jint JNICALL NettySocketConnectOverflow(JNIEnv* env, jclass cls, jint fd, jboolean ipv6,
+                                               jbyteArray address, jint scopeId, jint port) {
+    InterceptTrace trace(InterceptTarget::NettySocketConnect);
+    if (IsNettyConnectBlocked(env, address, port, trace)) {
+        return -1;
+    }
+    trace.Decide(trace.decided ? trace.event.path : TracePath::Java, TraceVerdict::Blocked);
+    LOG_WARNING("Refused a Netty connect to port %d: its native library has no interception slot "
+                "(more than %zu Netty libraries loaded)", port, kNettyConnectSlots);
+    return -EACCES;
+}
+
+/**
+ * Install wrapper for a Netty library's Socket.connect().
+ *
+ * @param original_address That library's implementation
+ * @return Wrapper address; NettySocketConnectOverflow() if every slot is taken
+ */
+void* InstallNettySocketConnectWrapper(void* original_address) {
+    std::lock_guard<std::mutex> lock(g_netty_connect_mutex);
+    for (size_t slot = 0; slot < kNettyConnectSlots; slot++) {
+        if (g_netty_connect_originals[slot] == (NettySocketConnectFunc)original_address ||
+            g_netty_connect_originals[slot] == nullptr) {
+            g_netty_connect_originals[slot] = (NettySocketConnectFunc)original_address;
+            return kNettyConnectInstallers[slot](original_address);
+        }
+    }
+    fprintf(stderr, "[junit-airgap:native] ERROR: More than %zu Netty native libraries loaded - "
+                    "every connect through the rest is refused\n", kNettyConnectSlots);
+    return (void*)&NettySocketConnectOverflow;
 }
@@ -0,0 +1,342 @@
+/**
+ * Interception Trace Buffer for junit-airgap JVMTI Agent
+ *
+ * See trace_buffer.h. Each thread owns one ring of TraceSlots. A slot is a seqlock
+ * over std::atomic words (as in dns_binding_table.cpp), so the drainer can copy
+ * records while the owner keeps writing without a data race:
+ *
+ *   sequence == 2 * index + 1   record `index` is being written
+ *   sequence == 2 * index + 2   record `index` is complete
+ *
+ * The drainer only accepts a slot whose sequence names the record it expects, before
+ * and after copying; anything else was overwritten and is counted as dropped.
+ */
+
+#include "agent.h"
+#include "trace_buffer.h"
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Category for DEBUG_LOG/DEBUG_LOGF in this file
+static constexpr LogCategory kLogCategory = LogCategory::Agent;
+
+bool g_trace_enabled = false;
+
+// Record payload in 64-bit words (see PackTraceEvent())
+static constexpr size_t kTraceRecordWords = 5;
+
+struct TraceSlot {
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<uint64_t> words[kTraceRecordWords];
+};
+
+/**
+ * One thread's ring. head is written only by the owning thread; drained only by
+ * DrainTraceBuffers() under g_trace_rings_mutex. retired is set once the owning
+ * thread has exited, after its last write to head.
+ */
+struct TraceRing {
+    uint32_t thread_index;
+    uint64_t capacity_mask;
+    std::unique_ptr<TraceSlot[]> slots;
+    std::atomic<uint64_t> head{0};
+    uint64_t drained = 0;
+    std::atomic<bool> retired{false};
+};
+
+/**
+ * Marks the calling thread's ring retired when the thread exits. The ring itself
+ * stays in g_trace_rings until DrainTraceBuffers() has written out its last records.
+ */
+struct TraceRingOwner {
+    TraceRing* ring = nullptr;
+
+    ~TraceRingOwner();
+};
+
+// Rings of live threads and of exited threads with undrained records
+static std::mutex g_trace_rings_mutex;
+static std::vector<std::unique_ptr<TraceRing>> g_trace_rings;
+
+// Fully drained rings of exited threads, reused before allocating a new one
+static constexpr size_t kMaxFreeTraceRings = 8;
+static std::vector<std::unique_ptr<TraceRing>> g_free_trace_rings;
+static uint32_t g_next_trace_thread_index = 0;
+
+static thread_local TraceRingOwner t_trace_ring_owner;
+
+TraceRingOwner::~TraceRingOwner() {
+    if (ring != nullptr) {
+        ring->retired.store(true, std::memory_order_release);
+        ring = nullptr;
+    }
+}
+
+static std::string g_trace_path;
+static uint32_t g_trace_ring_capacity = 0;
+static std::chrono::steady_clock::time_point g_trace_epoch;
+
+static const char* const kTraceVerdictNames[] = {"allowed", "blocked"};
+static const char* const kTracePathNames[] = {
+    "vm-init-pending", "unregistered", "policy-image", "disarmed", "no-configuration", "verdict-cache", "dns-cache",
+    "host-override", "policy", "java",
+};
+static_assert(sizeof(kTracePathNames) / sizeof(kTracePathNames[0]) == kTracePathCount,
+              "kTracePathNames must name every TracePath");
+
+static uint32_t RoundUpToPowerOfTwo(uint32_t value) {
+    uint32_t result = 1;
+    while (result < value && result < (1u << 31)) {
+        result <<= 1;
+    }
+    return result;
+}
+
+/**
+ * Substitute "%p" with the process id.
+ */
+static std::string ExpandTracePath(const char* path) {
+    std::string expanded(path);
+    size_t placeholder = expanded.find("%p");
+    if (placeholder != std::string::npos) {
+        expanded.replace(placeholder, 2, std::to_string((long)getpid()));
+    }
+    return expanded;
+}
+
+bool InitTraceBuffers(const char* path, uint32_t records_per_thread) {
+    g_trace_path = ExpandTracePath(path);
+    g_trace_ring_capacity = RoundUpToPowerOfTwo(records_per_thread > 0 ? records_per_thread : 1);
+    g_trace_epoch = std::chrono::steady_clock::now();
+
+    FILE* file = fopen(g_trace_path.c_str(), "w");
+    if (file == nullptr) {
+        fprintf(stderr, "[junit-airgap:native] WARNING: Cannot create trace file %s - tracing disabled\n",
+                g_trace_path.c_str());
+        return false;
+    }
+    fclose(file);
+
+    g_trace_enabled = true;
+    DEBUG_LOGF("Tracing to %s (%u records per thread)", g_trace_path.c_str(), g_trace_ring_capacity);
+    return true;
+}
+
+uint64_t TraceNow() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - g_trace_epoch).count();
+}
+
+static uint64_t SaturateToUint32(uint64_t value) {
+    return value > UINT32_MAX ? UINT32_MAX : value;
+}
+
+/**
+ * Pack an event into record words:
+ *   [0] timestamp_ns
+ *   [1] decision_ns (low 32 bits) | upcall_ns (high 32 bits), both saturated
+ *   [2] target | verdict << 8 | path << 16 | address length << 24 | port << 32
+ *   [3..4] address bytes (zero padded)
+ */
+static void PackTraceEvent(const TraceEvent& event, uint64_t words[kTraceRecordWords]) {
+    uint8_t address_length = event.address.length <= kInetAddressMaxLength ? event.address.length : 0;
+
+    words[0] = event.timestamp_ns;
+    words[1] = SaturateToUint32(event.decision_ns) | (SaturateToUint32(event.upcall_ns) << 32);
+    words[2] = (uint64_t)event.target |
+               ((uint64_t)event.verdict << 8) |
+               ((uint64_t)event.path << 16) |
+               ((uint64_t)address_length << 24) |
+               ((uint64_t)(uint32_t)event.port << 32);
+
+    uint8_t padded[kInetAddressMaxLength] = {};
+    memcpy(padded, event.address.bytes, address_length);
+    memcpy(&words[3], padded, sizeof(padded));
+}
+
+static void UnpackTraceEvent(const uint64_t words[kTraceRecordWords], TraceEvent* event) {
+    event->timestamp_ns = words[0];
+    event->decision_ns = words[1] & UINT32_MAX;
+    event->upcall_ns = words[1] >> 32;
+    event->target = (InterceptTarget)(words[2] & 0xff);
+    event->verdict = (TraceVerdict)((words[2] >> 8) & 0xff);
+    event->path = (TracePath)((words[2] >> 16) & 0xff);
+    event->address.length = (uint8_t)((words[2] >> 24) & 0xff);
+    event->port = (jint)(uint32_t)(words[2] >> 32);
+    memcpy(event->address.bytes, &words[3], kInetAddressMaxLength);
+}
+
+/**
+ * Get the calling thread's ring, reusing a drained one or allocating it on first use.
+ *
+ * A reused ring keeps its head (equal to drained), so slots still holding an exited
+ * thread's records never match an index the new owner hasn't written.
+ */
+static TraceRing* GetThreadTraceRing() {
+    TraceRingOwner& owner = t_trace_ring_owner;
+    if (owner.ring != nullptr) {
+        return owner.ring;
+    }
+
+    std::unique_ptr<TraceRing> ring;
+    std::lock_guard<std::mutex> lock(g_trace_rings_mutex);
+    if (!g_free_trace_rings.empty()) {
+        ring = std::move(g_free_trace_rings.back());
+        g_free_trace_rings.pop_back();
+        ring->retired.store(false, std::memory_order_relaxed);
+    } else {
+        ring.reset(new TraceRing());
+        ring->capacity_mask = g_trace_ring_capacity - 1;
+        ring->slots.reset(new TraceSlot[g_trace_ring_capacity]);
+    }
+
+    ring->thread_index = g_next_trace_thread_index++;
+    owner.ring = ring.get();
+    g_trace_rings.push_back(std::move(ring));
+    return owner.ring;
+}
+
+void RecordTraceEvent(const TraceEvent& event) {
+    TraceRing* ring = GetThreadTraceRing();
+
+    uint64_t words[kTraceRecordWords];
+    PackTraceEvent(event, words);
+
+    uint64_t index = ring->head.load(std::memory_order_relaxed);
+    TraceSlot& slot = ring->slots[index & ring->capacity_mask];
+
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kTraceRecordWords; i++) {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+
+    ring->head.store(index + 1, std::memory_order_release);
+}
+
+/**
+ * Copy record `index` out of a ring.
+ *
+ * @return false if it was overwritten before or during the copy
+ */
+static bool ReadTraceRecord(const TraceRing& ring, uint64_t index, TraceEvent* event) {
+    const TraceSlot& slot = ring.slots[index & ring.capacity_mask];
+
+    uint64_t expected = 2 * index + 2;
+    if (slot.sequence.load(std::memory_order_acquire) != expected) {
+        return false;
+    }
+
+    uint64_t words[kTraceRecordWords];
+    for (size_t i = 0; i < kTraceRecordWords; i++) {
+        words[i] = slot.words[i].load(std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != expected) {
+        return false;
+    }
+
+    UnpackTraceEvent(words, event);
+    return true;
+}
+
+static void WriteTraceRecord(FILE* file, uint32_t thread_index, const TraceEvent& event) {
+    fprintf(file,
+            "{\"ts\":%llu,\"thread\":%u,\"target\":\"%s\",\"verdict\":\"%s\",\"path\":\"%s\","
+            "\"decisionNs\":%llu,\"upcallNs\":%llu",
+            (unsigned long long)event.timestamp_ns,
+            thread_index,
+            GetInterceptTargetName(event.target),
+            kTraceVerdictNames[(size_t)event.verdict],
+            kTracePathNames[(size_t)event.path],
+            (unsigned long long)event.decision_ns,
+            (unsigned long long)event.upcall_ns);
+
+    if (event.address.length > 0) {
+        char address_text[kInetAddressTextMaxLength];
+        FormatInetAddress(event.address, address_text);
+        fprintf(file, ",\"address\":\"%s\",\"port\":%d", address_text, (int)event.port);
+    }
+
+    fputs("}\n", file);
+}
+
+int64_t DrainTraceBuffers() {
+    if (!g_trace_enabled) {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(g_trace_rings_mutex);
+
+    FILE* file = fopen(g_trace_path.c_str(), "a");
+    if (file == nullptr) {
+        fprintf(stderr, "[junit-airgap:native] ERROR: Cannot open trace file %s\n", g_trace_path.c_str());
+        return -1;
+    }
+
+    int64_t written = 0;
+    size_t live = 0;
+    for (std::unique_ptr<TraceRing>& ring : g_trace_rings) {
+        // Read retired first: once it is set, head is final
+        bool retired = ring->retired.load(std::memory_order_acquire);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t capacity = ring->capacity_mask + 1;
+
+        // Anything older than one ring's worth was overwritten
+        uint64_t start = head - ring->drained > capacity ? head - capacity : ring->drained;
+        uint64_t dropped = start - ring->drained;
+
+        for (uint64_t index = start; index < head; index++) {
+            TraceEvent event;
+            if (ReadTraceRecord(*ring, index, &event)) {
+                WriteTraceRecord(file, ring->thread_index, event);
+                written++;
+            } else {
+                dropped++;
+            }
+        }
+
+        if (dropped > 0) {
+            fprintf(file, "{\"thread\":%u,\"dropped\":%llu}\n", ring->thread_index, (unsigned long long)dropped);
+        }
+        ring->drained = head;
+
+        // An exited thread's ring is now empty: keep a few for reuse, free the rest
+        if (retired) {
+            if (g_free_trace_rings.size() < kMaxFreeTraceRings) {
+                g_free_trace_rings.push_back(std::move(ring));
+            } else {
+                ring.reset();
+            }
+        } else {
+            g_trace_rings[live++].swap(ring);
+        }
+    }
+    g_trace_rings.resize(live);
+
+    fclose(file);
+    DEBUG_LOGF("Drained %lld trace record(s) to %s", (long long)written, g_trace_path.c_str());
+    return written;
+}
+
+/**
+ * Drain the trace buffers to the trace file.
+ *
+ * Java signature: private external fun dumpAgentTrace(): Long
+ * JNI signature: ()J
+ *
+ * @return Number of records written, or -1 if tracing is disabled
+ */
+JNIEXPORT jlong JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_dumpAgentTrace(
+    JNIEnv* env,
+    jclass clazz
+) {
+    return (jlong)DrainTraceBuffers();
+}
@@ -0,0 +1,176 @@
+/**
+ * Native Connect Verdict Cache for junit-airgap JVMTI Agent
+ *
+ * A small direct-mapped cache per thread (thread_local, no locks). Each slot holds one
+ * (address, port) key stamped with the configuration generation and host policy id it
+ * was computed under.
+ *
+ * ## Why per-thread?
+ *
+ * - Connection pools reuse the same worker threads for the same targets
+ * - No synchronization on lookup or store
+ * - Memory is bounded: kVerdictCacheEntries slots per thread that connects
+ *
+ * The hit/miss counters are per thread too: a lookup only bumps its own thread's
+ * counter, and reading the statistics sums every thread's (see GetVerdictCacheHits()).
+ */
+
+#include "agent.h"
+#include "host_policy.h"
+#include "verdict_cache.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+// Slots per thread (power of two)
+static constexpr uint32_t kVerdictCacheEntries = 64;
+
+/**
+ * One cache slot. policy_id == 0 marks an empty slot.
+ */
+struct VerdictCacheEntry {
+    int64_t generation;
+    uint64_t policy_id;
+    int64_t context_id;
+    VerdictCacheKey key;
+};
+
+static thread_local VerdictCacheEntry t_verdict_cache[kVerdictCacheEntries];
+
+/**
+ * One thread's hit/miss counters. Written only by the owning thread (a plain load and
+ * store, no read-modify-write), read by GetVerdictCacheHits()/GetVerdictCacheMisses()
+ * under g_verdict_counters_mutex. Aligned so two threads' counters never share a
+ * cache line. On thread exit the counts move to the retired totals.
+ */
+struct alignas(64) VerdictCacheCounters {
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    bool registered = false;
+
+    ~VerdictCacheCounters();
+};
+
+// Counters of the live threads that looked something up, and the totals of exited ones
+static std::mutex g_verdict_counters_mutex;
+static std::vector<VerdictCacheCounters*> g_verdict_counters;
+static uint64_t g_retired_verdict_cache_hits = 0;
+static uint64_t g_retired_verdict_cache_misses = 0;
+
+static thread_local VerdictCacheCounters t_verdict_counters;
+
+VerdictCacheCounters::~VerdictCacheCounters() {
+    if (!registered) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(g_verdict_counters_mutex);
+    g_retired_verdict_cache_hits += hits.load(std::memory_order_relaxed);
+    g_retired_verdict_cache_misses += misses.load(std::memory_order_relaxed);
+    g_verdict_counters.erase(std::find(g_verdict_counters.begin(), g_verdict_counters.end(), this));
+}
+
+/**
+ * Count a lookup on the calling thread's counters, registering them on first use.
+ */
+static void CountLookup(bool hit) {
+    VerdictCacheCounters& counters = t_verdict_counters;
+    if (!counters.registered) {
+        std::lock_guard<std::mutex> lock(g_verdict_counters_mutex);
+        g_verdict_counters.push_back(&counters);
+        counters.registered = true;
+    }
+    std::atomic<uint64_t>& counter = hit ? counters.hits : counters.misses;
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+/**
+ * FNV-1a over the address bytes and port.
+ */
+static uint32_t HashKey(const VerdictCacheKey& key) {
+    uint32_t hash = 2166136261u;
+    for (uint8_t i = 0; i < key.address_length; i++) {
+        hash = (hash ^ key.address[i]) * 16777619u;
+    }
+    for (int shift = 0; shift < 32; shift += 8) {
+        hash = (hash ^ (uint8_t)((uint32_t)key.port >> shift)) * 16777619u;
+    }
+    return hash;
+}
+
+static bool KeysEqual(const VerdictCacheKey& a, const VerdictCacheKey& b) {
+    return a.port == b.port &&
+           a.address_length == b.address_length &&
+           memcmp(a.address, b.address, a.address_length) == 0;
+}
+
+void BuildVerdictCacheKey(const InetAddressBytes& address, jint port, VerdictCacheKey* key) {
+    memset(key, 0, sizeof(*key));
+    memcpy(key->address, address.bytes, address.length);
+    key->address_length = address.length;
+    key->port = port;
+}
+
+bool LookupAllowedVerdict(const VerdictCacheKey& key, int64_t context_id) {
+    const VerdictCacheEntry& entry = t_verdict_cache[HashKey(key) & (kVerdictCacheEntries - 1)];
+
+    uint64_t policy_id = GetContextPolicyId(context_id);
+    bool hit = policy_id != 0 &&
+               entry.policy_id == policy_id &&
+               entry.context_id == context_id &&
+               entry.generation == g_configuration_generation.load(std::memory_order_acquire) &&
+               KeysEqual(entry.key, key);
+
+    CountLookup(hit);
+    return hit;
+}
+
+void StoreAllowedVerdict(const VerdictCacheKey& key, uint64_t policy_id, int64_t context_id) {
+    VerdictCacheEntry& entry = t_verdict_cache[HashKey(key) & (kVerdictCacheEntries - 1)];
+    entry.generation = g_configuration_generation.load(std::memory_order_acquire);
+    entry.policy_id = policy_id;
+    entry.context_id = context_id;
+    entry.key = key;
+}
+
+uint64_t GetVerdictCacheHits() {
+    std::lock_guard<std::mutex> lock(g_verdict_counters_mutex);
+    uint64_t hits = g_retired_verdict_cache_hits;
+    for (const VerdictCacheCounters* counters : g_verdict_counters) {
+        hits += counters->hits.load(std::memory_order_relaxed);
+    }
+    return hits;
+}
+
+uint64_t GetVerdictCacheMisses() {
+    std::lock_guard<std::mutex> lock(g_verdict_counters_mutex);
+    uint64_t misses = g_retired_verdict_cache_misses;
+    for (const VerdictCacheCounters* counters : g_verdict_counters) {
+        misses += counters->misses.load(std::memory_order_relaxed);
+    }
+    return misses;
+}
+
+/**
+ * Get verdict cache statistics.
+ *
+ * Java signature: private external fun getAgentVerdictCacheStats(): LongArray
+ * JNI signature: ()[J
+ *
+ * @return long[2] = { hits, misses }
+ */
+JNIEXPORT jlongArray JNICALL Java_io_github_garryjeromson_junit_airgap_bytebuddy_NetworkBlockerContext_getAgentVerdictCacheStats(
+    JNIEnv* env,
+    jclass clazz
+) {
+    jlong stats[2] = {
+        (jlong)GetVerdictCacheHits(),
+        (jlong)GetVerdictCacheMisses(),
+    };
+
+    jlongArray result = env->NewLongArray(2);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, 2, stats);
+    }
+    return result;
+}
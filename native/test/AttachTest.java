@@ -0,0 +1,101 @@
+import com.sun.tools.attach.VirtualMachine;
+import io.github.garryjeromson.junit.airgap.bytebuddy.NetworkBlockerContext;
+
+import java.io.File;
+import java.net.InetAddress;
+import java.net.InetSocketAddress;
+import java.net.ServerSocket;
+import java.net.Socket;
+
+/**
+ * Test 4: Verify the agent intercepts requests when attached to a running JVM
+ *
+ * The JVM starts without -agentpath and links Net.connect0 and lookupAllHostAddr with a
+ * connect and a lookup of its own. It then attaches the agent to itself through
+ * VirtualMachine.loadAgentPath(), so no bind event will come for either: only
+ * Agent_OnAttach()'s rebind of the already loaded targets can put the wrappers in place.
+ *
+ * Expected behavior after the attach, with NetworkBlockerContext (the native test stub)
+ * registered and armed:
+ * - connect() to 127.0.0.1 and a lookup of localhost throw, from the stub's
+ *   checkConnection(), while neither is allowed
+ * - both succeed again once localhost and 127.0.0.1 are allowed (the rebound wrappers
+ *   call the JDK's own natives)
+ *
+ * Run with:
+ *   javac -d . io/github/garryjeromson/junit/airgap/bytebuddy/NetworkBlockerContext.java AttachTest.java
+ *   java -Djdk.attach.allowAttachSelf=true -Dsun.net.inetaddr.ttl=0 -Dairgap.test.active=true \
+ *     AttachTest ../build/libjunit-airgap-agent.so
+ */
+public class AttachTest {
+    private static int failures = 0;
+
+    public static void main(String[] args) throws Exception {
+        System.out.println("TEST: AttachTest started");
+        String agentPath = new File(args.length > 0 ? args[0] : "../build/libjunit-airgap-agent.so").getAbsolutePath();
+
+        try (ServerSocket server = new ServerSocket(0, 50, InetAddress.getByName("127.0.0.1"))) {
+            int port = server.getLocalPort();
+
+            // Links both natives before the agent is there to see the bind events
+            check("connect() before the attach", connect(port), null);
+            check("lookup before the attach", resolve("localhost"), null);
+
+            VirtualMachine vm = VirtualMachine.attach(String.valueOf(ProcessHandle.current().pid()));
+            try {
+                vm.loadAgentPath(agentPath, null);
+            } finally {
+                vm.detach();
+            }
+            System.out.println("TEST: Agent attached from " + agentPath);
+
+            // First use of the stub: registers it with the agent and arms it
+            NetworkBlockerContext.init();
+            NetworkBlockerContext.setHostPolicy(new String[] {"example.com"}, new String[0]);
+            check("connect() to a blocked address", connect(port), IllegalStateException.class);
+            check("lookup of a blocked host", resolve("localhost"), IllegalStateException.class);
+
+            NetworkBlockerContext.setHostPolicy(new String[] {"localhost", "127.0.0.1"}, new String[0]);
+            check("connect() to an allowed address", connect(port), null);
+            check("lookup of an allowed host", resolve("localhost"), null);
+        }
+
+        if (failures > 0) {
+            System.err.println("TEST FAILED: " + failures + " check(s) failed");
+            System.exit(1);
+        }
+        System.out.println("TEST: Attach test passed");
+        System.exit(0);
+    }
+
+    /** Connect to 127.0.0.1:port, returning what it threw or null. */
+    private static Throwable connect(int port) {
+        try (Socket socket = new Socket()) {
+            socket.connect(new InetSocketAddress(InetAddress.getByAddress(new byte[] {127, 0, 0, 1}), port), 1000);
+            return null;
+        } catch (Throwable e) {
+            return e;
+        }
+    }
+
+    /** Look up hostname, returning what it threw or null. */
+    private static Throwable resolve(String hostname) {
+        try {
+            InetAddress.getAllByName(hostname);
+            return null;
+        } catch (Throwable e) {
+            return e;
+        }
+    }
+
+    private static void check(String name, Throwable actual, Class<? extends Throwable> expected) {
+        boolean ok = expected == null ? actual == null : expected.isInstance(actual);
+        if (ok) {
+            System.out.println("TEST: " + name + ": " + (actual == null ? "no exception" : actual) + " (ok)");
+        } else {
+            System.out.println("TEST: " + name + ": expected " + (expected == null ? "no exception" : expected.getName())
+                + ", got " + actual);
+            failures++;
+        }
+    }
+}
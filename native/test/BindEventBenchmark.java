@@ -0,0 +1,147 @@
+import java.io.BufferedReader;
+import java.io.File;
+import java.io.InputStreamReader;
+import java.net.URI;
+import java.nio.file.FileSystem;
+import java.nio.file.FileSystems;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+import java.util.stream.Stream;
+
+/**
+ * Startup benchmark: cost of NativeMethodBind events with and without disarming.
+ *
+ * Each run starts a child JVM that initializes every class in the given JDK modules
+ * (each class initializer that calls registerNatives()/initIDs() binds natives, much
+ * like a Robolectric JVM loading android-all plus the JDK), then reports how long that
+ * workload took. The parent compares three configurations:
+ *
+ * - no agent (baseline)
+ * - agent with bindEvents=keep (every bind for the JVM's lifetime goes through the callback)
+ * - agent with bindEvents=auto (default: events switched off once all targets are bound)
+ *
+ * Run with:
+ *   javac BindEventBenchmark.java
+ *   java BindEventBenchmark ../build/libjunit-airgap-agent.dylib [runs] [modules]
+ *
+ * modules defaults to "java.base+java.desktop+java.sql+java.management".
+ */
+public class BindEventBenchmark {
+    private static final String WORKLOAD_PREFIX = "WORKLOAD_MS=";
+    private static final String CLASSES_PREFIX = "CLASSES=";
+
+    public static void main(String[] args) throws Exception {
+        if (args.length > 0 && args[0].equals("child")) {
+            runWorkload(args.length > 1 ? args[1] : "java.base");
+            return;
+        }
+
+        if (args.length < 1) {
+            System.err.println("Usage: java BindEventBenchmark <agent-path> [runs] [modules]");
+            System.exit(2);
+        }
+
+        String agentPath = new File(args[0]).getAbsolutePath();
+        int runs = args.length > 1 ? Integer.parseInt(args[1]) : 10;
+        String modules = args.length > 2 ? args[2] : "java.base+java.desktop+java.sql+java.management";
+
+        System.out.println("BENCHMARK: BindEventBenchmark (" + runs + " runs, modules " + modules + ")");
+        System.out.printf("%-22s %14s %14s %16s%n", "configuration", "startup p50", "startup min", "workload p50");
+
+        report("no agent", null, runs, modules);
+        report("bindEvents=keep", "-agentpath:" + agentPath + "=bindEvents=keep", runs, modules);
+        report("bindEvents=auto", "-agentpath:" + agentPath + "=bindEvents=auto", runs, modules);
+    }
+
+    private static void report(String name, String agentArg, int runs, String modules) throws Exception {
+        List<Double> totals = new ArrayList<>();
+        List<Double> workloads = new ArrayList<>();
+
+        // One discarded warm-up run (file system cache, CDS archive)
+        runChild(agentArg, modules);
+
+        for (int i = 0; i < runs; i++) {
+            long start = System.nanoTime();
+            double workload = runChild(agentArg, modules);
+            totals.add((System.nanoTime() - start) / 1_000_000.0);
+            workloads.add(workload);
+        }
+
+        System.out.printf("%-22s %11.1f ms %11.1f ms %13.1f ms%n",
+            name, median(totals), Collections.min(totals), median(workloads));
+    }
+
+    private static double runChild(String agentArg, String modules) throws Exception {
+        String java = System.getProperty("java.home") + File.separator + "bin" + File.separator + "java";
+        List<String> command = new ArrayList<>();
+        command.add(java);
+        if (agentArg != null) {
+            command.add(agentArg);
+        }
+        command.add("-Djava.awt.headless=true");
+        command.add("-cp");
+        command.add(System.getProperty("java.class.path"));
+        command.add("BindEventBenchmark");
+        command.add("child");
+        command.add(modules);
+
+        Process process = new ProcessBuilder(command).redirectErrorStream(true).start();
+        double workload = -1;
+        try (BufferedReader reader = new BufferedReader(new InputStreamReader(process.getInputStream()))) {
+            String line;
+            while ((line = reader.readLine()) != null) {
+                if (line.startsWith(WORKLOAD_PREFIX)) {
+                    workload = Double.parseDouble(line.substring(WORKLOAD_PREFIX.length()));
+                }
+            }
+        }
+        if (process.waitFor() != 0 || workload < 0) {
+            throw new IllegalStateException("Child JVM failed: " + command);
+        }
+        return workload;
+    }
+
+    /**
+     * Child: initialize every class of the given modules (failures ignored).
+     */
+    private static void runWorkload(String modules) throws Exception {
+        long start = System.nanoTime();
+        int initialized = 0;
+
+        FileSystem jrt = FileSystems.getFileSystem(URI.create("jrt:/"));
+        for (String module : modules.split("\\+")) {
+            Path root = jrt.getPath("/modules", module);
+            if (!Files.exists(root)) {
+                continue;
+            }
+            List<String> classNames = new ArrayList<>();
+            try (Stream<Path> paths = Files.walk(root)) {
+                paths.map(path -> root.relativize(path).toString())
+                    .filter(name -> name.endsWith(".class") && !name.equals("module-info.class"))
+                    .forEach(name -> classNames.add(name.substring(0, name.length() - 6).replace('/', '.')));
+            }
+            for (String className : classNames) {
+                try {
+                    Class.forName(className, true, ClassLoader.getSystemClassLoader());
+                    initialized++;
+                } catch (Throwable ignored) {
+                    // Inaccessible, platform-specific or failing initializers
+                }
+            }
+        }
+
+        double elapsed = (System.nanoTime() - start) / 1_000_000.0;
+        System.out.println(CLASSES_PREFIX + initialized);
+        System.out.println(WORKLOAD_PREFIX + elapsed);
+    }
+
+    private static double median(List<Double> values) {
+        List<Double> sorted = new ArrayList<>(values);
+        Collections.sort(sorted);
+        int middle = sorted.size() / 2;
+        return sorted.size() % 2 == 0 ? (sorted.get(middle - 1) + sorted.get(middle)) / 2 : sorted.get(middle);
+    }
+}
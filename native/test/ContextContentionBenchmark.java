@@ -0,0 +1,105 @@
+import io.github.garryjeromson.junit.airgap.bytebuddy.NetworkBlockerContext;
+
+import java.net.InetSocketAddress;
+import java.net.ServerSocket;
+import java.net.Socket;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.atomic.AtomicBoolean;
+import java.util.concurrent.atomic.LongAdder;
+
+/**
+ * Contention benchmark: loopback connects/sec through the agent at 1-64 threads.
+ *
+ * Every intercepted connect reads the cached NetworkBlockerContext class, method IDs
+ * and caller strings. This measures how connect throughput scales with thread count,
+ * which is where per-field locking in the agent shows up as a serialization point.
+ *
+ * Run with:
+ *   javac -d . io/github/garryjeromson/junit/airgap/bytebuddy/NetworkBlockerContext.java ContextContentionBenchmark.java
+ *   java -agentpath:../build/libjunit-airgap-agent.dylib ContextContentionBenchmark
+ *   java -agentpath:../build/libjunit-airgap-agent.dylib -Dairgap.test.active=true ContextContentionBenchmark
+ *
+ * Compare against a run without -agentpath for the uninstrumented baseline.
+ */
+public class ContextContentionBenchmark {
+    private static final int[] THREAD_COUNTS = {1, 2, 4, 8, 16, 32, 64};
+    private static final long WARMUP_MILLIS = 1000;
+    private static final long MEASURE_MILLIS = 3000;
+
+    public static void main(String[] args) throws Exception {
+        NetworkBlockerContext.init();
+
+        try (ServerSocket server = new ServerSocket()) {
+            server.bind(new InetSocketAddress("127.0.0.1", 0), 1024);
+            Thread acceptor = startAcceptor(server);
+
+            InetSocketAddress target = new InetSocketAddress("127.0.0.1", server.getLocalPort());
+            System.out.println("BENCHMARK: ContextContentionBenchmark (active configuration: "
+                + NetworkBlockerContext.hasActiveConfiguration() + ")");
+            System.out.printf("%8s %15s %20s%n", "threads", "connects/sec", "connects/sec/thread");
+
+            // Warm up (JIT, agent caches)
+            run(target, 4, WARMUP_MILLIS);
+
+            for (int threads : THREAD_COUNTS) {
+                double perSecond = run(target, threads, MEASURE_MILLIS);
+                System.out.printf("%8d %15.0f %20.0f%n", threads, perSecond, perSecond / threads);
+            }
+
+            acceptor.interrupt();
+        }
+    }
+
+    private static Thread startAcceptor(ServerSocket server) {
+        Thread acceptor = new Thread(() -> {
+            while (!server.isClosed()) {
+                try {
+                    server.accept().close();
+                } catch (Exception e) {
+                    return;
+                }
+            }
+        }, "acceptor");
+        acceptor.setDaemon(true);
+        acceptor.start();
+        return acceptor;
+    }
+
+    private static double run(InetSocketAddress target, int threads, long millis) throws InterruptedException {
+        LongAdder connects = new LongAdder();
+        AtomicBoolean running = new AtomicBoolean(true);
+        CountDownLatch start = new CountDownLatch(1);
+        List<Thread> workers = new ArrayList<>();
+
+        for (int i = 0; i < threads; i++) {
+            Thread worker = new Thread(() -> {
+                try {
+                    start.await();
+                    while (running.get()) {
+                        try (Socket socket = new Socket()) {
+                            socket.connect(target, 1000);
+                        }
+                        connects.increment();
+                    }
+                } catch (Exception e) {
+                    System.err.println("BENCHMARK: worker failed: " + e);
+                }
+            }, "worker-" + i);
+            worker.start();
+            workers.add(worker);
+        }
+
+        long begin = System.nanoTime();
+        start.countDown();
+        Thread.sleep(millis);
+        running.set(false);
+        for (Thread worker : workers) {
+            worker.join();
+        }
+        long elapsed = System.nanoTime() - begin;
+
+        return connects.sum() * 1_000_000_000.0 / elapsed;
+    }
+}
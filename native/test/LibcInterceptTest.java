@@ -0,0 +1,104 @@
+import io.github.garryjeromson.junit.airgap.bytebuddy.NetworkBlockerContext;
+
+import java.io.File;
+import java.net.InetAddress;
+import java.net.ServerSocket;
+
+/**
+ * Test 3: Verify libc interception (libc agent option) in JNI libraries
+ *
+ * Two copies of a small JNI library (libc_probe.cpp) call connect() and getaddrinfo()
+ * directly, like a native transport does:
+ * - Early: preloaded (LD_PRELOAD), so the agent's initial scan patches it
+ * - Late: loaded after start-up by Early's dlopen() of its soname, resolved through
+ *   Early's $ORIGIN RUNPATH (which must keep working with the libc option: the agent
+ *   doesn't hook dlopen()), so only the rescan at its first native method bind can patch it
+ *
+ * Expected behavior for both, under an allowlist of localhost and 127.0.0.1:
+ * - connect() to 127.0.0.1 (a local server) succeeds
+ * - connect() to 127.0.0.2 fails with EACCES (not ECONNREFUSED: nothing reaches the kernel)
+ * - getaddrinfo("localhost") succeeds, and fails with EAI_NONAME once only 127.0.0.1 is allowed
+ *
+ * Linux (x86_64, aarch64) only. Run with (after cmake -DJUNIT_AIRGAP_BUILD_TESTS=ON):
+ *   javac -d . io/github/garryjeromson/junit/airgap/bytebuddy/NetworkBlockerContext.java LibcInterceptTest.java
+ *   LD_PRELOAD=../build/libc-probe/libairgap-libc-probe-early.so \
+ *     java -agentpath:../build/libjunit-airgap-agent.so=libc -Dairgap.test.active=true \
+ *     LibcInterceptTest ../build/libc-probe
+ */
+public class LibcInterceptTest {
+    /** Bound to the preloaded copy of the probe. */
+    static final class Early {
+        static native int connect(String address, int port);
+
+        static native int resolve(String hostname);
+
+        static native int loadLibrary(String soname);
+
+        static native int blockedConnectError();
+
+        static native int blockedLookupStatus();
+    }
+
+    /** Bound to the copy loaded after start-up. */
+    static final class Late {
+        static native int connect(String address, int port);
+
+        static native int resolve(String hostname);
+
+        static native int loadLibrary(String soname);
+
+        static native int blockedConnectError();
+
+        static native int blockedLookupStatus();
+    }
+
+    private static int failures = 0;
+
+    public static void main(String[] args) throws Exception {
+        System.out.println("TEST: LibcInterceptTest started");
+        String libraryDirectory = args.length > 0 ? args[0] : "../build/libc-probe";
+
+        NetworkBlockerContext.init();
+        NetworkBlockerContext.setHostPolicy(new String[] {"localhost", "127.0.0.1"}, new String[0]);
+
+        // Already mapped by LD_PRELOAD: this only binds the natives
+        System.load(new File(libraryDirectory, "libairgap-libc-probe-early.so").getAbsolutePath());
+        // Mapped now, by soname from the early copy; System.load() then only binds the natives
+        check("early dlopen() of the late copy by soname", Early.loadLibrary("libairgap-libc-probe-late.so"), 0);
+        System.load(new File(libraryDirectory, "libairgap-libc-probe-late.so").getAbsolutePath());
+
+        try (ServerSocket server = new ServerSocket(0, 50, InetAddress.getByName("127.0.0.1"))) {
+            int port = server.getLocalPort();
+            int eacces = Early.blockedConnectError();
+
+            check("early connect() to an allowed address", Early.connect("127.0.0.1", port), 0);
+            check("early connect() to a blocked address", Early.connect("127.0.0.2", port), eacces);
+            check("late connect() to an allowed address", Late.connect("127.0.0.1", port), 0);
+            check("late connect() to a blocked address", Late.connect("127.0.0.2", port), eacces);
+        }
+
+        check("early getaddrinfo() of an allowed host", Early.resolve("localhost"), 0);
+        check("late getaddrinfo() of an allowed host", Late.resolve("localhost"), 0);
+
+        NetworkBlockerContext.setHostPolicy(new String[] {"127.0.0.1"}, new String[0]);
+        int eaiNoName = Early.blockedLookupStatus();
+        check("early getaddrinfo() of a blocked host", Early.resolve("localhost"), eaiNoName);
+        check("late getaddrinfo() of a blocked host", Late.resolve("localhost"), eaiNoName);
+
+        if (failures > 0) {
+            System.err.println("TEST FAILED: " + failures + " check(s) failed");
+            System.exit(1);
+        }
+        System.out.println("TEST: libc interception test passed");
+        System.exit(0);
+    }
+
+    private static void check(String name, int actual, int expected) {
+        if (actual == expected) {
+            System.out.println("TEST: " + name + ": " + actual + " (ok)");
+        } else {
+            System.out.println("TEST: " + name + ": expected " + expected + ", got " + actual);
+            failures++;
+        }
+    }
+}
@@ -0,0 +1,275 @@
+import io.github.garryjeromson.junit.airgap.bytebuddy.NetworkBlockerContext;
+
+import java.io.BufferedReader;
+import java.io.File;
+import java.io.InputStreamReader;
+import java.io.PrintWriter;
+import java.net.InetAddress;
+import java.net.InetSocketAddress;
+import java.net.ServerSocket;
+import java.net.Socket;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+
+/**
+ * Restore benchmark: time to first test of a test fork restored from a CRaC checkpoint,
+ * compared with a cold start, with and without the agent.
+ *
+ * For each configuration, one child JVM starts with -XX:CRaCCheckpointTo, runs a first
+ * test (loopback connect and DNS lookup), quiesces the agent (NetworkBlockerContext
+ * checkpoint()) and checkpoints itself through jdk.crac.Core.checkpointRestore(). Each
+ * run then times, from the parent:
+ *
+ * - cold: a fresh child JVM until its first test is done (like StartupBenchmark)
+ * - restored: java -XX:CRaCRestoreFrom until the restored child has revalidated the
+ *   agent (NetworkBlockerContext restore()) and done its first test
+ *
+ * The restored child also reports how many bind callbacks the agent handled since the
+ * checkpoint, which should be none: the wrappers stay bound. Medians are written as
+ * <output>/control and <output>/treatment/benchmark-results/results.json for
+ * BenchmarkComparison.
+ *
+ * Needs a CRaC-enabled JDK (e.g. Azul Zulu with CRaC) on Linux. Run with:
+ *   javac --release 11 -d . io/github/garryjeromson/junit/airgap/bytebuddy/NetworkBlockerContext.java RestoreBenchmark.java
+ *   java RestoreBenchmark ../build/libjunit-airgap-agent.so [runs] [crac-java-home] [output-dir]
+ *
+ * crac-java-home defaults to the running JDK; output-dir defaults to ../build/restore.
+ */
+public class RestoreBenchmark {
+    private static final String FIRST_TEST_MARKER = "RESTORE_FIRST_TEST";
+    private static final String BIND_EVENTS_PREFIX = "BIND_EVENTS_SINCE_CHECKPOINT=";
+    private static final String COMPLETE_PREFIX = "RESTORE_COMPLETE=";
+
+    /** Per-configuration times in milliseconds. */
+    private static final class Result {
+        final String name;
+        final List<Double> cold = new ArrayList<>();
+        final List<Double> restored = new ArrayList<>();
+        long bindEventsSinceCheckpoint = -1;
+
+        Result(String name) {
+            this.name = name;
+        }
+    }
+
+    public static void main(String[] args) throws Exception {
+        if (args.length > 0 && args[0].equals("cold")) {
+            runFirstTest();
+            System.out.println(FIRST_TEST_MARKER);
+            System.out.flush();
+            return;
+        }
+        if (args.length > 0 && args[0].equals("checkpoint")) {
+            runCheckpointChild();
+            return;
+        }
+
+        if (args.length < 1) {
+            System.err.println("Usage: java RestoreBenchmark <agent-path> [runs] [crac-java-home] [output-dir]");
+            System.exit(2);
+        }
+
+        String agentPath = new File(args[0]).getAbsolutePath();
+        int runs = args.length > 1 ? Integer.parseInt(args[1]) : 20;
+        String javaHome = args.length > 2 && !args[2].isEmpty() ? args[2] : System.getProperty("java.home");
+        File output = new File(args.length > 3 ? args[3] : "../build/restore");
+        String java = javaHome + File.separator + "bin" + File.separator + "java";
+
+        System.out.println("BENCHMARK: RestoreBenchmark (" + runs + " runs per configuration)");
+        System.out.printf("%-10s %16s %16s %16s %14s%n",
+            "agent", "cold p50", "restored p50", "restored min", "rebinds");
+
+        Result control = measure(java, null, runs, new File(output, "control/checkpoint"));
+        Result treatment = measure(java, "-agentpath:" + agentPath, runs, new File(output, "treatment/checkpoint"));
+        print(control, "no");
+        print(treatment, "yes");
+
+        writeResults(new File(output, "control"), control);
+        writeResults(new File(output, "treatment"), treatment);
+        System.out.println();
+        System.out.println("Benchmark results written to: " + output.getAbsolutePath());
+    }
+
+    private static Result measure(String java, String agentArg, int runs, File image) throws Exception {
+        Result result = new Result(agentArg == null ? "no agent" : "agent");
+        checkpoint(java, agentArg, image);
+
+        // One discarded warm-up run of each (file system cache, CDS archive)
+        launch(java, agentArg, null, result);
+        launch(java, null, image, result);
+        result.cold.clear();
+        result.restored.clear();
+
+        for (int i = 0; i < runs; i++) {
+            result.cold.add(launch(java, agentArg, null, result));
+            result.restored.add(launch(java, null, image, result));
+        }
+        return result;
+    }
+
+    /**
+     * Create the checkpoint image. CRaC ends the checkpointed process, so its exit
+     * status says nothing; the image directory does.
+     */
+    private static void checkpoint(String java, String agentArg, File image) throws Exception {
+        deleteRecursively(image);
+        if (!image.mkdirs()) {
+            throw new IllegalStateException("Cannot create " + image);
+        }
+        List<String> command = new ArrayList<>();
+        command.add(java);
+        if (agentArg != null) {
+            command.add(agentArg);
+        }
+        command.add("-XX:CRaCCheckpointTo=" + image.getAbsolutePath());
+        command.add("-cp");
+        command.add(System.getProperty("java.class.path"));
+        command.add("RestoreBenchmark");
+        command.add("checkpoint");
+
+        Process process = new ProcessBuilder(command).inheritIO().start();
+        process.waitFor();
+        String[] files = image.list();
+        if (files == null || files.length == 0) {
+            throw new IllegalStateException("No checkpoint image written (is this a CRaC JDK?): " + command);
+        }
+    }
+
+    /**
+     * Launch a cold child (image == null) or restore one from image.
+     *
+     * @return Milliseconds from just before process start until the child's first test is done
+     */
+    private static double launch(String java, String agentArg, File image, Result result) throws Exception {
+        List<String> command = new ArrayList<>();
+        command.add(java);
+        if (image != null) {
+            command.add("-XX:CRaCRestoreFrom=" + image.getAbsolutePath());
+        } else {
+            if (agentArg != null) {
+                command.add(agentArg);
+            }
+            command.add("-cp");
+            command.add(System.getProperty("java.class.path"));
+            command.add("RestoreBenchmark");
+            command.add("cold");
+        }
+
+        double firstTest = -1;
+        boolean complete = true;
+        long start = System.nanoTime();
+        Process process = new ProcessBuilder(command).redirectErrorStream(true).start();
+        try (BufferedReader reader = new BufferedReader(new InputStreamReader(process.getInputStream()))) {
+            String line;
+            while ((line = reader.readLine()) != null) {
+                double elapsed = (System.nanoTime() - start) / 1_000_000.0;
+                if (line.equals(FIRST_TEST_MARKER)) {
+                    firstTest = elapsed;
+                } else if (line.startsWith(BIND_EVENTS_PREFIX)) {
+                    result.bindEventsSinceCheckpoint = Long.parseLong(line.substring(BIND_EVENTS_PREFIX.length()));
+                } else if (line.startsWith(COMPLETE_PREFIX)) {
+                    complete = Boolean.parseBoolean(line.substring(COMPLETE_PREFIX.length()));
+                }
+            }
+        }
+        if (process.waitFor() != 0 || firstTest < 0 || !complete) {
+            throw new IllegalStateException("Child JVM failed: " + command);
+        }
+        return firstTest;
+    }
+
+    /**
+     * Checkpoint child: warm up like a fork that already ran a test, checkpoint, and after
+     * the restore (checkpointRestore() returns in the restored process) revalidate the
+     * agent and do the first test. Markers are flushed so the parent timestamps them on arrival.
+     */
+    private static void runCheckpointChild() throws Exception {
+        runFirstTest();
+        long bindEvents = NetworkBlockerContext.nativeBindEventCount();
+
+        NetworkBlockerContext.checkpoint();
+        // jdk.crac is only in CRaC JDKs, so it isn't a compile-time dependency
+        Class.forName("jdk.crac.Core").getMethod("checkpointRestore").invoke(null);
+        boolean complete = NetworkBlockerContext.restore();
+
+        runFirstTest();
+        System.out.println(FIRST_TEST_MARKER);
+        long bindEventsAfter = NetworkBlockerContext.nativeBindEventCount();
+        System.out.println(BIND_EVENTS_PREFIX + (bindEvents < 0 ? -1 : bindEventsAfter - bindEvents));
+        System.out.println(COMPLETE_PREFIX + complete);
+        System.out.flush();
+    }
+
+    /** What a test's first network call does. */
+    private static void runFirstTest() throws Exception {
+        NetworkBlockerContext.init();
+        try (ServerSocket server = new ServerSocket(0, 1, InetAddress.getLoopbackAddress());
+             Socket socket = new Socket()) {
+            socket.connect(new InetSocketAddress(InetAddress.getLoopbackAddress(), server.getLocalPort()), 1000);
+        }
+        InetAddress.getAllByName("localhost");
+    }
+
+    private static void print(Result result, String agent) {
+        System.out.printf("%-10s %13.1f ms %13.1f ms %13.1f ms %14s%n",
+            agent, median(result.cold), median(result.restored), Collections.min(result.restored),
+            result.bindEventsSinceCheckpoint < 0 ? "-" : String.valueOf(result.bindEventsSinceCheckpoint));
+    }
+
+    /** Write both metrics in the BenchmarkResultsCollector format (times in nanoseconds). */
+    private static void writeResults(File directory, Result result) throws Exception {
+        String rebinds = result.bindEventsSinceCheckpoint < 0
+            ? "" : ",\n      \"bindEvents\": " + result.bindEventsSinceCheckpoint;
+        List<String> entries = new ArrayList<>();
+        entries.add(jsonEntry("Time to first test, cold [" + result.name + "]", result.cold, ""));
+        entries.add(jsonEntry("Time to first test, restored [" + result.name + "]", result.restored, rebinds));
+
+        File resultsDirectory = new File(directory, "benchmark-results");
+        if (!resultsDirectory.isDirectory() && !resultsDirectory.mkdirs()) {
+            throw new IllegalStateException("Cannot create " + resultsDirectory);
+        }
+        try (PrintWriter writer = new PrintWriter(new File(resultsDirectory, "results.json"), "UTF-8")) {
+            writer.println("{");
+            writer.println("  \"results\": [");
+            writer.println(String.join(",\n", entries));
+            writer.println("  ]");
+            writer.println("}");
+        }
+    }
+
+    private static String jsonEntry(String name, List<Double> millis, String extraFields) {
+        return String.format("    {%n      \"name\": \"%s\",%n      \"medianNs\": %.1f,%n      \"stdDevNs\": %.1f%s%n    }",
+            name, median(millis) * 1_000_000.0, stdDev(millis) * 1_000_000.0, extraFields);
+    }
+
+    private static void deleteRecursively(File file) {
+        File[] children = file.listFiles();
+        if (children != null) {
+            for (File child : children) {
+                deleteRecursively(child);
+            }
+        }
+        file.delete();
+    }
+
+    private static double median(List<Double> values) {
+        List<Double> sorted = new ArrayList<>(values);
+        Collections.sort(sorted);
+        int middle = sorted.size() / 2;
+        return sorted.size() % 2 == 0 ? (sorted.get(middle - 1) + sorted.get(middle)) / 2 : sorted.get(middle);
+    }
+
+    private static double stdDev(List<Double> values) {
+        double mean = 0;
+        for (double value : values) {
+            mean += value;
+        }
+        mean /= values.size();
+        double variance = 0;
+        for (double value : values) {
+            variance += (value - mean) * (value - mean);
+        }
+        return Math.sqrt(variance / values.size());
+    }
+}
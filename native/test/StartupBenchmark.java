@@ -0,0 +1,224 @@
+import io.github.garryjeromson.junit.airgap.bytebuddy.NetworkBlockerContext;
+
+import java.io.BufferedReader;
+import java.io.File;
+import java.io.InputStreamReader;
+import java.io.PrintWriter;
+import java.net.InetAddress;
+import java.net.InetSocketAddress;
+import java.net.ServerSocket;
+import java.net.Socket;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+
+/**
+ * Startup benchmark: what the agent adds to every forked test JVM, per JDK.
+ *
+ * Each run launches a fresh child JVM and times, from the parent:
+ *
+ * - time to main: JVM creation, Agent_OnLoad, InitializeJVMTI, the startup stream of
+ *   NativeMethodBind callbacks and VMInitCallback, until the child's main() runs
+ * - time to first test: additionally NetworkBlockerContext's static registerWithAgent()
+ *   and a first intercepted loopback connect and DNS lookup (what a test's first
+ *   network call pays)
+ *
+ * The child also reports how many bind callbacks the agent handled. Every configuration
+ * runs on every given JDK, without the agent (control) and with it (treatment), and the
+ * medians are written as <output>/control and <output>/treatment
+ * /benchmark-results/results.json for BenchmarkComparison.
+ *
+ * Run with:
+ *   javac --release 11 -d . io/github/garryjeromson/junit/airgap/bytebuddy/NetworkBlockerContext.java StartupBenchmark.java
+ *   java StartupBenchmark ../build/libjunit-airgap-agent.dylib [runs] [java-homes] [output-dir]
+ *
+ * java-homes is a path-separator list of JDK homes (default: the running JDK);
+ * output-dir defaults to ../build/startup.
+ */
+public class StartupBenchmark {
+    private static final String MAIN_MARKER = "STARTUP_MAIN";
+    private static final String FIRST_TEST_MARKER = "STARTUP_FIRST_TEST";
+    private static final String BIND_EVENTS_PREFIX = "BIND_EVENTS=";
+    private static final String JDK_PREFIX = "JDK=";
+
+    /** One child JVM run, all times in milliseconds since just before process start. */
+    private static final class Run {
+        double timeToMain = -1;
+        double timeToFirstTest = -1;
+        long bindEvents = -1;
+        String jdk = "?";
+    }
+
+    /** Per-JDK, per-configuration medians. */
+    private static final class Result {
+        final String name;
+        final List<Double> timeToMain = new ArrayList<>();
+        final List<Double> timeToFirstTest = new ArrayList<>();
+        long bindEvents = -1;
+
+        Result(String name) {
+            this.name = name;
+        }
+    }
+
+    public static void main(String[] args) throws Exception {
+        if (args.length > 0 && args[0].equals("child")) {
+            runChild();
+            return;
+        }
+
+        if (args.length < 1) {
+            System.err.println("Usage: java StartupBenchmark <agent-path> [runs] [java-homes] [output-dir]");
+            System.exit(2);
+        }
+
+        String agentPath = new File(args[0]).getAbsolutePath();
+        int runs = args.length > 1 ? Integer.parseInt(args[1]) : 20;
+        String[] javaHomes = (args.length > 2 && !args[2].isEmpty() ? args[2] : System.getProperty("java.home"))
+            .split(File.pathSeparator);
+        File output = new File(args.length > 3 ? args[3] : "../build/startup");
+
+        System.out.println("BENCHMARK: StartupBenchmark (" + runs + " runs per JDK and configuration)");
+        System.out.printf("%-8s %-10s %16s %16s %16s %12s%n",
+            "jdk", "agent", "to main p50", "to test p50", "to test min", "bind events");
+
+        List<String> controlJson = new ArrayList<>();
+        List<String> treatmentJson = new ArrayList<>();
+        for (String javaHome : javaHomes) {
+            String java = javaHome + File.separator + "bin" + File.separator + "java";
+            Result control = measure(java, null, runs);
+            Result treatment = measure(java, "-agentpath:" + agentPath, runs);
+            print(control, "no");
+            print(treatment, "yes");
+            addJson(controlJson, control);
+            addJson(treatmentJson, treatment);
+        }
+
+        writeResults(new File(output, "control"), controlJson);
+        writeResults(new File(output, "treatment"), treatmentJson);
+        System.out.println();
+        System.out.println("Benchmark results written to: " + output.getAbsolutePath());
+    }
+
+    private static Result measure(String java, String agentArg, int runs) throws Exception {
+        // One discarded warm-up run (file system cache, CDS archive)
+        Run warmup = launch(java, agentArg);
+        Result result = new Result("JDK " + warmup.jdk);
+
+        for (int i = 0; i < runs; i++) {
+            Run run = launch(java, agentArg);
+            result.timeToMain.add(run.timeToMain);
+            result.timeToFirstTest.add(run.timeToFirstTest);
+            result.bindEvents = run.bindEvents;
+        }
+        return result;
+    }
+
+    private static Run launch(String java, String agentArg) throws Exception {
+        List<String> command = new ArrayList<>();
+        command.add(java);
+        if (agentArg != null) {
+            command.add(agentArg);
+        }
+        command.add("-cp");
+        command.add(System.getProperty("java.class.path"));
+        command.add("StartupBenchmark");
+        command.add("child");
+
+        Run run = new Run();
+        long start = System.nanoTime();
+        Process process = new ProcessBuilder(command).redirectErrorStream(true).start();
+        try (BufferedReader reader = new BufferedReader(new InputStreamReader(process.getInputStream()))) {
+            String line;
+            while ((line = reader.readLine()) != null) {
+                double elapsed = (System.nanoTime() - start) / 1_000_000.0;
+                if (line.equals(MAIN_MARKER)) {
+                    run.timeToMain = elapsed;
+                } else if (line.equals(FIRST_TEST_MARKER)) {
+                    run.timeToFirstTest = elapsed;
+                } else if (line.startsWith(BIND_EVENTS_PREFIX)) {
+                    run.bindEvents = Long.parseLong(line.substring(BIND_EVENTS_PREFIX.length()));
+                } else if (line.startsWith(JDK_PREFIX)) {
+                    run.jdk = line.substring(JDK_PREFIX.length());
+                }
+            }
+        }
+        if (process.waitFor() != 0 || run.timeToMain < 0 || run.timeToFirstTest < 0) {
+            throw new IllegalStateException("Child JVM failed: " + command);
+        }
+        return run;
+    }
+
+    /**
+     * Child: report reaching main() at once, then do what a test's first network call does.
+     * Markers are flushed immediately so the parent timestamps them on arrival.
+     */
+    private static void runChild() throws Exception {
+        System.out.println(MAIN_MARKER);
+        System.out.flush();
+
+        NetworkBlockerContext.init();
+        try (ServerSocket server = new ServerSocket(0, 1, InetAddress.getLoopbackAddress());
+             Socket socket = new Socket()) {
+            socket.connect(new InetSocketAddress(InetAddress.getLoopbackAddress(), server.getLocalPort()), 1000);
+        }
+        InetAddress.getAllByName("localhost");
+
+        System.out.println(FIRST_TEST_MARKER);
+        System.out.println(BIND_EVENTS_PREFIX + NetworkBlockerContext.nativeBindEventCount());
+        System.out.println(JDK_PREFIX + System.getProperty("java.specification.version"));
+        System.out.flush();
+    }
+
+    private static void print(Result result, String agent) {
+        System.out.printf("%-8s %-10s %13.1f ms %13.1f ms %13.1f ms %12s%n",
+            result.name.substring(4), agent, median(result.timeToMain), median(result.timeToFirstTest),
+            Collections.min(result.timeToFirstTest), result.bindEvents < 0 ? "-" : String.valueOf(result.bindEvents));
+    }
+
+    /** Add both metrics in the BenchmarkResultsCollector format (times in nanoseconds). */
+    private static void addJson(List<String> entries, Result result) {
+        String bindEvents = result.bindEvents < 0 ? "" : ",\n      \"bindEvents\": " + result.bindEvents;
+        entries.add(jsonEntry("Time to main [" + result.name + "]", result.timeToMain, ""));
+        entries.add(jsonEntry("Time to first test [" + result.name + "]", result.timeToFirstTest, bindEvents));
+    }
+
+    private static String jsonEntry(String name, List<Double> millis, String extraFields) {
+        return String.format("    {%n      \"name\": \"%s\",%n      \"medianNs\": %.1f,%n      \"stdDevNs\": %.1f%s%n    }",
+            name, median(millis) * 1_000_000.0, stdDev(millis) * 1_000_000.0, extraFields);
+    }
+
+    private static void writeResults(File directory, List<String> entries) throws Exception {
+        File resultsDirectory = new File(directory, "benchmark-results");
+        if (!resultsDirectory.isDirectory() && !resultsDirectory.mkdirs()) {
+            throw new IllegalStateException("Cannot create " + resultsDirectory);
+        }
+        try (PrintWriter writer = new PrintWriter(new File(resultsDirectory, "results.json"), "UTF-8")) {
+            writer.println("{");
+            writer.println("  \"results\": [");
+            writer.println(String.join(",\n", entries));
+            writer.println("  ]");
+            writer.println("}");
+        }
+    }
+
+    private static double median(List<Double> values) {
+        List<Double> sorted = new ArrayList<>(values);
+        Collections.sort(sorted);
+        int middle = sorted.size() / 2;
+        return sorted.size() % 2 == 0 ? (sorted.get(middle - 1) + sorted.get(middle)) / 2 : sorted.get(middle);
+    }
+
+    private static double stdDev(List<Double> values) {
+        double mean = 0;
+        for (double value : values) {
+            mean += value;
+        }
+        mean /= values.size();
+        double variance = 0;
+        for (double value : values) {
+            variance += (value - mean) * (value - mean);
+        }
+        return Math.sqrt(variance / values.size());
+    }
+}
@@ -0,0 +1,113 @@
+import io.github.garryjeromson.junit.airgap.bytebuddy.NetworkBlockerContext;
+
+import java.net.InetSocketAddress;
+import java.net.ServerSocket;
+import java.net.Socket;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.atomic.LongAdder;
+
+/**
+ * Virtual thread benchmark: 10k-100k virtual threads, each doing one loopback connect.
+ *
+ * Virtual threads are cheap to start, so per-thread costs in the agent path - the
+ * hasActiveConfiguration() upcall, thread-local lookups - dominate. Compare the
+ * per-thread configuration with a shared (JVM-wide) one, where the agent skips the
+ * upcall while armed.
+ *
+ * Run with:
+ *   javac -d . io/github/garryjeromson/junit/airgap/bytebuddy/NetworkBlockerContext.java VirtualThreadBenchmark.java
+ *   java -agentpath:../build/libjunit-airgap-agent.so -Dairgap.test.active=true VirtualThreadBenchmark
+ *   java -agentpath:../build/libjunit-airgap-agent.so -Dairgap.test.active=true -Dairgap.test.shared=true VirtualThreadBenchmark
+ *
+ * Pass thread counts as arguments to override the default (10000 100000).
+ */
+public class VirtualThreadBenchmark {
+    private static final int[] DEFAULT_THREAD_COUNTS = {10_000, 100_000};
+    private static final int WARMUP_THREADS = 5_000;
+    private static final int CONNECT_TIMEOUT_MILLIS = 10_000;
+
+    public static void main(String[] args) throws Exception {
+        NetworkBlockerContext.init();
+
+        int[] threadCounts = DEFAULT_THREAD_COUNTS;
+        if (args.length > 0) {
+            threadCounts = new int[args.length];
+            for (int i = 0; i < args.length; i++) {
+                threadCounts[i] = Integer.parseInt(args[i]);
+            }
+        }
+
+        try (ServerSocket server = new ServerSocket()) {
+            server.bind(new InetSocketAddress("127.0.0.1", 0), 4096);
+            Thread acceptor = startAcceptor(server);
+
+            InetSocketAddress target = new InetSocketAddress("127.0.0.1", server.getLocalPort());
+            System.out.println("BENCHMARK: VirtualThreadBenchmark (active configuration: "
+                + NetworkBlockerContext.hasActiveConfiguration()
+                + ", shared: " + Boolean.getBoolean("airgap.test.shared") + ")");
+            System.out.printf("%10s %12s %15s %10s%n", "threads", "millis", "connects/sec", "failures");
+
+            // Warm up (JIT, agent caches)
+            run(target, WARMUP_THREADS);
+
+            for (int threads : threadCounts) {
+                Result result = run(target, threads);
+                System.out.printf("%10d %12.1f %15.0f %10d%n",
+                    threads, result.elapsedNanos / 1_000_000.0,
+                    result.connects * 1_000_000_000.0 / result.elapsedNanos, result.failures);
+            }
+
+            acceptor.interrupt();
+        }
+    }
+
+    private static Thread startAcceptor(ServerSocket server) {
+        Thread acceptor = new Thread(() -> {
+            while (!server.isClosed()) {
+                try {
+                    server.accept().close();
+                } catch (Exception e) {
+                    return;
+                }
+            }
+        }, "acceptor");
+        acceptor.setDaemon(true);
+        acceptor.start();
+        return acceptor;
+    }
+
+    private static Result run(InetSocketAddress target, int threads) throws InterruptedException {
+        LongAdder connects = new LongAdder();
+        LongAdder failures = new LongAdder();
+        CountDownLatch start = new CountDownLatch(1);
+        List<Thread> workers = new ArrayList<>(threads);
+
+        for (int i = 0; i < threads; i++) {
+            workers.add(Thread.ofVirtual().start(() -> {
+                try {
+                    start.await();
+                    try (Socket socket = new Socket()) {
+                        // RST on close: 100k connections must not exhaust ports in TIME_WAIT
+                        socket.setSoLinger(true, 0);
+                        socket.connect(target, CONNECT_TIMEOUT_MILLIS);
+                    }
+                    connects.increment();
+                } catch (Exception e) {
+                    failures.increment();
+                }
+            }));
+        }
+
+        long begin = System.nanoTime();
+        start.countDown();
+        for (Thread worker : workers) {
+            worker.join();
+        }
+        return new Result(connects.sum(), failures.sum(), System.nanoTime() - begin);
+    }
+
+    private record Result(long connects, long failures, long elapsedNanos) {
+    }
+}
@@ -0,0 +1,109 @@
+package io.github.garryjeromson.junit.airgap.bytebuddy;
+
+/**
+ * Minimal stand-in for the Kotlin NetworkBlockerContext, used by the native test and
+ * benchmark programs so they can exercise the full interception path without the
+ * junit-airgap JAR and the Kotlin runtime on the classpath.
+ *
+ * Only the members the agent looks up in registerWithAgent() are provided; the JNI
+ * entry point names match the real class because the package and class name do.
+ *
+ * Set -Dairgap.test.active=true to report an active configuration that allows every
+ * host (exercises policy evaluation on every connect); otherwise the agent is
+ * disarmed and skips the hasActiveConfiguration() upcall. Add -Dairgap.test.shared=true
+ * to report that configuration as shared, so the armed agent skips the upcall too. The
+ * native interceptor microbenchmark flips activeConfiguration through JNI instead.
+ *
+ * checkpoint() and restore() do what the real class's CRaC resource does around a
+ * checkpoint, for programs that call jdk.crac themselves.
+ */
+public final class NetworkBlockerContext {
+    private static final boolean ACTIVE = Boolean.getBoolean("airgap.test.active");
+
+    private static final boolean SHARED = Boolean.getBoolean("airgap.test.shared");
+
+    private static volatile boolean activeConfiguration = ACTIVE;
+
+    static {
+        try {
+            registerWithAgent();
+            if (ACTIVE) {
+                setAgentHostPolicy(new String[] {"*"}, new String[0], 0);
+            }
+            if (SHARED) {
+                setAgentSharedContext(true);
+            }
+            setAgentArmState(ACTIVE, 0L);
+        } catch (UnsatisfiedLinkError e) {
+            // Agent not loaded - nothing is intercepted
+        }
+    }
+
+    private NetworkBlockerContext() {
+    }
+
+    private static native void registerWithAgent();
+
+    private static native void setAgentHostPolicy(String[] allowedHosts, String[] blockedHosts, long dnsCacheTtlMillis);
+
+    private static native void setAgentArmState(boolean armed, long generation);
+
+    private static native void setAgentSharedContext(boolean shared);
+
+    private static native long getAgentNativeBindEventCount();
+
+    private static native void quiesceAgentForCheckpoint();
+
+    private static native boolean restoreAgentAfterCheckpoint();
+
+    /** Force class initialization (and agent registration). */
+    public static void init() {
+    }
+
+    /** NativeMethodBind events the agent has handled, or -1 without the agent. */
+    public static long nativeBindEventCount() {
+        try {
+            return getAgentNativeBindEventCount();
+        } catch (UnsatisfiedLinkError e) {
+            return -1;
+        }
+    }
+
+    /** Replace the agent's JVM-wide host policy (what the libc hooks evaluate). */
+    public static void setHostPolicy(String[] allowedHosts, String[] blockedHosts) {
+        setAgentHostPolicy(allowedHosts, blockedHosts, 0);
+    }
+
+    /** Disarm the agent under a new generation and quiesce it before a checkpoint. */
+    public static void checkpoint() {
+        try {
+            setAgentArmState(false, 1L);
+            quiesceAgentForCheckpoint();
+        } catch (UnsatisfiedLinkError e) {
+            // Agent not loaded
+        }
+    }
+
+    /** Revalidate the agent after a restore and arm it again; false if that was incomplete. */
+    public static boolean restore() {
+        try {
+            boolean complete = restoreAgentAfterCheckpoint();
+            setAgentArmState(ACTIVE, 1L);
+            return complete;
+        } catch (UnsatisfiedLinkError e) {
+            return true;
+        }
+    }
+
+    public static boolean hasActiveConfiguration() {
+        return activeConfiguration;
+    }
+
+    public static void checkConnection(String host, int port, String caller) {
+        throw new IllegalStateException("Blocked " + host + ":" + port + " via " + caller);
+    }
+
+    public static boolean isExplicitlyBlocked(String host) {
+        return false;
+    }
+}
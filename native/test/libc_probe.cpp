@@ -0,0 +1,134 @@
+/**
+ * JNI probe library for LibcInterceptTest
+ *
+ * Calls connect() and getaddrinfo() from a non-JDK library, the way a JNI transport
+ * with its own socket code does, so the calls go through this library's GOT slots
+ * that the libc option patches. Built twice (see JUNIT_AIRGAP_BUILD_TESTS in
+ * native/CMakeLists.txt): once preloaded before the agent scans the loaded libraries,
+ * once loaded by the first copy, by soname through its $ORIGIN RUNPATH, after start-up
+ * to exercise the rescan. Each copy binds to its own nested class of LibcInterceptTest
+ * (JUNIT_AIRGAP_PROBE_CLASS).
+ */
+
+#include <jni.h>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef JUNIT_AIRGAP_PROBE_CLASS
+#error "Define JUNIT_AIRGAP_PROBE_CLASS to the mangled JNI class name"
+#endif
+
+#define PROBE_JNI_CONCAT(cls, name) Java_LibcInterceptTest_00024##cls##_##name
+#define PROBE_JNI_NAME(cls, name) PROBE_JNI_CONCAT(cls, name)
+#define PROBE_JNI(name) PROBE_JNI_NAME(JUNIT_AIRGAP_PROBE_CLASS, name)
+
+// How long a connect that neither succeeds nor fails at once may take
+static constexpr int kConnectTimeoutMs = 1000;
+
+extern "C" {
+
+/**
+ * Connect a non-blocking TCP socket to an IPv4 literal.
+ *
+ * @return 0 if connected, otherwise the errno (ETIMEDOUT after kConnectTimeoutMs)
+ */
+JNIEXPORT jint JNICALL PROBE_JNI(connect)(JNIEnv* env, jclass clazz, jstring address, jint port) {
+    const char* text = env->GetStringUTFChars(address, nullptr);
+    if (text == nullptr) {
+        return EINVAL;
+    }
+    struct sockaddr_in target;
+    memset(&target, 0, sizeof(target));
+    target.sin_family = AF_INET;
+    target.sin_port = htons((uint16_t)port);
+    int parsed = inet_pton(AF_INET, text, &target.sin_addr);
+    env->ReleaseStringUTFChars(address, text);
+    if (parsed != 1) {
+        return EINVAL;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return errno;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    int result = 0;
+    if (connect(fd, (const struct sockaddr*)&target, sizeof(target)) != 0) {
+        result = errno;
+        if (result == EINPROGRESS) {
+            struct pollfd pending = {fd, POLLOUT, 0};
+            if (poll(&pending, 1, kConnectTimeoutMs) == 1) {
+                socklen_t length = sizeof(result);
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &result, &length);
+            } else {
+                result = ETIMEDOUT;
+            }
+        }
+    }
+    close(fd);
+    return result;
+}
+
+/**
+ * Resolve a hostname with getaddrinfo().
+ *
+ * @return getaddrinfo() status (0 if resolved)
+ */
+JNIEXPORT jint JNICALL PROBE_JNI(resolve)(JNIEnv* env, jclass clazz, jstring hostname) {
+    const char* host = env->GetStringUTFChars(hostname, nullptr);
+    if (host == nullptr) {
+        return EAI_FAIL;
+    }
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* results = nullptr;
+    int status = getaddrinfo(host, nullptr, &hints, &results);
+    env->ReleaseStringUTFChars(hostname, host);
+    if (results != nullptr) {
+        freeaddrinfo(results);
+    }
+    return status;
+}
+
+/**
+ * dlopen() a library by soname from this library, the way a JNI library loads its own
+ * dependencies (resolved through this library's RUNPATH, not the agent's).
+ *
+ * @return 0 if loaded (the handle is kept), 1 otherwise
+ */
+JNIEXPORT jint JNICALL PROBE_JNI(loadLibrary)(JNIEnv* env, jclass clazz, jstring soname) {
+    const char* name = env->GetStringUTFChars(soname, nullptr);
+    if (name == nullptr) {
+        return 1;
+    }
+    void* handle = dlopen(name, RTLD_NOW);
+    if (handle == nullptr) {
+        fprintf(stderr, "libc_probe: dlopen(%s) failed: %s\n", name, dlerror());
+    }
+    env->ReleaseStringUTFChars(soname, name);
+    return handle != nullptr ? 0 : 1;
+}
+
+/** errno of a connect the agent blocked. */
+JNIEXPORT jint JNICALL PROBE_JNI(blockedConnectError)(JNIEnv* env, jclass clazz) {
+    return EACCES;
+}
+
+/** getaddrinfo() status of a lookup the agent blocked. */
+JNIEXPORT jint JNICALL PROBE_JNI(blockedLookupStatus)(JNIEnv* env, jclass clazz) {
+    return EAI_NONAME;
+}
+
+}  // extern "C"